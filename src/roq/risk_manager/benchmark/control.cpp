@@ -0,0 +1,68 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include <benchmark/benchmark.h>
+
+#include <fmt/format.h>
+
+#include <iterator>
+
+#include "roq/risk_manager/control/encoder.hpp"
+
+using namespace std::literals;
+
+using namespace roq;
+using namespace roq::risk_manager;
+
+// === IMPLEMENTATION ===
+
+void BM_control_encoder_trade(benchmark::State &state) {
+  auto trade = database::Trade{
+      .user = "trader"sv,
+      .strategy_id = 1,
+      .account = "A1"sv,
+      .exchange = "deribit"sv,
+      .symbol = "BTC-PERPETUAL"sv,
+      .side = Side::BUY,
+      .quantity = 1.0,
+      .price = 27193.5,
+      .exchange_time_utc = 1685248384123000000ns,
+      .external_account = "ABC123"sv,
+      .external_order_id = "12345678"sv,
+      .external_trade_id = "87654321"sv,
+  };
+  fmt::memory_buffer buffer;
+  size_t bytes = 0;
+  for (auto _ : state) {
+    buffer.clear();
+    control::Encoder::encode(std::back_inserter(buffer), trade);
+    bytes += std::size(buffer);
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(bytes);
+}
+
+BENCHMARK(BM_control_encoder_trade);
+
+void BM_control_encoder_position(benchmark::State &state) {
+  auto position = database::Position{
+      .user = {},
+      .strategy_id = {},
+      .account = "A1"sv,
+      .exchange = "deribit"sv,
+      .symbol = "BTC-PERPETUAL"sv,
+      .long_quantity = 12.0,
+      .short_quantity = 3.0,
+      .exchange_time_utc = 1685248384123000000ns,
+  };
+  fmt::memory_buffer buffer;
+  size_t bytes = 0;
+  for (auto _ : state) {
+    buffer.clear();
+    control::Encoder::encode(std::back_inserter(buffer), position);
+    bytes += std::size(buffer);
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(bytes);
+}
+
+BENCHMARK(BM_control_encoder_position);
@@ -0,0 +1,175 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include <benchmark/benchmark.h>
+
+#include <fmt/format.h>
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "roq/risk_manager/config.hpp"
+#include "roq/risk_manager/shared.hpp"
+
+#include "roq/risk_manager/database/factory.hpp"
+
+using namespace std::literals;
+
+using namespace roq;
+using namespace roq::risk_manager;
+
+// === CONSTANTS ===
+
+namespace {
+auto const DB_TYPE = "sqlite"sv;
+auto const PARTITION_INTERVAL = 24h;
+size_t const ACCOUNT_COUNT = 16;
+size_t const SYMBOL_COUNT = 64;
+size_t const BULK_BATCH_SIZE = 65536;
+auto const START_TIME = std::chrono::nanoseconds{1700000000s};
+}  // namespace
+
+// === HELPERS ===
+
+namespace {
+auto get_path(std::string_view const &name) {
+  return (std::filesystem::temp_directory_path() / fmt::format("roq-risk-manager-benchmark-{}.sqlite3"sv, name))
+      .string();
+}
+
+void remove(std::string const &path) {
+  for (auto suffix : {""sv, "-wal"sv, "-shm"sv})
+    std::filesystem::remove(fmt::format("{}{}"sv, path, suffix));
+}
+
+auto create_session(std::string_view const &path) {
+  return database::Factory::create({
+      .type = DB_TYPE,
+      .params = path,
+      .partition_interval = PARTITION_INTERVAL,
+  });
+}
+
+// note! strings must outlive the trades
+struct Generator final {
+  Generator() {
+    for (size_t i = 0; i < ACCOUNT_COUNT; ++i) {
+      accounts.emplace_back(fmt::format("A{}"sv, i));
+      users.emplace_back(fmt::format("U{}"sv, i));
+    }
+    for (size_t i = 0; i < SYMBOL_COUNT; ++i)
+      symbols.emplace_back(fmt::format("S{}"sv, i));
+  }
+
+  std::span<database::Trade const> operator()(size_t begin, size_t count) {
+    external_trade_ids.clear();
+    for (size_t i = 0; i < count; ++i)
+      external_trade_ids.emplace_back(fmt::format("{}"sv, begin + i));
+    trades.clear();
+    for (size_t i = 0; i < count; ++i) {
+      auto index = begin + i;
+      auto trade = database::Trade{
+          .user = users[index % ACCOUNT_COUNT],
+          .strategy_id = {},
+          .account = accounts[index % ACCOUNT_COUNT],
+          .exchange = "deribit"sv,
+          .symbol = symbols[index % SYMBOL_COUNT],
+          .side = (index % 3) ? Side::BUY : Side::SELL,
+          .quantity = 1.0,
+          .price = 27193.0,
+          .exchange_time_utc = START_TIME + std::chrono::milliseconds{index},
+          .external_account = {},
+          .external_order_id = {},
+          .external_trade_id = external_trade_ids[i],
+      };
+      trades.emplace_back(std::move(trade));
+    }
+    return trades;
+  }
+
+  std::vector<std::string> accounts, users, symbols;
+  std::vector<std::string> external_trade_ids;
+  std::vector<database::Trade> trades;
+};
+
+// note! re-used between runs (the database is only created if missing)
+auto get_database(size_t trade_count) {
+  auto path = get_path(fmt::format("{}"sv, trade_count));
+  if (!std::filesystem::exists(path)) {
+    auto session = create_session(path);
+    (*session)(database::Bulk{.enabled = true});
+    Generator generator;
+    for (size_t i = 0; i < trade_count; i += BULK_BATCH_SIZE)
+      (*session)(generator(i, std::min(BULK_BATCH_SIZE, trade_count - i)));
+    (*session)(database::Bulk{.enabled = false});
+  }
+  return path;
+}
+
+auto create_config() {
+  std::string text{R"(symbols = [".*"])"
+                   "\n"sv};
+  for (size_t i = 0; i < ACCOUNT_COUNT; ++i)
+    fmt::format_to(std::back_inserter(text), "[accounts.A{}.deribit.S0]\nlong_position_limit = 10\n"sv, i);
+  return Config::parse_text(text);
+}
+}  // namespace
+
+// === IMPLEMENTATION ===
+
+void BM_sqlite_trades_insert(benchmark::State &state) {
+  auto batch_size = static_cast<size_t>(state.range(0));
+  auto path = get_path("insert"sv);
+  remove(path);
+  auto session = create_session(path);
+  Generator generator;
+  size_t count = 0;
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto trades = generator(count, batch_size);
+    state.ResumeTiming();
+    (*session)(trades);
+    count += batch_size;
+  }
+  state.SetItemsProcessed(count);
+  session.reset();
+  remove(path);
+}
+
+BENCHMARK(BM_sqlite_trades_insert)->RangeMultiplier(16)->Range(1, 4096)->Unit(benchmark::kMicrosecond);
+
+// note! opening the database, e.g. schema, dimensions and statistics
+void BM_sqlite_startup(benchmark::State &state) {
+  auto path = get_database(static_cast<size_t>(state.range(0)));
+  for (auto _ : state) {
+    auto session = create_session(path);
+    benchmark::DoNotOptimize(session);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(BM_sqlite_startup)->RangeMultiplier(10)->Range(10000, 10000000)->Unit(benchmark::kMillisecond);
+
+// note! same steps as Controller::load_positions
+void BM_sqlite_load_positions(benchmark::State &state) {
+  auto path = get_database(static_cast<size_t>(state.range(0)));
+  auto session = create_session(path);
+  auto config = create_config();
+  size_t count = 0;
+  for (auto _ : state) {
+    Shared shared{config};
+    auto dispatch = [&](database::Position const &position) {
+      auto callback = [&](auto &item) { item(position); };
+      if (!std::empty(position.user))
+        shared.get_user(position.user, callback);
+      if (!std::empty(position.account))
+        shared.get_account(position.account, callback);
+      ++count;
+    };
+    (*session)(dispatch, {});
+  }
+  benchmark::DoNotOptimize(count);
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(BM_sqlite_load_positions)->RangeMultiplier(10)->Range(10000, 10000000)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,54 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+#include <string>
+
+#include "roq/risk_manager/metrics/metrics.hpp"
+
+using namespace std::literals;
+
+using namespace roq;
+using namespace roq::risk_manager;
+
+// === IMPLEMENTATION ===
+
+void BM_metrics_counter(benchmark::State &state) {
+  metrics::Counter counter;
+  for (auto _ : state) {
+    ++counter;
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_metrics_counter);
+
+void BM_metrics_histogram(benchmark::State &state) {
+  metrics::Histogram histogram;
+  std::chrono::nanoseconds value = 1234ns;
+  for (auto _ : state) {
+    histogram(value);
+    value += 7ns;  // note! spread across buckets
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_metrics_histogram);
+
+void BM_metrics_encode(benchmark::State &state) {
+  metrics::Metrics metrics{2};
+  for (int64_t i = 1; i <= 1000; ++i)
+    metrics.trade_update_latency(std::chrono::nanoseconds{i * 1000});
+  std::string result;
+  for (auto _ : state) {
+    result.clear();
+    metrics.encode(result, 0);
+    benchmark::DoNotOptimize(result);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_metrics_encode);
@@ -0,0 +1,319 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include <benchmark/benchmark.h>
+
+#include <fmt/format.h>
+
+#include <string>
+#include <vector>
+
+#include "roq/risk_manager/config.hpp"
+#include "roq/risk_manager/shared.hpp"
+
+#include "roq/risk_manager/risk/exposure.hpp"
+#include "roq/risk_manager/risk/instrument.hpp"
+#include "roq/risk_manager/risk/position.hpp"
+
+using namespace std::literals;
+
+using namespace roq;
+using namespace roq::risk_manager;
+
+// === CONSTANTS ===
+
+namespace {
+auto const EXCHANGE = "deribit"sv;
+}  // namespace
+
+// === HELPERS ===
+
+namespace {
+auto get_account(size_t index) {
+  return fmt::format("A{}"sv, index);
+}
+
+auto get_user(size_t index) {
+  return fmt::format("U{}"sv, index);
+}
+
+auto get_symbol(size_t index) {
+  return fmt::format("S{}"sv, index);
+}
+
+// note! every account (and user) has a limit for every symbol
+auto create_config(size_t entity_count, size_t symbol_count) {
+  std::string text{R"(symbols = [".*"])"
+                   "\n"sv};
+  for (size_t i = 0; i < entity_count; ++i)
+    for (size_t j = 0; j < symbol_count; ++j) {
+      auto helper = [&](auto const &type, auto const &name) {
+        fmt::format_to(
+            std::back_inserter(text),
+            "[{}.{}.{}.{}]\nlong_position_limit = 10\nshort_position_limit = 5\n"sv,
+            type,
+            name,
+            EXCHANGE,
+            get_symbol(j));
+      };
+      helper("accounts"sv, get_account(i));
+      helper("users"sv, get_user(i));
+    }
+  return Config::parse_text(text);
+}
+
+auto create_reference_data(std::string_view const &symbol) {
+  ReferenceData reference_data;
+  reference_data.exchange = EXCHANGE;
+  reference_data.symbol = symbol;
+  reference_data.min_trade_vol = 0.001;
+  return reference_data;
+}
+
+// note! one position per entity and symbol
+void create_positions(Shared &shared, size_t entity_count, size_t symbol_count) {
+  std::vector<std::string> symbols;
+  for (size_t j = 0; j < symbol_count; ++j) {
+    auto &symbol = symbols.emplace_back(get_symbol(j));
+    shared.get_instrument(EXCHANGE, symbol)(create_reference_data(symbol));
+  }
+  for (size_t i = 0; i < entity_count; ++i) {
+    auto account = get_account(i), user = get_user(i);
+    for (auto &symbol : symbols) {
+      auto position = database::Position{
+          .user = {},
+          .strategy_id = {},
+          .account = {},
+          .exchange = EXCHANGE,
+          .symbol = symbol,
+          .long_quantity = 1.0,
+          .short_quantity = 0.0,
+          .exchange_time_utc = {},
+      };
+      auto callback = [&](auto &item) { item(position); };
+      shared.get_account(account, callback);
+      shared.get_user(user, callback);
+    }
+  }
+}
+}  // namespace
+
+// === IMPLEMENTATION ===
+
+// note! fills are remembered (to avoid double-counting), i.e. the set grows with the number of iterations
+void BM_risk_position_fill(benchmark::State &state) {
+  risk::Instrument instrument{1, EXCHANGE, "BTC-PERPETUAL"sv};
+  instrument(create_reference_data("BTC-PERPETUAL"sv));
+  risk::Position position{risk::Limit{}};
+  char external_trade_id[32];
+  Fill fill;
+  fill.quantity = 1.0;
+  fill.price = 27193.0;
+  TradeUpdate trade_update;
+  trade_update.exchange = EXCHANGE;
+  trade_update.symbol = "BTC-PERPETUAL"sv;
+  trade_update.fills = {&fill, 1};
+  int64_t counter = 0;
+  for (auto _ : state) {
+    auto [out, size] = fmt::format_to_n(external_trade_id, sizeof(external_trade_id), "{}"sv, ++counter);
+    fill.external_trade_id = std::string_view{external_trade_id, size};
+    trade_update.side = (counter % 2) ? Side::BUY : Side::SELL;
+    trade_update.create_time_utc = std::chrono::nanoseconds{counter};
+    position(trade_update, instrument);
+  }
+  benchmark::DoNotOptimize(position.long_position());
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_risk_position_fill);
+
+// note! one price per instrument (all prices have changed), 4 positions per instrument and one bucket per instrument
+void BM_risk_exposure_reprice(benchmark::State &state) {
+  auto instrument_count = static_cast<uint32_t>(state.range(0));
+  risk::Exposure exposure;
+  for (uint32_t i = 1; i <= instrument_count; ++i) {
+    uint32_t bucket = exposure.create_bucket();
+    for (size_t j = 0; j < 4; ++j) {
+      auto slot = exposure.create_slot(i);
+      exposure.set_buckets(slot, {&bucket, 1});
+      exposure(slot, 1.0);
+    }
+  }
+  double price = 27193.0;
+  for (auto _ : state) {
+    price += 0.5;
+    for (uint32_t i = 1; i <= instrument_count; ++i)
+      exposure.set_price(i, price);
+    benchmark::DoNotOptimize(exposure.reprice());
+  }
+  benchmark::DoNotOptimize(exposure.get_bucket(1));
+  state.SetItemsProcessed(state.iterations() * std::size(exposure));
+}
+
+BENCHMARK(BM_risk_exposure_reprice)->RangeMultiplier(8)->Range(64, 32768);
+
+// note! the instrument is a member of every group (the aggregates are updated incrementally)
+void BM_shared_fill_with_groups(benchmark::State &state) {
+  auto group_count = static_cast<size_t>(state.range(0));
+  std::string text{R"(symbols = [".*"])"
+                   "\n"
+                   "[accounts.A0.\"*\".\"*\"]\nlong_position_limit = 10\n"sv};
+  for (size_t j = 0; j < group_count; ++j)
+    fmt::format_to(std::back_inserter(text), "[groups.G{}]\nsymbol = \"BTC-.*\"\nlong_position_limit = 10\n"sv, j);
+  auto config = Config::parse_text(text);
+  Shared shared{config};
+  shared(create_reference_data("BTC-PERPETUAL"sv));
+  char external_trade_id[32];
+  Fill fill;
+  fill.quantity = 1.0;
+  fill.price = 27193.0;
+  auto account = get_account(0);
+  TradeUpdate trade_update;
+  trade_update.account = account;
+  trade_update.exchange = EXCHANGE;
+  trade_update.symbol = "BTC-PERPETUAL"sv;
+  trade_update.fills = {&fill, 1};
+  int64_t counter = 0;
+  for (auto _ : state) {
+    auto [out, size] = fmt::format_to_n(external_trade_id, sizeof(external_trade_id), "{}"sv, ++counter);
+    fill.external_trade_id = std::string_view{external_trade_id, size};
+    trade_update.side = (counter % 2) ? Side::BUY : Side::SELL;
+    trade_update.create_time_utc = std::chrono::nanoseconds{counter};
+    shared.get_account(account, [&](auto &item) { item(trade_update, trade_update.create_time_utc); });
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_shared_fill_with_groups)->RangeMultiplier(4)->Range(1, 16);
+
+void BM_shared_get_instrument(benchmark::State &state) {
+  auto symbol_count = static_cast<size_t>(state.range(0));
+  auto config = create_config(0, 0);
+  Shared shared{config};
+  std::vector<std::string> symbols;
+  for (size_t j = 0; j < symbol_count; ++j)
+    shared.get_instrument(EXCHANGE, symbols.emplace_back(get_symbol(j)));
+  size_t index = 0;
+  for (auto _ : state) {
+    auto &instrument = shared.get_instrument(EXCHANGE, symbols[index]);
+    benchmark::DoNotOptimize(instrument);
+    if (++index == symbol_count)
+      index = 0;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_shared_get_instrument)->RangeMultiplier(8)->Range(8, 4096);
+
+void BM_shared_get_limit_by_account(benchmark::State &state) {
+  auto entity_count = static_cast<size_t>(state.range(0));
+  size_t const symbol_count = 16;
+  auto config = create_config(entity_count, symbol_count);
+  Shared shared{config};
+  auto &handler = static_cast<risk::Account::Handler &>(shared);
+  std::vector<std::string> accounts, symbols;
+  for (size_t i = 0; i < entity_count; ++i)
+    accounts.emplace_back(get_account(i));
+  for (size_t j = 0; j < symbol_count; ++j)
+    symbols.emplace_back(get_symbol(j));
+  size_t index = 0;
+  for (auto _ : state) {
+    auto limit = handler.get_limit_by_account(accounts[index % entity_count], EXCHANGE, symbols[index % symbol_count]);
+    benchmark::DoNotOptimize(limit);
+    ++index;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_shared_get_limit_by_account)->RangeMultiplier(8)->Range(8, 512);
+
+// note! worst case, the regex patterns don't match and the account default is used
+void BM_shared_get_limit_by_account_pattern(benchmark::State &state) {
+  auto pattern_count = static_cast<size_t>(state.range(0));
+  std::string text{R"(symbols = [".*"])"
+                   "\n"sv};
+  for (size_t j = 0; j < pattern_count; ++j)
+    fmt::format_to(
+        std::back_inserter(text),
+        "[accounts.A0.{}.\"^{}-.*\"]\nlong_position_limit = 10\n"sv,
+        EXCHANGE,
+        get_symbol(j));
+  fmt::format_to(std::back_inserter(text), "[accounts.A0.\"*\".\"*\"]\nlong_position_limit = 1\n"sv);
+  auto config = Config::parse_text(text);
+  Shared shared{config};
+  auto &handler = static_cast<risk::Account::Handler &>(shared);
+  auto account = get_account(0);
+  for (auto _ : state) {
+    auto limit = handler.get_limit_by_account(account, EXCHANGE, "BTC-PERPETUAL"sv);
+    benchmark::DoNotOptimize(limit);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_shared_get_limit_by_account_pattern)->RangeMultiplier(8)->Range(1, 64);
+
+// note! same steps as Controller::publish_accounts (every position has changed)
+void BM_shared_publish_accounts(benchmark::State &state) {
+  auto entity_count = static_cast<size_t>(state.range(0));
+  auto symbol_count = static_cast<size_t>(state.range(1));
+  auto config = create_config(entity_count, symbol_count);
+  Shared shared{config};
+  create_positions(shared, entity_count, symbol_count);
+  std::vector<RiskLimit> risk_limits;
+  size_t count = 0;
+  for (auto _ : state) {
+    shared.get_all_accounts([&](auto &account) { shared.publish_account(account.name); });
+    shared.get_all_accounts([&](auto &account) {
+      risk_limits.clear();
+      auto callback = [&](auto const &risk_limit) { risk_limits.emplace_back(risk_limit); };
+      shared.get_publish_by_account(account.name, callback);
+      count += std::size(risk_limits);
+    });
+  }
+  benchmark::DoNotOptimize(count);
+  state.SetItemsProcessed(count);
+}
+
+BENCHMARK(BM_shared_publish_accounts)->ArgsProduct({{16, 128, 1024}, {16, 256}})->Unit(benchmark::kMicrosecond);
+
+// note! same steps as Controller::publish_users (every position has changed)
+void BM_shared_publish_users(benchmark::State &state) {
+  auto entity_count = static_cast<size_t>(state.range(0));
+  auto symbol_count = static_cast<size_t>(state.range(1));
+  auto config = create_config(entity_count, symbol_count);
+  Shared shared{config};
+  create_positions(shared, entity_count, symbol_count);
+  std::vector<RiskLimit> risk_limits;
+  size_t count = 0;
+  for (auto _ : state) {
+    shared.get_all_users([&](auto &user) { shared.publish_user(user.name); });
+    shared.get_all_users([&](auto &user) {
+      risk_limits.clear();
+      auto callback = [&](auto const &risk_limit) { risk_limits.emplace_back(risk_limit); };
+      shared.get_publish_by_user(user.name, callback);
+      count += std::size(risk_limits);
+    });
+  }
+  benchmark::DoNotOptimize(count);
+  state.SetItemsProcessed(count);
+}
+
+BENCHMARK(BM_shared_publish_users)->ArgsProduct({{16, 128, 1024}, {16, 256}})->Unit(benchmark::kMicrosecond);
+
+// note! nothing has changed, i.e. the cost of every timer event
+void BM_shared_publish_accounts_idle(benchmark::State &state) {
+  auto entity_count = static_cast<size_t>(state.range(0));
+  size_t const symbol_count = 16;
+  auto config = create_config(entity_count, symbol_count);
+  Shared shared{config};
+  create_positions(shared, entity_count, symbol_count);
+  size_t count = 0;
+  for (auto _ : state) {
+    shared.get_all_accounts([&](auto &account) {
+      auto callback = [&](auto const &) { ++count; };
+      shared.get_publish_by_account(account.name, callback);
+    });
+  }
+  benchmark::DoNotOptimize(count);
+}
+
+BENCHMARK(BM_shared_publish_accounts_idle)->RangeMultiplier(8)->Range(16, 1024);
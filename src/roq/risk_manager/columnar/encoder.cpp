@@ -0,0 +1,83 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include "roq/risk_manager/columnar/encoder.hpp"
+
+#include <array>
+
+using namespace std::literals;
+
+namespace roq {
+namespace risk_manager {
+namespace columnar {
+
+// === CONSTANTS ===
+
+namespace {
+std::array<Column, 12> const TRADES{{
+    {"user"sv, Type::STRING},
+    {"strategy_id"sv, Type::UINT32},
+    {"account"sv, Type::STRING},
+    {"exchange"sv, Type::STRING},
+    {"symbol"sv, Type::STRING},
+    {"side"sv, Type::UINT8},
+    {"quantity"sv, Type::FLOAT64},
+    {"price"sv, Type::FLOAT64},
+    {"exchange_time_utc"sv, Type::INT64},
+    {"external_account"sv, Type::STRING},
+    {"external_order_id"sv, Type::STRING},
+    {"external_trade_id"sv, Type::STRING},
+}};
+
+std::array<Column, 8> const POSITIONS{{
+    {"user"sv, Type::STRING},
+    {"strategy_id"sv, Type::UINT32},
+    {"account"sv, Type::STRING},
+    {"exchange"sv, Type::STRING},
+    {"symbol"sv, Type::STRING},
+    {"long_quantity"sv, Type::FLOAT64},
+    {"short_quantity"sv, Type::FLOAT64},
+    {"exchange_time_utc"sv, Type::INT64},
+}};
+}  // namespace
+
+// === IMPLEMENTATION ===
+
+std::span<Column const> Encoder::get_trades_schema() {
+  return TRADES;
+}
+
+std::span<Column const> Encoder::get_positions_schema() {
+  return POSITIONS;
+}
+
+void Encoder::encode(Writer &writer, database::Trade const &trade) {
+  writer(
+      trade.user,
+      trade.strategy_id,
+      trade.account,
+      trade.exchange,
+      trade.symbol,
+      static_cast<uint8_t>(magic_enum::enum_integer(trade.side)),
+      trade.quantity,
+      trade.price,
+      static_cast<int64_t>(trade.exchange_time_utc.count()),
+      trade.external_account,
+      trade.external_order_id,
+      trade.external_trade_id);
+}
+
+void Encoder::encode(Writer &writer, database::Position const &position) {
+  writer(
+      position.user,
+      position.strategy_id,
+      position.account,
+      position.exchange,
+      position.symbol,
+      position.long_quantity,
+      position.short_quantity,
+      static_cast<int64_t>(position.exchange_time_utc.count()));
+}
+
+}  // namespace columnar
+}  // namespace risk_manager
+}  // namespace roq
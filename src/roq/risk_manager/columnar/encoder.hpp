@@ -0,0 +1,28 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include <span>
+
+#include "roq/risk_manager/database/position.hpp"
+#include "roq/risk_manager/database/trade.hpp"
+
+#include "roq/risk_manager/columnar/writer.hpp"
+
+namespace roq {
+namespace risk_manager {
+namespace columnar {
+
+// note! same field names as used by the control interface (side is the enum value)
+
+struct Encoder final {
+  static std::span<Column const> get_trades_schema();
+  static std::span<Column const> get_positions_schema();
+
+  static void encode(Writer &, database::Trade const &);
+  static void encode(Writer &, database::Position const &);
+};
+
+}  // namespace columnar
+}  // namespace risk_manager
+}  // namespace roq
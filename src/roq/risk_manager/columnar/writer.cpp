@@ -0,0 +1,202 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include "roq/risk_manager/columnar/writer.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+#include "roq/exceptions.hpp"
+
+using namespace std::literals;
+
+namespace roq {
+namespace risk_manager {
+namespace columnar {
+
+// === CONSTANTS ===
+
+namespace {
+size_t const ALIGNMENT = 8;
+}  // namespace
+
+// === HELPERS ===
+
+namespace {
+static_assert(std::endian::native == std::endian::little, "values are written in native byte order");
+
+template <typename T>
+void put(std::string &buffer, T value) {
+  char tmp[sizeof(T)];
+  std::memcpy(tmp, &value, sizeof(T));
+  buffer.append(tmp, sizeof(T));
+}
+
+void pad(std::string &buffer, size_t offset = 0) {
+  auto remainder = (offset + std::size(buffer)) % ALIGNMENT;
+  if (remainder)
+    buffer.append(ALIGNMENT - remainder, '\0');
+}
+
+size_t get_size(Type type) {
+  switch (type) {
+    case Type::STRING:
+    case Type::UINT32:
+      return sizeof(uint32_t);
+    case Type::INT64:
+      return sizeof(int64_t);
+    case Type::FLOAT64:
+      return sizeof(double);
+    case Type::UINT8:
+      return sizeof(uint8_t);
+  }
+  return 0;
+}
+
+void update(auto &buffer, int64_t value) {
+  buffer.min_int64 = std::min(buffer.min_int64, value);
+  buffer.max_int64 = std::max(buffer.max_int64, value);
+}
+
+void check(auto &buffer, Type type) {
+  if (buffer.type != type) [[unlikely]]
+    throw RuntimeError{"Unexpected: value does not match the schema"sv};
+}
+}  // namespace
+
+// === IMPLEMENTATION ===
+
+Writer::Writer(Output const &output, std::span<Column const> const &schema, size_t row_group_size)
+    : output_{output}, row_group_size_{std::max<size_t>(row_group_size, 1)} {
+  buffers_.reserve(std::size(schema));
+  for (auto &column : schema) {
+    if (std::size(column.name) > std::numeric_limits<uint8_t>::max())
+      throw RuntimeError{R"(Unexpected: column name="{}" is too long)"sv, column.name};
+    auto &buffer = buffers_.emplace_back(column.type);
+    buffer.data.reserve(row_group_size_ * get_size(column.type));
+  }
+  scratch_.append(MAGIC);
+  put(scratch_, VERSION);
+  put(scratch_, static_cast<uint32_t>(std::size(schema)));
+  for (auto &column : schema) {
+    put(scratch_, static_cast<uint8_t>(column.type));
+    put(scratch_, static_cast<uint8_t>(std::size(column.name)));
+    scratch_.append(column.name);
+  }
+  pad(scratch_);
+  write(scratch_);
+}
+
+void Writer::finish() {
+  if (row_count_)
+    flush();
+  scratch_.clear();
+  put(scratch_, uint32_t{0});
+  put(scratch_, uint32_t{0});
+  for (auto offset : row_groups_)
+    put(scratch_, offset);
+  put(scratch_, static_cast<uint64_t>(std::size(row_groups_)));
+  put(scratch_, static_cast<uint64_t>(total_row_count_));
+  scratch_.append(MAGIC);
+  write(scratch_);
+}
+
+void Writer::append(size_t index, std::string_view const &value) {
+  assert(index < std::size(buffers_));
+  auto &buffer = buffers_[index];
+  check(buffer, Type::STRING);
+  auto iter = buffer.dictionary.find(value);
+  if (iter == std::end(buffer.dictionary)) {
+    auto &entry = buffer.entries.emplace_back(value);
+    buffer.dictionary_bytes += std::size(entry);
+    iter = buffer.dictionary.emplace(entry, static_cast<uint32_t>(std::size(buffer.entries) - 1)).first;
+  }
+  put(buffer.data, (*iter).second);
+}
+
+void Writer::append(size_t index, int64_t value) {
+  assert(index < std::size(buffers_));
+  auto &buffer = buffers_[index];
+  check(buffer, Type::INT64);
+  update(buffer, value);
+  put(buffer.data, value);
+}
+
+void Writer::append(size_t index, double value) {
+  assert(index < std::size(buffers_));
+  auto &buffer = buffers_[index];
+  check(buffer, Type::FLOAT64);
+  if (!std::isnan(value)) {
+    buffer.min_float64 = std::min(buffer.min_float64, value);
+    buffer.max_float64 = std::max(buffer.max_float64, value);
+  }
+  put(buffer.data, value);
+}
+
+void Writer::append(size_t index, uint32_t value) {
+  assert(index < std::size(buffers_));
+  auto &buffer = buffers_[index];
+  check(buffer, Type::UINT32);
+  update(buffer, value);
+  put(buffer.data, value);
+}
+
+void Writer::append(size_t index, uint8_t value) {
+  assert(index < std::size(buffers_));
+  auto &buffer = buffers_[index];
+  check(buffer, Type::UINT8);
+  update(buffer, value);
+  put(buffer.data, value);
+}
+
+void Writer::flush() {
+  row_groups_.emplace_back(offset_);
+  scratch_.clear();
+  put(scratch_, static_cast<uint32_t>(row_count_));
+  put(scratch_, static_cast<uint32_t>(std::size(buffers_)));
+  write(scratch_);
+  for (auto &buffer : buffers_) {
+    scratch_.clear();
+    if (buffer.type == Type::STRING) {
+      put(scratch_, static_cast<uint64_t>(std::size(buffer.entries)));
+      put(scratch_, static_cast<uint64_t>(buffer.dictionary_bytes));
+      uint32_t offset = 0;
+      put(scratch_, offset);
+      for (auto &entry : buffer.entries)
+        put(scratch_, offset += static_cast<uint32_t>(std::size(entry)));
+      for (auto &entry : buffer.entries)
+        scratch_.append(entry);
+      pad(scratch_);
+    } else if (buffer.type == Type::FLOAT64) {
+      put(scratch_, row_count_ ? buffer.min_float64 : 0.0);
+      put(scratch_, row_count_ ? buffer.max_float64 : 0.0);
+    } else {
+      put(scratch_, row_count_ ? buffer.min_int64 : int64_t{0});
+      put(scratch_, row_count_ ? buffer.max_int64 : int64_t{0});
+    }
+    scratch_.append(buffer.data);
+    pad(scratch_);
+    std::string size;
+    put(size, static_cast<uint64_t>(std::size(scratch_)));
+    write(size);
+    write(scratch_);
+    // note! the dictionary is per row group (the data buffer is re-used)
+    auto data = std::move(buffer.data);
+    buffer = Buffer{buffer.type};
+    buffer.data = std::move(data);
+    buffer.data.clear();
+  }
+  total_row_count_ += row_count_;
+  row_count_ = {};
+}
+
+void Writer::write(std::string_view const &data) {
+  output_(data);
+  offset_ += std::size(data);
+}
+
+}  // namespace columnar
+}  // namespace risk_manager
+}  // namespace roq
@@ -0,0 +1,111 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include <absl/container/flat_hash_map.h>
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace roq {
+namespace risk_manager {
+namespace columnar {
+
+enum class Type : uint8_t {
+  STRING = 1,  // note! dictionary encoded
+  INT64,
+  FLOAT64,
+  UINT32,
+  UINT8,
+};
+
+struct Column final {
+  std::string_view name;
+  Type type = {};
+};
+
+// note!
+//   little-endian, all sections are 8-byte aligned, i.e. fixed-width columns can be used in-place (e.g. mmap)
+//
+//   file:      header, row group*, footer
+//   header:    magic (8), version (u32), column count (u32), (type (u8), name length (u8), name)*, padding
+//   row group: row count (u32), column count (u32), chunk*
+//   chunk:     size (u64, excluding this field), statistics (16), data, padding
+//     fixed:   min (8), max (8), values[row count]
+//              statistics are i64 (INT64, UINT32, UINT8) or f64 (FLOAT64), NaN is ignored
+//     string:  dictionary size (u64), dictionary bytes (u64), offsets (u32[size + 1]), bytes, padding,
+//              indices (u32[row count])
+//   footer:    end marker (u32 0, u32 0), row group offsets (u64*), row group count (u64), row count (u64), magic (8)
+//
+//   only a single row group is buffered, output is called whenever a row group has been completed
+
+struct Writer final {
+  static constexpr std::string_view MAGIC = "ROQCOLS1";
+  static constexpr uint32_t VERSION = 1;
+
+  using Output = std::function<void(std::string_view const &)>;
+
+  Writer(Output const &, std::span<Column const> const &schema, size_t row_group_size);
+
+  Writer(Writer &&) = delete;
+  Writer(Writer const &) = delete;
+
+  // note! one value per column (same order as the schema)
+  template <typename... Args>
+  void operator()(Args const &...args) {
+    size_t index = 0;
+    (append(index++, args), ...);
+    if (++row_count_ >= row_group_size_)
+      flush();
+  }
+
+  // note! flushes the last row group and writes the footer
+  void finish();
+
+ protected:
+  void append(size_t index, std::string_view const &);
+  void append(size_t index, int64_t);
+  void append(size_t index, double);
+  void append(size_t index, uint32_t);
+  void append(size_t index, uint8_t);
+
+  void flush();
+
+  void write(std::string_view const &);
+
+  struct Buffer final {
+    explicit Buffer(Type type) : type{type} {}
+
+    Type type = {};
+    std::string data;
+    // note! STRING
+    std::deque<std::string> entries;  // note! stable references
+    absl::flat_hash_map<std::string_view, uint32_t> dictionary;
+    size_t dictionary_bytes = {};
+    // note! statistics
+    int64_t min_int64 = std::numeric_limits<int64_t>::max();
+    int64_t max_int64 = std::numeric_limits<int64_t>::min();
+    double min_float64 = std::numeric_limits<double>::infinity();
+    double max_float64 = -std::numeric_limits<double>::infinity();
+  };
+
+ private:
+  Output const output_;
+  size_t const row_group_size_;
+  std::vector<Buffer> buffers_;
+  size_t row_count_ = {};
+  size_t total_row_count_ = {};
+  size_t offset_ = {};
+  std::vector<uint64_t> row_groups_;  // note! offsets
+  std::string scratch_;
+};
+
+}  // namespace columnar
+}  // namespace risk_manager
+}  // namespace roq
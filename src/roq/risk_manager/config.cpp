@@ -4,8 +4,17 @@
 
 #include <toml++/toml.h>
 
+#include <charconv>
+
+#include "roq/exceptions.hpp"
 #include "roq/logging.hpp"
 
+#include "roq/risk_manager/risk/aggregate.hpp"
+#include "roq/risk_manager/risk/capacity.hpp"
+#include "roq/risk_manager/risk/drawdown.hpp"
+#include "roq/risk_manager/risk/pattern.hpp"
+#include "roq/risk_manager/risk/velocity.hpp"
+
 using namespace std::literals;
 
 namespace roq {
@@ -30,7 +39,16 @@ void check_empty(auto &node) {
     error = true;
   }
   if (error)
-    log::fatal("Unexpected"sv);
+    throw RuntimeError{"Unexpected: unknown key(s)"sv};
+}
+
+// note! throws if the value is missing or has the wrong type
+template <typename T>
+T get_value(auto &node) {
+  auto result = node.template value<T>();
+  if (!result)
+    throw RuntimeError{"Unexpected: invalid value type"sv};
+  return *result;
 }
 
 template <typename Callback>
@@ -56,19 +74,19 @@ R parse_symbols(auto &node) {
   auto parse_helper = [&](auto &node) {
     using value_type = typename result_type::mapped_type::value_type;
     if (node.is_value()) {
-      result[EXCHANGE].emplace(*node.template value<value_type>());
+      result[EXCHANGE].emplace(get_value<value_type>(node));
     } else if (node.is_array()) {
       auto &arr = *node.as_array();
       for (auto &node_2 : arr) {
-        result[EXCHANGE].emplace(*node_2.template value<value_type>());
+        result[EXCHANGE].emplace(get_value<value_type>(node_2));
       }
     } else {
-      log::fatal("Unexpected"sv);
+      throw RuntimeError{"Unexpected: symbols must be a value or an array"sv};
     }
   };
   if (find_and_remove(node, "symbols"sv, parse_helper)) {
   } else {
-    log::fatal(R"(Unexpected: did not find the "symbols" table)"sv);
+    throw RuntimeError{R"(Unexpected: did not find the "symbols" table)"sv};
   }
   return result;
 }
@@ -92,40 +110,41 @@ R parse_limits(auto &node, auto const &name) {
               auto &table_2 = *value_2.as_table();
               for (auto &[key_3, value_3] : table_2) {
                 std::string symbol{key_3};
+                risk::Pattern::validate(symbol);
                 if (value_3.is_table()) {
                   auto &table_3 = *value_3.as_table();
                   risk::Limit limit;
                   find_and_remove(table_3, "long_position_limit"sv, [&](auto &value) {
-                    limit.long_position_limit = *value.template value<double>();
+                    limit.long_position_limit = get_value<double>(value);
                   });
                   find_and_remove(table_3, "short_position_limit"sv, [&](auto &value) {
-                    limit.short_position_limit = *value.template value<double>();
+                    limit.short_position_limit = get_value<double>(value);
                   });
                   find_and_remove(table_3, "long_risk_exposure_limit"sv, [&](auto &value) {
-                    limit.long_risk_exposure_limit = *value.template value<double>();
+                    limit.long_risk_exposure_limit = get_value<double>(value);
                   });
                   find_and_remove(table_3, "short_risk_exposure_limit"sv, [&](auto &value) {
-                    limit.short_risk_exposure_limit = *value.template value<double>();
+                    limit.short_risk_exposure_limit = get_value<double>(value);
                   });
                   find_and_remove(table_3, "allow_netting"sv, [&](auto &value) {
-                    limit.allow_netting = *value.template value<bool>();
+                    limit.allow_netting = get_value<bool>(value);
                   });
                   tmp_2.try_emplace(symbol, std::move(limit));
                   check_empty(value_3);
                 } else {
-                  log::fatal("Unexpected"sv);
+                  throw RuntimeError{R"(Unexpected: "{}" must be a table)"sv, symbol};
                 }
               }
             } else {
-              log::fatal("Unexpected"sv);
+              throw RuntimeError{R"(Unexpected: "{}" must be a table)"sv, exchange};
             }
           }
         } else {
-          log::fatal("Unexpected"sv);
+          throw RuntimeError{R"(Unexpected: "{}" must be a table)"sv, account};
         }
       }
     } else {
-      log::fatal("Unexpected"sv);
+      throw RuntimeError{R"(Unexpected: "{}" must be a table)"sv, name};
     }
   };
   if (find_and_remove(node, name, parse_helper)) {
@@ -134,6 +153,188 @@ R parse_limits(auto &node, auto const &name) {
   }
   return result;
 }
+
+template <typename R>
+R parse_groups(auto &node) {
+  using result_type = std::remove_cvref<R>::type;
+  result_type result;
+  auto parse_helper = [&](auto &node) {
+    if (node.is_table()) {
+      auto &table = *node.as_table();
+      for (auto &[key, value] : table) {
+        std::string name{key};
+        if (value.is_table()) {
+          auto &table_2 = *value.as_table();
+          risk::Group group;
+          find_and_remove(table_2, "exchange"sv, [&](auto &value) { group.exchange = get_value<std::string>(value); });
+          find_and_remove(table_2, "symbol"sv, [&](auto &value) { group.symbol = get_value<std::string>(value); });
+          find_and_remove(table_2, "underlying"sv, [&](auto &value) {
+            group.underlying = get_value<std::string>(value);
+          });
+          find_and_remove(table_2, "base_currency"sv, [&](auto &value) {
+            group.base_currency = get_value<std::string>(value);
+          });
+          find_and_remove(table_2, "long_position_limit"sv, [&](auto &value) {
+            group.long_position_limit = get_value<double>(value);
+          });
+          find_and_remove(table_2, "short_position_limit"sv, [&](auto &value) {
+            group.short_position_limit = get_value<double>(value);
+          });
+          find_and_remove(table_2, "long_notional_limit"sv, [&](auto &value) {
+            group.long_notional_limit = get_value<double>(value);
+          });
+          find_and_remove(table_2, "short_notional_limit"sv, [&](auto &value) {
+            group.short_notional_limit = get_value<double>(value);
+          });
+          check_empty(value);
+          if (std::empty(group.exchange) && std::empty(group.symbol) && std::empty(group.underlying) &&
+              std::empty(group.base_currency))
+            throw RuntimeError{R"(Unexpected: "{}" must match on at least one field)"sv, name};
+          risk::Aggregate::validate(group);
+          result.try_emplace(name, std::move(group));
+        } else {
+          throw RuntimeError{R"(Unexpected: "{}" must be a table)"sv, name};
+        }
+      }
+    } else {
+      throw RuntimeError{R"(Unexpected: "groups" must be a table)"sv};
+    }
+  };
+  find_and_remove(node, "groups"sv, parse_helper);  // note! optional
+  return result;
+}
+
+// note! "HH:MM" or "HH:MM:SS"
+std::chrono::seconds parse_time_of_day(std::string_view const &value) {
+  int64_t parts[3] = {};
+  size_t count = 0;
+  auto first = std::data(value), last = first + std::size(value);
+  while (count < std::size(parts)) {
+    auto [ptr, ec] = std::from_chars(first, last, parts[count]);
+    if (ec != std::errc{} || (ptr - first) != 2)
+      throw RuntimeError{R"(Unexpected: invalid time of day "{}")"sv, value};
+    ++count;
+    first = ptr;
+    if (first == last || *first != ':')
+      break;
+    ++first;
+  }
+  if (first != last || count < 2 || parts[0] > 23 || parts[1] > 59 || parts[2] > 59)
+    throw RuntimeError{R"(Unexpected: invalid time of day "{}")"sv, value};
+  return std::chrono::hours{parts[0]} + std::chrono::minutes{parts[1]} + std::chrono::seconds{parts[2]};
+}
+
+// note! the entity must exist (limits are only tracked for accounts and users known at start-up)
+template <typename R>
+R parse_by_entity(
+    auto &node, std::string_view const &table_name, std::string_view const &name, auto const &keys, auto parse_value) {
+  using result_type = std::remove_cvref<R>::type;
+  result_type result;
+  auto parse_helper = [&](auto &node) {
+    if (node.is_table()) {
+      auto &table = *node.as_table();
+      for (auto &[key, value] : table) {
+        std::string key_2{key};
+        if (!keys.contains(key_2))
+          throw RuntimeError{R"(Unexpected: {} for unknown {} "{}")"sv, table_name, name, key_2};
+        if (value.is_table()) {
+          auto &table_2 = *value.as_table();
+          auto item = parse_value(table_2);
+          check_empty(value);
+          result.try_emplace(key_2, std::move(item));
+        } else {
+          throw RuntimeError{R"(Unexpected: "{}" must be a table)"sv, key_2};
+        }
+      }
+    } else {
+      throw RuntimeError{R"(Unexpected: "{}" must be a table)"sv, name};
+    }
+  };
+  // note! optional, the table is removed when empty (accounts and users are parsed separately)
+  if (!node.is_table())
+    return result;
+  auto &table = *node.as_table();
+  auto iter = table.find(table_name);
+  if (iter == table.end())
+    return result;
+  auto &node_2 = (*iter).second;
+  find_and_remove(node_2, name, parse_helper);
+  if (node_2.is_table() && (*node_2.as_table()).empty())
+    table.erase(iter);
+  return result;
+}
+
+template <typename R>
+R parse_loss_limits(auto &node, std::string_view const &name, auto const &keys) {
+  auto parse_value = [](auto &table) {
+    risk::LossLimit result;
+    find_and_remove(table, "max_drawdown"sv, [&](auto &value) { result.max_drawdown = get_value<double>(value); });
+    find_and_remove(table, "max_daily_loss"sv, [&](auto &value) { result.max_daily_loss = get_value<double>(value); });
+    find_and_remove(table, "reset_time"sv, [&](auto &value) {
+      result.reset_time = parse_time_of_day(get_value<std::string>(value));
+    });
+    risk::Drawdown::validate(result);
+    return result;
+  };
+  return parse_by_entity<R>(node, "loss_limits"sv, name, keys, parse_value);
+}
+
+template <typename R>
+R parse_rate_limits(auto &node, std::string_view const &name, auto const &keys) {
+  auto parse_value = [](auto &table) {
+    risk::RateLimit result;
+    find_and_remove(table, "max_fills_per_second"sv, [&](auto &value) {
+      result.max_fills_per_second = get_value<double>(value);
+    });
+    find_and_remove(table, "max_notional_per_minute"sv, [&](auto &value) {
+      result.max_notional_per_minute = get_value<double>(value);
+    });
+    find_and_remove(table, "max_orders_per_minute"sv, [&](auto &value) {
+      result.max_orders_per_minute = get_value<double>(value);
+    });
+    risk::Velocity::validate(result);
+    return result;
+  };
+  return parse_by_entity<R>(node, "rate_limits"sv, name, keys, parse_value);
+}
+
+template <typename R>
+R parse_funds_limits(auto &node, std::string_view const &name, auto const &keys) {
+  auto parse_value = [](auto &table) {
+    risk::FundsLimit result;
+    find_and_remove(table, "currency"sv, [&](auto &value) { result.currency = get_value<std::string>(value); });
+    find_and_remove(table, "leverage"sv, [&](auto &value) { result.leverage = get_value<double>(value); });
+    risk::Capacity::validate(result);
+    return result;
+  };
+  return parse_by_entity<R>(node, "funds_limits"sv, name, keys, parse_value);
+}
+
+// note! positions are only aggregated for accounts, users and strategies known at start-up
+void check_keys(auto const &lhs, auto const &rhs, std::string_view const &name) {
+  auto result = std::size(lhs) == std::size(rhs);
+  for (auto &[key, _] : lhs)
+    result = result && rhs.contains(key);
+  if (!result)
+    throw RuntimeError{R"(Unexpected: {} can't be changed without a restart)"sv, name};
+}
+
+// note! members are only matched when reference data is received, i.e. only the limits of a group can be changed
+void check_groups(auto const &lhs, auto const &rhs) {
+  auto result = std::size(lhs) == std::size(rhs);
+  for (auto &[name, group] : lhs) {
+    auto iter = rhs.find(name);
+    if (iter == std::end(rhs)) {
+      result = false;
+      break;
+    }
+    auto &other = (*iter).second;
+    result = result && group.exchange == other.exchange && group.symbol == other.symbol &&
+             group.underlying == other.underlying && group.base_currency == other.base_currency;
+  }
+  if (!result)
+    throw RuntimeError{"Unexpected: groups can't be changed without a restart (only their limits)"sv};
+}
 }  // namespace
 
 // === IMPLEMENTATION ===
@@ -150,11 +351,27 @@ Config Config::parse_text(std::string_view const &text) {
 
 Config::Config(auto &node)
     : symbols{parse_symbols<decltype(symbols)>(node)}, accounts{parse_limits<decltype(accounts)>(node, "accounts"sv)},
-      users{parse_limits<decltype(accounts)>(node, "users"sv)} {
+      users{parse_limits<decltype(accounts)>(node, "users"sv)}, groups{parse_groups<decltype(groups)>(node)},
+      loss_limits_by_account{parse_loss_limits<decltype(loss_limits_by_account)>(node, "accounts"sv, accounts)},
+      loss_limits_by_user{parse_loss_limits<decltype(loss_limits_by_user)>(node, "users"sv, users)},
+      rate_limits_by_account{parse_rate_limits<decltype(rate_limits_by_account)>(node, "accounts"sv, accounts)},
+      rate_limits_by_user{parse_rate_limits<decltype(rate_limits_by_user)>(node, "users"sv, users)},
+      funds_limits_by_account{parse_funds_limits<decltype(funds_limits_by_account)>(node, "accounts"sv, accounts)} {
   check_empty(node);
   log::debug("config={}"sv, *this);
 }
 
+void Config::check_reload(Config const &config) const {
+  if (config.symbols != symbols)
+    throw RuntimeError{"Unexpected: symbols can't be changed without a restart"sv};
+  check_keys(config.accounts, accounts, "accounts"sv);
+  check_keys(config.users, users, "users"sv);
+  check_keys(config.strategies, strategies, "strategies"sv);
+  check_keys(config.loss_limits_by_account, loss_limits_by_account, "loss limits (accounts)"sv);
+  check_keys(config.loss_limits_by_user, loss_limits_by_user, "loss limits (users)"sv);
+  check_groups(config.groups, groups);
+}
+
 void Config::dispatch(Handler &handler) const {
   // accounts
   for (auto &[name, _] : accounts) {
@@ -13,7 +13,11 @@
 
 #include "roq/client/config.hpp"
 
+#include "roq/risk_manager/risk/funds_limit.hpp"
+#include "roq/risk_manager/risk/group.hpp"
 #include "roq/risk_manager/risk/limit.hpp"
+#include "roq/risk_manager/risk/loss_limit.hpp"
+#include "roq/risk_manager/risk/rate_limit.hpp"
 
 namespace roq {
 namespace risk_manager {
@@ -39,6 +43,27 @@ struct Config final : public client::Config {
   absl::flat_hash_map<uint32_t, absl::flat_hash_map<std::string, absl::flat_hash_map<std::string, risk::Limit>>> const
       strategies;
 
+  // group => group (instruments sharing an underlying)
+  absl::flat_hash_map<std::string, risk::Group> const groups;
+
+  // account => loss limit
+  absl::flat_hash_map<std::string, risk::LossLimit> const loss_limits_by_account;
+
+  // user => loss limit
+  absl::flat_hash_map<std::string, risk::LossLimit> const loss_limits_by_user;
+
+  // account => rate limit
+  absl::flat_hash_map<std::string, risk::RateLimit> const rate_limits_by_account;
+
+  // user => rate limit
+  absl::flat_hash_map<std::string, risk::RateLimit> const rate_limits_by_user;
+
+  // account => funds limit
+  absl::flat_hash_map<std::string, risk::FundsLimit> const funds_limits_by_account;
+
+  // note! throws if the config can't be applied without a restart (only limits can be changed by a reload)
+  void check_reload(Config const &) const;
+
   template <typename Context>
   auto format_to(Context &context) const {
     using namespace fmt::literals;
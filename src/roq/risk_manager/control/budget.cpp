@@ -0,0 +1,62 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include "roq/risk_manager/control/budget.hpp"
+
+#include "roq/api.hpp"
+#include "roq/exceptions.hpp"
+
+using namespace std::literals;
+
+namespace roq {
+namespace risk_manager {
+namespace control {
+
+// === HELPERS ===
+
+namespace {
+auto get_deadline(auto timeout) {
+  if (timeout.count() == 0)
+    return std::chrono::nanoseconds::max();
+  return clock::get_system() + timeout;
+}
+}  // namespace
+
+// === IMPLEMENTATION ===
+
+Budget::Budget(
+    std::chrono::nanoseconds timeout,
+    size_t max_rows,
+    std::atomic<bool> const &cancelled,
+    std::atomic<bool> const &stop)
+    : deadline_{get_deadline(timeout)}, max_rows_{max_rows}, cancelled_{cancelled}, stop_{stop} {
+}
+
+bool Budget::exceeded() const {
+  return !std::empty(reason());
+}
+
+std::string_view Budget::reason() const {
+  if (stop_.load(std::memory_order_relaxed))
+    return "shutdown"sv;
+  if (cancelled_.load(std::memory_order_relaxed))
+    return "cancelled"sv;
+  if (max_rows_ && rows_ > max_rows_)
+    return "too many rows"sv;
+  if (deadline_ < clock::get_system())
+    return "timeout"sv;
+  return {};
+}
+
+database::Interrupt Budget::interrupt() const {
+  return [this]() { return exceeded(); };
+}
+
+void Budget::count(size_t rows) {
+  rows_ += rows;
+  if (max_rows_ && rows_ > max_rows_) [[unlikely]]
+    throw RuntimeError{"Unexpected: exceeded max_rows={}"sv, max_rows_};
+}
+
+}  // namespace control
+}  // namespace risk_manager
+}  // namespace roq
@@ -0,0 +1,50 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <string_view>
+
+#include "roq/risk_manager/database/interrupt.hpp"
+
+namespace roq {
+namespace risk_manager {
+namespace control {
+
+// note!
+//   bounds the time (and number of rows) a single request may spend in the database
+//   the clock starts when a worker thread begins executing the query
+
+struct Budget final {
+  Budget(
+      std::chrono::nanoseconds timeout,
+      size_t max_rows,
+      std::atomic<bool> const &cancelled,
+      std::atomic<bool> const &stop);
+
+  Budget(Budget &&) = delete;
+  Budget(Budget const &) = delete;
+
+  bool exceeded() const;
+
+  // note! empty when not exceeded
+  std::string_view reason() const;
+
+  // note! passed to the database, checked periodically by the thread executing the query
+  database::Interrupt interrupt() const;
+
+  // note! throws when the row limit has been exceeded
+  void count(size_t rows = 1);
+
+ private:
+  std::chrono::nanoseconds const deadline_;
+  size_t const max_rows_;
+  std::atomic<bool> const &cancelled_;
+  std::atomic<bool> const &stop_;
+  size_t rows_ = {};
+};
+
+}  // namespace control
+}  // namespace risk_manager
+}  // namespace roq
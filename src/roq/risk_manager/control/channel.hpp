@@ -0,0 +1,104 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+#include "roq/risk_manager/database/trade.hpp"
+
+#include "roq/risk_manager/control/queue.hpp"
+#include "roq/risk_manager/control/snapshot.hpp"
+#include "roq/risk_manager/control/trade.hpp"
+
+namespace roq {
+namespace risk_manager {
+namespace control {
+
+// engine => control thread hand-off
+// - trades are counted when pushed (engine thread) and when popped (control thread)
+// - a snapshot records the number of trades pushed before it was published
+// - the control thread must load the snapshot *before* draining, all trades included by the snapshot have then been
+//   popped (draining first allows the engine to publish a newer snapshot in-between)
+// - snapshots and prices share the version counter, i.e. the latest version of either identifies the cached encoding
+// - snapshots and prices are swapped under a mutex (only the pointer, the previous one is released outside the lock)
+
+struct Channel final {
+  explicit Channel(size_t capacity)
+      : queue_{capacity}, snapshot_{std::make_shared<Snapshot const>()}, prices_{std::make_shared<Prices const>()} {}
+
+  Channel(Channel &&) = delete;
+  Channel(Channel const &) = delete;
+
+  // engine thread
+
+  // note! returns false if the queue is full (the trade is dropped)
+  bool operator()(database::Trade const &trade) {
+    auto callback = [&](auto &item) { item = trade; };
+    if (!queue_.push(callback)) [[unlikely]]
+      return false;
+    ++push_count_;
+    return true;
+  }
+
+  void operator()(Snapshot &&snapshot) {
+    snapshot.trade_count = push_count_;
+    snapshot.version = ++version_;
+    std::shared_ptr<Snapshot const> tmp = std::make_shared<Snapshot const>(std::move(snapshot));
+    std::lock_guard lock{mutex_};
+    snapshot_.swap(tmp);
+  }
+
+  void operator()(Prices &&prices) {
+    prices.version = ++version_;
+    std::shared_ptr<Prices const> tmp = std::make_shared<Prices const>(std::move(prices));
+    std::lock_guard lock{mutex_};
+    prices_.swap(tmp);
+  }
+
+  // any thread (the snapshot and the prices are immutable)
+
+  std::shared_ptr<Snapshot const> get_snapshot() const {
+    std::lock_guard lock{mutex_};
+    return snapshot_;
+  }
+
+  std::shared_ptr<Prices const> get_prices() const {
+    std::lock_guard lock{mutex_};
+    return prices_;
+  }
+
+  // control thread
+
+  template <typename Callback>
+  size_t drain(Callback callback) {
+    auto callback_2 = [&](Trade const &item) {
+      ++pop_count_;
+      callback(item);
+    };
+    return queue_.pop_all(callback_2);
+  }
+
+  uint64_t pop_count() const { return pop_count_; }
+
+  // note! number of trades popped after the snapshot was taken (the snapshot must have been loaded before draining)
+  uint64_t get_lag(Snapshot const &snapshot) const {
+    assert(pop_count_ >= snapshot.trade_count);
+    return pop_count_ - snapshot.trade_count;
+  }
+
+ private:
+  Queue<Trade> queue_;
+  uint64_t push_count_ = {};  // note! engine thread
+  uint64_t version_ = {};     // note! engine thread
+  uint64_t pop_count_ = {};   // note! control thread
+  mutable std::mutex mutex_;
+  std::shared_ptr<Snapshot const> snapshot_;  // note! protected by the mutex
+  std::shared_ptr<Prices const> prices_;      // note! protected by the mutex
+};
+
+}  // namespace control
+}  // namespace risk_manager
+}  // namespace roq
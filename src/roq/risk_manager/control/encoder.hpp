@@ -0,0 +1,157 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include <fmt/format.h>
+
+#include <cmath>
+#include <string>
+
+#include "roq/json/number.hpp"
+#include "roq/json/string.hpp"
+
+#include "roq/risk_manager/database/limit.hpp"
+#include "roq/risk_manager/database/position.hpp"
+#include "roq/risk_manager/database/trade.hpp"
+
+#include "roq/risk_manager/control/snapshot.hpp"
+
+namespace roq {
+namespace risk_manager {
+namespace control {
+
+// note! shared between rest responses and ws messages
+
+struct Encoder final {
+  template <typename Context>
+  static void encode(Context context, database::Trade const &trade) {
+    using namespace std::literals;
+    fmt::format_to(
+        context,
+        R"({{)"
+        R"("user":{},)"
+        R"("strategy_id":{},)"
+        R"("account":{},)"
+        R"("exchange":{},)"
+        R"("symbol":{},)"
+        R"("side":{},)"
+        R"("quantity":{},)"
+        R"("price":{},)"
+        R"("exchange_time_utc":{},)"
+        R"("external_account":{},)"
+        R"("external_order_id":{},)"
+        R"("external_trade_id":{})"
+        R"(}})"sv,
+        json::String{trade.user},
+        trade.strategy_id,
+        json::String{trade.account},
+        json::String{trade.exchange},
+        json::String{trade.symbol},
+        json::String{trade.side},
+        json::Number{trade.quantity},  // XXX TODO precision
+        json::Number{trade.price},     // XXX TODO precision
+        trade.exchange_time_utc.count(),
+        json::String{trade.external_account},
+        json::String{trade.external_order_id},
+        json::String{trade.external_trade_id});
+  }
+
+  template <typename Context>
+  static void encode(Context context, database::Position const &position) {
+    using namespace std::literals;
+    fmt::format_to(
+        context,
+        R"({{)"
+        R"("user":{},)"
+        R"("strategy_id":{},)"
+        R"("account":{},)"
+        R"("exchange":{},)"
+        R"("symbol":{},)"
+        R"("long_quantity":{},)"
+        R"("short_quantity":{},)"
+        R"("exchange_time_utc":{})"
+        R"(}})"sv,
+        json::String{position.user},
+        position.strategy_id,
+        json::String{position.account},
+        json::String{position.exchange},
+        json::String{position.symbol},
+        json::Number{position.long_quantity},   // XXX TODO precision
+        json::Number{position.short_quantity},  // XXX TODO precision
+        position.exchange_time_utc.count());
+  }
+
+  // note! nan (unknown) is encoded as null, unrealized pnl is marked to the prices
+  template <typename Context>
+  static void encode(Context context, Snapshot::Position const &position, Prices const &prices) {
+    using namespace std::literals;
+    auto value = [](double value) { return std::isnan(value) ? "null"s : fmt::format("{}"sv, json::Number{value}); };
+    fmt::format_to(
+        context,
+        R"({{)"
+        R"("user":{},)"
+        R"("strategy_id":{},)"
+        R"("account":{},)"
+        R"("exchange":{},)"
+        R"("symbol":{},)"
+        R"("long_quantity":{},)"
+        R"("short_quantity":{},)"
+        R"("exchange_time_utc":{},)"
+        R"("average_price":{},)"
+        R"("realized_pnl":{},)"
+        R"("unrealized_pnl":{},)"
+        R"("fees":{})"
+        R"(}})"sv,
+        json::String{position.user},
+        position.strategy_id,
+        json::String{position.account},
+        json::String{position.exchange},
+        json::String{position.symbol},
+        json::Number{position.long_quantity},   // XXX TODO precision
+        json::Number{position.short_quantity},  // XXX TODO precision
+        position.exchange_time_utc.count(),
+        value(position.average_price),
+        value(position.realized_pnl),
+        value(position.get_unrealized_pnl(prices)),
+        value(position.fees));
+  }
+
+  // note! nan (no limit) is encoded as null
+  template <typename Context>
+  static void encode(Context context, database::Limit const &limit) {
+    using namespace std::literals;
+    auto value = [](double value) { return std::isnan(value) ? "null"s : fmt::format("{}"sv, json::Number{value}); };
+    fmt::format_to(
+        context,
+        R"({{)"
+        R"("user":{},)"
+        R"("strategy_id":{},)"
+        R"("account":{},)"
+        R"("exchange":{},)"
+        R"("symbol":{},)"
+        R"("long_position_limit":{},)"
+        R"("short_position_limit":{},)"
+        R"("long_risk_exposure_limit":{},)"
+        R"("short_risk_exposure_limit":{},)"
+        R"("allow_netting":{},)"
+        R"("version":{},)"
+        R"("update_time_utc":{})"
+        R"(}})"sv,
+        json::String{limit.user},
+        limit.strategy_id,
+        json::String{limit.account},
+        json::String{limit.exchange},
+        json::String{limit.symbol},
+        value(limit.long_position_limit),
+        value(limit.short_position_limit),
+        value(limit.long_risk_exposure_limit),
+        value(limit.short_risk_exposure_limit),
+        limit.allow_netting,
+        limit.version,
+        limit.update_time_utc.count());
+  }
+};
+
+}  // namespace control
+}  // namespace risk_manager
+}  // namespace roq
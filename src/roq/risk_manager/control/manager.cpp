@@ -2,6 +2,7 @@
 
 #include "roq/risk_manager/control/manager.hpp"
 
+#include <algorithm>
 #include <charconv>
 #include <filesystem>
 
@@ -20,7 +21,8 @@ namespace control {
 
 namespace {
 auto const CLEANUP_FREQUENCY = 1s;
-}
+auto const DRAIN_FREQUENCY = 1ms;
+}  // namespace
 
 // === HELPERS ===
 
@@ -39,6 +41,13 @@ auto create_network_address(auto &settings) {
     log::info(R"(Created path="{}")"sv, directory.c_str());
   return io::NetworkAddress{address};
 }
+
+// note! errors are ignored (the file may be in the process of being replaced)
+auto get_last_write_time(auto &path) {
+  std::error_code error_code;
+  auto result = std::filesystem::last_write_time(path, error_code);
+  return error_code ? std::filesystem::file_time_type{} : result;
+}
 }  // namespace
 
 // === IMPLEMENTATION ===
@@ -47,28 +56,68 @@ Manager::Manager(
     Handler &handler,
     Settings const &settings,
     io::Context &context,
-    risk_manager::Shared const &shared_2,
-    database::Session &database)
-    : handler_{handler}, listener_{context.create_tcp_listener(*this, create_network_address(settings))},
-      shared_{settings}, shared_2_{shared_2}, database_{database} {
+    database::Session &database,
+    metrics::Metrics &metrics,
+    trace::Tracer &tracer)
+    : handler_{handler}, context_{context},
+      listener_{context_.create_tcp_listener(*this, create_network_address(settings))},
+      timer_{context_.create_timer(*this, DRAIN_FREQUENCY)}, shared_{settings, metrics, tracer}, database_{database},
+      channel_{settings.control_queue_capacity}, stream_{settings.control_stream_capacity}, config_file_{settings.config_file},
+      config_reload_interval_{settings.config_reload_interval},
+      config_last_write_time_{get_last_write_time(config_file_)},
+      workers_{settings.control_worker_threads, settings.control_query_timeout, settings.control_query_max_rows},
+      thread_{[this]() { run(); }} {
 }
 
-void Manager::operator()(Event<Timer> const &event) {
-  auto now = event.value.now;
-  if (next_cleanup_ < now) {
-    next_cleanup_ = now + CLEANUP_FREQUENCY;
-    remove_zombies();
-  }
+Manager::~Manager() {
+  stop_.store(true, std::memory_order_release);
+  if (thread_.joinable())
+    thread_.join();
 }
 
+// note! engine thread
+
 void Manager::operator()(database::Trade const &trade) {
-  if (std::empty(subscribers_))
+  if (!channel_(trade)) [[unlikely]] {
+    // note! the control thread will force all clients to re-synchronize
+    queue_overflow_.store(true, std::memory_order_release);
+  }
+}
+
+void Manager::operator()(Snapshot &&snapshot) {
+  channel_(std::move(snapshot));
+}
+
+void Manager::operator()(Prices &&prices) {
+  channel_(std::move(prices));
+}
+
+// note! control thread from here
+
+void Manager::run() {
+  log::info("Control thread has started"sv);
+  (*timer_).resume();
+  context_.dispatch();
+  log::info("Control thread has stopped"sv);
+}
+
+// io::sys::Timer::Handler
+
+void Manager::operator()(io::sys::Timer::Event const &event) {
+  if (stop_.load(std::memory_order_acquire)) [[unlikely]] {
+    context_.stop();
     return;
-  // XXX TODO lift json encoding out from Session and do it once here
-  for (auto session_id : subscribers_) {
-    auto iter = sessions_.find(session_id);
-    if (iter != std::end(sessions_))
-      (*(*iter).second)(trade);
+  }
+  drain();
+  dispatch_results();
+  auto now = event.now;
+  if (next_cleanup_ < now) {
+    next_cleanup_ = now + CLEANUP_FREQUENCY;
+    remove_zombies();
+  }
+  if (config_reload_interval_.count() && next_config_check_ < now) {
+    next_config_check_ = now + config_reload_interval_;
+    check_config();
   }
 }
 
@@ -76,7 +125,7 @@ void Manager::operator()(database::Trade const &trade) {
 
 void Manager::operator()(io::net::tcp::Connection::Factory &factory) {
   auto session_id = ++next_session_id_;
-  auto session = std::make_unique<Session>(*this, session_id, factory, shared_, shared_2_, database_);
+  auto session = std::make_unique<Session>(*this, session_id, factory, shared_, database_);
   sessions_.emplace(session_id, std::move(session));
 }
 
@@ -93,9 +142,75 @@ void Manager::operator()(Session::Disconnected const &disconnected) {
 }
 
 void Manager::operator()(Session::Upgraded const &upgraded) {
+  auto iter = sessions_.find(upgraded.session_id);
+  if (iter == std::end(sessions_))
+    return;  // XXX should never happen
+  resume(*(*iter).second, upgraded.resume_from);
   subscribers_.emplace(upgraded.session_id);
 }
 
+void Manager::operator()(Query &&query) {
+  workers_(std::move(query));
+}
+
+// note! worker thread
+void Manager::operator()(Reload const &reload) {
+  handler_(reload);
+}
+
+// note! worker thread
+bool Manager::operator()(std::span<database::Limit const> const &limits) {
+  return handler_(limits);
+}
+
+// note! any thread (the snapshot is immutable)
+std::shared_ptr<Snapshot const> Manager::get_snapshot() const {
+  return channel_.get_snapshot();
+}
+
+// note! any thread (the prices are immutable)
+std::shared_ptr<Prices const> Manager::get_prices() const {
+  return channel_.get_prices();
+}
+
+// utilities
+
+void Manager::drain() {
+  if (queue_overflow_.exchange(false, std::memory_order_acq_rel)) [[unlikely]] {
+    log::warn("Queue overflow detected: dropping {} subscriber(s)"sv, std::size(subscribers_));
+    ++shared_.metrics.websocket_queue_overflow;
+    stream_.reset();
+    auto subscribers = std::move(subscribers_);  // note! close may trigger a callback
+    subscribers_.clear();
+    for (auto session_id : subscribers) {
+      auto iter = sessions_.find(session_id);
+      if (iter != std::end(sessions_))
+        (*(*iter).second).close();
+    }
+  }
+  auto callback = [&](Trade const &item) {
+    auto message = stream_(static_cast<database::Trade>(item));  // note! sequenced and encoded once
+    for (auto session_id : subscribers_) {
+      auto iter = sessions_.find(session_id);
+      if (iter != std::end(sessions_))
+        (*(*iter).second).send(message);
+    }
+  };
+  auto count = channel_.drain(callback);
+  if (count)
+    shared_.metrics.websocket_queue_depth(count);
+  shared_.metrics.websocket_subscribers.set(std::size(subscribers_));
+}
+
+void Manager::dispatch_results() {
+  auto callback = [&](Result const &result) {
+    auto iter = sessions_.find(result.session_id);
+    if (iter != std::end(sessions_))
+      (*(*iter).second).send(result);
+  };
+  workers_.pop_all(callback);
+}
+
 void Manager::remove_zombies() {
   auto count = std::size(zombies_);
   if (count == 0)
@@ -106,6 +221,58 @@ void Manager::remove_zombies() {
   log::info("Removed {} zombied session(s) (remaining: {})"sv, count, std::size(sessions_));
 }
 
+// note! the config is parsed by a worker thread (there is no session waiting for the result)
+void Manager::check_config() {
+  auto last_write_time = get_last_write_time(config_file_);
+  if (last_write_time == config_last_write_time_)
+    return;
+  config_last_write_time_ = last_write_time;
+  log::info(R"(Detected a modified config file="{}")"sv, config_file_);
+  auto execute = [this](Response &response, Budget &) {
+    auto reload = Reload{
+        .reason = "modified"sv,
+    };
+    (*this)(reload);
+    response(web::http::Status::OK, web::http::ContentType::APPLICATION_JSON, R"({{"success":{}}})"sv, true);
+  };
+  auto query = Query{
+      .session_id = {},
+      .connection = {},
+      .cancelled = std::make_shared<std::atomic<bool>>(false),
+      .execute = std::move(execute),
+  };
+  workers_(std::move(query));
+}
+
+// note!
+//   reconnecting clients are served from memory (ring or cached snapshot), never from the database
+//   the snapshot may lag the stream (published once per tick) => the client catches up from the ring
+void Manager::resume(Session &session, uint64_t resume_from) {
+  // note! loaded before draining, i.e. the stream never lags the snapshot
+  auto snapshot = get_snapshot();
+  auto prices = get_prices();
+  drain();
+  auto callback = [&](auto const &message) { session.send(message); };
+  if (resume_from) {
+    if (stream_.get_messages_after(resume_from, callback)) {
+      log::info("Resumed from seqno={} (current: {})"sv, resume_from, stream_.seqno());
+      return;
+    }
+    log::info("Unable to resume from seqno={} (current: {}), sending snapshot"sv, resume_from, stream_.seqno());
+  }
+  auto seqno = stream_.seqno() - channel_.get_lag(*snapshot);
+  auto generator = [&](auto &callback) {
+    for (auto &item : (*snapshot).positions)
+      callback(item, *prices);
+  };
+  auto version = std::max((*snapshot).version, (*prices).version);
+  session.send(stream_.get_snapshot(seqno, version, generator));
+  if (!stream_.get_messages_after(seqno, callback)) {
+    log::warn("Snapshot is too old (seqno={}, current: {}), please retry"sv, seqno, stream_.seqno());
+    session.close();
+  }
+}
+
 }  // namespace control
 }  // namespace risk_manager
 }  // namespace roq
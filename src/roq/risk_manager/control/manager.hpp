@@ -5,8 +5,14 @@
 #include <absl/container/flat_hash_map.h>
 #include <absl/container/flat_hash_set.h>
 
+#include <atomic>
+#include <chrono>
+#include <filesystem>
 #include <functional>
 #include <memory>
+#include <span>
+#include <string>
+#include <thread>
 
 #include "roq/api.hpp"
 
@@ -14,31 +20,63 @@
 
 #include "roq/io/net/tcp/listener.hpp"
 
+#include "roq/io/sys/timer.hpp"
+
 #include "roq/risk_manager/settings.hpp"
-#include "roq/risk_manager/shared.hpp"
 
 #include "roq/risk_manager/database/session.hpp"
 
+#include "roq/risk_manager/metrics/metrics.hpp"
+
+#include "roq/risk_manager/trace/tracer.hpp"
+
+#include "roq/risk_manager/control/channel.hpp"
+#include "roq/risk_manager/control/reload.hpp"
 #include "roq/risk_manager/control/session.hpp"
 #include "roq/risk_manager/control/shared.hpp"
+#include "roq/risk_manager/control/snapshot.hpp"
+#include "roq/risk_manager/control/stream.hpp"
+#include "roq/risk_manager/control/trade.hpp"
+#include "roq/risk_manager/control/workers.hpp"
 
 namespace roq {
 namespace risk_manager {
 namespace control {
 
-struct Manager final : public Session::Handler, public io::net::tcp::Listener::Handler {
-  struct Handler {};
+// note!
+//   the manager runs its own event loop (the io::Context) on a dedicated thread
+//   the engine thread only ever pushes trades to a queue and publishes immutable snapshots (and prices)
+//   database queries are executed by worker threads, results are dispatched from the control thread
+
+struct Manager final : public Session::Handler,
+                       public io::net::tcp::Listener::Handler,
+                       public io::sys::Timer::Handler {
+  struct Handler {
+    // note! called from a worker thread (must be thread-safe), throws if the config can't be reloaded
+    virtual void operator()(Reload const &) = 0;
+    // note! called from a worker thread (must be thread-safe), returns false if a version check failed
+    virtual bool operator()(std::span<database::Limit const> const &) = 0;
+  };
 
-  Manager(Handler &, Settings const &, io::Context &, risk_manager::Shared const &, database::Session &);
+  Manager(Handler &, Settings const &, io::Context &, database::Session &, metrics::Metrics &, trace::Tracer &);
 
-  Manager(Manager &&) = default;
+  Manager(Manager &&) = delete;
   Manager(Manager const &) = delete;
 
-  void operator()(Event<Timer> const &);
+  ~Manager();
+
+  // note! the following methods must only be called from the engine thread
 
   void operator()(database::Trade const &);
 
+  void operator()(Snapshot &&);
+
+  void operator()(Prices &&);
+
  protected:
+  // io::sys::Timer::Handler
+  void operator()(io::sys::Timer::Event const &) override;
+
   // io::net::tcp::Listener::Handler
   void operator()(io::net::tcp::Connection::Factory &) override;
   void operator()(io::net::tcp::Connection::Factory &, io::NetworkAddress const &) override;
@@ -46,23 +84,54 @@ struct Manager final : public Session::Handler, public io::net::tcp::Listener::H
   // Session::Handler
   void operator()(Session::Disconnected const &) override;
   void operator()(Session::Upgraded const &) override;
+  void operator()(Query &&) override;
+  void operator()(Reload const &) override;
+  bool operator()(std::span<database::Limit const> const &) override;
+  std::shared_ptr<Snapshot const> get_snapshot() const override;
+  std::shared_ptr<Prices const> get_prices() const override;
+
+  void run();
+
+  void drain();
+
+  void dispatch_results();
 
   void remove_zombies();
 
+  void check_config();
+
+  void resume(Session &, uint64_t resume_from);
+
  private:
   Handler &handler_;
   // io
+  io::Context &context_;
   std::unique_ptr<io::net::tcp::Listener> listener_;
+  std::unique_ptr<io::sys::Timer> timer_;
   // shared
   Shared shared_;
-  risk_manager::Shared const &shared_2_;
   database::Session &database_;
+  // engine => control
+  Channel channel_;
+  std::atomic<bool> queue_overflow_ = {};
+  // stream
+  Stream stream_;
   // sessions
   uint64_t next_session_id_ = {};
   absl::flat_hash_map<uint64_t, std::unique_ptr<Session>> sessions_;
   absl::flat_hash_set<uint64_t> subscribers_;
   std::chrono::nanoseconds next_cleanup_ = {};
   absl::flat_hash_set<uint64_t> zombies_;
+  // config
+  std::string const config_file_;
+  std::chrono::nanoseconds const config_reload_interval_;
+  std::filesystem::file_time_type config_last_write_time_ = {};
+  std::chrono::nanoseconds next_config_check_ = {};
+  // database
+  Workers workers_;
+  // thread
+  std::atomic<bool> stop_ = {};
+  std::thread thread_;  // note! must be last
 };
 
 }  // namespace control
@@ -0,0 +1,29 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+
+#include "roq/web/http/connection.hpp"
+
+#include "roq/risk_manager/control/budget.hpp"
+#include "roq/risk_manager/control/response.hpp"
+
+namespace roq {
+namespace risk_manager {
+namespace control {
+
+// note! execute is called from a worker thread => it must not reference the request (or the session)
+
+struct Query final {
+  uint64_t session_id = {};
+  web::http::Connection connection = {};
+  std::shared_ptr<std::atomic<bool>> cancelled;  // note! set by the session (e.g. when disconnected)
+  std::function<void(Response &, Budget &)> execute;
+};
+
+}  // namespace control
+}  // namespace risk_manager
+}  // namespace roq
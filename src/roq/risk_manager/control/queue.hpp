@@ -0,0 +1,66 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <vector>
+
+namespace roq {
+namespace risk_manager {
+namespace control {
+
+// single-producer single-consumer queue
+// - bounded (capacity is rounded up to a power of two)
+// - slots are re-used => no allocations once the slots have been warmed up
+// - push is wait-free and never blocks the producer (returns false when full)
+
+template <typename T>
+struct Queue final {
+  explicit Queue(size_t capacity) : buffer_(std::bit_ceil(std::max<size_t>(capacity, 2))), mask_{std::size(buffer_) - 1} {}
+
+  Queue(Queue &&) = delete;
+  Queue(Queue const &) = delete;
+
+  size_t capacity() const { return std::size(buffer_); }
+
+  // note! approximate when called from neither producer nor consumer
+  size_t size() const { return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire); }
+
+  // producer
+
+  template <typename Callback>
+  bool push(Callback callback) {
+    auto head = head_.load(std::memory_order_relaxed);
+    if ((head - tail_.load(std::memory_order_acquire)) > mask_)
+      return false;
+    callback(buffer_[head & mask_]);
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  // consumer
+
+  template <typename Callback>
+  size_t pop_all(Callback callback) {
+    auto tail = tail_.load(std::memory_order_relaxed);
+    auto head = head_.load(std::memory_order_acquire);
+    for (auto next = tail; next != head; ++next) {
+      callback(buffer_[next & mask_]);
+      tail_.store(next + 1, std::memory_order_release);
+    }
+    return head - tail;
+  }
+
+ private:
+  std::vector<T> buffer_;
+  size_t const mask_;
+  alignas(64) std::atomic<size_t> head_ = {};
+  alignas(64) std::atomic<size_t> tail_ = {};
+};
+
+}  // namespace control
+}  // namespace risk_manager
+}  // namespace roq
@@ -0,0 +1,19 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include <string_view>
+
+namespace roq {
+namespace risk_manager {
+namespace control {
+
+// note! the config file is parsed (and validated) by a worker thread, the engine applies it on the next timer
+
+struct Reload final {
+  std::string_view reason;  // note! e.g. "request" or "modified"
+};
+
+}  // namespace control
+}  // namespace risk_manager
+}  // namespace roq
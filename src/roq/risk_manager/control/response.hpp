@@ -2,10 +2,12 @@
 
 #pragma once
 
+#include <fmt/format.h>
+
 #include <string>
 #include <string_view>
 
-#include "roq/web/rest/server.hpp"
+#include "roq/risk_manager/control/result.hpp"
 
 namespace roq {
 namespace risk_manager {
@@ -14,7 +16,7 @@ namespace control {
 // helper
 
 struct Response final {
-  Response(web::rest::Server &, web::rest::Server::Request const &, std::string &encode_buffer);
+  explicit Response(Result &);
 
   template <typename... Args>
   inline void operator()(
@@ -22,18 +24,17 @@ struct Response final {
       web::http::ContentType content_type,
       fmt::format_string<Args...> const &fmt,
       Args &&...args) {
-    encode_buffer_.clear();
-    fmt::format_to(std::back_inserter(encode_buffer_), fmt, std::forward<Args>(args)...);
-    send(status, content_type, encode_buffer_);
+    result_.status = status;
+    result_.content_type = content_type;
+    result_.body.clear();
+    fmt::format_to(std::back_inserter(result_.body), fmt, std::forward<Args>(args)...);
   }
 
- protected:
-  void send(web::http::Status, web::http::ContentType, std::string_view const &body);
+  // note! body is not formatted (e.g. binary)
+  void operator()(web::http::Status, web::http::ContentType, std::string &&body);
 
  private:
-  web::rest::Server &server_;
-  web::rest::Server::Request const &request_;
-  std::string &encode_buffer_;
+  Result &result_;
 };
 
 }  // namespace control
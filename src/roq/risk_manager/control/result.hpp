@@ -0,0 +1,25 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include <string>
+
+#include "roq/web/http/connection.hpp"
+#include "roq/web/http/content_type.hpp"
+#include "roq/web/http/status.hpp"
+
+namespace roq {
+namespace risk_manager {
+namespace control {
+
+struct Result final {
+  uint64_t session_id = {};
+  web::http::Connection connection = {};
+  web::http::Status status = {};
+  web::http::ContentType content_type = {};
+  std::string body;
+};
+
+}  // namespace control
+}  // namespace risk_manager
+}  // namespace roq
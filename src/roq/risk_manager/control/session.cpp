@@ -4,6 +4,7 @@
 
 #include <nlohmann/json.hpp>
 
+#include <cassert>
 #include <charconv>
 #include <chrono>
 
@@ -17,6 +18,10 @@
 
 #include "roq/web/rest/server_factory.hpp"
 
+#include "roq/risk_manager/columnar/encoder.hpp"
+
+#include "roq/risk_manager/control/encoder.hpp"
+
 using namespace std::literals;
 
 namespace roq {
@@ -29,22 +34,24 @@ namespace {
 auto const JSONRPC_VERSION = "2.0"sv;
 
 auto const UNKNOWN_METHOD = "UNKNOWN_METHOD"sv;
+
+auto const CACHE_CONTROL_NO_STORE = "no-store"sv;
+
+size_t const EXPORT_ROW_GROUP_SIZE = 65536;
 }  // namespace
 
 // === HELPERS ===
 
 namespace {
 template <typename R>
-R convert_to_timestamp(auto &value) {
+R convert_to_integer(auto &value) {
   using result_type = std::remove_cvref<R>::type;
   if (std::empty(value))
     return {};
-  int64_t result = {};
+  result_type result = {};
   auto [_, error_code] = std::from_chars(std::data(value), std::data(value) + std::size(value), result);
-  if (error_code == std::errc{}) {
-    // XXX TODO: check range
-    return result_type{result};
-  }
+  if (error_code == std::errc{})
+    return result;
   switch (error_code) {
     using namespace std::literals;
     case std::errc::invalid_argument:
@@ -57,36 +64,11 @@ R convert_to_timestamp(auto &value) {
   return {};
 }
 
-template <typename Context>
-void trade_to_json(Context context, database::Trade const &trade) {
-  fmt::format_to(
-      context,
-      R"({{)"
-      R"("user":{},)"
-      R"("strategy_id":{},)"
-      R"("account":{},)"
-      R"("exchange":{},)"
-      R"("symbol":{},)"
-      R"("side":{},)"
-      R"("quantity":{},)"
-      R"("price":{},)"
-      R"("exchange_time_utc":{},)"
-      R"("external_account":{},)"
-      R"("external_order_id":{},)"
-      R"("external_trade_id":{})"
-      R"(}})"sv,
-      json::String{trade.user},
-      trade.strategy_id,
-      json::String{trade.account},
-      json::String{trade.exchange},
-      json::String{trade.symbol},
-      json::String{trade.side},
-      json::Number{trade.quantity},  // XXX TODO precision
-      json::Number{trade.price},     // XXX TODO precision
-      trade.exchange_time_utc.count(),
-      json::String{trade.external_account},
-      json::String{trade.external_order_id},
-      json::String{trade.external_trade_id});
+template <typename R>
+R convert_to_timestamp(auto &value) {
+  using result_type = std::remove_cvref<R>::type;
+  // XXX TODO: check range
+  return result_type{convert_to_integer<int64_t>(value)};
 }
 }  // namespace
 
@@ -97,18 +79,37 @@ Session::Session(
     uint64_t session_id,
     io::net::tcp::Connection::Factory &factory,
     Shared &shared,
-    risk_manager::Shared const &shared_2,
     database::Session &database)
     : handler_{handler}, session_id_{session_id}, server_{web::rest::ServerFactory::create(*this, factory)},
-      shared_{shared}, shared_2_{shared_2}, database_{database} {
+      shared_{shared}, database_{database} {
 }
 
-void Session::operator()(database::Trade const &trade) {
+void Session::send(std::string_view const &message) {
   assert(ready());
-  // XXX TODO clean up
-  std::string message;
-  trade_to_json(std::back_inserter(message), trade);
-  send_text("{}"sv, message);
+  (*server_).send_text(message);
+}
+
+// note! the session may have been disconnected while the query was executing
+void Session::send(Result const &result) {
+  pending_ = false;
+  shared_.metrics[route_].latency(clock::get_system() - request_time_);
+  cancelled_.reset();
+  if (zombie())
+    return;
+  auto connection = [&]() {
+    if (result.status != web::http::Status::OK)  // XXX maybe only close based on category ???
+      return web::http::Connection::CLOSE;
+    return result.connection;
+  }();
+  auto response = web::rest::Server::Response{
+      .status = result.status,
+      .connection = connection,
+      .sec_websocket_accept = {},
+      .cache_control = CACHE_CONTROL_NO_STORE,
+      .content_type = result.content_type,
+      .body = result.body,
+  };
+  (*server_).send(response);
 }
 
 bool Session::ready() const {
@@ -127,6 +128,8 @@ void Session::close() {
 
 void Session::operator()(web::rest::Server::Disconnected const &) {
   state_ = State::ZOMBIE;
+  if (cancelled_)
+    (*cancelled_).store(true, std::memory_order_release);  // note! interrupts the in-flight query
   auto disconnected = Disconnected{
       .session_id = session_id_,
   };
@@ -139,20 +142,26 @@ void Session::operator()(web::rest::Server::Request const &request) {
   try {
     if (request.headers.connection == roq::web::http::Connection::UPGRADE) {
       roq::log::info("Upgrading session_id={} to websocket..."sv, session_id_);
+      uint64_t resume_from = {};
+      for (auto &[key, value] : request.query) {
+        if (key == "resume_from"sv)
+          resume_from = convert_to_integer<uint64_t>(value);
+        else
+          throw RuntimeError{R"(Unexpected: query key="{}" not supported)"sv, key};
+      }
       (*server_).upgrade(request);
       state_ = State::READY;
       auto upgraded = Upgraded{
           .session_id = session_id_,
+          .resume_from = resume_from,
       };
       handler_(upgraded);
     } else {
       auto path = request.path;  // note! url path has already been split
       if (!std::empty(path) && !std::empty(shared_.url_prefix) && path[0] == shared_.url_prefix)
         path = path.subspan(1);  // drop prefix
-      if (!std::empty(path)) {
-        Response response{*server_, request, shared_.encode_buffer};
-        route(response, request, path);
-      }
+      if (!std::empty(path))
+        route(request, path);
     }
     success = true;
   } catch (RuntimeError &e) {
@@ -182,23 +191,37 @@ void Session::operator()(web::rest::Server::Text const &text) {
 void Session::operator()(web::rest::Server::Binary const &) {
 }
 
-void Session::route(
-    Response &response, web::rest::Server::Request const &request, std::span<std::string_view> const &path) {
+void Session::route(web::rest::Server::Request const &request, std::span<std::string_view> const &path) {
   switch (request.method) {
     using enum web::http::Method;
     case GET:
       if (path[0] == "accounts"sv) {
         if (std::size(path) == 1)
-          get_accounts(response, request);
+          get_accounts(request);
       } else if (path[0] == "positions"sv) {
         if (std::size(path) == 1)
-          get_positions(response, request);
+          get_positions(request);
       } else if (path[0] == "trades"sv) {
         if (std::size(path) == 1)
-          get_trades(response, request);
+          get_trades(request);
       } else if (path[0] == "funds"sv) {
         if (std::size(path) == 1)
-          get_funds(response, request);
+          get_funds(request);
+      } else if (path[0] == "backup"sv) {
+        if (std::size(path) == 1)
+          get_backup(request);
+      } else if (path[0] == "export"sv) {
+        if (std::size(path) == 1)
+          get_export(request);
+      } else if (path[0] == "metrics"sv) {
+        if (std::size(path) == 1)
+          get_metrics(request);
+      } else if (path[0] == "limits"sv) {
+        if (std::size(path) == 1)
+          get_limits(request);
+      } else if (path[0] == "pnl"sv) {
+        if (std::size(path) == 1)
+          get_pnl(request);
       }
       break;
     case HEAD:
@@ -208,10 +231,22 @@ void Session::route(
     case PUT:
       if (path[0] == "trade"sv) {
         if (std::size(path) == 1)
-          put_trade(response, request);
+          put_trade(request);
       } else if (path[0] == "compress"sv) {
         if (std::size(path) == 1)
-          put_compress(response, request);
+          put_compress(request);
+      } else if (path[0] == "backup"sv) {
+        if (std::size(path) == 1)
+          put_backup(request);
+      } else if (path[0] == "trace"sv) {
+        if (std::size(path) == 1)
+          put_trace(request);
+      } else if (path[0] == "reload"sv) {
+        if (std::size(path) == 1)
+          put_reload(request);
+      } else if (path[0] == "limits"sv) {
+        if (std::size(path) == 1)
+          put_limits(request);
       }
       break;
     case DELETE:
@@ -227,71 +262,66 @@ void Session::route(
 
 // get
 
-void Session::get_accounts(Response &response, web::rest::Server::Request const &request) {
+void Session::get_accounts(web::rest::Server::Request const &request) {
   if (!std::empty(request.query))
     throw RuntimeError{"Unexpected: query keys not supported"sv};
-  std::string result;  // XXX TODO shared encode buffer
-  auto callback = [&](database::Account const &account) {
-    if (!std::empty(result))
-      fmt::format_to(std::back_inserter(result), ","sv);
-    fmt::format_to(
-        std::back_inserter(result),
-        R"({{)"
-        R"("name":{},)"
-        R"("exchange_time_utc_min":{},)"
-        R"("exchange_time_utc_max":{},)"
-        R"("trade_count":{})"
-        R"(}})"sv,
-        json::String{account.name},
-        account.exchange_time_utc_min.count(),
-        account.exchange_time_utc_max.count(),
-        account.trade_count);
+  auto execute = [&database = database_](Response &response, Budget &budget) {
+    std::string result;
+    auto callback = [&](database::Account const &account) {
+      budget.count();
+      if (!std::empty(result))
+        fmt::format_to(std::back_inserter(result), ","sv);
+      fmt::format_to(
+          std::back_inserter(result),
+          R"({{)"
+          R"("name":{},)"
+          R"("exchange_time_utc_min":{},)"
+          R"("exchange_time_utc_max":{},)"
+          R"("trade_count":{},)"
+          R"("volume":{},)"
+          R"("notional":{},)"
+          R"("duplicate_count":{})"
+          R"(}})"sv,
+          json::String{account.name},
+          account.exchange_time_utc_min.count(),
+          account.exchange_time_utc_max.count(),
+          account.trade_count,
+          json::Number{account.volume},     // XXX TODO precision
+          json::Number{account.notional},  // XXX TODO precision
+          account.duplicate_count);
+    };
+    database(callback, budget.interrupt());
+    if (std::empty(result)) {
+      response(web::http::Status::NOT_FOUND, web::http::ContentType::APPLICATION_JSON, "[]"sv);
+    } else {
+      response(web::http::Status::OK, web::http::ContentType::APPLICATION_JSON, "[{}]"sv, result);
+    }
   };
-  database_(callback);
-  if (std::empty(result)) {
-    response(web::http::Status::NOT_FOUND, web::http::ContentType::APPLICATION_JSON, "[]"sv);
-  } else {
-    response(web::http::Status::OK, web::http::ContentType::APPLICATION_JSON, "[{}]"sv, result);
-  }
+  dispatch(metrics::Route::GET_ACCOUNTS, request, std::move(execute));
 }
 
-void Session::get_positions(Response &response, web::rest::Server::Request const &request) {
+void Session::get_positions(web::rest::Server::Request const &request) {
   if (!std::empty(request.query))
     throw RuntimeError{"Unexpected: query keys not supported"sv};
-  std::string result;  // XXX TODO shared encode buffer
-  auto callback = [&](database::Position const &position) {
-    if (!std::empty(result))
-      fmt::format_to(std::back_inserter(result), ","sv);
-    fmt::format_to(
-        std::back_inserter(result),
-        R"({{)"
-        R"("user":{},)"
-        R"("strategy_id":{},)"
-        R"("account":{},)"
-        R"("exchange":{},)"
-        R"("symbol":{},)"
-        R"("long_quantity":{},)"
-        R"("short_quantity":{},)"
-        R"("exchange_time_utc":{})"
-        R"(}})"sv,
-        json::String{position.user},
-        position.strategy_id,
-        json::String{position.account},
-        json::String{position.exchange},
-        json::String{position.symbol},
-        json::Number{position.long_quantity},   // XXX TODO precision
-        json::Number{position.short_quantity},  // XXX TODO precision
-        position.exchange_time_utc.count());
+  auto execute = [&database = database_](Response &response, Budget &budget) {
+    std::string result;
+    auto callback = [&](database::Position const &position) {
+      budget.count();
+      if (!std::empty(result))
+        fmt::format_to(std::back_inserter(result), ","sv);
+      Encoder::encode(std::back_inserter(result), position);
+    };
+    database(callback, budget.interrupt());
+    if (std::empty(result)) {
+      response(web::http::Status::NOT_FOUND, web::http::ContentType::APPLICATION_JSON, "[]"sv);
+    } else {
+      response(web::http::Status::OK, web::http::ContentType::APPLICATION_JSON, "[{}]"sv, result);
+    }
   };
-  database_(callback);
-  if (std::empty(result)) {
-    response(web::http::Status::NOT_FOUND, web::http::ContentType::APPLICATION_JSON, "[]"sv);
-  } else {
-    response(web::http::Status::OK, web::http::ContentType::APPLICATION_JSON, "[{}]"sv, result);
-  }
+  dispatch(metrics::Route::GET_POSITIONS, request, std::move(execute));
 }
 
-void Session::get_trades(Response &response, web::rest::Server::Request const &request) {
+void Session::get_trades(web::rest::Server::Request const &request) {
   std::string_view account, start_time_as_string;
   for (auto &[key, value] : request.query) {
     log::debug("key={}, value={}"sv, key, value);
@@ -303,21 +333,26 @@ void Session::get_trades(Response &response, web::rest::Server::Request const &r
       throw RuntimeError{R"(Unexpected: query key="{}" not supported)"sv, key};
   }
   auto start_time = convert_to_timestamp<std::chrono::nanoseconds>(start_time_as_string);
-  std::string result;  // XXX TODO shared encode buffer
-  auto callback = [&](database::Trade const &trade) {
-    if (!std::empty(result))
-      fmt::format_to(std::back_inserter(result), ","sv);
-    trade_to_json(std::back_inserter(result), trade);
+  auto execute = [&database = database_, account = std::string{account}, start_time](
+                     Response &response, Budget &budget) {
+    std::string result;
+    auto callback = [&](database::Trade const &trade) {
+      budget.count();
+      if (!std::empty(result))
+        fmt::format_to(std::back_inserter(result), ","sv);
+      Encoder::encode(std::back_inserter(result), trade);
+    };
+    database(callback, account, start_time, budget.interrupt());
+    if (std::empty(result)) {
+      response(web::http::Status::NOT_FOUND, web::http::ContentType::APPLICATION_JSON, "[]"sv);
+    } else {
+      response(web::http::Status::OK, web::http::ContentType::APPLICATION_JSON, "[{}]"sv, result);
+    }
   };
-  database_(callback, account, start_time);
-  if (std::empty(result)) {
-    response(web::http::Status::NOT_FOUND, web::http::ContentType::APPLICATION_JSON, "[]"sv);
-  } else {
-    response(web::http::Status::OK, web::http::ContentType::APPLICATION_JSON, "[{}]"sv, result);
-  }
+  dispatch(metrics::Route::GET_TRADES, request, std::move(execute));
 }
 
-void Session::get_funds(Response &response, web::rest::Server::Request const &request) {
+void Session::get_funds(web::rest::Server::Request const &request) {
   std::string_view account, currency;
   for (auto &[key, value] : request.query) {
     log::debug("key={}, value={}"sv, key, value);
@@ -328,87 +363,246 @@ void Session::get_funds(Response &response, web::rest::Server::Request const &re
     else
       throw RuntimeError{R"(Unexpected: query key="{}" not supported)"sv, key};
   }
-  std::string result;  // XXX TODO shared encode buffer
-  auto callback = [&](database::Funds const &funds) {
-    if (!std::empty(result))
-      fmt::format_to(std::back_inserter(result), ","sv);
-    fmt::format_to(
-        std::back_inserter(result),
-        R"({{)"
-        R"("account":{},)"
-        R"("currency":{},)"
-        R"("balance":{},)"
-        R"("hold":{},)"
-        R"("exchange_time_utc":{},)"
-        R"("external_account":{})"
-        R"(}})"sv,
-        json::String{funds.account},
-        json::String{funds.currency},
-        json::Number{funds.balance},  // XXX TODO precision
-        json::Number{funds.hold},     // XXX TODO precision
-        funds.exchange_time_utc.count(),
-        json::String{funds.external_account});
+  auto execute = [&database = database_, account = std::string{account}, currency = std::string{currency}](
+                     Response &response, Budget &budget) {
+    std::string result;
+    auto callback = [&](database::Funds const &funds) {
+      budget.count();
+      if (!std::empty(result))
+        fmt::format_to(std::back_inserter(result), ","sv);
+      fmt::format_to(
+          std::back_inserter(result),
+          R"({{)"
+          R"("account":{},)"
+          R"("currency":{},)"
+          R"("balance":{},)"
+          R"("hold":{},)"
+          R"("exchange_time_utc":{},)"
+          R"("external_account":{})"
+          R"(}})"sv,
+          json::String{funds.account},
+          json::String{funds.currency},
+          json::Number{funds.balance},  // XXX TODO precision
+          json::Number{funds.hold},     // XXX TODO precision
+          funds.exchange_time_utc.count(),
+          json::String{funds.external_account});
+    };
+    database(callback, account, currency, budget.interrupt());
+    if (std::empty(result)) {
+      response(web::http::Status::NOT_FOUND, web::http::ContentType::APPLICATION_JSON, "[]"sv);
+    } else {
+      response(web::http::Status::OK, web::http::ContentType::APPLICATION_JSON, "[{}]"sv, result);
+    }
   };
-  database_(callback, account, currency);
-  if (std::empty(result)) {
-    response(web::http::Status::NOT_FOUND, web::http::ContentType::APPLICATION_JSON, "[]"sv);
-  } else {
-    response(web::http::Status::OK, web::http::ContentType::APPLICATION_JSON, "[{}]"sv, result);
+  dispatch(metrics::Route::GET_FUNDS, request, std::move(execute));
+}
+
+void Session::get_backup(web::rest::Server::Request const &request) {
+  if (!std::empty(request.query))
+    throw RuntimeError{"Unexpected: query keys not supported"sv};
+  auto execute = [&database = database_](Response &response, Budget &budget) {
+    auto callback = [&](database::BackupStatus const &status) {
+      response(
+          web::http::Status::OK,
+          web::http::ContentType::APPLICATION_JSON,
+          R"({{)"
+          R"("filename":{},)"
+          R"("running":{},)"
+          R"("page_count":{},)"
+          R"("remaining":{},)"
+          R"("start_time_utc":{},)"
+          R"("duration":{},)"
+          R"("backup_count":{},)"
+          R"("error":{})"
+          R"(}})"sv,
+          json::String{status.filename},
+          status.running,
+          status.page_count,
+          status.remaining,
+          status.start_time_utc.count(),
+          status.duration.count(),
+          status.backup_count,
+          json::String{status.error});
+    };
+    database(callback, budget.interrupt());
+  };
+  dispatch(metrics::Route::GET_BACKUP, request, std::move(execute));
+}
+
+// note! streamed from the database, only the (compact) encoded result is buffered
+void Session::get_export(web::rest::Server::Request const &request) {
+  std::string_view type, account, start_time_as_string;
+  for (auto &[key, value] : request.query) {
+    log::debug("key={}, value={}"sv, key, value);
+    if (key == "type"sv)
+      type = value;
+    else if (key == "account"sv)
+      account = value;
+    else if (key == "start_time"sv)
+      start_time_as_string = value;
+    else
+      throw RuntimeError{R"(Unexpected: query key="{}" not supported)"sv, key};
   }
+  auto positions = type == "positions"sv;
+  if (!positions && !std::empty(type) && type != "trades"sv)
+    throw RuntimeError{R"(Unexpected: type="{}" not supported)"sv, type};
+  if (positions && (!std::empty(account) || !std::empty(start_time_as_string)))
+    throw RuntimeError{R"(Unexpected: account and start_time are not supported for positions)"sv};
+  auto start_time = convert_to_timestamp<std::chrono::nanoseconds>(start_time_as_string);
+  auto execute = [&database = database_, positions, account = std::string{account}, start_time](
+                     Response &response, Budget &budget) {
+    std::string result;
+    auto output = [&](auto &data) { result.append(data); };
+    if (positions) {
+      columnar::Writer writer{output, columnar::Encoder::get_positions_schema(), EXPORT_ROW_GROUP_SIZE};
+      auto callback = [&](database::Position const &position) {
+        budget.count();
+        columnar::Encoder::encode(writer, position);
+      };
+      database(callback, budget.interrupt());
+      writer.finish();
+    } else {
+      columnar::Writer writer{output, columnar::Encoder::get_trades_schema(), EXPORT_ROW_GROUP_SIZE};
+      auto callback = [&](database::Trade const &trade) {
+        budget.count();
+        columnar::Encoder::encode(writer, trade);
+      };
+      database(callback, account, start_time, budget.interrupt());
+      writer.finish();
+    }
+    response(web::http::Status::OK, web::http::ContentType::APPLICATION_OCTET_STREAM, std::move(result));
+  };
+  dispatch(metrics::Route::GET_EXPORT, request, std::move(execute));
 }
 
-// put
+// note! duplicates are only known to the database (served from memory)
+void Session::get_metrics(web::rest::Server::Request const &request) {
+  if (!std::empty(request.query))
+    throw RuntimeError{"Unexpected: query keys not supported"sv};
+  auto execute = [&database = database_, &metrics = shared_.metrics](Response &response, Budget &budget) {
+    uint64_t duplicate_count = {};
+    auto callback = [&](database::Account const &account) { duplicate_count += account.duplicate_count; };
+    database(callback, budget.interrupt());
+    std::string result;
+    metrics.encode(result, duplicate_count);
+    response(web::http::Status::OK, web::http::ContentType::TEXT_PLAIN, std::move(result));
+  };
+  dispatch(metrics::Route::GET_METRICS, request, std::move(execute));
+}
 
-void Session::put_trade(Response &response, web::rest::Server::Request const &request) {
-  if (std::empty(request.body)) {
-    // XXX TODO what is a proper response?
-    response(web::http::Status::NOT_FOUND, web::http::ContentType::APPLICATION_JSON, R"({{"success":{}}})"sv, false);
-    return;
+void Session::get_limits(web::rest::Server::Request const &request) {
+  auto history = false;
+  for (auto &[key, value] : request.query) {
+    log::debug("key={}, value={}"sv, key, value);
+    if (key == "history"sv)
+      history = value == "true"sv;
+    else
+      throw RuntimeError{R"(Unexpected: query key="{}" not supported)"sv, key};
   }
-  std::vector<database::Correction> corrections;
-  auto parse_item = [&](auto &item) {
-    database::Correction correction;
-    for (auto &[key, value] : item.items()) {
-      if (key == "user"sv)
-        correction.user = value.template get<std::string_view>();
-      else if (key == "strategy_id"sv)
-        correction.strategy_id = value.template get<uint32_t>();
-      else if (key == "account"sv)
-        correction.account = value.template get<std::string_view>();
-      else if (key == "exchange"sv)
-        correction.exchange = value.template get<std::string_view>();
-      else if (key == "symbol"sv)
-        correction.symbol = value.template get<std::string_view>();
-      else if (key == "side"sv) {
-        auto tmp = value.template get<std::string_view>();
-        correction.side = magic_enum::enum_cast<Side>(tmp).value();
-      } else if (key == "quantity"sv)
-        correction.quantity = value.template get<double>();
-      else if (key == "price"sv)
-        correction.price = value.template get<double>();
-      else if (key == "exchange_time_utc"sv || key == "exchange_time_utc"sv) {
-        // XXX TODO
-        // correction.exchange_time_utc = value.template get<std::string_view>();
-      } else if (key == "reason"sv)
-        correction.reason = value.template get<std::string_view>();
-      else
-        throw RuntimeError{R"(Unexpected: json key="{}" not supported)"sv, key};
+  auto execute = [&database = database_, history](Response &response, Budget &budget) {
+    std::string result;
+    auto callback = [&](database::Limit const &limit) {
+      budget.count();
+      if (!std::empty(result))
+        fmt::format_to(std::back_inserter(result), ","sv);
+      Encoder::encode(std::back_inserter(result), limit);
+    };
+    database(callback, history, budget.interrupt());
+    if (std::empty(result)) {
+      response(web::http::Status::NOT_FOUND, web::http::ContentType::APPLICATION_JSON, "[]"sv);
+    } else {
+      response(web::http::Status::OK, web::http::ContentType::APPLICATION_JSON, "[{}]"sv, result);
     }
-    // XXX TODO validation? ... or maybe database should validate?
-    corrections.emplace_back(std::move(correction));
   };
-  auto json = nlohmann::json::parse(request.body);
-  if (json.is_array()) {
-    for (auto item : json)  // XXX not sure if reference would work here...
-      parse_item(item);
-  } else {
-    parse_item(json);
+  dispatch(metrics::Route::GET_LIMITS, request, std::move(execute));
+}
+
+// note! served from the latest snapshot (no database query), marked to the latest prices
+void Session::get_pnl(web::rest::Server::Request const &request) {
+  std::string_view account;
+  for (auto &[key, value] : request.query) {
+    log::debug("key={}, value={}"sv, key, value);
+    if (key == "account"sv)
+      account = value;
+    else
+      throw RuntimeError{R"(Unexpected: query key="{}" not supported)"sv, key};
   }
-  database_(corrections);
-  response(web::http::Status::OK, web::http::ContentType::APPLICATION_JSON, R"({{"success":{}}})"sv, true);
+  auto execute = [snapshot = handler_.get_snapshot(), prices = handler_.get_prices(), account = std::string{account}](
+                     Response &response, Budget &budget) {
+    std::string result;
+    for (auto &item : (*snapshot).positions) {
+      if (!std::empty(account) && item.account != account)
+        continue;
+      budget.count();
+      if (!std::empty(result))
+        fmt::format_to(std::back_inserter(result), ","sv);
+      Encoder::encode(std::back_inserter(result), item, *prices);
+    }
+    if (std::empty(result)) {
+      response(web::http::Status::NOT_FOUND, web::http::ContentType::APPLICATION_JSON, "[]"sv);
+    } else {
+      response(web::http::Status::OK, web::http::ContentType::APPLICATION_JSON, "[{}]"sv, result);
+    }
+  };
+  dispatch(metrics::Route::GET_PNL, request, std::move(execute));
+}
+
+// put
+
+// note! the request body is parsed by the worker thread
+void Session::put_trade(web::rest::Server::Request const &request) {
+  auto execute = [&database = database_, body = std::string{request.body}](Response &response, Budget &) {
+    if (std::empty(body)) {
+      // XXX TODO what is a proper response?
+      response(web::http::Status::NOT_FOUND, web::http::ContentType::APPLICATION_JSON, R"({{"success":{}}})"sv, false);
+      return;
+    }
+    std::vector<database::Correction> corrections;
+    auto parse_item = [&](auto &item) {
+      database::Correction correction;
+      for (auto &[key, value] : item.items()) {
+        if (key == "user"sv)
+          correction.user = value.template get<std::string_view>();
+        else if (key == "strategy_id"sv)
+          correction.strategy_id = value.template get<uint32_t>();
+        else if (key == "account"sv)
+          correction.account = value.template get<std::string_view>();
+        else if (key == "exchange"sv)
+          correction.exchange = value.template get<std::string_view>();
+        else if (key == "symbol"sv)
+          correction.symbol = value.template get<std::string_view>();
+        else if (key == "side"sv) {
+          auto tmp = value.template get<std::string_view>();
+          correction.side = magic_enum::enum_cast<Side>(tmp).value();
+        } else if (key == "quantity"sv)
+          correction.quantity = value.template get<double>();
+        else if (key == "price"sv)
+          correction.price = value.template get<double>();
+        else if (key == "exchange_time_utc"sv || key == "exchange_time_utc"sv) {
+          // XXX TODO
+          // correction.exchange_time_utc = value.template get<std::string_view>();
+        } else if (key == "reason"sv)
+          correction.reason = value.template get<std::string_view>();
+        else
+          throw RuntimeError{R"(Unexpected: json key="{}" not supported)"sv, key};
+      }
+      // XXX TODO validation? ... or maybe database should validate?
+      corrections.emplace_back(std::move(correction));
+    };
+    auto json = nlohmann::json::parse(body);
+    if (json.is_array()) {
+      for (auto item : json)  // XXX not sure if reference would work here...
+        parse_item(item);
+    } else {
+      parse_item(json);
+    }
+    database(corrections);
+    response(web::http::Status::OK, web::http::ContentType::APPLICATION_JSON, R"({{"success":{}}})"sv, true);
+  };
+  dispatch(metrics::Route::PUT_TRADE, request, std::move(execute));
 }
 
-void Session::put_compress(Response &response, web::rest::Server::Request const &request) {
+void Session::put_compress(web::rest::Server::Request const &request) {
   std::string_view end_time_as_string;
   for (auto &[key, value] : request.query) {
     log::debug("key={}, value={}"sv, key, value);
@@ -431,13 +625,161 @@ void Session::put_compress(Response &response, web::rest::Server::Request const
   if (std::empty(end_time_as_string))
     throw RuntimeError{R"(Unexpected: no timestamp)"sv};
   auto exchange_time_utc = convert_to_timestamp<std::chrono::nanoseconds>(end_time_as_string);
-  auto compress = database::Compress{
-      .exchange_time_utc = exchange_time_utc,
+  auto execute = [&database = database_, exchange_time_utc](Response &response, Budget &) {
+    auto compress = database::Compress{
+        .exchange_time_utc = exchange_time_utc,
+    };
+    database(compress);
+    response(web::http::Status::OK, web::http::ContentType::APPLICATION_JSON, R"({{"success":{}}})"sv, true);
+  };
+  dispatch(metrics::Route::PUT_COMPRESS, request, std::move(execute));
+}
+
+// note! the backup is executed asynchronously, progress is available from GET /backup
+void Session::put_backup(web::rest::Server::Request const &request) {
+  std::string_view filename;
+  for (auto &[key, value] : request.query) {
+    log::debug("key={}, value={}"sv, key, value);
+    if (key == "file"sv)
+      filename = value;
+    else
+      throw RuntimeError{R"(Unexpected: query key="{}" not supported)"sv, key};
+  }
+  auto execute = [&database = database_, filename = std::string{filename}](Response &response, Budget &) {
+    auto backup = database::Backup{
+        .filename = filename,
+    };
+    if (database(backup)) {
+      response(web::http::Status::OK, web::http::ContentType::APPLICATION_JSON, R"({{"success":{}}})"sv, true);
+    } else {
+      response(
+          web::http::Status::CONFLICT,
+          web::http::ContentType::APPLICATION_JSON,
+          R"({{"success":false,"error":{}}})"sv,
+          json::String{"backup is already running"sv});
+    }
   };
-  database_(compress);
-  response(web::http::Status::OK, web::http::ContentType::APPLICATION_JSON, R"({{"success":{}}})"sv, true);
+  dispatch(metrics::Route::PUT_BACKUP, request, std::move(execute));
 }
 
+// note! the dump is executed by the engine thread (next timer)
+void Session::put_trace(web::rest::Server::Request const &request) {
+  if (!std::empty(request.query))
+    throw RuntimeError{"Unexpected: query keys not supported"sv};
+  auto execute = [&tracer = shared_.tracer](Response &response, Budget &) {
+    if (tracer.enabled()) {
+      tracer.request_dump();
+      response(web::http::Status::OK, web::http::ContentType::APPLICATION_JSON, R"({{"success":{}}})"sv, true);
+    } else {
+      response(
+          web::http::Status::CONFLICT,
+          web::http::ContentType::APPLICATION_JSON,
+          R"({{"success":false,"error":{}}})"sv,
+          json::String{"trace is not enabled"sv});
+    }
+  };
+  dispatch(metrics::Route::PUT_TRACE, request, std::move(execute));
+}
+
+// note! the config is applied by the engine thread (next timer), errors are returned (nothing is applied)
+void Session::put_reload(web::rest::Server::Request const &request) {
+  if (!std::empty(request.query))
+    throw RuntimeError{"Unexpected: query keys not supported"sv};
+  auto execute = [&handler = handler_](Response &response, Budget &) {
+    auto reload = Reload{
+        .reason = "request"sv,
+    };
+    handler(reload);
+    response(web::http::Status::OK, web::http::ContentType::APPLICATION_JSON, R"({{"success":{}}})"sv, true);
+  };
+  dispatch(metrics::Route::PUT_RELOAD, request, std::move(execute));
+}
+
+// note!
+//   the request body is parsed by the worker thread
+//   all or nothing, the limits are applied by the engine thread (next timer)
+void Session::put_limits(web::rest::Server::Request const &request) {
+  if (!std::empty(request.query))
+    throw RuntimeError{"Unexpected: query keys not supported"sv};
+  auto execute = [&handler = handler_, body = std::string{request.body}](Response &response, Budget &) {
+    if (std::empty(body))
+      throw RuntimeError{"Unexpected: no limits"sv};
+    std::vector<database::Limit> limits;
+    auto parse_item = [&](auto &item) {
+      database::Limit limit;
+      for (auto &[key, value] : item.items()) {
+        if (key == "user"sv)
+          limit.user = value.template get<std::string_view>();
+        else if (key == "strategy_id"sv)
+          limit.strategy_id = value.template get<uint32_t>();
+        else if (key == "account"sv)
+          limit.account = value.template get<std::string_view>();
+        else if (key == "exchange"sv)
+          limit.exchange = value.template get<std::string_view>();
+        else if (key == "symbol"sv)
+          limit.symbol = value.template get<std::string_view>();
+        else if (key == "long_position_limit"sv)
+          limit.long_position_limit = value.is_null() ? NaN : value.template get<double>();
+        else if (key == "short_position_limit"sv)
+          limit.short_position_limit = value.is_null() ? NaN : value.template get<double>();
+        else if (key == "long_risk_exposure_limit"sv)
+          limit.long_risk_exposure_limit = value.is_null() ? NaN : value.template get<double>();
+        else if (key == "short_risk_exposure_limit"sv)
+          limit.short_risk_exposure_limit = value.is_null() ? NaN : value.template get<double>();
+        else if (key == "allow_netting"sv)
+          limit.allow_netting = value.template get<bool>();
+        else if (key == "version"sv)
+          limit.version = value.template get<uint64_t>();
+        else
+          throw RuntimeError{R"(Unexpected: json key="{}" not supported)"sv, key};
+      }
+      limits.emplace_back(std::move(limit));
+    };
+    auto document = nlohmann::json::parse(body);  // note! must outlive limits (string views)
+    if (document.is_array()) {
+      for (auto &item : document)
+        parse_item(item);
+    } else {
+      parse_item(document);
+    }
+    if (handler(limits)) {
+      response(web::http::Status::OK, web::http::ContentType::APPLICATION_JSON, R"({{"success":{}}})"sv, true);
+    } else {
+      response(
+          web::http::Status::CONFLICT,
+          web::http::ContentType::APPLICATION_JSON,
+          R"({{"success":false,"error":{}}})"sv,
+          json::String{"version check failed"sv});
+    }
+  };
+  dispatch(metrics::Route::PUT_LIMITS, request, std::move(execute));
+}
+
+// note!
+//   http/1.1 requires responses to be sent in request order
+//   we therefore only allow one outstanding request per session (pipelining is not supported)
+void Session::dispatch(
+    metrics::Route route,
+    web::rest::Server::Request const &request,
+    std::function<void(Response &, Budget &)> &&execute) {
+  if (pending_)
+    throw RuntimeError{"Unexpected: request pipelining is not supported"sv};
+  pending_ = true;
+  route_ = route;
+  request_time_ = clock::get_system();
+  ++shared_.metrics[route].count;
+  cancelled_ = std::make_shared<std::atomic<bool>>(false);
+  auto query = Query{
+      .session_id = session_id_,
+      .connection = request.headers.connection,
+      .cancelled = cancelled_,
+      .execute = std::move(execute),
+  };
+  handler_(std::move(query));
+}
+
+// ws
+
 void Session::process(std::string_view const &message) {
   assert(!zombie());
   auto success = false;
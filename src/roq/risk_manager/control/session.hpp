@@ -2,18 +2,24 @@
 
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <functional>
 #include <memory>
+#include <span>
 
 #include "roq/io/net/tcp/connection.hpp"
 
 #include "roq/web/rest/server.hpp"
 
-#include "roq/risk_manager/shared.hpp"
-
 #include "roq/risk_manager/database/session.hpp"
 
+#include "roq/risk_manager/control/query.hpp"
+#include "roq/risk_manager/control/reload.hpp"
 #include "roq/risk_manager/control/response.hpp"
+#include "roq/risk_manager/control/result.hpp"
 #include "roq/risk_manager/control/shared.hpp"
+#include "roq/risk_manager/control/snapshot.hpp"
 
 namespace roq {
 namespace risk_manager {
@@ -26,11 +32,18 @@ struct Session final : public web::rest::Server::Handler {
 
   struct Upgraded final {
     uint64_t session_id = {};
+    uint64_t resume_from = {};  // note! zero means "start from snapshot"
   };
 
   struct Handler {
     virtual void operator()(Disconnected const &) = 0;
     virtual void operator()(Upgraded const &) = 0;
+    virtual void operator()(Query &&) = 0;
+    virtual void operator()(Reload const &) = 0;  // note! called from a worker thread, throws if invalid
+    // note! called from a worker thread, throws if invalid, returns false if a version check failed
+    virtual bool operator()(std::span<database::Limit const> const &) = 0;
+    virtual std::shared_ptr<Snapshot const> get_snapshot() const = 0;
+    virtual std::shared_ptr<Prices const> get_prices() const = 0;
   };
 
   Session(
@@ -38,17 +51,17 @@ struct Session final : public web::rest::Server::Handler {
       uint64_t session_id,
       io::net::tcp::Connection::Factory &,
       Shared &,
-      risk_manager::Shared const &,
       database::Session &);
 
-  void operator()(database::Trade const &);
+  void send(std::string_view const &message);
+  void send(Result const &);
+
+  void close();
 
  protected:
   bool ready() const;
   bool zombie() const;
 
-  void close();
-
   // web::rest::Server::Handler
   void operator()(web::rest::Server::Disconnected const &) override;
   void operator()(web::rest::Server::Request const &) override;
@@ -57,15 +70,28 @@ struct Session final : public web::rest::Server::Handler {
 
   // rest
 
-  void route(Response &, web::rest::Server::Request const &, std::span<std::string_view> const &path);
-
-  void get_accounts(Response &, web::rest::Server::Request const &);
-  void get_positions(Response &, web::rest::Server::Request const &);
-  void get_trades(Response &, web::rest::Server::Request const &);
-  void get_funds(Response &, web::rest::Server::Request const &);
-
-  void put_trade(Response &, web::rest::Server::Request const &);
-  void put_compress(Response &, web::rest::Server::Request const &);
+  void route(web::rest::Server::Request const &, std::span<std::string_view> const &path);
+
+  void get_accounts(web::rest::Server::Request const &);
+  void get_positions(web::rest::Server::Request const &);
+  void get_trades(web::rest::Server::Request const &);
+  void get_funds(web::rest::Server::Request const &);
+  void get_backup(web::rest::Server::Request const &);
+  void get_export(web::rest::Server::Request const &);
+  void get_metrics(web::rest::Server::Request const &);
+  void get_limits(web::rest::Server::Request const &);
+  void get_pnl(web::rest::Server::Request const &);
+
+  void put_trade(web::rest::Server::Request const &);
+  void put_compress(web::rest::Server::Request const &);
+  void put_backup(web::rest::Server::Request const &);
+  void put_trace(web::rest::Server::Request const &);
+  void put_reload(web::rest::Server::Request const &);
+  void put_limits(web::rest::Server::Request const &);
+
+  // note! the response is created by a worker thread
+  void dispatch(
+      metrics::Route, web::rest::Server::Request const &, std::function<void(Response &, Budget &)> &&execute);
 
   // ws
 
@@ -89,7 +115,10 @@ struct Session final : public web::rest::Server::Handler {
   std::unique_ptr<web::rest::Server> server_;
   Shared &shared_;
   enum class State { WAITING, READY, ZOMBIE } state_ = {};
-  risk_manager::Shared const &shared_2_;
+  bool pending_ = {};
+  std::shared_ptr<std::atomic<bool>> cancelled_;  // note! in-flight query
+  metrics::Route route_ = {};                     // note! in-flight query
+  std::chrono::nanoseconds request_time_ = {};
   database::Session &database_;
 };
 
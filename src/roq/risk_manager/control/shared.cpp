@@ -10,7 +10,8 @@ namespace control {
 
 // === IMPLEMENTATION ===
 
-Shared::Shared(Settings const &settings) : url_prefix{settings.control_url_prefix} {
+Shared::Shared(Settings const &settings, metrics::Metrics &metrics, trace::Tracer &tracer)
+    : url_prefix{settings.control_url_prefix}, metrics{metrics}, tracer{tracer} {
 }
 
 }  // namespace control
@@ -7,18 +7,25 @@
 
 #include "roq/risk_manager/settings.hpp"
 
+#include "roq/risk_manager/metrics/metrics.hpp"
+
+#include "roq/risk_manager/trace/tracer.hpp"
+
 namespace roq {
 namespace risk_manager {
 namespace control {
 
 struct Shared final {
-  explicit Shared(Settings const &);
+  Shared(Settings const &, metrics::Metrics &, trace::Tracer &);
 
   Shared(Shared const &) = delete;
   Shared(Shared &&) = default;
 
   std::string_view const url_prefix;
 
+  metrics::Metrics &metrics;
+  trace::Tracer &tracer;  // note! owned by the engine thread (only enabled and request_dump are thread-safe)
+
   std::string encode_buffer;
 };
 
@@ -0,0 +1,86 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "roq/risk_manager/database/position.hpp"
+
+namespace roq {
+namespace risk_manager {
+namespace control {
+
+// immutable view of the latest prices
+// - published by the engine thread (at most once per timer tick, only if any price has changed)
+// - published separately from the snapshot, i.e. a new price doesn't require the positions to be copied
+
+struct Prices final {
+  struct Price final {
+    double price = NaN;
+    double multiplier = NaN;
+  };
+
+  // note! nan if the instrument has no price
+  Price operator[](uint32_t instrument_id) const {
+    if (instrument_id < std::size(prices))
+      return prices[instrument_id];
+    return {};
+  }
+
+  uint64_t version = {};      // note! assigned by the manager (cached encodings must be refreshed)
+  std::vector<Price> prices;  // note! indexed by instrument id
+};
+
+// immutable view of the risk state
+// - published by the engine thread (at most once per timer tick, only if any position has changed)
+// - read by the control thread without locking the engine
+
+struct Snapshot final {
+  struct Position final {
+    operator database::Position() const {
+      return {
+          .user = user,
+          .strategy_id = strategy_id,
+          .account = account,
+          .exchange = exchange,
+          .symbol = symbol,
+          .long_quantity = long_quantity,
+          .short_quantity = short_quantity,
+          .exchange_time_utc = exchange_time_utc,
+      };
+    }
+
+    // note! unrealized pnl is marked to the latest price when served (nan if there is no price)
+    double get_unrealized_pnl(Prices const &prices) const {
+      auto quantity = long_quantity - short_quantity;
+      if (quantity == 0.0)
+        return 0.0;
+      auto price = prices[instrument_id];
+      return quantity * (price.price - average_price) * price.multiplier;
+    }
+
+    uint32_t instrument_id = {};
+    std::string user;
+    uint32_t strategy_id = {};
+    std::string account;
+    std::string exchange;
+    std::string symbol;
+    double long_quantity = NaN;
+    double short_quantity = NaN;
+    std::chrono::nanoseconds exchange_time_utc = {};
+    // pnl (only changed by fills)
+    double average_price = NaN;
+    double realized_pnl = NaN;
+    double fees = NaN;
+  };
+
+  uint64_t trade_count = {};  // note! number of trades queued for the control thread when the snapshot was taken
+  uint64_t version = {};      // note! assigned by the manager (cached encodings must be refreshed)
+  std::vector<Position> positions;
+};
+
+}  // namespace control
+}  // namespace risk_manager
+}  // namespace roq
@@ -0,0 +1,92 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include "roq/risk_manager/control/stream.hpp"
+
+#include <algorithm>
+
+#include "roq/logging.hpp"
+
+#include "roq/risk_manager/control/encoder.hpp"
+
+using namespace std::literals;
+
+namespace roq {
+namespace risk_manager {
+namespace control {
+
+// === HELPERS ===
+
+namespace {
+// note!
+//   sequence numbers are seeded from the wall clock (microseconds) so they keep increasing across restarts
+//   a client resuming with a sequence number from a previous process will therefore always fall outside the ring
+auto create_initial_seqno() {
+  auto now = clock::get_realtime();
+  return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(now).count());
+}
+}  // namespace
+
+// === IMPLEMENTATION ===
+
+Stream::Stream(size_t capacity)
+    : initial_seqno_{create_initial_seqno()}, seqno_{initial_seqno_}, messages_(std::max<size_t>(capacity, 1)) {
+  log::info("Stream: initial_seqno={}, capacity={}"sv, initial_seqno_, std::size(messages_));
+}
+
+std::string_view Stream::operator()(database::Trade const &trade) {
+  auto seqno = ++seqno_;
+  auto &message = messages_[seqno % std::size(messages_)];
+  message.clear();  // note! keeps capacity
+  fmt::format_to(
+      std::back_inserter(message),
+      R"({{)"
+      R"("type":"trade",)"
+      R"("seqno":{},)"
+      R"("data":)"sv,
+      seqno);
+  Encoder::encode(std::back_inserter(message), trade);
+  fmt::format_to(std::back_inserter(message), R"(}})"sv);
+  return message;
+}
+
+void Stream::reset() {
+  seqno_ += std::size(messages_);
+  initial_seqno_ = seqno_;
+  snapshot_.clear();
+  log::warn("Stream: reset (seqno={})"sv, seqno_);
+}
+
+// note! a client at first_seqno() has seen everything up to that point and only needs what's in the ring
+uint64_t Stream::first_seqno() const {
+  auto count = seqno_ - initial_seqno_;
+  auto capacity = std::size(messages_);
+  if (count <= capacity)
+    return initial_seqno_;
+  return seqno_ - capacity;
+}
+
+void Stream::begin_snapshot(uint64_t seqno) {
+  fmt::format_to(
+      std::back_inserter(snapshot_),
+      R"({{)"
+      R"("type":"snapshot",)"
+      R"("seqno":{},)"
+      R"("data":[)"sv,
+      seqno);
+  snapshot_empty_ = true;
+}
+
+void Stream::add_to_snapshot(Snapshot::Position const &position, Prices const &prices) {
+  if (!snapshot_empty_)
+    fmt::format_to(std::back_inserter(snapshot_), ","sv);
+  Encoder::encode(std::back_inserter(snapshot_), position, prices);
+  snapshot_empty_ = false;
+}
+
+void Stream::end_snapshot() {
+  fmt::format_to(std::back_inserter(snapshot_), R"(]}})"sv);
+}
+
+}  // namespace control
+}  // namespace risk_manager
+}  // namespace roq
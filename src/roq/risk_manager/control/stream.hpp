@@ -0,0 +1,82 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "roq/risk_manager/database/trade.hpp"
+
+#include "roq/risk_manager/control/snapshot.hpp"
+
+namespace roq {
+namespace risk_manager {
+namespace control {
+
+// sequenced event stream
+// - every event is assigned the next sequence number and kept (encoded) in a ring
+// - clients can resume from a sequence number as long as it's still covered by the ring
+// - otherwise clients must start from a snapshot (cached until the next event)
+
+struct Stream final {
+  explicit Stream(size_t capacity);
+
+  Stream(Stream &&) = default;
+  Stream(Stream const &) = delete;
+
+  uint64_t seqno() const { return seqno_; }
+
+  // note! returns the encoded message (valid until the next event)
+  std::string_view operator()(database::Trade const &);
+
+  // note! returns false if the gap can't be filled from the ring
+  template <typename Callback>
+  bool get_messages_after(uint64_t seqno, Callback callback) const {
+    if (seqno > seqno_ || seqno < first_seqno())
+      return false;
+    for (auto next = seqno + 1; next <= seqno_; ++next)
+      callback(std::string_view{messages_[next % std::size(messages_)]});
+    return true;
+  }
+
+  // note! the generator is only invoked when the cache is stale (new event or new version of the snapshot or prices)
+  template <typename Generator>
+  std::string_view get_snapshot(uint64_t seqno, uint64_t version, Generator generator) {
+    if (snapshot_seqno_ != seqno || snapshot_version_ != version || std::empty(snapshot_)) {
+      snapshot_.clear();
+      begin_snapshot(seqno);
+      auto callback = [this](Snapshot::Position const &position, Prices const &prices) {
+        add_to_snapshot(position, prices);
+      };
+      generator(callback);
+      end_snapshot();
+      snapshot_seqno_ = seqno;
+      snapshot_version_ = version;
+    }
+    return snapshot_;
+  }
+
+  // note! invalidates the ring (all clients must then start from a snapshot)
+  void reset();
+
+ protected:
+  uint64_t first_seqno() const;
+
+  void begin_snapshot(uint64_t seqno);
+  void add_to_snapshot(Snapshot::Position const &, Prices const &);
+  void end_snapshot();
+
+ private:
+  uint64_t initial_seqno_;
+  uint64_t seqno_;
+  std::vector<std::string> messages_;
+  std::string snapshot_;
+  uint64_t snapshot_seqno_ = {};
+  uint64_t snapshot_version_ = {};
+  bool snapshot_empty_ = {};
+};
+
+}  // namespace control
+}  // namespace risk_manager
+}  // namespace roq
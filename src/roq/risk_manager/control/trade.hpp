@@ -0,0 +1,65 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include <string>
+
+#include "roq/risk_manager/database/trade.hpp"
+
+namespace roq {
+namespace risk_manager {
+namespace control {
+
+// note! owns the strings so it can be passed between threads (string capacity is re-used when assigned)
+
+struct Trade final {
+  Trade &operator=(database::Trade const &trade) {
+    user = trade.user;
+    strategy_id = trade.strategy_id;
+    account = trade.account;
+    exchange = trade.exchange;
+    symbol = trade.symbol;
+    side = trade.side;
+    quantity = trade.quantity;
+    price = trade.price;
+    exchange_time_utc = trade.exchange_time_utc;
+    external_account = trade.external_account;
+    external_order_id = trade.external_order_id;
+    external_trade_id = trade.external_trade_id;
+    return *this;
+  }
+
+  operator database::Trade() const {
+    return {
+        .user = user,
+        .strategy_id = strategy_id,
+        .account = account,
+        .exchange = exchange,
+        .symbol = symbol,
+        .side = side,
+        .quantity = quantity,
+        .price = price,
+        .exchange_time_utc = exchange_time_utc,
+        .external_account = external_account,
+        .external_order_id = external_order_id,
+        .external_trade_id = external_trade_id,
+    };
+  }
+
+  std::string user;
+  uint32_t strategy_id = {};
+  std::string account;
+  std::string exchange;
+  std::string symbol;
+  Side side = {};
+  double quantity = NaN;
+  double price = NaN;
+  std::chrono::nanoseconds exchange_time_utc = {};
+  std::string external_account;
+  std::string external_order_id;
+  std::string external_trade_id;
+};
+
+}  // namespace control
+}  // namespace risk_manager
+}  // namespace roq
@@ -0,0 +1,106 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include "roq/risk_manager/control/workers.hpp"
+
+#include "roq/logging.hpp"
+
+#include "roq/exceptions.hpp"
+
+#include "roq/json/string.hpp"
+
+using namespace std::literals;
+
+namespace roq {
+namespace risk_manager {
+namespace control {
+
+// === IMPLEMENTATION ===
+
+Workers::Workers(size_t thread_count, std::chrono::nanoseconds query_timeout, size_t query_max_rows)
+    : query_timeout_{query_timeout}, query_max_rows_{query_max_rows} {
+  if (thread_count == 0)
+    log::fatal("Unexpected: at least one worker thread is required"sv);
+  for (size_t i = 0; i < thread_count; ++i)
+    threads_.emplace_back([this]() { run(); });
+}
+
+// note! queued queries are discarded, queries being executed are interrupted
+Workers::~Workers() {
+  {
+    std::lock_guard lock{mutex_};
+    stop_ = true;
+  }
+  condition_.notify_all();
+  for (auto &item : threads_)
+    if (item.joinable())
+      item.join();
+}
+
+void Workers::operator()(Query &&query) {
+  {
+    std::lock_guard lock{mutex_};
+    queries_.emplace_back(std::move(query));
+  }
+  condition_.notify_one();
+}
+
+void Workers::run() {
+  for (;;) {
+    Query query;
+    {
+      std::unique_lock lock{mutex_};
+      condition_.wait(lock, [&]() { return stop_ || !std::empty(queries_); });
+      if (stop_)
+        return;
+      query = std::move(queries_.front());
+      queries_.pop_front();
+    }
+    if ((*query.cancelled).load(std::memory_order_acquire))
+      continue;  // note! nobody is waiting for the result
+    auto result = execute(query);
+    std::lock_guard lock{mutex_};
+    results_.emplace_back(std::move(result));
+  }
+}
+
+Result Workers::execute(Query &query) {
+  auto result = Result{
+      .session_id = query.session_id,
+      .connection = query.connection,
+      .status = {},
+      .content_type = {},
+      .body = {},
+  };
+  Response response{result};
+  Budget budget{query_timeout_, query_max_rows_, *query.cancelled, stop_};
+  auto error = [&](auto const &what) {
+    if (budget.exceeded()) {
+      log::warn(R"(Query was aborted (reason="{}"))"sv, budget.reason());
+      response(
+          web::http::Status::SERVICE_UNAVAILABLE,
+          web::http::ContentType::APPLICATION_JSON,
+          R"({{"success":false,"error":{}}})"sv,
+          json::String{budget.reason()});
+    } else {
+      response(
+          web::http::Status::INTERNAL_SERVER_ERROR,
+          web::http::ContentType::APPLICATION_JSON,
+          R"({{"success":false,"error":{}}})"sv,
+          json::String{what});
+    }
+  };
+  try {
+    query.execute(response, budget);
+  } catch (RuntimeError &e) {
+    log::error("Error: {}"sv, e);
+    error(e.what());
+  } catch (std::exception &e) {
+    log::error("Error: {}"sv, e.what());
+    error(e.what());
+  }
+  return result;
+}
+
+}  // namespace control
+}  // namespace risk_manager
+}  // namespace roq
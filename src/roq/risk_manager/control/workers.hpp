@@ -0,0 +1,67 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "roq/risk_manager/control/query.hpp"
+#include "roq/risk_manager/control/result.hpp"
+
+namespace roq {
+namespace risk_manager {
+namespace control {
+
+// note!
+//   database queries are executed by worker threads so they never block the control event loop
+//   results are collected by the control thread (pop_all)
+//   each query is given a budget (time and rows), queries exceeding the budget are aborted (503)
+
+struct Workers final {
+  Workers(size_t thread_count, std::chrono::nanoseconds query_timeout, size_t query_max_rows);
+
+  Workers(Workers &&) = delete;
+  Workers(Workers const &) = delete;
+
+  ~Workers();
+
+  void operator()(Query &&);
+
+  template <typename Callback>
+  size_t pop_all(Callback callback) {
+    {
+      std::lock_guard lock{mutex_};
+      std::swap(results_, buffer_);
+    }
+    for (auto const &item : buffer_)
+      callback(item);
+    auto result = std::size(buffer_);
+    buffer_.clear();
+    return result;
+  }
+
+ protected:
+  void run();
+
+  Result execute(Query &);
+
+ private:
+  std::chrono::nanoseconds const query_timeout_;
+  size_t const query_max_rows_;
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  std::atomic<bool> stop_ = {};  // note! also used to interrupt queries being executed
+  std::deque<Query> queries_;
+  std::vector<Result> results_;
+  std::vector<Result> buffer_;  // note! control thread
+  std::vector<std::thread> threads_;
+};
+
+}  // namespace control
+}  // namespace risk_manager
+}  // namespace roq
@@ -4,15 +4,41 @@
 
 #include <cassert>
 
+#include "roq/exceptions.hpp"
 #include "roq/logging.hpp"
 
 #include "roq/risk_manager/database/factory.hpp"
 
+#include "roq/risk_manager/risk/pattern.hpp"
+
 using namespace std::literals;
 
 namespace roq {
 namespace risk_manager {
 
+// === HELPERS ===
+
+namespace {
+auto create_recorder(auto &settings, auto source_count) -> std::unique_ptr<events::Recorder> {
+  if (std::empty(settings.record_file))
+    return {};
+  return std::make_unique<events::Recorder>(settings.record_file, source_count);
+}
+
+auto create_database(auto &settings) {
+  auto options = database::Options{
+      .type = settings.db_type,
+      .params = settings.db_params,
+      .read_connections = settings.db_read_connections,
+      .partition_interval = settings.db_partition_interval,
+      .backup_file = settings.db_backup_file,
+      .backup_interval = settings.db_backup_interval,
+      .backup_step_pages = settings.db_backup_step_pages,
+  };
+  return database::Factory::create(options);
+}
+}  // namespace
+
 // === IMPLEMENTATION ===
 
 Controller::Controller(
@@ -21,38 +47,74 @@ Controller::Controller(
     Config const &config,
     roq::io::Context &context,
     size_t source_count)
-    : dispatcher_{dispatcher}, context_{context},
-      database_{database::Factory::create(settings.db_type, settings.db_params)},
-      control_manager_{*this, settings, context_, shared_, *database_}, shared_{settings, config},
+    : dispatcher_{dispatcher}, config_file_{settings.config_file}, config_{config},
+      recorder_{create_recorder(settings, source_count)},
+      database_{create_database(settings)},
+      shared_{config}, metrics_{source_count},
+      tracer_{settings.trace_file, settings.trace_capacity, settings.trace_latency_slo, source_count},
+      control_manager_{std::make_unique<control::Manager>(*this, settings, context, *database_, metrics_, tracer_)},
       state_(source_count) {
+  load_limits();     // note! before positions are created
+  load_drawdowns();  // note! before the realized pnl is restored by the positions
   load_positions();
+  publish_snapshot();
 }
 
 // client::Handler
 
 // note! timer is used to achieve batching of updates => gateway & clients can proxy until updates arrive
 void Controller::operator()(Event<Timer> const &event) {
-  context_.drain();
-  control_manager_(event);
-  for (size_t source = 0; source < std::size(state_); ++source) {
-    auto const &state = state_[source];
-    if (!state.ready)  // note! wait for "ready" (all accounts have then been downloaded)
-      continue;
-    publish_accounts(static_cast<uint8_t>(source));
-    publish_users(static_cast<uint8_t>(source));
+  if (recorder_)
+    (*recorder_)(event);
+  auto start_time = clock::get_system();
+  std::shared_ptr<Config const> config;
+  {
+    std::lock_guard lock{reload_mutex_};
+    config.swap(reload_);
   }
+  if (config) [[unlikely]] {
+    auto count = shared_(*config);
+    log::info("Config has been reloaded ({} limit(s) have changed)"sv, count);
+  }
+  apply_limits();
+  // note! prices are conflated between timers
+  auto reprice_start_time = clock::get_system();
+  if (shared_.reprice())
+    publish_prices();  // note! unrealized pnl is marked when the snapshot is served
+  if (shared_.take_marked())
+    snapshot_is_stale_ = true;
+  metrics_.reprice_latency(clock::get_system() - reprice_start_time);
+  // note! marked to the repriced exposure, also handles the daily reset
+  auto now_utc = clock::get_realtime();
+  shared_.update_loss_limits(now_utc);
+  if (shared_.take_drawdowns_changed()) [[unlikely]]
+    persist_drawdowns();
+  shared_.update_rate_limits(now_utc);
+  shared_.take_urgent();  // note! everything is published below
+  if (snapshot_is_stale_)
+    publish_snapshot();
+  publish_ready();
+  auto now = clock::get_system();
+  metrics_.timer_publish_latency(now - start_time);
+  tracer_.refresh(now);
 }
 
-void Controller::operator()(Event<Connected> const &) {
+void Controller::operator()(Event<Connected> const &event) {
+  if (recorder_)
+    (*recorder_)(event);
 }
 
 void Controller::operator()(Event<Disconnected> const &event) {
+  if (recorder_)
+    (*recorder_)(event);
   auto &[message_info, disconnected] = event;
   state_[message_info.source] = {};
   log::warn("*** NOT READY *** (source={})"sv, message_info.source);
 }
 
 void Controller::operator()(Event<DownloadBegin> const &event) {
+  if (recorder_)
+    (*recorder_)(event);
   auto &[message_info, download_begin] = event;
   (*this)(message_info);
   if (std::empty(download_begin.account))
@@ -62,6 +124,8 @@ void Controller::operator()(Event<DownloadBegin> const &event) {
 }
 
 void Controller::operator()(Event<DownloadEnd> const &event) {
+  if (recorder_)
+    (*recorder_)(event);
   auto &[message_info, download_end] = event;
   (*this)(message_info);
   if (std::empty(download_end.account))
@@ -74,6 +138,8 @@ void Controller::operator()(Event<DownloadEnd> const &event) {
 }
 
 void Controller::operator()(Event<Ready> const &event) {
+  if (recorder_)
+    (*recorder_)(event);
   auto &[message_info, ready] = event;
   (*this)(message_info);
   auto &state = state_[message_info.source];
@@ -87,9 +153,12 @@ void Controller::operator()(Event<Ready> const &event) {
 
 // XXX TODO also use MarketByPrice in case reference data not available...?
 void Controller::operator()(Event<ReferenceData> const &event) {
+  if (recorder_)
+    (*recorder_)(event);
   auto &reference_data = event.value;
   // log::debug("reference_data={}"sv, reference_data);
   auto &instrument = shared_.get_instrument(reference_data.exchange, reference_data.symbol);
+  shared_(reference_data);
   if (instrument(reference_data)) {
     auto callback = [&](auto &item) { item(reference_data); };
     shared_.get_all_accounts(callback);
@@ -97,24 +166,48 @@ void Controller::operator()(Event<ReferenceData> const &event) {
   }
 }
 
+// note! only the price is stored, exposure is re-computed from the timer
+void Controller::operator()(Event<TopOfBook> const &event) {
+  if (recorder_)
+    (*recorder_)(event);
+  ++metrics_.market_data_updates;
+  if (shared_(event.value))
+    ++metrics_.market_data_conflated;
+}
+
 // note!
 // we are currently persisting trade updates synchronously
 // this should not be an issue for low volume throughput
 // however, for high volume throughput one might consider buffering and postpone persisting until the timer event fires
 void Controller::operator()(Event<TradeUpdate> const &event) {
+  if (recorder_)
+    (*recorder_)(event);
   log::info<1>("event={}"sv, event);
+  auto start_time = clock::get_system();
+  auto &record = tracer_(trace::Type::TRADE_UPDATE, event.message_info);
   (*this)(event.message_info);
   auto &trade_update = event.value;
   // note! we drop any trades prior to our last seen exchange time
   if (trade_update.create_time_utc <= last_exchange_time_utc_) {
     log::warn<1>("*** DROP *** ({} <= {})"sv, trade_update.create_time_utc, last_exchange_time_utc_);
+    ++metrics_.trades_dropped;
+    record.engine_done = clock::get_system();
     return;
   }
+  metrics_.fills += std::size(trade_update.fills);
   log::debug("trade_update={}"sv, trade_update);
   // positions
-  auto callback = [&](auto &item) { item(trade_update); };
+  auto now_utc = clock::get_realtime();  // note! rate limits are also expired by the timer using this clock
+  auto callback = [&](auto &item) { item(trade_update, now_utc); };
   shared_.get_account(trade_update.account, callback);
   shared_.get_user(trade_update.user, callback);
+  snapshot_is_stale_ = true;
+  // note! a loss limit (or rate limit) breach can't wait for the next timer
+  if (shared_.take_urgent()) [[unlikely]] {
+    ++metrics_.risk_limits_urgent;
+    publish_ready();
+  }
+  record.engine_done = clock::get_system();
   // database
   try {
     trades_buffer_.clear();
@@ -134,20 +227,33 @@ void Controller::operator()(Event<TradeUpdate> const &event) {
           .external_trade_id = item.external_trade_id,
       };
       // subscribers
-      control_manager_(trade);
+      (*control_manager_)(trade);
       // for database
       trades_buffer_.emplace_back(std::move(trade));
     }
-    (*database_)(trades_buffer_);
+    // note! the pnl (and the loss limit state) is persisted with the trades (restored at start-up)
+    positions_buffer_.clear();
+    shared_.get_positions(trade_update, [&](auto const &position) { positions_buffer_.emplace_back(position); });
+    drawdowns_buffer_.clear();
+    shared_.get_drawdowns(trade_update, [&](auto const &drawdown) { drawdowns_buffer_.emplace_back(drawdown); });
+    record.database_enqueued = clock::get_system();
+    (*database_)(trades_buffer_, positions_buffer_, drawdowns_buffer_);
+    record.database_committed = clock::get_system();
+    metrics_.database_insert_latency(record.database_committed - record.database_enqueued);
+    metrics_.database_insert_batch_size(std::size(trades_buffer_));
   } catch (...) {
     // XXX TODO more specific
   }
+  metrics_.trade_update_latency(clock::get_system() - start_time);
 }
 
 // XXX TODO perhaps useful to persist this into the database?
 void Controller::operator()(Event<PositionUpdate> const &event) {
+  if (recorder_)
+    (*recorder_)(event);
   log::info<1>("event={}"sv, event);
   auto &[message_info, position_update] = event;
+  auto &record = tracer_(trace::Type::POSITION_UPDATE, message_info);
   log::debug("position_update={}"sv, position_update);
   // database
   // cache
@@ -156,12 +262,16 @@ void Controller::operator()(Event<PositionUpdate> const &event) {
   if (position(position_update)) {
     // XXX TODO notify subscribers
   }
+  record.engine_done = clock::get_system();
 }
 
 // XXX TODO perhaps useful to persist this into the database?
 void Controller::operator()(Event<FundsUpdate> const &event) {
+  if (recorder_)
+    (*recorder_)(event);
   log::info<1>("event={}"sv, event);
   auto &[message_info, funds_update] = event;
+  auto &record = tracer_(trace::Type::FUNDS_UPDATE, message_info);
   log::debug("funds_update={}"sv, funds_update);
   // database
   {
@@ -173,7 +283,9 @@ void Controller::operator()(Event<FundsUpdate> const &event) {
         .exchange_time_utc = funds_update.exchange_time_utc,
         .external_account = funds_update.external_account,
     };
+    record.database_enqueued = clock::get_system();
     (*database_)({&funds, 1});
+    record.database_committed = clock::get_system();
   }
   // cache
   auto &account = shared_.accounts_by_source[message_info.source][funds_update.account];
@@ -181,10 +293,59 @@ void Controller::operator()(Event<FundsUpdate> const &event) {
   if (funds(funds_update)) {
     // XXX TODO notify subscribers
   }
+  // note! published with the next timer
+  shared_(funds_update);
+  record.engine_done = clock::get_system();
 }
 
 // control::Manager::Handler
-// note! empty
+
+// note! worker thread, the config is applied by the engine thread (next timer)
+void Controller::operator()(control::Reload const &reload) {
+  log::info(R"(Reloading config (reason={}, file="{}"))"sv, reload.reason, config_file_);
+  auto config = std::make_shared<Config const>(Config::parse_file(config_file_));
+  config_.check_reload(*config);
+  std::lock_guard lock{reload_mutex_};
+  reload_ = std::move(config);
+}
+
+// note! worker thread, the limits are persisted before being applied by the engine thread (next timer)
+bool Controller::operator()(std::span<database::Limit const> const &limits) {
+  if (std::empty(limits))
+    throw RuntimeError{"Unexpected: no limits"sv};
+  for (auto &item : limits) {
+    auto count = !std::empty(item.user) + (item.strategy_id != 0) + !std::empty(item.account);
+    if (count != 1)
+      throw RuntimeError{"Unexpected: exactly one of user, strategy_id or account is required (limit={})"sv, item};
+    if (std::empty(item.exchange) || std::empty(item.symbol))
+      throw RuntimeError{"Unexpected: exchange and symbol are required (limit={})"sv, item};
+    risk::Pattern::validate(item.symbol);
+    // note! positions are only aggregated for accounts, users and strategies known at start-up
+    auto known = [&]() {
+      if (!std::empty(item.user))
+        return config_.users.contains(item.user);
+      if (item.strategy_id)
+        return config_.strategies.contains(item.strategy_id);
+      return config_.accounts.contains(item.account);
+    }();
+    if (!known)
+      throw RuntimeError{"Unexpected: unknown user, strategy_id or account (limit={})"sv, item};
+  }
+  // note! concurrent requests for the same key must be applied in the same order as they were persisted
+  std::lock_guard writer_lock{limits_writer_mutex_};
+  if (!(*database_)(limits))
+    return false;
+  std::lock_guard lock{limits_mutex_};
+  for (auto &item : limits)
+    limits_.emplace_back(Limit{
+        .user = std::string{item.user},
+        .account = std::string{item.account},
+        .exchange = std::string{item.exchange},
+        .symbol = std::string{item.symbol},
+        .limit = item,
+    });
+  return true;
+}
 
 // utilities
 
@@ -194,24 +355,21 @@ void Controller::operator()(MessageInfo const &message_info) {
   state.seqno = message_info.source_seqno;
 }
 
+void Controller::publish_ready() {
+  for (size_t source = 0; source < std::size(state_); ++source) {
+    auto const &state = state_[source];
+    if (!state.ready)  // note! wait for "ready" (all accounts have then been downloaded)
+      continue;
+    publish_accounts(static_cast<uint8_t>(source));
+    publish_users(static_cast<uint8_t>(source));
+  }
+}
+
 void Controller::publish_accounts(uint8_t source) {
   auto const &state = state_[source];
   auto callback = [&](auto &account) {
     risk_limits_buffer_.clear();
-    auto callback = [&](auto &position, auto &instrument) {
-      auto risk_limit = RiskLimit{
-          .exchange = instrument.exchange,
-          .symbol = instrument.symbol,
-          .long_position = position.long_position(),
-          .short_position = position.short_position(),
-          .long_position_limit = position.long_position_limit(),
-          .short_position_limit = position.short_position_limit(),
-          .long_risk_exposure_limit = position.long_risk_exposure_limit(),
-          .short_risk_exposure_limit = position.short_risk_exposure_limit(),
-          .allow_netting = position.allow_netting,
-      };
-      risk_limits_buffer_.emplace_back(std::move(risk_limit));
-    };
+    auto callback = [&](auto const &risk_limit) { risk_limits_buffer_.emplace_back(risk_limit); };
     shared_.get_publish_by_account(account.name, callback);
     if (!std::empty(risk_limits_buffer_)) {
       auto risk_limits = RiskLimits{
@@ -222,8 +380,7 @@ void Controller::publish_accounts(uint8_t source) {
           .session_id = state.session_id,
           .seqno = state.seqno,
       };
-      log::debug("risk_limits={}"sv, risk_limits);
-      dispatcher_.send(risk_limits, source);
+      publish(risk_limits, source);
     }
   };
   shared_.get_all_accounts(callback);
@@ -234,20 +391,7 @@ void Controller::publish_users(uint8_t source) {
   auto const &state = state_[source];
   auto callback = [&](auto &user) {
     risk_limits_buffer_.clear();
-    auto callback = [&](auto &position, auto &instrument) {
-      auto risk_limit = RiskLimit{
-          .exchange = instrument.exchange,
-          .symbol = instrument.symbol,
-          .long_position = position.long_position(),
-          .short_position = position.short_position(),
-          .long_position_limit = position.long_position_limit(),
-          .short_position_limit = position.short_position_limit(),
-          .long_risk_exposure_limit = position.long_risk_exposure_limit(),
-          .short_risk_exposure_limit = position.short_risk_exposure_limit(),
-          .allow_netting = position.allow_netting,
-      };
-      risk_limits_buffer_.emplace_back(std::move(risk_limit));
-    };
+    auto callback = [&](auto const &risk_limit) { risk_limits_buffer_.emplace_back(risk_limit); };
     shared_.get_publish_by_user(user.name, callback);  // XXX
     if (!std::empty(risk_limits_buffer_)) {
       auto risk_limits = RiskLimits{
@@ -258,13 +402,86 @@ void Controller::publish_users(uint8_t source) {
           .session_id = state.session_id,
           .seqno = state.seqno,
       };
-      log::debug("risk_limits={}"sv, risk_limits);
-      dispatcher_.send(risk_limits, source);
+      publish(risk_limits, source);
     }
   };
   shared_.get_all_users(callback);
 }
 
+// note! the size is estimated (strings and limits), the encoding is owned by the client library
+void Controller::publish(RiskLimits const &risk_limits, uint8_t source) {
+  log::debug("risk_limits={}"sv, risk_limits);
+  dispatcher_.send(risk_limits, source);
+  tracer_(source, clock::get_system());
+  auto &metrics = metrics_.sources[source];
+  ++metrics.risk_limits_messages;
+  metrics.risk_limits_limits += std::size(risk_limits.limits);
+  metrics.risk_limits_bytes += sizeof(RiskLimits) + std::size(risk_limits.user) + std::size(risk_limits.account) +
+                               std::size(risk_limits.limits) * sizeof(RiskLimit);
+}
+
+// note! immutable copy handed over to the control thread
+void Controller::publish_snapshot() {
+  control::Snapshot snapshot;
+  auto callback = [&](uint32_t instrument_id, database::Position const &position, risk::PnL const &pnl) {
+    auto position_2 = control::Snapshot::Position{
+        .instrument_id = instrument_id,
+        .user = std::string{position.user},
+        .strategy_id = position.strategy_id,
+        .account = std::string{position.account},
+        .exchange = std::string{position.exchange},
+        .symbol = std::string{position.symbol},
+        .long_quantity = position.long_quantity,
+        .short_quantity = position.short_quantity,
+        .exchange_time_utc = position.exchange_time_utc,
+        .average_price = pnl.average_price,
+        .realized_pnl = pnl.realized,
+        .fees = pnl.fees,
+    };
+    snapshot.positions.emplace_back(std::move(position_2));
+  };
+  shared_.get_all_positions(callback);
+  (*control_manager_)(std::move(snapshot));
+  snapshot_is_stale_ = false;
+}
+
+// note! immutable copy handed over to the control thread (one price per instrument, not per position)
+void Controller::publish_prices() {
+  control::Prices prices;
+  auto callback = [&](uint32_t instrument_id, double price, double multiplier) {
+    if (std::size(prices.prices) <= instrument_id)
+      prices.prices.resize(instrument_id + 1);
+    prices.prices[instrument_id] = {
+        .price = price,
+        .multiplier = multiplier,
+    };
+  };
+  shared_.get_all_prices(callback);
+  (*control_manager_)(std::move(prices));
+}
+
+void Controller::load_limits() {
+  size_t count = {};
+  auto callback = [&](database::Limit const &limit) {
+    log::debug("limit={}"sv, limit);
+    shared_({&limit, 1});
+    ++count;
+  };
+  (*database_)(callback, false, {});  // note! never interrupted
+  log::info("Loaded {} limit(s) from the database"sv, count);
+}
+
+void Controller::load_drawdowns() {
+  size_t count = {};
+  auto callback = [&](database::Drawdown const &drawdown) {
+    log::debug("drawdown={}"sv, drawdown);
+    if (shared_(drawdown))
+      ++count;
+  };
+  (*database_)(callback, {});  // note! never interrupted
+  log::info("Loaded {} loss limit(s) from the database"sv, count);
+}
+
 void Controller::load_positions() {
   auto dispatch = [&last_exchange_time_utc = last_exchange_time_utc_,
                    &shared = shared_](database::Position const &position) {
@@ -280,7 +497,40 @@ void Controller::load_positions() {
       shared.get_account(position.account, callback);
     }
   };
-  (*database_)(dispatch);
+  (*database_)(dispatch, {});  // note! never interrupted
+}
+
+// note! the engine only blocks (briefly) if a worker is pushing at the same time
+void Controller::apply_limits() {
+  {
+    std::lock_guard lock{limits_mutex_};
+    if (std::empty(limits_))
+      return;
+    std::swap(limits_, limits_swap_);
+  }
+  limits_buffer_.clear();
+  for (auto &item : limits_swap_) {
+    auto limit = item.limit;
+    limit.user = item.user;
+    limit.account = item.account;
+    limit.exchange = item.exchange;
+    limit.symbol = item.symbol;
+    limits_buffer_.emplace_back(limit);
+  }
+  auto count = shared_(limits_buffer_);
+  log::info("Limits have been updated ({} limit(s) have changed)"sv, count);
+  limits_swap_.clear();
+}
+
+// note! only when a loss limit has been reset or breached by the timer (fills persist their own loss limits)
+void Controller::persist_drawdowns() {
+  drawdowns_buffer_.clear();
+  shared_.get_all_drawdowns([&](auto const &drawdown) { drawdowns_buffer_.emplace_back(drawdown); });
+  try {
+    (*database_)(drawdowns_buffer_);
+  } catch (...) {
+    // XXX TODO more specific
+  }
 }
 
 }  // namespace risk_manager
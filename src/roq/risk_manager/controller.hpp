@@ -4,6 +4,10 @@
 
 #include <absl/container/flat_hash_map.h>
 
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
 #include <vector>
 
 #include "roq/client.hpp"
@@ -18,13 +22,19 @@
 
 #include "roq/risk_manager/control/manager.hpp"
 
+#include "roq/risk_manager/events/recorder.hpp"
+
+#include "roq/risk_manager/metrics/metrics.hpp"
+
+#include "roq/risk_manager/trace/tracer.hpp"
+
 namespace roq {
 namespace risk_manager {
 
 struct Controller final : public client::Handler, public control::Manager::Handler {
   Controller(client::Dispatcher &, Settings const &, Config const &, roq::io::Context &context, size_t source_count);
 
-  Controller(Controller &&) = default;
+  Controller(Controller &&) = delete;
   Controller(Controller const &) = delete;
 
  protected:
@@ -36,26 +46,61 @@ struct Controller final : public client::Handler, public control::Manager::Handl
   void operator()(Event<DownloadEnd> const &) override;
   void operator()(Event<Ready> const &) override;
   void operator()(Event<ReferenceData> const &) override;
+  void operator()(Event<TopOfBook> const &) override;
   void operator()(Event<TradeUpdate> const &) override;
   void operator()(Event<PositionUpdate> const &) override;
   void operator()(Event<FundsUpdate> const &) override;
 
   // control::Manager::Handler
-  // note! empty
+  void operator()(control::Reload const &) override;
+  bool operator()(std::span<database::Limit const> const &) override;
 
   void operator()(MessageInfo const &);
 
+  void publish_ready();
   void publish_accounts(uint8_t source);
   void publish_users(uint8_t source);
 
+  void publish(RiskLimits const &, uint8_t source);
+
+  void publish_snapshot();
+  void publish_prices();
+
+  void load_limits();
+  void load_drawdowns();
   void load_positions();
 
+  void persist_drawdowns();
+
+  void apply_limits();
+
  private:
   client::Dispatcher &dispatcher_;
-  io::Context &context_;
+  // config
+  std::string const config_file_;
+  Config const &config_;  // note! start-up
+  std::mutex reload_mutex_;
+  std::shared_ptr<Config const> reload_;  // note! worker => engine (protected by the mutex)
+  // limits
+  struct Limit final {
+    std::string user;
+    std::string account;
+    std::string exchange;
+    std::string symbol;
+    database::Limit limit;  // note! strings refer to the above
+  };
+  std::mutex limits_writer_mutex_;  // note! worker threads (persist and enqueue in commit order)
+  std::mutex limits_mutex_;
+  std::vector<Limit> limits_;  // note! worker => engine (protected by the mutex)
+  std::vector<Limit> limits_swap_;
+  std::vector<database::Limit> limits_buffer_;
+  std::unique_ptr<events::Recorder> recorder_;         // note! optional
   std::unique_ptr<database::Session> database_;
-  control::Manager control_manager_;
   Shared shared_;
+  metrics::Metrics metrics_;
+  trace::Tracer tracer_;
+  std::unique_ptr<control::Manager> control_manager_;  // note! runs on its own thread
+  bool snapshot_is_stale_ = {};
   // time
   std::chrono::nanoseconds last_exchange_time_utc_ = {};
   // sources
@@ -69,6 +114,8 @@ struct Controller final : public client::Handler, public control::Manager::Handl
   // buffering
   std::vector<RiskLimit> risk_limits_buffer_;
   std::vector<database::Trade> trades_buffer_;
+  std::vector<database::Position> positions_buffer_;
+  std::vector<database::Drawdown> drawdowns_buffer_;
 };
 
 }  // namespace risk_manager
@@ -18,6 +18,9 @@ struct Account final {
   std::chrono::nanoseconds exchange_time_utc_min = {};
   std::chrono::nanoseconds exchange_time_utc_max = {};
   uint64_t trade_count = {};
+  double volume = {};             // note! sum of quantity
+  double notional = {};           // note! sum of quantity * price
+  uint64_t duplicate_count = {};  // note! ignored since start-up (not persisted)
 };
 
 }  // namespace database
@@ -39,11 +42,17 @@ struct fmt::formatter<roq::risk_manager::database::Account> {
         R"(account="{}", )"
         R"(exchange_time_utc_min={}, )"
         R"(exchange_time_utc_max={}, )"
-        R"(trade_count={})"
+        R"(trade_count={}, )"
+        R"(volume={}, )"
+        R"(notional={}, )"
+        R"(duplicate_count={})"
         R"(}})"_cf,
         value.name,
         value.exchange_time_utc_min,
         value.exchange_time_utc_max,
-        value.trade_count);
+        value.trade_count,
+        value.volume,
+        value.notional,
+        value.duplicate_count);
   }
 };
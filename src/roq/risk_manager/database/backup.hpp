@@ -0,0 +1,39 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include <fmt/chrono.h>
+#include <fmt/compile.h>
+#include <fmt/format.h>
+
+#include <string_view>
+
+namespace roq {
+namespace risk_manager {
+namespace database {
+
+struct Backup final {
+  std::string_view filename;  // note! missing means "default" (--db_backup_file)
+};
+
+}  // namespace database
+}  // namespace risk_manager
+}  // namespace roq
+
+template <>
+struct fmt::formatter<roq::risk_manager::database::Backup> {
+  template <typename Context>
+  constexpr auto parse(Context &context) {
+    return std::begin(context);
+  }
+  template <typename Context>
+  auto format(roq::risk_manager::database::Backup const &value, Context &context) const {
+    using namespace fmt::literals;
+    return fmt::format_to(
+        context.out(),
+        R"({{)"
+        R"(filename="{}")"
+        R"(}})"_cf,
+        value.filename);
+  }
+};
@@ -0,0 +1,61 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include <fmt/chrono.h>
+#include <fmt/compile.h>
+#include <fmt/format.h>
+
+#include <chrono>
+#include <string_view>
+
+namespace roq {
+namespace risk_manager {
+namespace database {
+
+struct BackupStatus final {
+  std::string_view filename;
+  bool running = false;
+  uint64_t page_count = {};
+  uint64_t remaining = {};                       // note! pages
+  std::chrono::nanoseconds start_time_utc = {};  // note! most recent backup
+  std::chrono::nanoseconds duration = {};        // note! elapsed (if running)
+  uint64_t backup_count = {};                    // note! completed since start-up
+  std::string_view error;                        // note! empty unless the most recent backup failed
+};
+
+}  // namespace database
+}  // namespace risk_manager
+}  // namespace roq
+
+template <>
+struct fmt::formatter<roq::risk_manager::database::BackupStatus> {
+  template <typename Context>
+  constexpr auto parse(Context &context) {
+    return std::begin(context);
+  }
+  template <typename Context>
+  auto format(roq::risk_manager::database::BackupStatus const &value, Context &context) const {
+    using namespace fmt::literals;
+    return fmt::format_to(
+        context.out(),
+        R"({{)"
+        R"(filename="{}", )"
+        R"(running={}, )"
+        R"(page_count={}, )"
+        R"(remaining={}, )"
+        R"(start_time_utc={}, )"
+        R"(duration={}, )"
+        R"(backup_count={}, )"
+        R"(error="{}")"
+        R"(}})"_cf,
+        value.filename,
+        value.running,
+        value.page_count,
+        value.remaining,
+        value.start_time_utc,
+        value.duration,
+        value.backup_count,
+        value.error);
+  }
+};
@@ -0,0 +1,37 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include <fmt/compile.h>
+#include <fmt/format.h>
+
+namespace roq {
+namespace risk_manager {
+namespace database {
+
+// note! brackets a bulk load, e.g. index builds may be deferred until the bulk load has completed
+struct Bulk final {
+  bool enabled = false;
+};
+
+}  // namespace database
+}  // namespace risk_manager
+}  // namespace roq
+
+template <>
+struct fmt::formatter<roq::risk_manager::database::Bulk> {
+  template <typename Context>
+  constexpr auto parse(Context &context) {
+    return std::begin(context);
+  }
+  template <typename Context>
+  auto format(roq::risk_manager::database::Bulk const &value, Context &context) const {
+    using namespace fmt::literals;
+    return fmt::format_to(
+        context.out(),
+        R"({{)"
+        R"(enabled={})"
+        R"(}})"_cf,
+        value.enabled);
+  }
+};
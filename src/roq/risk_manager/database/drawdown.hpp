@@ -0,0 +1,61 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include <fmt/chrono.h>
+#include <fmt/compile.h>
+#include <fmt/format.h>
+
+#include <chrono>
+#include <string_view>
+
+#include "roq/api.hpp"
+
+namespace roq {
+namespace risk_manager {
+namespace database {
+
+// note!
+//   loss limit state, exactly one of user or account (same as for loss limits)
+//   the pnl itself is not stored (realized is restored from the positions, unrealized is marked again)
+
+struct Drawdown final {
+  std::string_view user;
+  std::string_view account;
+  double peak = NaN;
+  double start = NaN;  // note! pnl at the most recent reset
+  std::chrono::nanoseconds next_reset = {};
+  bool breach = {};
+};
+
+}  // namespace database
+}  // namespace risk_manager
+}  // namespace roq
+
+template <>
+struct fmt::formatter<roq::risk_manager::database::Drawdown> {
+  template <typename Context>
+  constexpr auto parse(Context &context) {
+    return std::begin(context);
+  }
+  template <typename Context>
+  auto format(roq::risk_manager::database::Drawdown const &value, Context &context) const {
+    using namespace fmt::literals;
+    return fmt::format_to(
+        context.out(),
+        R"({{)"
+        R"(user="{}", )"
+        R"(account="{}", )"
+        R"(peak={}, )"
+        R"(start={}, )"
+        R"(next_reset={}, )"
+        R"(breach={})"
+        R"(}})"_cf,
+        value.user,
+        value.account,
+        value.peak,
+        value.start,
+        value.next_reset,
+        value.breach);
+  }
+};
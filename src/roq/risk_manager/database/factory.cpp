@@ -22,19 +22,28 @@ namespace roq {
 namespace risk_manager {
 namespace database {
 
-std::unique_ptr<Session> Factory::create(std::string_view const &type, std::string_view const &params) {
+// === IMPLEMENTATION ===
+
+std::unique_ptr<Session> Factory::create(Options const &options) {
+  auto &type = options.type;
   if (utils::case_insensitive_compare(type, "sqlite"sv) == 0 ||
       utils::case_insensitive_compare(type, "sqlite3"sv) == 0) {
-    return std::make_unique<sqlite::Session>(params);
+    return std::make_unique<sqlite::Session>(
+        options.params,
+        options.read_connections,
+        options.partition_interval,
+        options.backup_file,
+        options.backup_interval,
+        options.backup_step_pages);
 #if defined(BUILD_CLICKHOUSE)
   } else if (utils::case_insensitive_compare(type, "clickhouse"sv) == 0) {
-    return std::make_unique<clickhouse::Session>(params);
+    return std::make_unique<clickhouse::Session>(options.params);
 #endif
 #if defined(BUILD_MONGO)
   } else if (
       utils::case_insensitive_compare(type, "mongo"sv) == 0 ||
       utils::case_insensitive_compare(type, "mongodb"sv) == 0) {
-    return std::make_unique<mongo::Session>(params);
+    return std::make_unique<mongo::Session>(options.params);
 #endif
   } else {
     log::fatal(R"(Unexpected: database type="{}")"sv, type);
@@ -4,6 +4,7 @@
 
 #include <memory>
 
+#include "roq/risk_manager/database/options.hpp"
 #include "roq/risk_manager/database/session.hpp"
 
 namespace roq {
@@ -11,7 +12,7 @@ namespace risk_manager {
 namespace database {
 
 struct Factory final {
-  static std::unique_ptr<Session> create(std::string_view const &type, std::string_view const &params);
+  static std::unique_ptr<Session> create(Options const &);
 };
 
 }  // namespace database
@@ -0,0 +1,20 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include <functional>
+
+namespace roq {
+namespace risk_manager {
+namespace database {
+
+// note!
+//   called periodically while a query is executing (from the thread executing the query)
+//   returning true will abort the query (an exception is then thrown)
+//   an empty function means "no limit"
+
+using Interrupt = std::function<bool()>;
+
+}  // namespace database
+}  // namespace risk_manager
+}  // namespace roq
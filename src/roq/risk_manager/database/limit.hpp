@@ -0,0 +1,78 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include <fmt/chrono.h>
+#include <fmt/compile.h>
+#include <fmt/format.h>
+
+#include <string_view>
+
+#include "roq/api.hpp"
+
+namespace roq {
+namespace risk_manager {
+namespace database {
+
+// note!
+//   exactly one of user, strategy_id or account (same as for positions)
+//   nan means "no limit"
+
+struct Limit final {
+  std::string_view user;
+  uint32_t strategy_id = {};
+  std::string_view account;
+  std::string_view exchange;
+  std::string_view symbol;
+  double long_position_limit = NaN;
+  double short_position_limit = NaN;
+  double long_risk_exposure_limit = NaN;
+  double short_risk_exposure_limit = NaN;
+  bool allow_netting = {};
+  uint64_t version = {};  // note! insert: the expected current version (zero means "don't check")
+  std::chrono::nanoseconds update_time_utc = {};
+};
+
+}  // namespace database
+}  // namespace risk_manager
+}  // namespace roq
+
+template <>
+struct fmt::formatter<roq::risk_manager::database::Limit> {
+  template <typename Context>
+  constexpr auto parse(Context &context) {
+    return std::begin(context);
+  }
+  template <typename Context>
+  auto format(roq::risk_manager::database::Limit const &value, Context &context) const {
+    using namespace fmt::literals;
+    return fmt::format_to(
+        context.out(),
+        R"({{)"
+        R"(user="{}", )"
+        R"(strategy_id={}, )"
+        R"(account="{}", )"
+        R"(exchange="{}", )"
+        R"(symbol="{}", )"
+        R"(long_position_limit={}, )"
+        R"(short_position_limit={}, )"
+        R"(long_risk_exposure_limit={}, )"
+        R"(short_risk_exposure_limit={}, )"
+        R"(allow_netting={}, )"
+        R"(version={}, )"
+        R"(update_time_utc={})"
+        R"(}})"_cf,
+        value.user,
+        value.strategy_id,
+        value.account,
+        value.exchange,
+        value.symbol,
+        value.long_position_limit,
+        value.short_position_limit,
+        value.long_risk_exposure_limit,
+        value.short_risk_exposure_limit,
+        value.allow_netting,
+        value.version,
+        value.update_time_utc);
+  }
+};
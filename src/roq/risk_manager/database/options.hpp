@@ -0,0 +1,60 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include <fmt/chrono.h>
+#include <fmt/compile.h>
+#include <fmt/format.h>
+
+#include <chrono>
+#include <string_view>
+
+namespace roq {
+namespace risk_manager {
+namespace database {
+
+// note! decoupled from the flags => each application decides how the database is configured
+
+struct Options final {
+  std::string_view type;
+  std::string_view params;
+  size_t read_connections = {};                      // note! zero means queries use the writer
+  std::chrono::nanoseconds partition_interval = {};  // note! zero means a single partition
+  std::string_view backup_file;
+  std::chrono::nanoseconds backup_interval = {};  // note! zero means no scheduled backups
+  size_t backup_step_pages = 256;
+};
+
+}  // namespace database
+}  // namespace risk_manager
+}  // namespace roq
+
+template <>
+struct fmt::formatter<roq::risk_manager::database::Options> {
+  template <typename Context>
+  constexpr auto parse(Context &context) {
+    return std::begin(context);
+  }
+  template <typename Context>
+  auto format(roq::risk_manager::database::Options const &value, Context &context) const {
+    using namespace fmt::literals;
+    return fmt::format_to(
+        context.out(),
+        R"({{)"
+        R"(type="{}", )"
+        R"(params="{}", )"
+        R"(read_connections={}, )"
+        R"(partition_interval={}, )"
+        R"(backup_file="{}", )"
+        R"(backup_interval={}, )"
+        R"(backup_step_pages={})"
+        R"(}})"_cf,
+        value.type,
+        value.params,
+        value.read_connections,
+        value.partition_interval,
+        value.backup_file,
+        value.backup_interval,
+        value.backup_step_pages);
+  }
+};
@@ -14,6 +14,10 @@ namespace roq {
 namespace risk_manager {
 namespace database {
 
+// note!
+//   quantities are aggregated from the trades
+//   pnl is the latest persisted by the engine (nan means "unknown", e.g. written before schema version 7)
+
 struct Position final {
   std::string_view user;
   uint32_t strategy_id = {};
@@ -23,6 +27,9 @@ struct Position final {
   double long_quantity = NaN;
   double short_quantity = NaN;
   std::chrono::nanoseconds exchange_time_utc = {};
+  double average_price = NaN;
+  double realized_pnl = NaN;
+  double fees = NaN;
 };
 
 }  // namespace database
@@ -48,7 +55,10 @@ struct fmt::formatter<roq::risk_manager::database::Position> {
         R"(symbol="{}", )"
         R"(long_quantity={}, )"
         R"(short_quantity={}, )"
-        R"(exchange_time_utc={})"
+        R"(exchange_time_utc={}, )"
+        R"(average_price={}, )"
+        R"(realized_pnl={}, )"
+        R"(fees={})"
         R"(}})"_cf,
         value.user,
         value.strategy_id,
@@ -57,6 +67,9 @@ struct fmt::formatter<roq::risk_manager::database::Position> {
         value.symbol,
         value.long_quantity,
         value.short_quantity,
-        value.exchange_time_utc);
+        value.exchange_time_utc,
+        value.average_price,
+        value.realized_pnl,
+        value.fees);
   }
 };
@@ -8,9 +8,15 @@
 #include <utility>
 
 #include "roq/risk_manager/database/account.hpp"
+#include "roq/risk_manager/database/backup.hpp"
+#include "roq/risk_manager/database/backup_status.hpp"
+#include "roq/risk_manager/database/bulk.hpp"
 #include "roq/risk_manager/database/compress.hpp"
 #include "roq/risk_manager/database/correction.hpp"
+#include "roq/risk_manager/database/drawdown.hpp"
 #include "roq/risk_manager/database/funds.hpp"
+#include "roq/risk_manager/database/interrupt.hpp"
+#include "roq/risk_manager/database/limit.hpp"
 #include "roq/risk_manager/database/position.hpp"
 #include "roq/risk_manager/database/trade.hpp"
 
@@ -26,25 +32,41 @@ struct Session {
 
   // query
 
-  virtual void operator()(std::function<void(Account const &)> const &) = 0;
-  virtual void operator()(std::function<void(Position const &)> const &) = 0;
+  virtual void operator()(std::function<void(Account const &)> const &, Interrupt const &) = 0;
+  virtual void operator()(std::function<void(Position const &)> const &, Interrupt const &) = 0;
   virtual void operator()(
       std::function<void(Trade const &)> const &,
       std::string_view const &account,
-      std::chrono::nanoseconds start_time) = 0;
+      std::chrono::nanoseconds start_time,
+      Interrupt const &) = 0;
   virtual void operator()(
       std::function<void(Funds const &)> const &,
       std::string_view const &account,
-      std::string_view const &currency) = 0;
+      std::string_view const &currency,
+      Interrupt const &) = 0;
+  virtual void operator()(std::function<void(BackupStatus const &)> const &, Interrupt const &) = 0;
+  // note! history means all versions (otherwise only the current)
+  virtual void operator()(std::function<void(Limit const &)> const &, bool history, Interrupt const &) = 0;
+  virtual void operator()(std::function<void(Drawdown const &)> const &, Interrupt const &) = 0;
 
   // insert
 
   virtual void operator()(std::span<Trade const> const &) = 0;
+  // note! the pnl of the positions (and the loss limit state) changed by the trades (same transaction)
+  virtual void operator()(
+      std::span<Trade const> const &, std::span<Position const> const &, std::span<Drawdown const> const &) = 0;
   virtual void operator()(std::span<Correction const> const &) = 0;
   virtual void operator()(std::span<Funds const> const &) = 0;
+  // note! all or nothing, returns false if a version check failed
+  virtual bool operator()(std::span<Limit const> const &) = 0;
+  virtual void operator()(std::span<Drawdown const> const &) = 0;
 
   // maintenance
   virtual void operator()(Compress const &) = 0;
+  // note! asynchronous, returns false if a backup is already running
+  virtual bool operator()(Backup const &) = 0;
+  // note! synchronous, ending a bulk load may take a while (e.g. building indexes)
+  virtual void operator()(Bulk const &) = 0;
 
  protected:
   Session() = default;
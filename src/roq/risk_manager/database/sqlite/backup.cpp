@@ -0,0 +1,164 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include "roq/risk_manager/database/sqlite/backup.hpp"
+
+#include <filesystem>
+#include <utility>
+
+#include "roq/exceptions.hpp"
+
+#include "roq/logging.hpp"
+
+#include "roq/third_party/sqlite/backup.hpp"
+
+using namespace std::literals;
+using namespace std::chrono_literals;
+
+namespace roq {
+namespace risk_manager {
+namespace database {
+namespace sqlite {
+
+// === CONSTANTS ===
+
+namespace {
+auto const TEMPORARY_EXTENSION = ".tmp"sv;
+auto const STEP_PAUSE = 1ms;  // note! gives the writer a chance to acquire the lock
+}  // namespace
+
+// === IMPLEMENTATION ===
+
+Backup::Backup(
+    std::mutex &writer,
+    third_party::sqlite::Connection &connection,
+    std::string_view const &filename,
+    std::chrono::nanoseconds interval,
+    size_t step_pages)
+    : writer_{writer}, connection_{connection}, filename_{filename}, interval_{interval},
+      step_pages_{static_cast<int>(step_pages)}, thread_{[this]() { run(); }} {
+  if (step_pages_ <= 0)
+    log::fatal("Unexpected: backup must copy at least one page per step"sv);
+  if (interval_.count() && std::empty(filename_))
+    log::fatal("Unexpected: scheduled backup requires a filename"sv);
+}
+
+Backup::~Backup() {
+  {
+    std::lock_guard lock{mutex_};
+    stop_.store(true, std::memory_order_release);
+  }
+  condition_.notify_all();
+  if (thread_.joinable())
+    thread_.join();
+}
+
+bool Backup::operator()(std::string_view const &filename) {
+  {
+    std::lock_guard lock{mutex_};
+    if (running_ || !std::empty(request_))
+      return false;
+    request_ = std::empty(filename) ? filename_ : filename;
+    if (std::empty(request_))
+      throw RuntimeError{"Unexpected: no filename"sv};
+  }
+  condition_.notify_one();
+  return true;
+}
+
+void Backup::get_status(std::function<void(BackupStatus const &)> const &callback) const {
+  std::lock_guard lock{mutex_};
+  auto status = BackupStatus{
+      .filename = current_,
+      .running = running_,
+      .page_count = page_count_,
+      .remaining = remaining_,
+      .start_time_utc = start_time_utc_,
+      .duration = running_ ? (clock::get_realtime() - start_time_utc_) : duration_,
+      .backup_count = backup_count_,
+      .error = error_,
+  };
+  callback(status);
+}
+
+void Backup::run() {
+  auto next = std::chrono::steady_clock::now() + interval_;
+  auto predicate = [&]() { return stop_.load(std::memory_order_acquire) || !std::empty(request_); };
+  for (;;) {
+    std::string filename;
+    {
+      std::unique_lock lock{mutex_};
+      if (interval_.count())
+        condition_.wait_until(lock, next, predicate);
+      else
+        condition_.wait(lock, predicate);
+      if (stop_.load(std::memory_order_acquire))
+        return;
+      if (!std::empty(request_))
+        filename = std::exchange(request_, {});
+      else if (interval_.count() && std::chrono::steady_clock::now() >= next)
+        filename = filename_;
+      else
+        continue;
+      current_ = filename;
+      running_ = true;
+      page_count_ = {};
+      remaining_ = {};
+      start_time_utc_ = clock::get_realtime();
+      error_.clear();
+    }
+    backup(filename);
+    if (interval_.count())
+      next = std::chrono::steady_clock::now() + interval_;
+  }
+}
+
+void Backup::backup(std::string const &filename) {
+  log::info(R"(Backup to "{}" has started)"sv, filename);
+  auto temporary = fmt::format("{}{}"sv, filename, TEMPORARY_EXTENSION);
+  std::string error;
+  try {
+    std::filesystem::remove(temporary);
+    {
+      third_party::sqlite::Connection destination{temporary};
+      third_party::sqlite::Backup backup{destination, connection_};
+      for (;;) {
+        bool more = false;
+        {
+          std::lock_guard lock{writer_};
+          more = backup.step(step_pages_);
+          std::lock_guard lock_2{mutex_};
+          page_count_ = backup.page_count();
+          remaining_ = backup.remaining();
+        }
+        if (!more)
+          break;
+        if (stop_.load(std::memory_order_acquire))
+          throw RuntimeError{"Unexpected: shutdown"sv};
+        std::this_thread::sleep_for(STEP_PAUSE);
+      }
+    }
+    std::filesystem::rename(temporary, filename);
+  } catch (RuntimeError &e) {
+    log::error("Error: {}"sv, e);
+    error = e.what();
+  } catch (std::exception &e) {
+    log::error("Error: {}"sv, e.what());
+    error = e.what();
+  }
+  std::lock_guard lock{mutex_};
+  running_ = false;
+  duration_ = clock::get_realtime() - start_time_utc_;
+  if (std::empty(error)) {
+    ++backup_count_;
+    log::info(R"(Backup to "{}" has completed (page_count={}, duration={}))"sv, filename, page_count_, duration_);
+  } else {
+    error_ = std::move(error);
+    std::error_code ec;
+    std::filesystem::remove(temporary, ec);
+  }
+}
+
+}  // namespace sqlite
+}  // namespace database
+}  // namespace risk_manager
+}  // namespace roq
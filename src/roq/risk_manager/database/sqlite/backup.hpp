@@ -0,0 +1,78 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include "roq/third_party/sqlite/connection.hpp"
+
+#include "roq/risk_manager/database/backup_status.hpp"
+
+namespace roq {
+namespace risk_manager {
+namespace database {
+namespace sqlite {
+
+// note!
+//   online backup of the writer connection, executed by a dedicated thread
+//   the writer is only locked while copying a (bounded) number of pages
+//   the backup is written to a temporary file and then renamed (the target is therefore always complete)
+//   backups are requested explicitly or scheduled (interval)
+
+struct Backup final {
+  Backup(
+      std::mutex &writer,
+      third_party::sqlite::Connection &,
+      std::string_view const &filename,
+      std::chrono::nanoseconds interval,
+      size_t step_pages);
+
+  Backup(Backup &&) = delete;
+  Backup(Backup const &) = delete;
+
+  ~Backup();
+
+  // note! empty filename means default, returns false if a backup is already pending or running
+  bool operator()(std::string_view const &filename);
+
+  void get_status(std::function<void(BackupStatus const &)> const &) const;
+
+ protected:
+  void run();
+
+  void backup(std::string const &filename);
+
+ private:
+  std::mutex &writer_;
+  third_party::sqlite::Connection &connection_;
+  std::string const filename_;
+  std::chrono::nanoseconds const interval_;
+  int const step_pages_;
+  mutable std::mutex mutex_;
+  std::condition_variable condition_;
+  std::atomic<bool> stop_ = {};
+  std::string request_;
+  // status
+  std::string current_;
+  bool running_ = false;
+  uint64_t page_count_ = {};
+  uint64_t remaining_ = {};
+  std::chrono::nanoseconds start_time_utc_ = {};
+  std::chrono::nanoseconds duration_ = {};
+  uint64_t backup_count_ = {};
+  std::string error_;
+  // thread
+  std::thread thread_;  // note! must be last
+};
+
+}  // namespace sqlite
+}  // namespace database
+}  // namespace risk_manager
+}  // namespace roq
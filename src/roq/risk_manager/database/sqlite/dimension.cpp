@@ -0,0 +1,84 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include "roq/risk_manager/database/sqlite/dimension.hpp"
+
+#include "roq/logging.hpp"
+
+#include "roq/third_party/sqlite/statement.hpp"
+
+using namespace std::literals;
+
+namespace roq {
+namespace risk_manager {
+namespace database {
+namespace sqlite {
+
+// === IMPLEMENTATION ===
+
+Dimension::Dimension(std::string_view const &table_name) : table_name_{table_name} {
+}
+
+void Dimension::create(third_party::sqlite::Connection &connection, std::string_view const &table_name) {
+  log::info(R"(Creating table "{}")"sv, table_name);
+  auto query = fmt::format(
+      "CREATE TABLE IF NOT EXISTS {} ("
+      "  id INTEGER PRIMARY KEY, "
+      "  name TEXT NOT NULL UNIQUE"
+      ")"sv,
+      table_name);
+  log::debug(R"(query="{}")"sv, query);
+  connection.exec(query);
+}
+
+int64_t Dimension::operator()(third_party::sqlite::Connection &connection, std::string_view const &name) {
+  auto iter = ids_.find(name);
+  if (iter != std::end(ids_)) [[likely]]
+    return (*iter).second;
+  auto select = [&]() -> int64_t {
+    auto query = fmt::format("SELECT id FROM {} WHERE name=?"sv, table_name_);
+    auto &statement = connection.prepare(query);
+    statement.bind(0, name);
+    if (statement.step())
+      return statement.template get<int64_t>(0);
+    return 0;
+  };
+  auto insert = [&]() {
+    auto query = fmt::format("INSERT INTO {} (name) VALUES (?)"sv, table_name_);
+    auto &statement = connection.prepare(query);
+    statement.bind(0, name);
+    statement.step();
+    return connection.last_insert_rowid();
+  };
+  auto id = select();
+  if (id == 0) {
+    id = insert();
+    log::debug(R"(Interned {}="{}" (id={}))"sv, table_name_, name, id);
+  }
+  ids_.emplace(name, id);
+  return id;
+}
+
+void Dimension::clear() {
+  ids_.clear();
+}
+
+// dimensions
+
+void Dimensions::create(third_party::sqlite::Connection &connection) {
+  Dimension::create(connection, USERS);
+  Dimension::create(connection, ACCOUNTS);
+  Dimension::create(connection, EXCHANGES);
+  Dimension::create(connection, SYMBOLS);
+}
+
+void Dimensions::clear() {
+  users.clear();
+  accounts.clear();
+  exchanges.clear();
+  symbols.clear();
+}
+
+}  // namespace sqlite
+}  // namespace database
+}  // namespace risk_manager
+}  // namespace roq
@@ -0,0 +1,59 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include <absl/container/flat_hash_map.h>
+
+#include <string>
+#include <string_view>
+
+#include "roq/third_party/sqlite/connection.hpp"
+
+namespace roq {
+namespace risk_manager {
+namespace database {
+namespace sqlite {
+
+// note!
+//   interned strings (name => integer id)
+//   only used by the writer, readers will join with the table
+
+struct Dimension final {
+  explicit Dimension(std::string_view const &table_name);
+
+  Dimension(Dimension &&) = delete;
+  Dimension(Dimension const &) = delete;
+
+  static void create(third_party::sqlite::Connection &, std::string_view const &table_name);
+
+  // note! inserts the name if it doesn't already exist
+  int64_t operator()(third_party::sqlite::Connection &, std::string_view const &name);
+
+  // note! e.g. after a rollback
+  void clear();
+
+ private:
+  std::string_view const table_name_;
+  absl::flat_hash_map<std::string, int64_t> ids_;
+};
+
+struct Dimensions final {
+  static constexpr std::string_view USERS = "users";
+  static constexpr std::string_view ACCOUNTS = "accounts";
+  static constexpr std::string_view EXCHANGES = "exchanges";
+  static constexpr std::string_view SYMBOLS = "symbols";
+
+  Dimension users{USERS};
+  Dimension accounts{ACCOUNTS};
+  Dimension exchanges{EXCHANGES};
+  Dimension symbols{SYMBOLS};
+
+  static void create(third_party::sqlite::Connection &);
+
+  void clear();
+};
+
+}  // namespace sqlite
+}  // namespace database
+}  // namespace risk_manager
+}  // namespace roq
@@ -0,0 +1,118 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include "roq/risk_manager/database/sqlite/drawdowns.hpp"
+
+#include "roq/logging.hpp"
+
+#include "roq/third_party/sqlite/statement.hpp"
+
+using namespace std::literals;
+
+namespace roq {
+namespace risk_manager {
+namespace database {
+namespace sqlite {
+
+// === CONSTANTS ===
+
+namespace {
+auto const TABLE_NAME = "drawdowns"sv;
+}
+
+// === IMPLEMENTATION ===
+
+// create
+
+void Drawdowns::create(third_party::sqlite::Connection &connection) {
+  log::info(R"(Creating table "{}")"sv, TABLE_NAME);
+  auto query = fmt::format(
+      "CREATE TABLE IF NOT EXISTS {} ("
+      "  user TEXT NOT NULL, "
+      "  account TEXT NOT NULL, "
+      "  peak REAL NOT NULL, "
+      "  start REAL NOT NULL, "
+      "  next_reset INTEGER NOT NULL, "
+      "  breach INTEGER NOT NULL, "
+      "  update_time_utc INTEGER NOT NULL, "
+      "  PRIMARY KEY ("
+      "    user, "
+      "    account"
+      "  )"
+      ")"sv,
+      TABLE_NAME);
+  log::debug(R"(query="{}")"sv, query);
+  connection.exec(query);
+}
+
+// select
+
+void Drawdowns::select(
+    third_party::sqlite::Connection &connection, std::function<void(Drawdown const &)> const &callback) {
+  auto query = fmt::format(
+      "SELECT "
+      "  user, "
+      "  account, "
+      "  peak, "
+      "  start, "
+      "  next_reset, "
+      "  breach "
+      "FROM {} "
+      "ORDER BY "
+      "  user, "
+      "  account"sv,
+      TABLE_NAME);
+  log::debug(R"(query="{}")"sv, query);
+  auto &statement = connection.prepare(query);
+  while (statement.step()) {
+    auto user = statement.template get<std::string>(0);
+    auto account = statement.template get<std::string>(1);
+    auto peak = statement.template get<double>(2);
+    auto start = statement.template get<double>(3);
+    auto next_reset = statement.template get<int64_t>(4);
+    auto breach = statement.template get<int32_t>(5);
+    auto drawdown = Drawdown{
+        .user = user,
+        .account = account,
+        .peak = peak,
+        .start = start,
+        .next_reset = std::chrono::nanoseconds{next_reset},
+        .breach = breach != 0,
+    };
+    callback(drawdown);
+  }
+}
+
+// insert
+
+void Drawdowns::insert(third_party::sqlite::Connection &connection, std::span<Drawdown const> const &drawdowns) {
+  auto now = clock::get_realtime();
+  auto query = fmt::format(
+      "INSERT OR REPLACE "
+      "INTO {} ("
+      "  user, "
+      "  account, "
+      "  peak, "
+      "  start, "
+      "  next_reset, "
+      "  breach, "
+      "  update_time_utc"
+      ") "
+      "VALUES (?,?,?,?,?,?,?)"sv,
+      TABLE_NAME);
+  for (auto &item : drawdowns) {
+    auto &statement = connection.prepare(query);
+    statement.bind(0, item.user);
+    statement.bind(1, item.account);
+    statement.bind(2, item.peak);
+    statement.bind(3, item.start);
+    statement.bind(4, static_cast<int64_t>(item.next_reset.count()));
+    statement.bind(5, static_cast<int32_t>(item.breach));
+    statement.bind(6, static_cast<int64_t>(now.count()));
+    statement.step();
+  }
+}
+
+}  // namespace sqlite
+}  // namespace database
+}  // namespace risk_manager
+}  // namespace roq
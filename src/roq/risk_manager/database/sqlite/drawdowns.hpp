@@ -0,0 +1,37 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include <functional>
+#include <span>
+
+#include "roq/third_party/sqlite/connection.hpp"
+
+#include "roq/risk_manager/database/drawdown.hpp"
+
+namespace roq {
+namespace risk_manager {
+namespace database {
+namespace sqlite {
+
+// note! the latest loss limit state of each account and user, one row per key
+
+struct Drawdowns final {
+  // create
+
+  static void create(third_party::sqlite::Connection &);
+
+  // query
+
+  static void select(third_party::sqlite::Connection &, std::function<void(Drawdown const &)> const &);
+
+  // insert
+
+  // note! replaces the current row
+  static void insert(third_party::sqlite::Connection &, std::span<Drawdown const> const &);
+};
+
+}  // namespace sqlite
+}  // namespace database
+}  // namespace risk_manager
+}  // namespace roq
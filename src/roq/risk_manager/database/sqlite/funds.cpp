@@ -89,11 +89,11 @@ void Funds::select(
   if (!(std::empty(account) && std::empty(currency))) {
     fmt::format_to(std::back_inserter(query), "WHERE "sv);
     if (!std::empty(account))
-      fmt::format_to(std::back_inserter(query), "account='{}' "sv, account);
+      fmt::format_to(std::back_inserter(query), "account=? "sv);
     if (!std::empty(currency)) {
       if (!std::empty(account))
         fmt::format_to(std::back_inserter(query), "AND "sv);
-      fmt::format_to(std::back_inserter(query), "currency='{}' "sv, currency);
+      fmt::format_to(std::back_inserter(query), "currency=? "sv);
     }
   }
   fmt::format_to(
@@ -110,7 +110,12 @@ void Funds::select(
       "  t1.account, "
       "  t1.currency"sv);
   log::debug(R"(query="{}")"sv, query);
-  auto statement = third_party::sqlite::Statement{connection, query};
+  auto &statement = connection.prepare(query);
+  size_t column = 0;
+  if (!std::empty(account))
+    statement.bind(column++, account);
+  if (!std::empty(currency))
+    statement.bind(column++, currency);
   while (statement.step()) {
     auto account = statement.template get<std::string>(0);
     auto currency = statement.template get<std::string>(1);
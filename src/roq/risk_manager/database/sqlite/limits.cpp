@@ -0,0 +1,234 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include "roq/risk_manager/database/sqlite/limits.hpp"
+
+#include <cmath>
+
+#include "roq/logging.hpp"
+
+#include "roq/third_party/sqlite/statement.hpp"
+
+using namespace std::literals;
+
+namespace roq {
+namespace risk_manager {
+namespace database {
+namespace sqlite {
+
+// === CONSTANTS ===
+
+namespace {
+auto const TABLE_NAME = "limits"sv;
+
+auto const KEY = "user, strategy_id, account, exchange, symbol"sv;
+}  // namespace
+
+// === HELPERS ===
+
+namespace {
+void bind_key(auto &statement, Limit const &limit) {
+  statement.bind(0, limit.user);
+  statement.bind(1, static_cast<int64_t>(limit.strategy_id));
+  statement.bind(2, limit.account);
+  statement.bind(3, limit.exchange);
+  statement.bind(4, limit.symbol);
+}
+
+// note! nan is stored as null
+void bind_value(auto &statement, size_t column, double value) {
+  if (std::isnan(value))
+    statement.bind(column);
+  else
+    statement.bind(column, value);
+}
+
+double get_value(auto &statement, size_t column) {
+  if (statement.is_null(column))
+    return NaN;
+  return statement.template get<double>(column);
+}
+
+uint64_t get_version(auto &connection, Limit const &limit) {
+  auto query = fmt::format(
+      "SELECT MAX(version) "
+      "FROM {} "
+      "WHERE "
+      "  user=? AND "
+      "  strategy_id=? AND "
+      "  account=? AND "
+      "  exchange=? AND "
+      "  symbol=?"sv,
+      TABLE_NAME);
+  auto &statement = connection.prepare(query);
+  bind_key(statement, limit);
+  if (!statement.step() || statement.is_null(0))
+    return {};
+  return statement.template get<uint64_t>(0);
+}
+}  // namespace
+
+// === IMPLEMENTATION ===
+
+// create
+
+void Limits::create(third_party::sqlite::Connection &connection) {
+  log::info(R"(Creating table "{}")"sv, TABLE_NAME);
+  auto query = fmt::format(
+      "CREATE TABLE IF NOT EXISTS {} ("
+      "  user TEXT NOT NULL, "
+      "  strategy_id INTEGER NOT NULL, "
+      "  account TEXT NOT NULL, "
+      "  exchange TEXT NOT NULL, "
+      "  symbol TEXT NOT NULL, "
+      "  version INTEGER NOT NULL, "
+      "  long_position_limit REAL, "
+      "  short_position_limit REAL, "
+      "  long_risk_exposure_limit REAL, "
+      "  short_risk_exposure_limit REAL, "
+      "  allow_netting INTEGER NOT NULL, "
+      "  update_time_utc INTEGER NOT NULL, "
+      "  PRIMARY KEY ("
+      "    {}, "
+      "    version"
+      "  )"
+      ")"sv,
+      TABLE_NAME,
+      KEY);
+  log::debug(R"(query="{}")"sv, query);
+  connection.exec(query);
+}
+
+// select
+
+void Limits::select(
+    third_party::sqlite::Connection &connection, std::function<void(Limit const &)> const &callback, bool history) {
+  auto columns =
+      "  t1.user, "
+      "  t1.strategy_id, "
+      "  t1.account, "
+      "  t1.exchange, "
+      "  t1.symbol, "
+      "  t1.long_position_limit, "
+      "  t1.short_position_limit, "
+      "  t1.long_risk_exposure_limit, "
+      "  t1.short_risk_exposure_limit, "
+      "  t1.allow_netting, "
+      "  t1.version, "
+      "  t1.update_time_utc "sv;
+  auto query = [&]() {
+    if (history)
+      return fmt::format(
+          "SELECT {}"
+          "FROM {} AS t1 "
+          "ORDER BY {}, version"sv,
+          columns,
+          TABLE_NAME,
+          KEY);
+    return fmt::format(
+        "SELECT {}"
+        "FROM {} AS t1 "
+        "JOIN ("
+        "  SELECT "
+        "    {}, "
+        "    MAX(version) AS version "
+        "  FROM {} "
+        "  GROUP BY {}"
+        ") t2 "
+        "ON "
+        "  t1.user = t2.user AND "
+        "  t1.strategy_id = t2.strategy_id AND "
+        "  t1.account = t2.account AND "
+        "  t1.exchange = t2.exchange AND "
+        "  t1.symbol = t2.symbol AND "
+        "  t1.version = t2.version "
+        "ORDER BY "
+        "  t1.user, "
+        "  t1.strategy_id, "
+        "  t1.account, "
+        "  t1.exchange, "
+        "  t1.symbol"sv,
+        columns,
+        TABLE_NAME,
+        KEY,
+        TABLE_NAME,
+        KEY);
+  }();
+  log::debug(R"(query="{}")"sv, query);
+  auto &statement = connection.prepare(query);
+  while (statement.step()) {
+    auto user = statement.template get<std::string>(0);
+    auto strategy_id = statement.template get<uint32_t>(1);
+    auto account = statement.template get<std::string>(2);
+    auto exchange = statement.template get<std::string>(3);
+    auto symbol = statement.template get<std::string>(4);
+    auto allow_netting = statement.template get<int32_t>(9);
+    auto version = statement.template get<uint64_t>(10);
+    auto update_time_utc = statement.template get<int64_t>(11);
+    auto limit = Limit{
+        .user = user,
+        .strategy_id = strategy_id,
+        .account = account,
+        .exchange = exchange,
+        .symbol = symbol,
+        .long_position_limit = get_value(statement, 5),
+        .short_position_limit = get_value(statement, 6),
+        .long_risk_exposure_limit = get_value(statement, 7),
+        .short_risk_exposure_limit = get_value(statement, 8),
+        .allow_netting = allow_netting != 0,
+        .version = version,
+        .update_time_utc = std::chrono::nanoseconds{update_time_utc},
+    };
+    callback(limit);
+  }
+}
+
+// insert
+
+// note! all versions are checked before anything is inserted (the caller owns the transaction)
+bool Limits::insert(third_party::sqlite::Connection &connection, std::span<Limit const> const &limits) {
+  for (auto &item : limits) {
+    if (!item.version)
+      continue;
+    auto version = get_version(connection, item);
+    if (item.version != version) {
+      log::warn("Version check failed (current: {}) limit={}"sv, version, item);
+      connection.reset();
+      return false;
+    }
+  }
+  auto now = clock::get_realtime();
+  auto query = fmt::format(
+      "INSERT "
+      "INTO {} ("
+      "  {}, "
+      "  version, "
+      "  long_position_limit, "
+      "  short_position_limit, "
+      "  long_risk_exposure_limit, "
+      "  short_risk_exposure_limit, "
+      "  allow_netting, "
+      "  update_time_utc"
+      ") "
+      "VALUES (?,?,?,?,?,?,?,?,?,?,?,?)"sv,
+      TABLE_NAME,
+      KEY);
+  for (auto &item : limits) {
+    auto version = get_version(connection, item) + 1;  // note! the same key may appear more than once
+    auto &statement = connection.prepare(query);
+    bind_key(statement, item);
+    statement.bind(5, static_cast<int64_t>(version));
+    bind_value(statement, 6, item.long_position_limit);
+    bind_value(statement, 7, item.short_position_limit);
+    bind_value(statement, 8, item.long_risk_exposure_limit);
+    bind_value(statement, 9, item.short_risk_exposure_limit);
+    statement.bind(10, static_cast<int32_t>(item.allow_netting));
+    statement.bind(11, static_cast<int64_t>(now.count()));
+    statement.step();
+  }
+  return true;
+}
+
+}  // namespace sqlite
+}  // namespace database
+}  // namespace risk_manager
+}  // namespace roq
@@ -0,0 +1,40 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include <functional>
+#include <span>
+
+#include "roq/third_party/sqlite/connection.hpp"
+
+#include "roq/risk_manager/database/limit.hpp"
+
+namespace roq {
+namespace risk_manager {
+namespace database {
+namespace sqlite {
+
+// note!
+//   rows are never updated, a change is inserted as the next version (the table is the audit trail)
+//   the current limit is the row having the highest version
+
+struct Limits final {
+  // create
+
+  static void create(third_party::sqlite::Connection &);
+
+  // query
+
+  // note! history means all versions (otherwise only the current)
+  static void select(third_party::sqlite::Connection &, std::function<void(Limit const &)> const &, bool history);
+
+  // insert
+
+  // note! returns false if a version check failed (then nothing has been inserted)
+  static bool insert(third_party::sqlite::Connection &, std::span<Limit const> const &);
+};
+
+}  // namespace sqlite
+}  // namespace database
+}  // namespace risk_manager
+}  // namespace roq
@@ -0,0 +1,334 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include "roq/risk_manager/database/sqlite/partitions.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <span>
+#include <vector>
+
+#include "roq/logging.hpp"
+
+#include "roq/third_party/sqlite/statement.hpp"
+
+#include "roq/risk_manager/database/sqlite/trades.hpp"
+
+using namespace std::literals;
+
+namespace roq {
+namespace risk_manager {
+namespace database {
+namespace sqlite {
+
+// === CONSTANTS ===
+
+namespace {
+auto const TRADES = "trades"sv;  // note! view (all partitions)
+auto const SAVEPOINT = "partitions"sv;
+size_t const MAX_COMPOUND_SELECT = 256;  // note! sqlite limits the number of terms (default 500)
+}  // namespace
+
+// === HELPERS ===
+
+namespace {
+auto get_name(int64_t id) {
+  return fmt::format("{}_{}"sv, TRADES, id);
+}
+
+std::string union_all(std::span<std::string const> const &names) {
+  std::string result;
+  if (std::size(names) <= MAX_COMPOUND_SELECT) {
+    for (auto &name : names) {
+      if (!std::empty(result))
+        fmt::format_to(std::back_inserter(result), " UNION ALL "sv);
+      fmt::format_to(std::back_inserter(result), "SELECT * FROM {}"sv, name);
+    }
+    return result;
+  }
+  for (size_t i = 0; i < std::size(names); i += MAX_COMPOUND_SELECT) {
+    auto chunk = names.subspan(i, std::min(MAX_COMPOUND_SELECT, std::size(names) - i));
+    if (!std::empty(result))
+      fmt::format_to(std::back_inserter(result), " UNION ALL "sv);
+    fmt::format_to(std::back_inserter(result), "SELECT * FROM ({})"sv, union_all(chunk));
+  }
+  return result;
+}
+
+// note! nested (unlike BEGIN) => may be used from within a transaction
+template <typename Callback>
+void savepoint(auto &connection, Callback callback) {
+  connection.exec(fmt::format("SAVEPOINT {}"sv, SAVEPOINT));
+  try {
+    callback();
+    connection.exec(fmt::format("RELEASE {}"sv, SAVEPOINT));
+  } catch (...) {
+    connection.exec(fmt::format("ROLLBACK TO {}"sv, SAVEPOINT));
+    connection.exec(fmt::format("RELEASE {}"sv, SAVEPOINT));
+    throw;
+  }
+}
+
+int64_t insert(auto &connection, std::chrono::nanoseconds start_time_utc, std::chrono::nanoseconds end_time_utc) {
+  auto query = fmt::format(
+      "INSERT INTO {} ("
+      "  start_time_utc, "
+      "  end_time_utc"
+      ") "
+      "VALUES (?,?)"sv,
+      Partitions::TABLE_NAME);
+  auto &statement = connection.prepare(query);
+  statement.bind(0, static_cast<int64_t>(start_time_utc.count()));
+  statement.bind(1, static_cast<int64_t>(end_time_utc.count()));
+  statement.step();
+  return connection.last_insert_rowid();
+}
+
+void create_view(auto &connection, auto const &partitions) {
+  std::vector<std::string> names;
+  for (auto &[_, partition] : partitions)
+    names.emplace_back(partition.name);
+  connection.exec(fmt::format("DROP VIEW IF EXISTS {}"sv, TRADES));
+  auto query = fmt::format("CREATE VIEW {} AS {}"sv, TRADES, union_all(names));
+  log::debug(R"(query="{}")"sv, query);
+  connection.exec(query);
+}
+}  // namespace
+
+// === IMPLEMENTATION ===
+
+Partitions::Partitions(third_party::sqlite::Connection &connection, std::chrono::nanoseconds interval)
+    : interval_{interval} {
+  load(connection);
+}
+
+void Partitions::create(third_party::sqlite::Connection &connection) {
+  log::info(R"(Creating table "{}")"sv, TABLE_NAME);
+  // note! AUTOINCREMENT => partition names are never re-used
+  auto query = fmt::format(
+      "CREATE TABLE IF NOT EXISTS {} ("
+      "  id INTEGER PRIMARY KEY AUTOINCREMENT, "
+      "  start_time_utc INTEGER NOT NULL, "
+      "  end_time_utc INTEGER NOT NULL"
+      ")"sv,
+      TABLE_NAME);
+  log::debug(R"(query="{}")"sv, query);
+  connection.exec(query);
+}
+
+void Partitions::migrate_from_v2(third_party::sqlite::Connection &connection) {
+  log::info(R"(Migrating table "{}"...)"sv, TRADES);
+  int64_t count = 0, start_time_utc = 0, end_time_utc = 0;
+  {
+    auto query = fmt::format(
+        "SELECT "
+        "  COUNT(*), "
+        "  MIN(exchange_time_utc), "
+        "  MAX(exchange_time_utc) "
+        "FROM {}"sv,
+        TRADES);
+    third_party::sqlite::Statement statement{connection, query};
+    if (statement.step() && (count = statement.template get<int64_t>(0)) > 0) {
+      start_time_utc = statement.template get<int64_t>(1);
+      end_time_utc = statement.template get<int64_t>(2) + 1;
+    }
+  }
+  if (count == 0) {
+    connection.drop_table(TRADES);
+    return;
+  }
+  auto id = insert(connection, std::chrono::nanoseconds{start_time_utc}, std::chrono::nanoseconds{end_time_utc});
+  auto name = get_name(id);
+  connection.rename_table(TRADES, name);
+  log::info(R"(Migrated table "{}" (now partition "{}", trade_count={}))"sv, TRADES, name, count);
+}
+
+std::vector<std::string> Partitions::get_names(third_party::sqlite::Connection &connection) {
+  auto query = fmt::format(
+      "SELECT "
+      "  id "
+      "FROM {} "
+      "ORDER BY "
+      "  start_time_utc"sv,
+      TABLE_NAME);
+  third_party::sqlite::Statement statement{connection, query};
+  std::vector<std::string> result;
+  while (statement.step())
+    result.emplace_back(get_name(statement.template get<int64_t>(0)));
+  return result;
+}
+
+std::string Partitions::select(third_party::sqlite::Connection &connection, std::chrono::nanoseconds start_time) {
+  auto query = fmt::format(
+      "SELECT "
+      "  id "
+      "FROM {} "
+      "WHERE "
+      "  end_time_utc>? "
+      "ORDER BY "
+      "  start_time_utc"sv,
+      TABLE_NAME);
+  auto &statement = connection.prepare(query);
+  statement.bind(0, static_cast<int64_t>(start_time.count()));
+  std::vector<std::string> names;
+  while (statement.step())
+    names.emplace_back(get_name(statement.template get<int64_t>(0)));
+  switch (std::size(names)) {
+    case 0:
+      return fmt::format("(SELECT * FROM {} WHERE 0)"sv, TRADES);
+    case 1:
+      return names[0];
+    default:
+      return fmt::format("({})"sv, union_all(names));
+  }
+}
+
+std::string_view Partitions::operator()(
+    third_party::sqlite::Connection &connection, std::chrono::nanoseconds exchange_time_utc) {
+  auto iter = partitions_.upper_bound(exchange_time_utc);
+  if (iter != std::begin(partitions_)) {
+    auto &partition = (*std::prev(iter)).second;
+    if (exchange_time_utc < partition.end_time_utc) [[likely]]
+      return partition.name;
+  }
+  // note! aligned to interval, but never overlapping an existing partition
+  auto start_time_utc = std::chrono::nanoseconds::min();
+  auto end_time_utc = std::chrono::nanoseconds::max();
+  if (interval_.count()) {
+    start_time_utc = exchange_time_utc - (((exchange_time_utc % interval_) + interval_) % interval_);
+    end_time_utc = start_time_utc + interval_;
+  }
+  if (iter != std::begin(partitions_))
+    start_time_utc = std::max(start_time_utc, (*std::prev(iter)).second.end_time_utc);
+  if (iter != std::end(partitions_))
+    end_time_utc = std::min(end_time_utc, (*iter).first);
+  return add(connection, start_time_utc, end_time_utc);
+}
+
+void Partitions::reload(third_party::sqlite::Connection &connection) {
+  partitions_.clear();
+  load(connection);
+}
+
+void Partitions::defer_indexes(third_party::sqlite::Connection &connection, bool defer) {
+  if (defer == defer_indexes_)
+    return;
+  log::info("{} secondary indexes ({} partition(s))..."sv, defer ? "Dropping"sv : "Creating"sv, std::size(partitions_));
+  for (auto &[_, partition] : partitions_) {
+    if (defer)
+      Trades::drop_indexes(connection, partition.name);
+    else
+      Trades::create_indexes(connection, partition.name);
+  }
+  defer_indexes_ = defer;
+}
+
+bool Partitions::merge(
+    third_party::sqlite::Connection &connection,
+    std::chrono::nanoseconds exchange_time_utc,
+    std::function<void(std::string_view const &target, std::string_view const &source)> const &callback) {
+  std::vector<std::string> names;
+  auto iter = std::begin(partitions_);
+  for (; iter != std::end(partitions_) && (*iter).second.end_time_utc <= exchange_time_utc; ++iter)
+    names.emplace_back((*iter).second.name);
+  if (std::empty(names))
+    return false;
+  auto start_time_utc = (*std::begin(partitions_)).second.start_time_utc;
+  auto end_time_utc = (*std::prev(iter)).second.end_time_utc;
+  auto partitions = partitions_;
+  partitions.erase(std::begin(partitions), std::next(std::begin(partitions), std::size(names)));
+  savepoint(connection, [&]() {
+    auto id = insert(connection, start_time_utc, end_time_utc);
+    auto partition = Partition{
+        .name = get_name(id),
+        .start_time_utc = start_time_utc,
+        .end_time_utc = end_time_utc,
+    };
+    log::info(
+        R"(Merging {} partition(s) into "{}" (start_time_utc={}, end_time_utc={}))"sv,
+        std::size(names),
+        partition.name,
+        start_time_utc,
+        end_time_utc);
+    Trades::create(connection, partition.name, defer_indexes_);
+    auto source = std::size(names) == 1 ? names[0] : fmt::format("({})"sv, union_all(names));
+    callback(partition.name, source);
+    // note! O(1) per partition (no DELETE, no VACUUM)
+    connection.exec(fmt::format("DROP VIEW IF EXISTS {}"sv, TRADES));
+    for (auto &name : names)
+      connection.drop_table(name);
+    auto query = fmt::format("DELETE FROM {} WHERE end_time_utc<=? AND id<?"sv, TABLE_NAME);
+    auto &statement = connection.prepare(query);
+    statement.bind(0, static_cast<int64_t>(end_time_utc.count()));
+    statement.bind(1, id);
+    statement.step();
+    partitions.emplace(start_time_utc, std::move(partition));
+    create_view(connection, partitions);
+  });
+  partitions_ = std::move(partitions);
+  // note! partition names are never re-used => statements referring to the dropped partitions are never used again
+  connection.clear();
+  return true;
+}
+
+void Partitions::load(third_party::sqlite::Connection &connection) {
+  {
+    auto query = fmt::format(
+        "SELECT "
+        "  id, "
+        "  start_time_utc, "
+        "  end_time_utc "
+        "FROM {}"sv,
+        TABLE_NAME);
+    third_party::sqlite::Statement statement{connection, query};
+    while (statement.step()) {
+      auto id = statement.template get<int64_t>(0);
+      auto start_time_utc = std::chrono::nanoseconds{statement.template get<int64_t>(1)};
+      auto end_time_utc = std::chrono::nanoseconds{statement.template get<int64_t>(2)};
+      auto partition = Partition{
+          .name = get_name(id),
+          .start_time_utc = start_time_utc,
+          .end_time_utc = end_time_utc,
+      };
+      partitions_.emplace(start_time_utc, std::move(partition));
+    }
+  }
+  log::info("Found {} partition(s)"sv, std::size(partitions_));
+  // note! the view requires at least one partition
+  if (std::empty(partitions_))
+    (*this)(connection, clock::get_realtime());
+  else
+    create_view(connection, partitions_);
+}
+
+std::string_view Partitions::add(
+    third_party::sqlite::Connection &connection,
+    std::chrono::nanoseconds start_time_utc,
+    std::chrono::nanoseconds end_time_utc) {
+  auto [iter, _] = partitions_.emplace(start_time_utc, Partition{});
+  try {
+    savepoint(connection, [&]() {
+      auto id = insert(connection, start_time_utc, end_time_utc);
+      (*iter).second = {
+          .name = get_name(id),
+          .start_time_utc = start_time_utc,
+          .end_time_utc = end_time_utc,
+      };
+      log::info(
+          R"(Creating partition "{}" (start_time_utc={}, end_time_utc={}))"sv,
+          (*iter).second.name,
+          start_time_utc,
+          end_time_utc);
+      Trades::create(connection, (*iter).second.name, defer_indexes_);
+      create_view(connection, partitions_);
+    });
+  } catch (...) {
+    partitions_.erase(iter);
+    throw;
+  }
+  return (*iter).second.name;
+}
+
+}  // namespace sqlite
+}  // namespace database
+}  // namespace risk_manager
+}  // namespace roq
@@ -0,0 +1,85 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "roq/third_party/sqlite/connection.hpp"
+
+namespace roq {
+namespace risk_manager {
+namespace database {
+namespace sqlite {
+
+// note!
+//   trades are stored in tables covering a (non-overlapping) range of exchange_time_utc
+//   the ranges are recorded in the "partitions" table and all partitions are exposed by the "trades" view
+//   partitions are created on demand by the writer (interval is only used when creating a new partition)
+//   partitions are dropped (not deleted from) when compressed
+
+struct Partitions final {
+  static constexpr std::string_view TABLE_NAME = "partitions";
+
+  Partitions(third_party::sqlite::Connection &, std::chrono::nanoseconds interval);
+
+  Partitions(Partitions &&) = delete;
+  Partitions(Partitions const &) = delete;
+
+  static void create(third_party::sqlite::Connection &);
+
+  // note! the (version 2) trades table becomes the first partition
+  static void migrate_from_v2(third_party::sqlite::Connection &);
+
+  // note! returns the names of all partitions (ordered by start_time_utc)
+  static std::vector<std::string> get_names(third_party::sqlite::Connection &);
+
+  // note! returns a table expression covering all trades from start_time (only the relevant partitions)
+  static std::string select(third_party::sqlite::Connection &, std::chrono::nanoseconds start_time);
+
+  // note! returns the name of the partition covering exchange_time_utc (created if it doesn't exist)
+  std::string_view operator()(third_party::sqlite::Connection &, std::chrono::nanoseconds exchange_time_utc);
+
+  // note! re-loads the partitions, e.g. after a rollback
+  void reload(third_party::sqlite::Connection &);
+
+  // note! secondary indexes are dropped (also from new partitions) and then re-built when no longer deferred
+  void defer_indexes(third_party::sqlite::Connection &, bool);
+
+  // note!
+  //   replaces all partitions ending before exchange_time_utc with a single partition
+  //   callback is used to populate the new partition (target) from the existing partitions (source)
+  //   returns false if there was nothing to do
+  bool merge(
+      third_party::sqlite::Connection &,
+      std::chrono::nanoseconds exchange_time_utc,
+      std::function<void(std::string_view const &target, std::string_view const &source)> const &);
+
+ protected:
+  struct Partition final {
+    std::string name;
+    std::chrono::nanoseconds start_time_utc = {};
+    std::chrono::nanoseconds end_time_utc = {};
+  };
+
+  void load(third_party::sqlite::Connection &);
+
+  std::string_view add(
+      third_party::sqlite::Connection &,
+      std::chrono::nanoseconds start_time_utc,
+      std::chrono::nanoseconds end_time_utc);
+
+ private:
+  std::chrono::nanoseconds const interval_;
+  std::map<std::chrono::nanoseconds, Partition> partitions_;  // note! by start_time_utc
+  bool defer_indexes_ = false;
+};
+
+}  // namespace sqlite
+}  // namespace database
+}  // namespace risk_manager
+}  // namespace roq
@@ -0,0 +1,97 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include "roq/risk_manager/database/sqlite/pnl.hpp"
+
+#include <cmath>
+
+#include "roq/logging.hpp"
+
+#include "roq/third_party/sqlite/statement.hpp"
+
+using namespace std::literals;
+
+namespace roq {
+namespace risk_manager {
+namespace database {
+namespace sqlite {
+
+// === HELPERS ===
+
+namespace {
+// note! nan is stored as null
+void bind_value(auto &statement, size_t column, double value) {
+  if (std::isnan(value))
+    statement.bind(column);
+  else
+    statement.bind(column, value);
+}
+}  // namespace
+
+// === IMPLEMENTATION ===
+
+// create
+
+void PnL::create(third_party::sqlite::Connection &connection) {
+  log::info(R"(Creating table "{}")"sv, TABLE_NAME);
+  auto query = fmt::format(
+      "CREATE TABLE IF NOT EXISTS {} ("
+      "  user TEXT NOT NULL, "
+      "  strategy_id INTEGER NOT NULL, "
+      "  account TEXT NOT NULL, "
+      "  exchange TEXT NOT NULL, "
+      "  symbol TEXT NOT NULL, "
+      "  average_price REAL, "
+      "  realized_pnl REAL, "
+      "  fees REAL, "
+      "  update_time_utc INTEGER NOT NULL, "
+      "  PRIMARY KEY ("
+      "    user, "
+      "    strategy_id, "
+      "    account, "
+      "    exchange, "
+      "    symbol"
+      "  )"
+      ")"sv,
+      TABLE_NAME);
+  log::debug(R"(query="{}")"sv, query);
+  connection.exec(query);
+}
+
+// insert
+
+void PnL::insert(third_party::sqlite::Connection &connection, std::span<Position const> const &positions) {
+  auto now = clock::get_realtime();
+  auto query = fmt::format(
+      "INSERT OR REPLACE "
+      "INTO {} ("
+      "  user, "
+      "  strategy_id, "
+      "  account, "
+      "  exchange, "
+      "  symbol, "
+      "  average_price, "
+      "  realized_pnl, "
+      "  fees, "
+      "  update_time_utc"
+      ") "
+      "VALUES (?,?,?,?,?,?,?,?,?)"sv,
+      TABLE_NAME);
+  for (auto &item : positions) {
+    auto &statement = connection.prepare(query);
+    statement.bind(0, item.user);
+    statement.bind(1, static_cast<int64_t>(item.strategy_id));
+    statement.bind(2, item.account);
+    statement.bind(3, item.exchange);
+    statement.bind(4, item.symbol);
+    bind_value(statement, 5, item.average_price);
+    bind_value(statement, 6, item.realized_pnl);
+    bind_value(statement, 7, item.fees);
+    statement.bind(8, static_cast<int64_t>(now.count()));
+    statement.step();
+  }
+}
+
+}  // namespace sqlite
+}  // namespace database
+}  // namespace risk_manager
+}  // namespace roq
@@ -0,0 +1,38 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include <span>
+#include <string_view>
+
+#include "roq/third_party/sqlite/connection.hpp"
+
+#include "roq/risk_manager/database/position.hpp"
+
+namespace roq {
+namespace risk_manager {
+namespace database {
+namespace sqlite {
+
+// note!
+//   the latest pnl (average price, realized pnl and fees) of each position, one row per position
+//   quantities are not stored (positions are aggregated from the trades and the pnl is then joined by key)
+//   written in the same transaction as the trades having changed the positions
+
+struct PnL final {
+  static constexpr std::string_view TABLE_NAME = "pnl";
+
+  // create
+
+  static void create(third_party::sqlite::Connection &);
+
+  // insert
+
+  // note! replaces the current row
+  static void insert(third_party::sqlite::Connection &, std::span<Position const> const &);
+};
+
+}  // namespace sqlite
+}  // namespace database
+}  // namespace risk_manager
+}  // namespace roq
@@ -0,0 +1,67 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include "roq/risk_manager/database/sqlite/pool.hpp"
+
+#include <cassert>
+
+#include "roq/logging.hpp"
+
+using namespace std::literals;
+using namespace std::chrono_literals;
+
+namespace roq {
+namespace risk_manager {
+namespace database {
+namespace sqlite {
+
+// === CONSTANTS ===
+
+namespace {
+// note! a connection is never shared => no need for sqlite's own mutex
+auto const FLAGS = SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX;
+auto const BUSY_TIMEOUT = 1s;
+}  // namespace
+
+// === HELPERS ===
+
+namespace {
+auto create_connections(auto &params, auto size) {
+  std::vector<std::unique_ptr<third_party::sqlite::Connection>> result;
+  for (size_t i = 0; i < size; ++i) {
+    auto connection = std::make_unique<third_party::sqlite::Connection>(params, FLAGS);
+    (*connection).busy_timeout(BUSY_TIMEOUT);
+    result.emplace_back(std::move(connection));
+  }
+  log::info("Opened {} read-only connection(s)"sv, size);
+  return result;
+}
+}  // namespace
+
+// === IMPLEMENTATION ===
+
+Pool::Pool(std::string_view const &params, size_t size)
+    : size_{size}, available_{create_connections(params, size)} {
+}
+
+std::unique_ptr<third_party::sqlite::Connection> Pool::acquire() {
+  assert(!empty());
+  std::unique_lock lock{mutex_};
+  condition_.wait(lock, [&]() { return !std::empty(available_); });
+  auto result = std::move(available_.back());
+  available_.pop_back();
+  return result;
+}
+
+void Pool::release(std::unique_ptr<third_party::sqlite::Connection> &&connection) {
+  (*connection).reset();  // note! ends the implicit read transaction
+  {
+    std::lock_guard lock{mutex_};
+    available_.emplace_back(std::move(connection));
+  }
+  condition_.notify_one();
+}
+
+}  // namespace sqlite
+}  // namespace database
+}  // namespace risk_manager
+}  // namespace roq
@@ -0,0 +1,57 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+#include "roq/third_party/sqlite/connection.hpp"
+
+namespace roq {
+namespace risk_manager {
+namespace database {
+namespace sqlite {
+
+// note!
+//   read-only connections, each with its own statement cache
+//   a connection is leased exclusively by one thread for the duration of the callback
+
+struct Pool final {
+  Pool(std::string_view const &params, size_t size);
+
+  Pool(Pool &&) = delete;
+  Pool(Pool const &) = delete;
+
+  bool empty() const { return size_ == 0; }
+
+  // note! blocks until a connection is available
+  template <typename Callback>
+  void operator()(Callback callback) {
+    auto connection = acquire();
+    try {
+      callback(*connection);
+    } catch (...) {
+      release(std::move(connection));
+      throw;
+    }
+    release(std::move(connection));
+  }
+
+ protected:
+  std::unique_ptr<third_party::sqlite::Connection> acquire();
+  void release(std::unique_ptr<third_party::sqlite::Connection> &&);
+
+ private:
+  size_t const size_;
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  std::vector<std::unique_ptr<third_party::sqlite::Connection>> available_;
+};
+
+}  // namespace sqlite
+}  // namespace database
+}  // namespace risk_manager
+}  // namespace roq
@@ -0,0 +1,70 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include "roq/risk_manager/database/sqlite/schema.hpp"
+
+#include "roq/exceptions.hpp"
+
+#include "roq/logging.hpp"
+
+#include "roq/risk_manager/database/sqlite/dimension.hpp"
+#include "roq/risk_manager/database/sqlite/drawdowns.hpp"
+#include "roq/risk_manager/database/sqlite/funds.hpp"
+#include "roq/risk_manager/database/sqlite/limits.hpp"
+#include "roq/risk_manager/database/sqlite/partitions.hpp"
+#include "roq/risk_manager/database/sqlite/pnl.hpp"
+#include "roq/risk_manager/database/sqlite/trades.hpp"
+
+using namespace std::literals;
+
+namespace roq {
+namespace risk_manager {
+namespace database {
+namespace sqlite {
+
+// === CONSTANTS ===
+
+namespace {
+auto const TRADES = "trades"sv;
+}
+
+// === IMPLEMENTATION ===
+
+void Schema::upgrade(third_party::sqlite::Connection &connection) {
+  auto version = connection.get_user_version();
+  log::info("Database schema version={} (current: {})"sv, version, VERSION);
+  if (version > VERSION)
+    throw RuntimeError{"Unexpected: database schema version={} is not supported (current: {})"sv, version, VERSION};
+  connection.exec("BEGIN"sv);
+  try {
+    if (version == 0 && connection.table_exists(TRADES)) {
+      Trades::migrate_from_v0(connection);
+      version = 2;
+    } else if (version == 1) {
+      Trades::migrate_from_v1(connection);
+      version = 2;
+    }
+    Dimensions::create(connection);
+    Partitions::create(connection);
+    if (version == 2)
+      Partitions::migrate_from_v2(connection);
+    Funds::create(connection);
+    Limits::create(connection);
+    PnL::create(connection);
+    Drawdowns::create(connection);
+    Trades::create_trade_ids(connection);
+    if (version >= 2 && version < 5)
+      Trades::migrate_from_v4(connection);
+    if (version >= 2 && version < 6)
+      Trades::migrate_from_v5(connection);
+    connection.set_user_version(VERSION);
+    connection.exec("COMMIT"sv);
+  } catch (...) {
+    connection.exec("ROLLBACK"sv);
+    throw;
+  }
+}
+
+}  // namespace sqlite
+}  // namespace database
+}  // namespace risk_manager
+}  // namespace roq
@@ -0,0 +1,36 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include <cstdint>
+
+#include "roq/third_party/sqlite/connection.hpp"
+
+namespace roq {
+namespace risk_manager {
+namespace database {
+namespace sqlite {
+
+// note!
+//   the schema version is stored as PRAGMA user_version
+//   version 0: TEXT columns, 8-column primary key, single-column indexes
+//   version 1: dimension tables (users, accounts, exchanges, symbols) and integer keys
+//   version 2: trades are unique by (exchange, external_trade_id)
+//   version 3: trades are partitioned by exchange_time_utc ("trades" is a view)
+//   version 4: versioned limits
+//   version 5: trades are unique by (exchange, external_trade_id) across partitions (also after compression)
+//   version 6: the (redundant) unique index of each partition has been dropped
+//   version 7: pnl of positions (average price, realized pnl and fees)
+//   version 8: loss limit state (drawdowns)
+
+struct Schema final {
+  static constexpr uint32_t VERSION = 8;
+
+  // note! creates (or migrates) all tables, all in one transaction
+  static void upgrade(third_party::sqlite::Connection &);
+};
+
+}  // namespace sqlite
+}  // namespace database
+}  // namespace risk_manager
+}  // namespace roq
@@ -2,73 +2,250 @@
 
 #include "roq/risk_manager/database/sqlite/session.hpp"
 
+#include "roq/logging.hpp"
+
+#include "roq/third_party/sqlite/statement.hpp"
+
+#include "roq/risk_manager/database/sqlite/drawdowns.hpp"
 #include "roq/risk_manager/database/sqlite/funds.hpp"
+#include "roq/risk_manager/database/sqlite/limits.hpp"
+#include "roq/risk_manager/database/sqlite/pnl.hpp"
+#include "roq/risk_manager/database/sqlite/schema.hpp"
 #include "roq/risk_manager/database/sqlite/trades.hpp"
 
 using namespace std::literals;
+using namespace std::chrono_literals;
 
 namespace roq {
 namespace risk_manager {
 namespace database {
 namespace sqlite {
 
+// === CONSTANTS ===
+
+namespace {
+auto const BUSY_TIMEOUT = 1s;
+auto const PROGRESS_HANDLER_INSTRUCTIONS = 1000;
+}  // namespace
+
 // === HELPERS ===
 
 namespace {
 auto create_connection(auto &params) {
-  return std::make_unique<third_party::sqlite::Connection>(params);
+  auto result = std::make_unique<third_party::sqlite::Connection>(params);
+  (*result).busy_timeout(BUSY_TIMEOUT);
+  // note! readers will then never block the writer (and vice versa)
+  {
+    // note! must be finalized before the schema can be changed
+    third_party::sqlite::Statement statement{*result, "PRAGMA journal_mode=WAL"sv};
+    if (statement.step()) {
+      auto journal_mode = statement.template get<std::string>(0);
+      log::info(R"(Using journal_mode="{}")"sv, journal_mode);
+    }
+  }
+  // note! durable at checkpoint, much cheaper commits
+  (*result).exec("PRAGMA synchronous=NORMAL"sv);
+  // note! the schema must exist before any read-only connection is opened
+  Schema::upgrade(*result);
+  return result;
+}
+
+// note! an in-memory database can't be shared between connections
+bool is_in_memory(auto &params) {
+  return std::empty(params) || params == ":memory:"sv || params.find("mode=memory"sv) != params.npos;
+}
+
+size_t get_pool_size(auto &params, size_t read_connections) {
+  if (read_connections > 0 && is_in_memory(params)) {
+    log::warn("Queries will use the writer connection (in-memory database)"sv);
+    return 0;
+  }
+  return read_connections;
 }
 }  // namespace
 
 // === IMPLEMENTATION ===
 
-Session::Session(std::string_view const &params) : connection_{create_connection(params)} {
-  Trades::create(*connection_);
-  Funds::create(*connection_);
+Session::Session(
+    std::string_view const &params,
+    size_t read_connections,
+    std::chrono::nanoseconds partition_interval,
+    std::string_view const &backup_file,
+    std::chrono::nanoseconds backup_interval,
+    size_t backup_step_pages)
+    : connection_{create_connection(params)}, partitions_{*connection_, partition_interval},
+      pool_{params, get_pool_size(params, read_connections)},
+      backup_{mutex_, *connection_, backup_file, backup_interval, backup_step_pages} {
+  // note! full scan, only done once
+  Trades::select(*connection_, [&](Account const &account) { statistics_(account); });
+  (*connection_).reset();
 }
 
 // query
 
-void Session::operator()(std::function<void(Account const &)> const &callback) {
-  Trades::select(*connection_, callback);
+void Session::operator()(std::function<void(Account const &)> const &callback, Interrupt const &) {
+  statistics_.get_accounts(callback);
 }
 
-void Session::operator()(std::function<void(Position const &)> const &callback) {
-  Trades::select(*connection_, callback);
+void Session::operator()(std::function<void(Position const &)> const &callback, Interrupt const &interrupt) {
+  read(interrupt, [&](auto &connection) { Trades::select(connection, callback); });
 }
 
 void Session::operator()(
     std::function<void(Trade const &)> const &callback,
     std::string_view const &account,
-    std::chrono::nanoseconds start_time) {
-  Trades::select(*connection_, callback, account, start_time);
+    std::chrono::nanoseconds start_time,
+    Interrupt const &interrupt) {
+  read(interrupt, [&](auto &connection) { Trades::select(connection, callback, account, start_time); });
 }
 
 void Session::operator()(
     std::function<void(database::Funds const &)> const &callback,
     std::string_view const &account,
-    std::string_view const &currency) {
-  Funds::select(*connection_, callback, account, currency);
+    std::string_view const &currency,
+    Interrupt const &interrupt) {
+  read(interrupt, [&](auto &connection) { Funds::select(connection, callback, account, currency); });
+}
+
+void Session::operator()(std::function<void(BackupStatus const &)> const &callback, Interrupt const &) {
+  backup_.get_status(callback);
+}
+
+void Session::operator()(std::function<void(Limit const &)> const &callback, bool history, Interrupt const &interrupt) {
+  read(interrupt, [&](auto &connection) { Limits::select(connection, callback, history); });
+}
+
+void Session::operator()(std::function<void(Drawdown const &)> const &callback, Interrupt const &interrupt) {
+  read(interrupt, [&](auto &connection) { Drawdowns::select(connection, callback); });
 }
 
 // insert
 
 void Session::operator()(std::span<Trade const> const &trades) {
-  Trades::insert(*connection_, trades);
+  (*this)(trades, {}, {});
+}
+
+void Session::operator()(
+    std::span<Trade const> const &trades,
+    std::span<Position const> const &positions,
+    std::span<Drawdown const> const &drawdowns) {
+  write([&](auto &connection) {
+    transaction(connection, [&]() {
+      Trades::insert(connection, trades, dimensions_, partitions_, statistics_);
+      PnL::insert(connection, positions);
+      Drawdowns::insert(connection, drawdowns);
+    });
+  });
 }
 
 void Session::operator()(std::span<Correction const> const &corrections) {
-  Trades::insert(*connection_, corrections);
+  write([&](auto &connection) {
+    transaction(connection, [&]() { Trades::insert(connection, corrections, dimensions_, partitions_, statistics_); });
+  });
 }
 
 void Session::operator()(std::span<database::Funds const> const &funds) {
-  Funds::insert(*connection_, funds);
+  write([&](auto &connection) { transaction(connection, [&]() { Funds::insert(connection, funds); }); });
+}
+
+bool Session::operator()(std::span<Limit const> const &limits) {
+  auto result = false;
+  write([&](auto &connection) { transaction(connection, [&]() { result = Limits::insert(connection, limits); }); });
+  return result;
+}
+
+void Session::operator()(std::span<Drawdown const> const &drawdowns) {
+  write([&](auto &connection) { transaction(connection, [&]() { Drawdowns::insert(connection, drawdowns); }); });
 }
 
 // maintenance
 
+// note! compressed rows are aggregates => statistics (e.g. trade_count) are adjusted by the compressed accounts
 void Session::operator()(Compress const &compress) {
-  Trades::compress(*connection_, compress.exchange_time_utc);
+  write([&](auto &connection) {
+    statistics_.compress([&](auto const &removed, auto const &added) {
+      Trades::compress(connection, compress.exchange_time_utc, partitions_, removed, added);
+    });
+  });
+}
+
+bool Session::operator()(database::Backup const &backup) {
+  return backup_(backup.filename);
+}
+
+// note! the trade ids are never dropped (duplicates must still be ignored while bulk loading)
+void Session::operator()(Bulk const &bulk) {
+  log::info("bulk={}"sv, bulk);
+  write([&](auto &connection) {
+    partitions_.defer_indexes(connection, bulk.enabled);
+    // note! the query planner needs fresh statistics after a large change
+    if (!bulk.enabled)
+      connection.exec("ANALYZE"sv);
+  });
+}
+
+// utilities
+
+// note! the progress handler is only installed for the duration of the query
+template <typename Callback>
+void Session::read(Interrupt const &interrupt, Callback callback) {
+  auto helper = [&](auto &connection) {
+    if (!interrupt) {
+      callback(connection);
+      return;
+    }
+    connection.progress_handler(interrupt, PROGRESS_HANDLER_INSTRUCTIONS);
+    try {
+      callback(connection);
+    } catch (...) {
+      connection.progress_handler({}, 0);
+      throw;
+    }
+    connection.progress_handler({}, 0);
+  };
+  if (pool_.empty()) {
+    write(helper);
+    return;
+  }
+  pool_(helper);
+}
+
+template <typename Callback>
+void Session::write(Callback callback) {
+  std::lock_guard lock{mutex_};
+  try {
+    callback(*connection_);
+  } catch (...) {
+    (*connection_).reset();
+    throw;
+  }
+  (*connection_).reset();
+}
+
+// note! a single commit per batch (instead of one per row)
+template <typename Callback>
+void Session::transaction(third_party::sqlite::Connection &connection, Callback callback) {
+  connection.exec("BEGIN"sv);
+  try {
+    callback();
+    connection.exec("COMMIT"sv);
+  } catch (...) {
+    connection.reset();
+    connection.exec("ROLLBACK"sv);
+    statistics_.rollback();
+    reload(connection);
+    throw;
+  }
+  statistics_.commit();
+}
+
+// note!
+//   cached ids may refer to rows (dimensions) or tables (partitions) which no longer exist
+//   statistics are not affected (only committed updates are ever applied) => no full scan
+void Session::reload(third_party::sqlite::Connection &connection) {
+  log::warn("Re-loading state after rollback..."sv);
+  dimensions_.clear();
+  partitions_.reload(connection);
 }
 
 }  // namespace sqlite
@@ -2,43 +2,92 @@
 
 #pragma once
 
+#include <chrono>
 #include <memory>
+#include <mutex>
 
 #include "roq/third_party/sqlite/connection.hpp"
 
 #include "roq/risk_manager/database/session.hpp"
 
+#include "roq/risk_manager/database/sqlite/backup.hpp"
+#include "roq/risk_manager/database/sqlite/dimension.hpp"
+#include "roq/risk_manager/database/sqlite/partitions.hpp"
+#include "roq/risk_manager/database/sqlite/pool.hpp"
+#include "roq/risk_manager/database/sqlite/statistics.hpp"
+
 namespace roq {
 namespace risk_manager {
 namespace database {
 namespace sqlite {
 
+// note!
+//   inserts and maintenance are serialized on the (WAL-mode) writer connection
+//   queries lease a read-only connection from the pool and may run concurrently from any thread
+//   per-account statistics are served from memory
+//   each batch of inserts is a single transaction (in-memory state is re-loaded after a rollback)
+//   backups are executed by a dedicated thread (interleaved with the writer)
+
 struct Session final : public database::Session {
-  explicit Session(std::string_view const &params);
+  Session(
+      std::string_view const &params,
+      size_t read_connections,
+      std::chrono::nanoseconds partition_interval,
+      std::string_view const &backup_file,
+      std::chrono::nanoseconds backup_interval,
+      size_t backup_step_pages);
 
  protected:
   // query
-  void operator()(std::function<void(Account const &)> const &) override;
-  void operator()(std::function<void(Position const &)> const &) override;
+  void operator()(std::function<void(Account const &)> const &, Interrupt const &) override;
+  void operator()(std::function<void(Position const &)> const &, Interrupt const &) override;
   void operator()(
       std::function<void(Trade const &)> const &,
       std::string_view const &account,
-      std::chrono::nanoseconds start_time) override;
+      std::chrono::nanoseconds start_time,
+      Interrupt const &) override;
   void operator()(
       std::function<void(Funds const &)> const &,
       std::string_view const &account,
-      std::string_view const &currency) override;
+      std::string_view const &currency,
+      Interrupt const &) override;
+  void operator()(std::function<void(BackupStatus const &)> const &, Interrupt const &) override;
+  void operator()(std::function<void(Limit const &)> const &, bool history, Interrupt const &) override;
+  void operator()(std::function<void(Drawdown const &)> const &, Interrupt const &) override;
 
   // insert
   void operator()(std::span<Trade const> const &) override;
+  void operator()(
+      std::span<Trade const> const &, std::span<Position const> const &, std::span<Drawdown const> const &) override;
   void operator()(std::span<Correction const> const &) override;
   void operator()(std::span<Funds const> const &) override;
+  bool operator()(std::span<Limit const> const &) override;
+  void operator()(std::span<Drawdown const> const &) override;
 
   // maintenance
   void operator()(Compress const &) override;
+  bool operator()(database::Backup const &) override;
+  void operator()(Bulk const &) override;
+
+  template <typename Callback>
+  void read(Interrupt const &, Callback);
+
+  template <typename Callback>
+  void write(Callback);
+
+  template <typename Callback>
+  void transaction(third_party::sqlite::Connection &, Callback);
+
+  void reload(third_party::sqlite::Connection &);
 
  private:
+  std::mutex mutex_;  // note! writer
   std::unique_ptr<third_party::sqlite::Connection> connection_;
+  Dimensions dimensions_;  // note! writer
+  Partitions partitions_;  // note! writer
+  Pool pool_;
+  Statistics statistics_;
+  Backup backup_;  // note! must be destroyed before the writer
 };
 
 }  // namespace sqlite
@@ -0,0 +1,137 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include "roq/risk_manager/database/sqlite/statistics.hpp"
+
+#include <algorithm>
+
+using namespace std::literals;
+
+namespace roq {
+namespace risk_manager {
+namespace database {
+namespace sqlite {
+
+// === IMPLEMENTATION ===
+
+void Statistics::get_accounts(std::function<void(Account const &)> const &callback) const {
+  std::lock_guard lock{mutex_};
+  for (auto &[name, item] : accounts_) {
+    auto account = Account{
+        .name = name,
+        .exchange_time_utc_min = item.exchange_time_utc_min,
+        .exchange_time_utc_max = item.exchange_time_utc_max,
+        .trade_count = item.trade_count,
+        .volume = item.volume,
+        .notional = item.notional,
+        .duplicate_count = item.duplicate_count,
+    };
+    callback(account);
+  }
+}
+
+void Statistics::operator()(Account const &account) {
+  std::lock_guard lock{mutex_};
+  accounts_[std::string{account.name}] = create_item(account);
+}
+
+void Statistics::update(
+    std::string_view const &account,
+    std::chrono::nanoseconds exchange_time_utc,
+    int64_t trade_count,
+    double volume,
+    double notional) {
+  auto &item = get_pending(account);
+  item.exchange_time_utc_min = std::min(item.exchange_time_utc_min, exchange_time_utc);
+  item.exchange_time_utc_max = std::max(item.exchange_time_utc_max, exchange_time_utc);
+  item.trade_count += trade_count;
+  item.volume += volume;
+  item.notional += notional;
+}
+
+void Statistics::duplicate(std::string_view const &account) {
+  ++get_pending(account).duplicate_count;
+}
+
+// note! a duplicate requires the original trade => an account is only created by an update
+void Statistics::commit() {
+  if (std::empty(pending_))
+    return;
+  {
+    std::lock_guard lock{mutex_};
+    for (auto &[name, pending] : pending_) {
+      auto iter = accounts_.find(name);
+      if (iter == std::end(accounts_)) {
+        if (pending.exchange_time_utc_min <= pending.exchange_time_utc_max)
+          accounts_.emplace(name, pending);
+        continue;
+      }
+      auto &item = (*iter).second;
+      item.exchange_time_utc_min = std::min(item.exchange_time_utc_min, pending.exchange_time_utc_min);
+      item.exchange_time_utc_max = std::max(item.exchange_time_utc_max, pending.exchange_time_utc_max);
+      item.trade_count += pending.trade_count;
+      item.volume += pending.volume;
+      item.notional += pending.notional;
+      item.duplicate_count += pending.duplicate_count;
+    }
+  }
+  pending_.clear();
+}
+
+void Statistics::rollback() {
+  pending_.clear();
+}
+
+Statistics::Item Statistics::create_item(Account const &account) {
+  return {
+      .exchange_time_utc_min = account.exchange_time_utc_min,
+      .exchange_time_utc_max = account.exchange_time_utc_max,
+      .trade_count = account.trade_count,
+      .volume = account.volume,
+      .notional = account.notional,
+  };
+}
+
+// note! an empty time range (min > max) until the first update
+Statistics::Item &Statistics::get_pending(std::string_view const &account) {
+  auto iter = pending_.find(account);
+  if (iter == std::end(pending_)) {
+    auto item = Item{
+        .exchange_time_utc_min = std::chrono::nanoseconds::max(),
+        .exchange_time_utc_max = std::chrono::nanoseconds::min(),
+    };
+    iter = pending_.emplace(account, item).first;
+  }
+  return (*iter).second;
+}
+
+// note! the new partition covers the oldest time range => its earliest trade is also the earliest of the account
+void Statistics::adjust(Accounts const &removed, Accounts const &added) {
+  std::lock_guard lock{mutex_};
+  for (auto &[name, item] : removed) {
+    auto iter = accounts_.find(name);
+    if (iter == std::end(accounts_)) [[unlikely]]
+      continue;
+    auto &account = (*iter).second;
+    account.trade_count -= item.trade_count;
+    account.volume -= item.volume;
+    account.notional -= item.notional;
+  }
+  for (auto &[name, item] : added) {
+    auto iter = accounts_.find(name);
+    if (iter == std::end(accounts_)) [[unlikely]] {
+      accounts_.emplace(name, item);
+      continue;
+    }
+    auto &account = (*iter).second;
+    account.exchange_time_utc_min = item.exchange_time_utc_min;
+    account.exchange_time_utc_max = std::max(account.exchange_time_utc_max, item.exchange_time_utc_max);
+    account.trade_count += item.trade_count;
+    account.volume += item.volume;
+    account.notional += item.notional;
+  }
+}
+
+}  // namespace sqlite
+}  // namespace database
+}  // namespace risk_manager
+}  // namespace roq
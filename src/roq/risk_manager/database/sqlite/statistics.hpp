@@ -0,0 +1,94 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+#include "roq/risk_manager/database/account.hpp"
+
+namespace roq {
+namespace risk_manager {
+namespace database {
+namespace sqlite {
+
+// note!
+//   per-account trade statistics, kept in memory
+//   rebuilt once (from the database) at startup and then updated by the writer on each insert
+//   updates are buffered by the writer and only become visible when the transaction has been committed
+//   thread-safe
+
+struct Statistics final {
+  Statistics() = default;
+
+  Statistics(Statistics &&) = delete;
+  Statistics(Statistics const &) = delete;
+
+  // note! sorted by account
+  void get_accounts(std::function<void(Account const &)> const &) const;
+
+  void operator()(Account const &);
+
+  // writer
+
+  // note! trade_count, volume and notional are deltas
+  void update(
+      std::string_view const &account,
+      std::chrono::nanoseconds exchange_time_utc,
+      int64_t trade_count,
+      double volume,
+      double notional);
+
+  void duplicate(std::string_view const &account);
+
+  // note! buffered updates become visible
+  void commit();
+
+  // note! buffered updates are discarded, e.g. after a rollback
+  void rollback();
+
+  // note!
+  //   compressed partitions are replaced by position rows => fewer trades, the same volume and notional
+  //   the callback is given two callbacks: the accounts of the compressed partitions and those of the new partition
+  //   only the compressed accounts are adjusted (no full scan), nothing is changed if the callback throws
+  template <typename Callback>
+  void compress(Callback callback) {
+    Accounts removed, added;
+    callback(
+        [&](Account const &account) { removed[std::string{account.name}] = create_item(account); },
+        [&](Account const &account) { added[std::string{account.name}] = create_item(account); });
+    adjust(removed, added);
+  }
+
+ protected:
+  struct Item final {
+    std::chrono::nanoseconds exchange_time_utc_min = {};
+    std::chrono::nanoseconds exchange_time_utc_max = {};
+    uint64_t trade_count = {};
+    double volume = {};
+    double notional = {};
+    uint64_t duplicate_count = {};
+  };
+
+  using Accounts = std::map<std::string, Item, std::less<>>;
+
+  static Item create_item(Account const &);
+
+  Item &get_pending(std::string_view const &account);
+
+  void adjust(Accounts const &removed, Accounts const &added);
+
+ private:
+  mutable std::mutex mutex_;
+  Accounts accounts_;
+  Accounts pending_;  // note! writer (not protected by the mutex)
+};
+
+}  // namespace sqlite
+}  // namespace database
+}  // namespace risk_manager
+}  // namespace roq
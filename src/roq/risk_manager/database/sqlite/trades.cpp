@@ -2,12 +2,19 @@
 
 #include "roq/risk_manager/database/sqlite/trades.hpp"
 
+#include <array>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
 #include "roq/logging.hpp"
 
 #include "roq/third_party/sqlite/statement.hpp"
 
 #include "roq/risk_manager/database/type.hpp"
 
+#include "roq/risk_manager/database/sqlite/pnl.hpp"
+
 using namespace std::literals;
 
 namespace roq {
@@ -19,173 +26,343 @@ namespace sqlite {
 
 namespace {
 auto const TABLE_NAME = "trades"sv;
-}
+auto const TABLE_NAME_V0 = "trades_v0"sv;
+auto const TABLE_NAME_V1 = "trades_v1"sv;
+auto const TRADE_IDS = "trade_ids"sv;
+auto const REASON_COMPRESS = "compress"sv;
+auto const SNAPSHOT = "snapshot"sv;
+
+struct Index final {
+  std::string_view name;
+  std::string_view columns;
+  std::string_view where;
+};
+
+// note! secondary indexes (de-duplication uses the trade ids, see create_trade_ids)
+std::array<Index, 4> const INDEXES{{
+    // note! trades are selected by account (and time)
+    {"account_time"sv, "account_id, exchange_time_utc"sv, {}},
+    // note! positions are grouped by (key, exchange, symbol)
+    {"user_instrument"sv, "user_id, exchange_id, symbol_id"sv, {}},
+    {"strategy_instrument"sv, "strategy_id, exchange_id, symbol_id"sv, "strategy_id > 0"sv},
+    {"account_instrument"sv, "account_id, exchange_id, symbol_id"sv, {}},
+}};
+}  // namespace
 
 // === HELPERS ===
 
 namespace {
-auto select_positions_by_user(auto &connection) {
+// note!
+//   single pass (conditional aggregation) over integer keys
+//   names are only joined after grouping (the pnl is then joined by name, null if never persisted)
+auto &select_positions(
+    auto &connection,
+    std::string_view const &group_by,
+    std::string_view const &columns,
+    std::string_view const &join,
+    std::string_view const &where) {
   auto query = fmt::format(
       "SELECT "
-      "  t1.user, "
-      "  0 AS strategy_id, "
-      "  '' AS account, "
-      "  t1.exchange, "
-      "  t1.symbol, "
-      "  SUM(COALESCE(t1.quantity, 0.0)) AS long_quantity, "
-      "  SUM(COALESCE(t2.quantity, 0.0)) AS short_quantity, "
-      "  MAX("
-      "    COALESCE(t1.exchange_time_utc, 0), "
-      "    COALESCE(t2.exchange_time_utc, 0) "
-      "  ) AS exchange_time_utc "
+      "  p.user, "
+      "  p.strategy_id, "
+      "  p.account, "
+      "  p.exchange, "
+      "  p.symbol, "
+      "  p.long_quantity, "
+      "  p.short_quantity, "
+      "  p.exchange_time_utc, "
+      "  n.average_price, "
+      "  n.realized_pnl, "
+      "  n.fees "
       "FROM ( "
       "  SELECT "
-      "    user,"
-      "    exchange,"
-      "    symbol,"
-      "    SUM(quantity) AS quantity, "
-      "    MAX(exchange_time_utc) AS exchange_time_utc "
-      "  FROM {} "
-      "  WHERE "
-      "    side='BUY' "
-      "  GROUP BY "
-      "    user,"
-      "    exchange,"
-      "    symbol "
-      ") t1 "
-      "FULL OUTER JOIN ( "
-      "  SELECT "
-      "    user,"
-      "    exchange,"
-      "    symbol,"
-      "    SUM(quantity) AS quantity, "
-      "    MAX(exchange_time_utc) AS exchange_time_utc "
-      "  FROM {} "
-      "  WHERE "
-      "    side='SELL'  "
-      "  GROUP BY "
-      "    user,"
-      "    exchange,"
-      "    symbol"
-      ") t2 "
-      "ON "
-      "  t1.user=t2.user AND "
-      "  t1.exchange=t2.exchange AND "
-      "  t1.symbol=t2.symbol"sv,
+      "    {}, "
+      "    e.name AS exchange, "
+      "    s.name AS symbol, "
+      "    t.long_quantity, "
+      "    t.short_quantity, "
+      "    t.exchange_time_utc "
+      "  FROM ( "
+      "    SELECT "
+      "      {} AS group_id, "
+      "      exchange_id, "
+      "      symbol_id, "
+      "      SUM(CASE WHEN side={} THEN quantity ELSE 0.0 END) AS long_quantity, "
+      "      SUM(CASE WHEN side={} THEN quantity ELSE 0.0 END) AS short_quantity, "
+      "      MAX(exchange_time_utc) AS exchange_time_utc "
+      "    FROM {} "
+      "    WHERE "
+      "      {} "
+      "    GROUP BY "
+      "      {}, "
+      "      exchange_id, "
+      "      symbol_id "
+      "  ) t "
+      "  {} "
+      "  JOIN {} e ON e.id=t.exchange_id "
+      "  JOIN {} s ON s.id=t.symbol_id "
+      ") p "
+      "LEFT JOIN {} n ON "
+      "  n.user=p.user AND "
+      "  n.strategy_id=p.strategy_id AND "
+      "  n.account=p.account AND "
+      "  n.exchange=p.exchange AND "
+      "  n.symbol=p.symbol"sv,
+      columns,
+      group_by,
+      magic_enum::enum_integer(Side::BUY),
+      magic_enum::enum_integer(Side::SELL),
       TABLE_NAME,
-      TABLE_NAME);
+      where,
+      group_by,
+      join,
+      Dimensions::EXCHANGES,
+      Dimensions::SYMBOLS,
+      PnL::TABLE_NAME);
   log::debug(R"(query="{}")"sv, query);
-  return third_party::sqlite::Statement{connection, query};
+  return connection.prepare(query);
+}
+
+auto &select_positions_by_user(auto &connection) {
+  auto join = fmt::format("JOIN {} d ON d.id=t.group_id"sv, Dimensions::USERS);
+  return select_positions(connection, "user_id"sv, "d.name AS user, 0 AS strategy_id, '' AS account"sv, join, "1"sv);
 }
 
 // note! only when strategy_id > 0
-auto select_positions_by_strategy(auto &connection) {
+auto &select_positions_by_strategy(auto &connection) {
+  return select_positions(
+      connection, "strategy_id"sv, "'' AS user, t.group_id AS strategy_id, '' AS account"sv, {}, "strategy_id > 0"sv);
+}
+
+auto &select_positions_by_account(auto &connection) {
+  auto join = fmt::format("JOIN {} d ON d.id=t.group_id"sv, Dimensions::ACCOUNTS);
+  return select_positions(connection, "account_id"sv, "'' AS user, 0 AS strategy_id, d.name AS account"sv, join, "1"sv);
+}
+
+// note! null is returned as nan
+double get_value(auto &statement, size_t column) {
+  if (statement.is_null(column))
+    return NaN;
+  return statement.template get<double>(column);
+}
+
+// note! used when migrating enums stored as TEXT
+template <typename T>
+std::string enum_to_integer(std::string_view const &column, std::initializer_list<T> values) {
+  std::string result;
+  fmt::format_to(std::back_inserter(result), "CASE {} "sv, column);
+  for (auto value : values) {
+    auto name = magic_enum::enum_name(value);
+    auto integer = magic_enum::enum_integer(value);
+    fmt::format_to(std::back_inserter(result), "WHEN '{}' THEN {} "sv, name, integer);
+  }
+  fmt::format_to(std::back_inserter(result), "ELSE 0 END"sv);
+  return result;
+}
+
+struct Row final {
+  int64_t user_id = {};
+  uint32_t strategy_id = {};
+  int64_t account_id = {};
+  int64_t exchange_id = {};
+  int64_t symbol_id = {};
+  Side side = {};
+  double quantity = NaN;
+  double price = NaN;
+  std::chrono::nanoseconds exchange_time_utc = {};
+  std::string_view external_account;
+  std::string_view external_order_id;
+  std::string_view external_trade_id;
+  std::string_view reason;
+  Type type = {};
+};
+
+// note! returns false if the trade id already exists
+bool insert_trade_id(auto &connection, Row const &row) {
+  auto query = fmt::format(
+      "INSERT OR IGNORE "
+      "INTO {} ("
+      "  exchange_id, "
+      "  external_trade_id"
+      ") "
+      "VALUES (?,?)"sv,
+      TRADE_IDS);
+  auto &statement = connection.prepare(query);
+  statement.bind(0, row.exchange_id);
+  statement.bind(1, row.external_trade_id);
+  statement.step();
+  return connection.changes() > 0;
+}
+
+// note!
+//   exchange trades are unique by (exchange, external_trade_id), also across partitions
+//   a replayed fill (e.g. gateway re-download after reconnect) is therefore ignored and costs no write to a partition
+//   returns false if the row was a duplicate
+bool insert_or_ignore(auto &connection, std::string_view const &table_name, Row const &row) {
+  if (!std::empty(row.external_trade_id) && !insert_trade_id(connection, row))
+    return false;
   auto query = fmt::format(
+      "INSERT "
+      "INTO {} ("
+      "  user_id, "
+      "  strategy_id, "
+      "  account_id, "
+      "  exchange_id, "
+      "  symbol_id, "
+      "  side, "
+      "  quantity, "
+      "  price, "
+      "  exchange_time_utc, "
+      "  external_account, "
+      "  external_order_id, "
+      "  external_trade_id, "
+      "  reason, "
+      "  type"
+      ") "
+      "VALUES (?,?,?,?,?,?,?,?,?,?,?,?,?,?)"sv,
+      table_name);
+  auto &statement = connection.prepare(query);
+  statement.bind(0, row.user_id);
+  statement.bind(1, static_cast<int64_t>(row.strategy_id));
+  statement.bind(2, row.account_id);
+  statement.bind(3, row.exchange_id);
+  statement.bind(4, row.symbol_id);
+  statement.bind(5, static_cast<int32_t>(magic_enum::enum_integer(row.side)));
+  statement.bind(6, row.quantity);
+  statement.bind(7, row.price);
+  statement.bind(8, static_cast<int64_t>(row.exchange_time_utc.count()));
+  statement.bind(9, row.external_account);
+  statement.bind(10, row.external_order_id);
+  statement.bind(11, row.external_trade_id);
+  statement.bind(12, row.reason);
+  statement.bind(13, static_cast<int32_t>(magic_enum::enum_integer(row.type)));
+  statement.step();
+  return true;
+}
+
+bool insert_row(
+    auto &connection, auto &partitions, auto &statistics, Row const &row, std::string_view const &account) {
+  auto table_name = partitions(connection, row.exchange_time_utc);
+  if (!insert_or_ignore(connection, table_name, row)) {
+    statistics.duplicate(account);
+    return false;
+  }
+  statistics.update(account, row.exchange_time_utc, 1, row.quantity, row.quantity * row.price);
+  return true;
+}
+
+// note!
+//   a read transaction (nested, unlike BEGIN) => all statements see the same version of the database
+//   the statement(s) must be finalized or reset before the callback returns
+template <typename Callback>
+void snapshot(auto &connection, Callback callback) {
+  connection.exec(fmt::format("SAVEPOINT {}"sv, SNAPSHOT));
+  try {
+    callback();
+  } catch (...) {
+    connection.exec(fmt::format("ROLLBACK TO {}"sv, SNAPSHOT));
+    connection.exec(fmt::format("RELEASE {}"sv, SNAPSHOT));
+    throw;
+  }
+  connection.exec(fmt::format("RELEASE {}"sv, SNAPSHOT));
+}
+
+// note! the first trade wins if (exchange, external_trade_id) has been duplicated
+void copy_from(auto &connection, std::string_view const &table_name) {
+  auto query = fmt::format(
+      "INSERT "
+      "INTO {} ("
+      "  user_id, "
+      "  strategy_id, "
+      "  account_id, "
+      "  exchange_id, "
+      "  symbol_id, "
+      "  side, "
+      "  quantity, "
+      "  price, "
+      "  exchange_time_utc, "
+      "  external_account, "
+      "  external_order_id, "
+      "  external_trade_id, "
+      "  reason, "
+      "  type"
+      ") "
       "SELECT "
-      "  '' AS user, "
-      "  t1.strategy_id, "
-      "  '' AS account, "
-      "  t1.exchange, "
-      "  t1.symbol, "
-      "  SUM(COALESCE(t1.quantity, 0.0)) AS long_quantity, "
-      "  SUM(COALESCE(t2.quantity, 0.0)) AS short_quantity, "
-      "  MAX("
-      "    COALESCE(t1.exchange_time_utc, 0), "
-      "    COALESCE(t2.exchange_time_utc, 0) "
-      "  ) AS exchange_time_utc "
-      "FROM ( "
-      "  SELECT "
-      "    strategy_id,"
-      "    exchange,"
-      "    symbol,"
-      "    SUM(quantity) AS quantity, "
-      "    MAX(exchange_time_utc) AS exchange_time_utc "
-      "  FROM {} "
-      "  WHERE "
-      "    strategy_id > 0 AND "
-      "    side='BUY' "
-      "  GROUP BY "
-      "    strategy_id,"
-      "    exchange,"
-      "    symbol "
-      ") t1 "
-      "FULL OUTER JOIN ( "
-      "  SELECT "
-      "    strategy_id,"
-      "    exchange,"
-      "    symbol,"
-      "    SUM(quantity) AS quantity, "
-      "    MAX(exchange_time_utc) AS exchange_time_utc "
-      "  FROM {} "
-      "  WHERE "
-      "    strategy_id > 0 AND "
-      "    side='SELL' "
-      "  GROUP BY "
-      "    strategy_id,"
-      "    exchange,"
-      "    symbol"
-      ") t2 "
-      "ON "
-      "  t1.strategy_id=t2.strategy_id AND "
-      "  t1.exchange=t2.exchange AND "
-      "  t1.symbol=t2.symbol"sv,
+      "  user_id, "
+      "  strategy_id, "
+      "  account_id, "
+      "  exchange_id, "
+      "  symbol_id, "
+      "  side, "
+      "  quantity, "
+      "  price, "
+      "  exchange_time_utc, "
+      "  external_account, "
+      "  external_order_id, "
+      "  external_trade_id, "
+      "  reason, "
+      "  type "
+      "FROM {} "
+      "WHERE "
+      "  external_trade_id='' OR "
+      "  rowid IN ("
+      "    SELECT MIN(rowid) FROM {} WHERE external_trade_id<>'' GROUP BY exchange_id, external_trade_id"
+      "  ) "
+      "ORDER BY rowid"sv,
       TABLE_NAME,
-      TABLE_NAME);
+      table_name,
+      table_name);
   log::debug(R"(query="{}")"sv, query);
-  return third_party::sqlite::Statement{connection, query};
+  connection.exec(query);
 }
 
-auto select_positions_by_account(auto &connection) {
+// note! table_name can also be a partition (or a sub-query)
+void select_accounts(auto &connection, std::string_view const &table_name, auto const &callback) {
   auto query = fmt::format(
       "SELECT "
-      "  '' AS user, "
-      "  0 AS strategy_id, "
-      "  t1.account, "
-      "  t1.exchange, "
-      "  t1.symbol, "
-      "  SUM(COALESCE(t1.quantity, 0.0)) AS long_quantity, "
-      "  SUM(COALESCE(t2.quantity, 0.0)) AS short_quantity, "
-      "  MAX("
-      "    COALESCE(t1.exchange_time_utc, 0), "
-      "    COALESCE(t2.exchange_time_utc, 0) "
-      "  ) AS exchange_time_utc "
+      "  a.name AS account, "
+      "  t.exchange_time_utc_min, "
+      "  t.exchange_time_utc_max, "
+      "  t.trade_count, "
+      "  t.volume, "
+      "  t.notional "
       "FROM ( "
       "  SELECT "
-      "    account,"
-      "    exchange,"
-      "    symbol,"
-      "    SUM(quantity) AS quantity, "
-      "    MAX(exchange_time_utc) AS exchange_time_utc "
-      "  FROM {} "
-      "  WHERE side='BUY' "
-      "  GROUP BY "
-      "    account,"
-      "    exchange,"
-      "    symbol "
-      ") t1 "
-      "FULL OUTER JOIN ( "
-      "  SELECT "
-      "    account,"
-      "    exchange,"
-      "    symbol,"
-      "    SUM(quantity) AS quantity, "
-      "    MAX(exchange_time_utc) AS exchange_time_utc "
+      "    account_id, "
+      "    MIN(exchange_time_utc) AS exchange_time_utc_min, "
+      "    MAX(exchange_time_utc) AS exchange_time_utc_max, "
+      "    COUNT(*) AS trade_count, "
+      "    SUM(quantity) AS volume, "
+      "    SUM(quantity * price) AS notional "
       "  FROM {} "
-      "  WHERE "
-      "    side='SELL'  "
       "  GROUP BY "
-      "    account,"
-      "    exchange,"
-      "    symbol"
-      ") t2 "
-      "ON "
-      "  t1.account=t2.account AND "
-      "  t1.exchange=t2.exchange AND "
-      "  t1.symbol=t2.symbol"sv,
-      TABLE_NAME,
-      TABLE_NAME);
+      "    account_id "
+      ") t "
+      "JOIN {} a ON a.id=t.account_id "
+      "ORDER BY "
+      "  a.name"sv,
+      table_name,
+      Dimensions::ACCOUNTS);
   log::debug(R"(query="{}")"sv, query);
-  return third_party::sqlite::Statement{connection, query};
+  third_party::sqlite::Statement statement{connection, query};
+  while (statement.step()) {
+    auto name = statement.template get<std::string>(0);
+    auto exchange_time_utc_min = statement.template get<int64_t>(1);
+    auto exchange_time_utc_max = statement.template get<int64_t>(2);
+    auto trade_count = statement.template get<uint64_t>(3);
+    auto volume = statement.template get<double>(4);
+    auto notional = statement.template get<double>(5);
+    auto account = Account{
+        .name = name,
+        .exchange_time_utc_min = std::chrono::nanoseconds{exchange_time_utc_min},
+        .exchange_time_utc_max = std::chrono::nanoseconds{exchange_time_utc_max},
+        .trade_count = trade_count,
+        .volume = volume,
+        .notional = notional,
+    };
+    log::debug("account={}"sv, account);
+    callback(account);
+  }
 }
 }  // namespace
 
@@ -193,17 +370,20 @@ auto select_positions_by_account(auto &connection) {
 
 // create
 
-// XXX TODO maybe exchange + external_trade_id is enough for primary key?
-void Trades::create(third_party::sqlite::Connection &connection) {
-  log::info(R"(Creating table "{}")"sv, TABLE_NAME);
+// note!
+//   integer keys referencing the dimension tables (users, accounts, exchanges, symbols)
+//   no unique index, exchange trades are de-duplicated by the trade ids before being inserted (see create_trade_ids)
+void Trades::create(
+    third_party::sqlite::Connection &connection, std::string_view const &table_name, bool defer_indexes) {
+  log::info(R"(Creating table "{}")"sv, table_name);
   auto query = fmt::format(
       "CREATE TABLE IF NOT EXISTS {} ("
-      "  user TEXT, "
-      "  strategy_id INTEGER, "
-      "  account TEXT NOT NULL, "
-      "  exchange TEXT NOT NULL, "
-      "  symbol TEXT NOT NULL, "
-      "  side TEXT NOT NULL, "
+      "  user_id INTEGER NOT NULL, "
+      "  strategy_id INTEGER NOT NULL, "
+      "  account_id INTEGER NOT NULL, "
+      "  exchange_id INTEGER NOT NULL, "
+      "  symbol_id INTEGER NOT NULL, "
+      "  side INTEGER NOT NULL, "
       "  quantity REAL NOT NULL, "
       "  price REAL NOT NULL, "
       "  exchange_time_utc INTEGER NOT NULL, "
@@ -211,81 +391,197 @@ void Trades::create(third_party::sqlite::Connection &connection) {
       "  external_order_id TEXT, "
       "  external_trade_id TEXT NOT NULL, "
       "  reason TEXT NOT NULL, "
-      "  type TEXT NOT NULL, "
-      "  PRIMARY KEY ("
-      "    user, "
-      "    strategy_id, "
-      "    account, "
-      "    exchange, "
-      "    symbol, "
-      "    exchange_time_utc, "
-      "    external_trade_id, "
-      "    type "
-      "  )"
+      "  type INTEGER NOT NULL"
       ")"sv,
-      TABLE_NAME);
+      table_name);
   log::debug(R"(query="{}")"sv, query);
   connection.exec(query);
-  auto create_index = [&](auto const &index_name, bool sorted = false) {
+  if (!defer_indexes)
+    create_indexes(connection, table_name);
+}
+
+void Trades::create_indexes(third_party::sqlite::Connection &connection, std::string_view const &table_name) {
+  for (auto &index : INDEXES) {
     std::string query;
     fmt::format_to(
         std::back_inserter(query),
-        "CREATE INDEX IF NOT EXISTS idx_{}_{} ON {}({}"sv,
-        TABLE_NAME,
-        index_name,
-        TABLE_NAME,
-        index_name);
-    if (sorted)
-      fmt::format_to(std::back_inserter(query), " ASC"sv);
-    fmt::format_to(std::back_inserter(query), ")"sv);
+        "CREATE INDEX IF NOT EXISTS idx_{}_{} ON {}({})"sv,
+        table_name,
+        index.name,
+        table_name,
+        index.columns);
+    if (!std::empty(index.where))
+      fmt::format_to(std::back_inserter(query), " WHERE {}"sv, index.where);
+    log::debug(R"(query="{}")"sv, query);
     connection.exec(query);
-  };
-  create_index("user"sv);
-  create_index("strategy_id"sv);
-  create_index("account"sv);
-  create_index("exchange"sv);
-  create_index("symbol"sv);
-  create_index("side"sv);
-  create_index("exchange_time_utc"sv, true);
-  create_index("type"sv);
+  }
 }
 
-// select
+void Trades::drop_indexes(third_party::sqlite::Connection &connection, std::string_view const &table_name) {
+  for (auto &index : INDEXES) {
+    auto query = fmt::format("DROP INDEX IF EXISTS idx_{}_{}"sv, table_name, index.name);
+    log::debug(R"(query="{}")"sv, query);
+    connection.exec(query);
+  }
+}
 
-void Trades::select(third_party::sqlite::Connection &connection, std::function<void(Account const &)> const &callback) {
+void Trades::migrate_from_v0(third_party::sqlite::Connection &connection) {
+  log::info(R"(Migrating table "{}" (this may take a while)...)"sv, TABLE_NAME);
+  connection.rename_table(TABLE_NAME, TABLE_NAME_V0);
+  Dimensions::create(connection);
+  create(connection, TABLE_NAME);
+  auto intern = [&](auto const &table_name, auto const &column) {
+    auto query = fmt::format(
+        "INSERT OR IGNORE INTO {} (name) "
+        "SELECT DISTINCT COALESCE({}, '') FROM {}"sv,
+        table_name,
+        column,
+        TABLE_NAME_V0);
+    log::debug(R"(query="{}")"sv, query);
+    connection.exec(query);
+  };
+  intern(Dimensions::USERS, "user"sv);
+  intern(Dimensions::ACCOUNTS, "account"sv);
+  intern(Dimensions::EXCHANGES, "exchange"sv);
+  intern(Dimensions::SYMBOLS, "symbol"sv);
+  // note! the first trade wins if (exchange, external_trade_id) has been duplicated
   auto query = fmt::format(
+      "INSERT "
+      "INTO {} ("
+      "  user_id, "
+      "  strategy_id, "
+      "  account_id, "
+      "  exchange_id, "
+      "  symbol_id, "
+      "  side, "
+      "  quantity, "
+      "  price, "
+      "  exchange_time_utc, "
+      "  external_account, "
+      "  external_order_id, "
+      "  external_trade_id, "
+      "  reason, "
+      "  type"
+      ") "
       "SELECT "
-      "  DISTINCT(account) AS account, "
-      "  MIN(exchange_time_utc) AS exchange_time_utc, "
-      "  MAX(exchange_time_utc) AS exchange_time_utc, "
-      "  COUNT(external_trade_id) AS trade_count "
-      "FROM {} "
-      "GROUP BY "
-      "  account "
-      "ORDER BY "
-      "  account"sv,
-      TABLE_NAME);
+      "  u.id, "
+      "  COALESCE(t.strategy_id, 0), "
+      "  a.id, "
+      "  e.id, "
+      "  s.id, "
+      "  {}, "
+      "  t.quantity, "
+      "  t.price, "
+      "  t.exchange_time_utc, "
+      "  t.external_account, "
+      "  t.external_order_id, "
+      "  t.external_trade_id, "
+      "  t.reason, "
+      "  {} "
+      "FROM {} t "
+      "JOIN {} u ON u.name=COALESCE(t.user, '') "
+      "JOIN {} a ON a.name=t.account "
+      "JOIN {} e ON e.name=t.exchange "
+      "JOIN {} s ON s.name=t.symbol "
+      "WHERE "
+      "  t.external_trade_id='' OR "
+      "  t.rowid IN ("
+      "    SELECT MIN(rowid) FROM {} WHERE external_trade_id<>'' GROUP BY exchange, external_trade_id"
+      "  ) "
+      "ORDER BY t.rowid"sv,
+      TABLE_NAME,
+      enum_to_integer("t.side"sv, {Side::BUY, Side::SELL}),
+      enum_to_integer("t.type"sv, {Type::EXCHANGE, Type::MANUAL, Type::POSITION}),
+      TABLE_NAME_V0,
+      Dimensions::USERS,
+      Dimensions::ACCOUNTS,
+      Dimensions::EXCHANGES,
+      Dimensions::SYMBOLS,
+      TABLE_NAME_V0);
   log::debug(R"(query="{}")"sv, query);
-  auto statement = third_party::sqlite::Statement{connection, query};
-  while (statement.step()) {
-    auto name = statement.template get<std::string>(0);
-    auto exchange_time_utc_min = statement.template get<int64_t>(1);
-    auto exchange_time_utc_max = statement.template get<int64_t>(2);
-    auto trade_count = statement.template get<uint64_t>(3);
-    auto account = Account{
-        .name = name,
-        .exchange_time_utc_min = std::chrono::nanoseconds{exchange_time_utc_min},
-        .exchange_time_utc_max = std::chrono::nanoseconds{exchange_time_utc_max},
-        .trade_count = trade_count,
-    };
-    log::debug("account={}"sv, account);
-    callback(account);
+  connection.exec(query);
+  connection.drop_table(TABLE_NAME_V0);
+  log::info(R"(Migrated table "{}")"sv, TABLE_NAME);
+}
+
+void Trades::migrate_from_v1(third_party::sqlite::Connection &connection) {
+  log::info(R"(Migrating table "{}" (this may take a while)...)"sv, TABLE_NAME);
+  connection.rename_table(TABLE_NAME, TABLE_NAME_V1);
+  // note! indexes follow the renamed table, the names must be released before they can be re-created
+  for (auto index_name : {"user_instrument"sv, "strategy_instrument"sv, "account_instrument"sv}) {
+    auto query = fmt::format("DROP INDEX IF EXISTS idx_{}_{}"sv, TABLE_NAME, index_name);
+    log::debug(R"(query="{}")"sv, query);
+    connection.exec(query);
   }
+  create(connection, TABLE_NAME);
+  copy_from(connection, TABLE_NAME_V1);
+  connection.drop_table(TABLE_NAME_V1);
+  log::info(R"(Migrated table "{}")"sv, TABLE_NAME);
+}
+
+// note! WITHOUT ROWID => the primary key is the table (no separate index)
+void Trades::create_trade_ids(third_party::sqlite::Connection &connection) {
+  log::info(R"(Creating table "{}")"sv, TRADE_IDS);
+  auto query = fmt::format(
+      "CREATE TABLE IF NOT EXISTS {} ("
+      "  exchange_id INTEGER NOT NULL, "
+      "  external_trade_id TEXT NOT NULL, "
+      "  PRIMARY KEY (exchange_id, external_trade_id)"
+      ") WITHOUT ROWID"sv,
+      TRADE_IDS);
+  log::debug(R"(query="{}")"sv, query);
+  connection.exec(query);
+}
+
+void Trades::migrate_from_v4(third_party::sqlite::Connection &connection) {
+  log::info(R"(Migrating table "{}" (this may take a while)...)"sv, TRADE_IDS);
+  for (auto &name : Partitions::get_names(connection)) {
+    auto query = fmt::format(
+        "INSERT OR IGNORE "
+        "INTO {} ("
+        "  exchange_id, "
+        "  external_trade_id"
+        ") "
+        "SELECT "
+        "  exchange_id, "
+        "  external_trade_id "
+        "FROM {} "
+        "WHERE "
+        "  external_trade_id<>''"sv,
+        TRADE_IDS,
+        name);
+    log::debug(R"(query="{}")"sv, query);
+    connection.exec(query);
+  }
+  log::info(R"(Migrated table "{}")"sv, TRADE_IDS);
+}
+
+// note! also the partitions renamed from the (migrated) trades table, the index names then follow the original table
+void Trades::migrate_from_v5(third_party::sqlite::Connection &connection) {
+  std::vector<std::string> names;
+  {
+    auto query = "SELECT name FROM sqlite_master WHERE type='index' AND name LIKE 'idx_%_external_trade_id'"sv;
+    third_party::sqlite::Statement statement{connection, query};
+    while (statement.step())
+      names.emplace_back(statement.template get<std::string>(0));
+  }
+  for (auto &name : names) {
+    auto query = fmt::format("DROP INDEX IF EXISTS {}"sv, name);
+    log::debug(R"(query="{}")"sv, query);
+    connection.exec(query);
+  }
+  log::info("Dropped the unique index of {} partition(s)"sv, std::size(names));
+}
+
+// select
+
+void Trades::select(third_party::sqlite::Connection &connection, std::function<void(Account const &)> const &callback) {
+  select_accounts(connection, TABLE_NAME, callback);
 }
 
 void Trades::select(
     third_party::sqlite::Connection &connection, std::function<void(Position const &)> const &callback) {
-  auto dispatch = [&](auto &&statement) {
+  auto dispatch = [&](auto &statement) {
     while (statement.step()) {
       auto user = statement.template get<std::string>(0);
       auto strategy_id = statement.template get<uint32_t>(1);
@@ -304,6 +600,9 @@ void Trades::select(
           .long_quantity = long_quantity,
           .short_quantity = short_quantity,
           .exchange_time_utc = std::chrono::nanoseconds{exchange_time_utc},
+          .average_price = get_value(statement, 8),
+          .realized_pnl = get_value(statement, 9),
+          .fees = get_value(statement, 10),
       };
       callback(position);
     }
@@ -318,135 +617,228 @@ void Trades::select(
     std::function<void(Trade const &)> const &callback,
     std::string_view const &account,
     std::chrono::nanoseconds start_time) {
-  auto query = fmt::format(
-      "SELECT "
-      "  user, "
-      "  strategy_id, "
-      "  account, "
-      "  exchange, "
-      "  symbol, "
-      "  side, "
-      "  quantity, "
-      "  price, "
-      "  exchange_time_utc, "
-      "  external_account, "
-      "  external_order_id, "
-      "  external_trade_id "
-      "FROM {}"sv,
-      TABLE_NAME);
-  if (!std::empty(account) || start_time.count()) {
-    fmt::format_to(std::back_inserter(query), " WHERE "sv);
+  auto create_query = [&](auto const &table_name) {
+    auto query = fmt::format(
+        "SELECT "
+        "  u.name AS user, "
+        "  t.strategy_id, "
+        "  a.name AS account, "
+        "  e.name AS exchange, "
+        "  s.name AS symbol, "
+        "  t.side, "
+        "  t.quantity, "
+        "  t.price, "
+        "  t.exchange_time_utc, "
+        "  t.external_account, "
+        "  t.external_order_id, "
+        "  t.external_trade_id "
+        "FROM {} t "
+        "JOIN {} u ON u.id=t.user_id "
+        "JOIN {} a ON a.id=t.account_id "
+        "JOIN {} e ON e.id=t.exchange_id "
+        "JOIN {} s ON s.id=t.symbol_id"sv,
+        table_name,
+        Dimensions::USERS,
+        Dimensions::ACCOUNTS,
+        Dimensions::EXCHANGES,
+        Dimensions::SYMBOLS);
+    if (!std::empty(account) || start_time.count()) {
+      fmt::format_to(std::back_inserter(query), " WHERE "sv);
+      if (!std::empty(account))
+        fmt::format_to(std::back_inserter(query), " a.name=? "sv);
+      if (!std::empty(account) && start_time.count())
+        fmt::format_to(std::back_inserter(query), " AND "sv);
+      if (start_time.count())
+        fmt::format_to(std::back_inserter(query), " t.exchange_time_utc>=? "sv);
+    }
+    fmt::format_to(
+        std::back_inserter(query),
+        " ORDER BY "
+        "  a.name, "
+        "  t.exchange_time_utc"sv);
+    log::debug(R"(query="{}")"sv, query);
+    return query;
+  };
+  auto dispatch = [&](auto &statement) {
+    size_t column = 0;
     if (!std::empty(account))
-      fmt::format_to(std::back_inserter(query), " account='{}' "sv, account);
-    if (!std::empty(account) && start_time.count())
-      fmt::format_to(std::back_inserter(query), " AND "sv);
+      statement.bind(column++, account);
     if (start_time.count())
-      fmt::format_to(std::back_inserter(query), " exchange_time_utc>={} "sv, start_time.count());
-  }
-  fmt::format_to(
-      std::back_inserter(query),
-      " ORDER BY "
-      "  account, "
-      "  exchange_time_utc"sv);
-  log::debug(R"(query="{}")"sv, query);
-  auto statement = third_party::sqlite::Statement{connection, query};
-  while (statement.step()) {
-    auto user = statement.template get<std::string>(0);
-    auto strategy_id = statement.template get<uint32_t>(1);
-    auto account = statement.template get<std::string>(2);
-    auto exchange = statement.template get<std::string>(3);
-    auto symbol = statement.template get<std::string>(4);
-    auto side = statement.template get<std::string>(5);
-    auto quantity = statement.template get<double>(6);
-    auto price = statement.template get<double>(7);
-    auto exchange_time_utc = statement.template get<int64_t>(8);
-    auto external_account = statement.template get<std::string>(9);
-    auto external_order_id = statement.template get<std::string>(10);
-    auto external_trade_id = statement.template get<std::string>(11);
-    auto trade = Trade{
-        .user = user,
-        .strategy_id = strategy_id,
-        .account = account,
-        .exchange = exchange,
-        .symbol = symbol,
-        .side = magic_enum::enum_cast<Side>(side).value(),  // XXX TODO exception handling
-        .quantity = quantity,
-        .price = price,
-        .exchange_time_utc = std::chrono::nanoseconds{exchange_time_utc},
-        .external_account = external_account,
-        .external_order_id = external_order_id,
-        .external_trade_id = external_trade_id,
-    };
-    log::debug("trade={}"sv, trade);
-    callback(trade);
+      statement.bind(column++, static_cast<int64_t>(start_time.count()));
+    while (statement.step()) {
+      auto user = statement.template get<std::string>(0);
+      auto strategy_id = statement.template get<uint32_t>(1);
+      auto account = statement.template get<std::string>(2);
+      auto exchange = statement.template get<std::string>(3);
+      auto symbol = statement.template get<std::string>(4);
+      auto side = statement.template get<int32_t>(5);
+      auto quantity = statement.template get<double>(6);
+      auto price = statement.template get<double>(7);
+      auto exchange_time_utc = statement.template get<int64_t>(8);
+      auto external_account = statement.template get<std::string>(9);
+      auto external_order_id = statement.template get<std::string>(10);
+      auto external_trade_id = statement.template get<std::string>(11);
+      auto trade = Trade{
+          .user = user,
+          .strategy_id = strategy_id,
+          .account = account,
+          .exchange = exchange,
+          .symbol = symbol,
+          .side = magic_enum::enum_cast<Side>(side).value(),  // XXX TODO exception handling
+          .quantity = quantity,
+          .price = price,
+          .exchange_time_utc = std::chrono::nanoseconds{exchange_time_utc},
+          .external_account = external_account,
+          .external_order_id = external_order_id,
+          .external_trade_id = external_trade_id,
+      };
+      log::debug("trade={}"sv, trade);
+      callback(trade);
+    }
+  };
+  // note! parameterized => at most 2 distinct statements in the cache
+  if (!start_time.count()) {
+    dispatch(connection.prepare(create_query(TABLE_NAME)));
+    return;
   }
+  // note!
+  //   only the partitions covering start_time (or later) are scanned
+  //   the query depends on the partitions and is therefore not cached
+  //   a snapshot => the partitions can't be dropped (by compression) between the lookup and the scan
+  snapshot(connection, [&]() {
+    third_party::sqlite::Statement statement{connection, create_query(Partitions::select(connection, start_time))};
+    dispatch(statement);
+  });
 }
 
 // insert
 
-void Trades::insert(third_party::sqlite::Connection &connection, std::span<Trade const> const &trades) {
-  // XXX TODO use prepared statement
-  auto insert_or_replace = [&](auto &item) {
-    auto query = fmt::format(
-        "INSERT OR REPLACE "
-        "INTO {} "
-        "VALUES ('{}',{},'{}','{}','{}','{}',{},{},{},'{}','{}','{}','','{}')"sv,
-        TABLE_NAME,
-        item.user,
-        item.strategy_id,
-        item.account,
-        item.exchange,
-        item.symbol,
-        item.side,
-        item.quantity,
-        item.price,
-        item.exchange_time_utc.count(),
-        item.external_account,
-        item.external_order_id,
-        item.external_trade_id,
-        magic_enum::enum_name(Type::EXCHANGE));
-    log::debug(R"(query="{}")"sv, query);
-    auto statement = third_party::sqlite::Statement{connection, query};
-    statement.step();
-  };
-  for (auto &item : trades)
-    insert_or_replace(item);
+void Trades::insert(
+    third_party::sqlite::Connection &connection,
+    std::span<Trade const> const &trades,
+    Dimensions &dimensions,
+    Partitions &partitions,
+    Statistics &statistics) {
+  size_t duplicates = 0;
+  for (auto &item : trades) {
+    auto row = Row{
+        .user_id = dimensions.users(connection, item.user),
+        .strategy_id = item.strategy_id,
+        .account_id = dimensions.accounts(connection, item.account),
+        .exchange_id = dimensions.exchanges(connection, item.exchange),
+        .symbol_id = dimensions.symbols(connection, item.symbol),
+        .side = item.side,
+        .quantity = item.quantity,
+        .price = item.price,
+        .exchange_time_utc = item.exchange_time_utc,
+        .external_account = item.external_account,
+        .external_order_id = item.external_order_id,
+        .external_trade_id = item.external_trade_id,
+        .reason = {},
+        .type = Type::EXCHANGE,
+    };
+    if (!insert_row(connection, partitions, statistics, row, item.account))
+      ++duplicates;
+  }
+  if (duplicates)
+    log::info<1>("Ignored {} duplicate trade(s) (out of {})"sv, duplicates, std::size(trades));
 }
 
-void Trades::insert(third_party::sqlite::Connection &connection, std::span<Correction const> const &corrections) {
+void Trades::insert(
+    third_party::sqlite::Connection &connection,
+    std::span<Correction const> const &corrections,
+    Dimensions &dimensions,
+    Partitions &partitions,
+    Statistics &statistics) {
   auto now = clock::get_realtime();
-  // XXX TODO use prepared statement
-  auto insert_or_replace = [&](auto &item) {
-    auto exchange_time_utc = item.exchange_time_utc.count() ? item.exchange_time_utc : now;
-    // XXX TODO external_trade_id is a primary key -- should maybe require something unique?
-    auto query = fmt::format(
-        "INSERT OR REPLACE "
-        "INTO {} "
-        "VALUES ('{}',{},'{}','{}','{}','{}',{},{},{},'','','','{}','{}')"sv,
-        TABLE_NAME,
-        item.user,
-        item.strategy_id,
-        item.account,
-        item.exchange,
-        item.symbol,
-        item.side,
-        item.quantity,
-        item.price,
-        exchange_time_utc.count(),
-        item.reason,
-        magic_enum::enum_name(Type::MANUAL));
-    log::debug(R"(query="{}")"sv, query);
-    auto statement = third_party::sqlite::Statement{connection, query};
-    statement.step();
-  };
-  for (auto &item : corrections)
-    insert_or_replace(item);
+  for (auto &item : corrections) {
+    // note! no external_trade_id => never ignored
+    auto row = Row{
+        .user_id = dimensions.users(connection, item.user),
+        .strategy_id = item.strategy_id,
+        .account_id = dimensions.accounts(connection, item.account),
+        .exchange_id = dimensions.exchanges(connection, item.exchange),
+        .symbol_id = dimensions.symbols(connection, item.symbol),
+        .side = item.side,
+        .quantity = item.quantity,
+        .price = item.price,
+        .exchange_time_utc = item.exchange_time_utc.count() ? item.exchange_time_utc : now,
+        .external_account = {},
+        .external_order_id = {},
+        .external_trade_id = {},
+        .reason = item.reason,
+        .type = Type::MANUAL,
+    };
+    insert_row(connection, partitions, statistics, row, item.account);
+  }
 }
 
 // maintenance
 
-void Trades::compress(third_party::sqlite::Connection &, [[maybe_unused]] std::chrono::nanoseconds exchange_time_utc) {
-  // XXX TODO accumulate all "trades" prior to exchange_time_utc and create positions (remember group-by)
+// note!
+//   trades are accumulated into one position row per (user, strategy, account, exchange, symbol, side)
+//   only partitions ending before exchange_time_utc are compressed (they are then dropped)
+//   accounts are only aggregated over the compressed partitions (before) and the new partition (after)
+bool Trades::compress(
+    third_party::sqlite::Connection &connection,
+    std::chrono::nanoseconds exchange_time_utc,
+    Partitions &partitions,
+    std::function<void(Account const &)> const &removed,
+    std::function<void(Account const &)> const &added) {
+  auto merge = [&](auto const &target, auto const &source) {
+    select_accounts(connection, source, removed);
+    auto query = fmt::format(
+        "INSERT INTO {} ("
+        "  user_id, "
+        "  strategy_id, "
+        "  account_id, "
+        "  exchange_id, "
+        "  symbol_id, "
+        "  side, "
+        "  quantity, "
+        "  price, "
+        "  exchange_time_utc, "
+        "  external_account, "
+        "  external_order_id, "
+        "  external_trade_id, "
+        "  reason, "
+        "  type"
+        ") "
+        "SELECT "
+        "  user_id, "
+        "  strategy_id, "
+        "  account_id, "
+        "  exchange_id, "
+        "  symbol_id, "
+        "  side, "
+        "  SUM(quantity), "
+        "  COALESCE(SUM(quantity * price) / NULLIF(SUM(quantity), 0.0), 0.0), "
+        "  MAX(exchange_time_utc), "
+        "  '', "
+        "  '', "
+        "  '', "
+        "  '{}', "
+        "  {} "
+        "FROM {} "
+        "GROUP BY "
+        "  user_id, "
+        "  strategy_id, "
+        "  account_id, "
+        "  exchange_id, "
+        "  symbol_id, "
+        "  side"sv,
+        target,
+        REASON_COMPRESS,
+        magic_enum::enum_integer(Type::POSITION),
+        source);
+    log::debug(R"(query="{}")"sv, query);
+    connection.exec(query);
+    select_accounts(connection, target, added);
+  };
+  if (partitions.merge(connection, exchange_time_utc, merge))
+    return true;
+  log::info("Nothing to compress (no partition ends before exchange_time_utc={})"sv, exchange_time_utc);
+  return false;
 }
 
 }  // namespace sqlite
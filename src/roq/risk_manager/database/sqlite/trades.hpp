@@ -9,6 +9,10 @@
 #include "roq/risk_manager/database/position.hpp"
 #include "roq/risk_manager/database/trade.hpp"
 
+#include "roq/risk_manager/database/sqlite/dimension.hpp"
+#include "roq/risk_manager/database/sqlite/partitions.hpp"
+#include "roq/risk_manager/database/sqlite/statistics.hpp"
+
 namespace roq {
 namespace risk_manager {
 namespace database {
@@ -17,7 +21,29 @@ namespace sqlite {
 struct Trades final {
   // create
 
-  static void create(third_party::sqlite::Connection &);
+  // note! also used to create a partition
+  static void create(
+      third_party::sqlite::Connection &, std::string_view const &table_name, bool defer_indexes = false);
+
+  // note! secondary indexes can be dropped while bulk loading (much cheaper to build once, at the end)
+  static void create_indexes(third_party::sqlite::Connection &, std::string_view const &table_name);
+  static void drop_indexes(third_party::sqlite::Connection &, std::string_view const &table_name);
+
+  // note! converts the version 0 schema (TEXT columns) to integer keys referencing the dimension tables
+  static void migrate_from_v0(third_party::sqlite::Connection &);
+  // note! replaces the (large) unique key, trades are de-duplicated by (exchange, external_trade_id)
+  static void migrate_from_v1(third_party::sqlite::Connection &);
+
+  // note!
+  //   exchange trades are unique by (exchange, external_trade_id) across all partitions
+  //   never compressed and never pruned => grows with the number of trades ever inserted
+  static void create_trade_ids(third_party::sqlite::Connection &);
+
+  // note! populates the trade ids from all (existing) partitions
+  static void migrate_from_v4(third_party::sqlite::Connection &);
+
+  // note! drops the (redundant) unique index of each partition
+  static void migrate_from_v5(third_party::sqlite::Connection &);
 
   // query
 
@@ -31,12 +57,22 @@ struct Trades final {
 
   // insert
 
-  static void insert(third_party::sqlite::Connection &, std::span<Trade const> const &);
-  static void insert(third_party::sqlite::Connection &, std::span<Correction const> const &);
+  static void insert(
+      third_party::sqlite::Connection &, std::span<Trade const> const &, Dimensions &, Partitions &, Statistics &);
+  static void insert(
+      third_party::sqlite::Connection &, std::span<Correction const> const &, Dimensions &, Partitions &, Statistics &);
 
   // maintenance
 
-  static void compress(third_party::sqlite::Connection &, std::chrono::nanoseconds exchange_time_utc);
+  // note!
+  //   returns false if there was nothing to compress
+  //   removed are the accounts of the compressed partitions, added are those of the new partition
+  static bool compress(
+      third_party::sqlite::Connection &,
+      std::chrono::nanoseconds exchange_time_utc,
+      Partitions &,
+      std::function<void(Account const &)> const &removed,
+      std::function<void(Account const &)> const &added);
 };
 
 }  // namespace sqlite
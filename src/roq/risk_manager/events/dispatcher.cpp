@@ -0,0 +1,83 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include "roq/risk_manager/events/dispatcher.hpp"
+
+#include "roq/exceptions.hpp"
+
+using namespace std::literals;
+
+namespace roq {
+namespace risk_manager {
+namespace events {
+
+// === IMPLEMENTATION ===
+
+Dispatcher::Dispatcher(size_t source_count) : statistics_(source_count) {
+}
+
+Dispatcher::Dispatcher(Handler &handler, size_t source_count) : handler_{&handler}, statistics_(source_count) {
+}
+
+Dispatcher::Statistics Dispatcher::get_total() const {
+  Statistics result;
+  for (auto &item : statistics_) {
+    result.risk_limits_count += item.risk_limits_count;
+    result.risk_limit_count += item.risk_limit_count;
+  }
+  return result;
+}
+
+void Dispatcher::stop() {
+}
+
+void Dispatcher::send(CreateOrder const &, uint8_t source, bool) {
+  unexpected("CreateOrder"sv, source);
+}
+
+void Dispatcher::send(ModifyOrder const &, uint8_t source, bool) {
+  unexpected("ModifyOrder"sv, source);
+}
+
+void Dispatcher::send(CancelOrder const &, uint8_t source, bool) {
+  unexpected("CancelOrder"sv, source);
+}
+
+void Dispatcher::send(CancelAllOrders const &, uint8_t source, bool) {
+  unexpected("CancelAllOrders"sv, source);
+}
+
+void Dispatcher::send(MassQuote const &, uint8_t source, bool) {
+  unexpected("MassQuote"sv, source);
+}
+
+void Dispatcher::send(CancelQuotes const &, uint8_t source, bool) {
+  unexpected("CancelQuotes"sv, source);
+}
+
+void Dispatcher::send(CustomMetrics const &, uint8_t source, bool) {
+  unexpected("CustomMetrics"sv, source);
+}
+
+void Dispatcher::send(CustomMatrix const &, uint8_t source, bool) {
+  unexpected("CustomMatrix"sv, source);
+}
+
+void Dispatcher::send(CustomMessage const &, uint8_t source, bool) {
+  unexpected("CustomMessage"sv, source);
+}
+
+void Dispatcher::send(RiskLimits const &risk_limits, uint8_t source, bool) {
+  auto &statistics = statistics_.at(source);
+  ++statistics.risk_limits_count;
+  statistics.risk_limit_count += std::size(risk_limits.limits);
+  if (handler_)
+    (*handler_)(risk_limits, source);
+}
+
+void Dispatcher::unexpected(std::string_view const &name, uint8_t source) {
+  throw RuntimeError{"Unexpected: {} (source={})"sv, name, source};
+}
+
+}  // namespace events
+}  // namespace risk_manager
+}  // namespace roq
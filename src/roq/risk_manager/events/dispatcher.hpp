@@ -0,0 +1,59 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include <string_view>
+#include <vector>
+
+#include "roq/client.hpp"
+
+namespace roq {
+namespace risk_manager {
+namespace events {
+
+// note! stand-in for the gateway connections (risk limits are counted and forwarded, anything else is unexpected)
+
+struct Dispatcher final : public client::Dispatcher {
+  struct Handler {
+    virtual void operator()(RiskLimits const &, uint8_t source) = 0;
+  };
+
+  struct Statistics final {
+    uint64_t risk_limits_count = {};
+    uint64_t risk_limit_count = {};
+  };
+
+  explicit Dispatcher(size_t source_count);
+  Dispatcher(Handler &, size_t source_count);
+
+  Dispatcher(Dispatcher &&) = delete;
+  Dispatcher(Dispatcher const &) = delete;
+
+  Statistics const &get_statistics(uint8_t source) const { return statistics_[source]; }
+
+  Statistics get_total() const;
+
+ protected:
+  void stop() override;
+
+  void send(CreateOrder const &, uint8_t source, bool is_last) override;
+  void send(ModifyOrder const &, uint8_t source, bool is_last) override;
+  void send(CancelOrder const &, uint8_t source, bool is_last) override;
+  void send(CancelAllOrders const &, uint8_t source, bool is_last) override;
+  void send(MassQuote const &, uint8_t source, bool is_last) override;
+  void send(CancelQuotes const &, uint8_t source, bool is_last) override;
+  void send(CustomMetrics const &, uint8_t source, bool is_last) override;
+  void send(CustomMatrix const &, uint8_t source, bool is_last) override;
+  void send(CustomMessage const &, uint8_t source, bool is_last) override;
+  void send(RiskLimits const &, uint8_t source, bool is_last) override;
+
+  void unexpected(std::string_view const &name, uint8_t source);
+
+ private:
+  Handler *const handler_ = {};  // note! optional
+  std::vector<Statistics> statistics_;
+};
+
+}  // namespace events
+}  // namespace risk_manager
+}  // namespace roq
@@ -0,0 +1,47 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+namespace roq {
+namespace risk_manager {
+namespace events {
+
+// note!
+//   little-endian, packed (records are copied into a buffer before decoding)
+//
+//   file:         header, record*
+//   header:       magic (8), version (u32), source count (u32)
+//   record:       size (u32, excluding this field), type (u8), message info, payload
+//   message info: source (u8), is_last (u8), source session id (16), source seqno (u64), receive time utc (i64),
+//                 receive time (i64), source send time (i64), source receive time (i64), origin create time (i64),
+//                 origin create time utc (i64)
+//   string:       length (u16), bytes
+//   payload:      type specific, see recorder.cpp
+//
+//   all timestamps are the original (recorded) nanoseconds, source name is not recorded
+//
+//   version 2: reference data includes the underlying, top of book
+
+enum class Type : uint8_t {
+  TIMER = 1,
+  CONNECTED,
+  DISCONNECTED,
+  DOWNLOAD_BEGIN,
+  DOWNLOAD_END,
+  READY,
+  REFERENCE_DATA,
+  TRADE_UPDATE,
+  POSITION_UPDATE,
+  FUNDS_UPDATE,
+  TOP_OF_BOOK,
+};
+
+static constexpr std::string_view MAGIC = "ROQEVTS1";
+static constexpr uint32_t VERSION = 2;
+
+}  // namespace events
+}  // namespace risk_manager
+}  // namespace roq
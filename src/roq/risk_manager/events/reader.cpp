@@ -0,0 +1,240 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include "roq/risk_manager/events/reader.hpp"
+
+#include <bit>
+#include <cstring>
+
+#include "roq/exceptions.hpp"
+
+using namespace std::literals;
+
+namespace roq {
+namespace risk_manager {
+namespace events {
+
+// === HELPERS ===
+
+namespace {
+static_assert(std::endian::native == std::endian::little, "values are read in native byte order");
+
+struct Decoder final {
+  explicit Decoder(std::string_view const &data) : data_{data} {}
+
+  template <typename T>
+  T get() {
+    T result;
+    std::memcpy(&result, take(sizeof(T)), sizeof(T));
+    return result;
+  }
+
+  std::chrono::nanoseconds get_time() { return std::chrono::nanoseconds{get<int64_t>()}; }
+
+  std::string_view get_string() {
+    auto length = get<uint16_t>();
+    return {take(length), length};
+  }
+
+  template <typename T>
+  T get_enum() {
+    return static_cast<T>(get<uint8_t>());
+  }
+
+  std::string_view get_bytes(size_t length) { return {take(length), length}; }
+
+  std::string_view remaining() const { return data_; }
+
+ protected:
+  char const *take(size_t length) {
+    if (std::size(data_) < length) [[unlikely]]
+      throw RuntimeError{"Unexpected: record is truncated"sv};
+    auto result = std::data(data_);
+    data_.remove_prefix(length);
+    return result;
+  }
+
+ private:
+  std::string_view data_;
+};
+
+template <typename T>
+void dispatch_helper(client::Handler &handler, MessageInfo const &message_info, T const &value) {
+  Event<T> event{message_info, value};
+  handler(event);
+}
+}  // namespace
+
+// === IMPLEMENTATION ===
+
+Reader::Reader(std::string_view const &path) : path_{path}, file_{path_, std::ios::binary} {
+  if (!file_)
+    throw RuntimeError{R"(Unexpected: unable to open file="{}")"sv, path_};
+  buffer_.resize(std::size(MAGIC) + sizeof(uint32_t) * 2);
+  if (!file_.read(std::data(buffer_), std::size(buffer_)))
+    throw RuntimeError{R"(Unexpected: file="{}" is too small)"sv, path_};
+  Decoder decoder{buffer_};
+  if (decoder.get_bytes(std::size(MAGIC)) != MAGIC)
+    throw RuntimeError{R"(Unexpected: file="{}" is not an event file)"sv, path_};
+  version_ = decoder.get<uint32_t>();
+  if (version_ < 1 || version_ > VERSION)
+    throw RuntimeError{R"(Unexpected: file="{}" has version={} (expected {}))"sv, path_, version_, VERSION};
+  source_count_ = decoder.get<uint32_t>();
+}
+
+bool Reader::next() {
+  uint32_t size = {};
+  if (!file_.read(reinterpret_cast<char *>(&size), sizeof(size))) {
+    if (file_.gcount() != 0)
+      throw RuntimeError{R"(Unexpected: file="{}" is truncated)"sv, path_};
+    return false;
+  }
+  buffer_.resize(size);
+  if (!file_.read(std::data(buffer_), size))
+    throw RuntimeError{R"(Unexpected: file="{}" is truncated)"sv, path_};
+  Decoder decoder{buffer_};
+  type_ = decoder.get_enum<Type>();
+  message_info_ = {};
+  message_info_.source = decoder.get<uint8_t>();
+  message_info_.is_last = decoder.get<uint8_t>() != 0;
+  auto session_id = decoder.get_bytes(sizeof(message_info_.source_session_id));
+  std::memcpy(&message_info_.source_session_id, std::data(session_id), std::size(session_id));
+  message_info_.source_seqno = decoder.get<uint64_t>();
+  message_info_.receive_time_utc = decoder.get_time();
+  message_info_.receive_time = decoder.get_time();
+  message_info_.source_send_time = decoder.get_time();
+  message_info_.source_receive_time = decoder.get_time();
+  message_info_.origin_create_time = decoder.get_time();
+  message_info_.origin_create_time_utc = decoder.get_time();
+  if (message_info_.source >= source_count_)
+    throw RuntimeError{"Unexpected: source={} (source_count={})"sv, message_info_.source, source_count_};
+  payload_ = decoder.remaining();
+  return true;
+}
+
+// note! fields are assigned (rather than designated initializers) to be independent of declaration order
+void Reader::dispatch(client::Handler &handler) {
+  Decoder decoder{payload_};
+  switch (type_) {
+    case Type::TIMER: {
+      Timer timer;
+      timer.now = decoder.get_time();
+      dispatch_helper(handler, message_info_, timer);
+      break;
+    }
+    case Type::CONNECTED:
+      dispatch_helper(handler, message_info_, Connected{});
+      break;
+    case Type::DISCONNECTED:
+      dispatch_helper(handler, message_info_, Disconnected{});
+      break;
+    case Type::DOWNLOAD_BEGIN: {
+      DownloadBegin download_begin;
+      download_begin.account = decoder.get_string();
+      dispatch_helper(handler, message_info_, download_begin);
+      break;
+    }
+    case Type::DOWNLOAD_END: {
+      DownloadEnd download_end;
+      download_end.account = decoder.get_string();
+      download_end.max_order_id = decoder.get<uint32_t>();
+      dispatch_helper(handler, message_info_, download_end);
+      break;
+    }
+    case Type::READY:
+      dispatch_helper(handler, message_info_, Ready{});
+      break;
+    case Type::REFERENCE_DATA: {
+      ReferenceData reference_data;
+      reference_data.exchange = decoder.get_string();
+      reference_data.symbol = decoder.get_string();
+      reference_data.description = decoder.get_string();
+      reference_data.security_type = decoder.get_enum<SecurityType>();
+      reference_data.base_currency = decoder.get_string();
+      reference_data.quote_currency = decoder.get_string();
+      reference_data.margin_currency = decoder.get_string();
+      reference_data.commission_currency = decoder.get_string();
+      reference_data.tick_size = decoder.get<double>();
+      reference_data.multiplier = decoder.get<double>();
+      reference_data.min_notional = decoder.get<double>();
+      reference_data.min_trade_vol = decoder.get<double>();
+      reference_data.max_trade_vol = decoder.get<double>();
+      reference_data.trade_vol_step_size = decoder.get<double>();
+      reference_data.discard = decoder.get<uint8_t>() != 0;
+      if (version_ >= 2)
+        reference_data.underlying = decoder.get_string();
+      dispatch_helper(handler, message_info_, reference_data);
+      break;
+    }
+    case Type::TOP_OF_BOOK: {
+      TopOfBook top_of_book;
+      top_of_book.stream_id = decoder.get<uint16_t>();
+      top_of_book.exchange = decoder.get_string();
+      top_of_book.symbol = decoder.get_string();
+      top_of_book.layer.bid_price = decoder.get<double>();
+      top_of_book.layer.bid_quantity = decoder.get<double>();
+      top_of_book.layer.ask_price = decoder.get<double>();
+      top_of_book.layer.ask_quantity = decoder.get<double>();
+      dispatch_helper(handler, message_info_, top_of_book);
+      break;
+    }
+    case Type::TRADE_UPDATE: {
+      TradeUpdate trade_update;
+      trade_update.stream_id = decoder.get<uint16_t>();
+      trade_update.account = decoder.get_string();
+      trade_update.order_id = decoder.get<uint32_t>();
+      trade_update.exchange = decoder.get_string();
+      trade_update.symbol = decoder.get_string();
+      trade_update.side = decoder.get_enum<Side>();
+      trade_update.create_time_utc = decoder.get_time();
+      trade_update.update_time_utc = decoder.get_time();
+      trade_update.external_account = decoder.get_string();
+      trade_update.external_order_id = decoder.get_string();
+      trade_update.client_order_id = decoder.get_string();
+      trade_update.user = decoder.get_string();
+      trade_update.strategy_id = decoder.get<uint32_t>();
+      auto fill_count = decoder.get<uint16_t>();
+      fills_.clear();
+      for (size_t i = 0; i < fill_count; ++i) {
+        Fill fill;
+        fill.exchange_time_utc = decoder.get_time();
+        fill.external_trade_id = decoder.get_string();
+        fill.quantity = decoder.get<double>();
+        fill.price = decoder.get<double>();
+        fill.liquidity = decoder.get_enum<Liquidity>();
+        fills_.emplace_back(std::move(fill));
+      }
+      trade_update.fills = fills_;
+      dispatch_helper(handler, message_info_, trade_update);
+      break;
+    }
+    case Type::POSITION_UPDATE: {
+      PositionUpdate position_update;
+      position_update.account = decoder.get_string();
+      position_update.exchange = decoder.get_string();
+      position_update.symbol = decoder.get_string();
+      position_update.external_account = decoder.get_string();
+      position_update.long_quantity = decoder.get<double>();
+      position_update.short_quantity = decoder.get<double>();
+      position_update.exchange_time_utc = decoder.get_time();
+      dispatch_helper(handler, message_info_, position_update);
+      break;
+    }
+    case Type::FUNDS_UPDATE: {
+      FundsUpdate funds_update;
+      funds_update.account = decoder.get_string();
+      funds_update.currency = decoder.get_string();
+      funds_update.balance = decoder.get<double>();
+      funds_update.hold = decoder.get<double>();
+      funds_update.external_account = decoder.get_string();
+      funds_update.exchange_time_utc = decoder.get_time();
+      dispatch_helper(handler, message_info_, funds_update);
+      break;
+    }
+    default:
+      throw RuntimeError{"Unexpected: type={}"sv, static_cast<uint8_t>(type_)};
+  }
+}
+
+}  // namespace events
+}  // namespace risk_manager
+}  // namespace roq
@@ -0,0 +1,51 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "roq/client.hpp"
+
+#include "roq/risk_manager/events/format.hpp"
+
+namespace roq {
+namespace risk_manager {
+namespace events {
+
+// note! strings (and fills) refer to the buffer, i.e. only valid until the next record has been read
+
+struct Reader final {
+  explicit Reader(std::string_view const &path);
+
+  Reader(Reader &&) = delete;
+  Reader(Reader const &) = delete;
+
+  size_t get_source_count() const { return source_count_; }
+
+  // note! returns false when all records have been read
+  bool next();
+
+  Type get_type() const { return type_; }
+  MessageInfo const &get_message_info() const { return message_info_; }
+
+  // note! the record most recently read by next()
+  void dispatch(client::Handler &);
+
+ private:
+  std::string const path_;
+  std::ifstream file_;
+  uint32_t version_ = {};
+  size_t source_count_ = {};
+  std::string buffer_;
+  Type type_ = {};
+  MessageInfo message_info_;
+  std::string_view payload_;
+  std::vector<Fill> fills_;
+};
+
+}  // namespace events
+}  // namespace risk_manager
+}  // namespace roq
@@ -0,0 +1,254 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include "roq/risk_manager/events/recorder.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <limits>
+
+#include "roq/exceptions.hpp"
+#include "roq/logging.hpp"
+
+using namespace std::literals;
+
+namespace roq {
+namespace risk_manager {
+namespace events {
+
+// === CONSTANTS ===
+
+namespace {
+size_t const FLUSH_SIZE = 65536;
+}  // namespace
+
+// === HELPERS ===
+
+namespace {
+static_assert(std::endian::native == std::endian::little, "values are written in native byte order");
+
+template <typename T>
+void put(std::string &buffer, T value) {
+  char tmp[sizeof(T)];
+  std::memcpy(tmp, &value, sizeof(T));
+  buffer.append(tmp, sizeof(T));
+}
+
+void put(std::string &buffer, std::chrono::nanoseconds value) {
+  put<int64_t>(buffer, value.count());
+}
+
+// note! truncation is not expected (api strings are bounded)
+void put_string(std::string &buffer, std::string_view const &value) {
+  auto length = std::min<size_t>(std::size(value), std::numeric_limits<uint16_t>::max());
+  put(buffer, static_cast<uint16_t>(length));
+  buffer.append(std::data(value), length);
+}
+
+template <typename T>
+void put_enum(std::string &buffer, T value) {
+  put(buffer, static_cast<uint8_t>(value));
+}
+}  // namespace
+
+// === IMPLEMENTATION ===
+
+Recorder::Recorder(std::string_view const &path, size_t source_count)
+    : path_{path}, file_{path_, std::ios::binary | std::ios::trunc} {
+  if (!file_)
+    throw RuntimeError{R"(Unexpected: unable to open file="{}")"sv, path_};
+  buffer_.reserve(FLUSH_SIZE * 2);
+  buffer_.append(MAGIC);
+  put(buffer_, VERSION);
+  put(buffer_, static_cast<uint32_t>(source_count));
+  flush();
+  log::info(R"(Recording events to file="{}")"sv, path_);
+}
+
+Recorder::~Recorder() {
+  try {
+    flush();
+  } catch (...) {
+  }
+}
+
+// payload: now (i64)
+void Recorder::operator()(Event<Timer> const &event) {
+  begin(Type::TIMER, event.message_info);
+  put(buffer_, event.value.now);
+  end();
+  flush();  // note! at most one timer period is lost
+}
+
+// payload: (empty)
+void Recorder::operator()(Event<Connected> const &event) {
+  begin(Type::CONNECTED, event.message_info);
+  end();
+}
+
+// payload: (empty)
+void Recorder::operator()(Event<Disconnected> const &event) {
+  begin(Type::DISCONNECTED, event.message_info);
+  end();
+}
+
+// payload: account (string)
+void Recorder::operator()(Event<DownloadBegin> const &event) {
+  auto &download_begin = event.value;
+  begin(Type::DOWNLOAD_BEGIN, event.message_info);
+  put_string(buffer_, download_begin.account);
+  end();
+}
+
+// payload: account (string), max order id (u32)
+void Recorder::operator()(Event<DownloadEnd> const &event) {
+  auto &download_end = event.value;
+  begin(Type::DOWNLOAD_END, event.message_info);
+  put_string(buffer_, download_end.account);
+  put(buffer_, download_end.max_order_id);
+  end();
+}
+
+// payload: (empty)
+void Recorder::operator()(Event<Ready> const &event) {
+  begin(Type::READY, event.message_info);
+  end();
+}
+
+// payload: exchange, symbol, description, security type (u8), base currency, quote currency, margin currency,
+//          commission currency, tick size (f64), multiplier (f64), min notional (f64), min trade vol (f64),
+//          max trade vol (f64), trade vol step size (f64), discard (u8), underlying
+void Recorder::operator()(Event<ReferenceData> const &event) {
+  auto &reference_data = event.value;
+  begin(Type::REFERENCE_DATA, event.message_info);
+  put_string(buffer_, reference_data.exchange);
+  put_string(buffer_, reference_data.symbol);
+  put_string(buffer_, reference_data.description);
+  put_enum(buffer_, reference_data.security_type);
+  put_string(buffer_, reference_data.base_currency);
+  put_string(buffer_, reference_data.quote_currency);
+  put_string(buffer_, reference_data.margin_currency);
+  put_string(buffer_, reference_data.commission_currency);
+  put(buffer_, reference_data.tick_size);
+  put(buffer_, reference_data.multiplier);
+  put(buffer_, reference_data.min_notional);
+  put(buffer_, reference_data.min_trade_vol);
+  put(buffer_, reference_data.max_trade_vol);
+  put(buffer_, reference_data.trade_vol_step_size);
+  put<uint8_t>(buffer_, reference_data.discard);
+  put_string(buffer_, reference_data.underlying);
+  end();
+}
+
+// payload: stream id (u16), exchange, symbol, bid price (f64), bid quantity (f64), ask price (f64),
+//          ask quantity (f64)
+void Recorder::operator()(Event<TopOfBook> const &event) {
+  auto &top_of_book = event.value;
+  begin(Type::TOP_OF_BOOK, event.message_info);
+  put(buffer_, top_of_book.stream_id);
+  put_string(buffer_, top_of_book.exchange);
+  put_string(buffer_, top_of_book.symbol);
+  put(buffer_, top_of_book.layer.bid_price);
+  put(buffer_, top_of_book.layer.bid_quantity);
+  put(buffer_, top_of_book.layer.ask_price);
+  put(buffer_, top_of_book.layer.ask_quantity);
+  end();
+}
+
+// payload: stream id (u16), account, order id (u32), exchange, symbol, side (u8), create time utc (i64),
+//          update time utc (i64), external account, external order id, client order id, user, strategy id (u32),
+//          fill count (u16), (exchange time utc (i64), external trade id, quantity (f64), price (f64), liquidity (u8))*
+void Recorder::operator()(Event<TradeUpdate> const &event) {
+  auto &trade_update = event.value;
+  if (std::size(trade_update.fills) > std::numeric_limits<uint16_t>::max()) [[unlikely]]
+    throw RuntimeError{"Unexpected: too many fills (size={})"sv, std::size(trade_update.fills)};
+  begin(Type::TRADE_UPDATE, event.message_info);
+  put(buffer_, trade_update.stream_id);
+  put_string(buffer_, trade_update.account);
+  put(buffer_, trade_update.order_id);
+  put_string(buffer_, trade_update.exchange);
+  put_string(buffer_, trade_update.symbol);
+  put_enum(buffer_, trade_update.side);
+  put(buffer_, trade_update.create_time_utc);
+  put(buffer_, trade_update.update_time_utc);
+  put_string(buffer_, trade_update.external_account);
+  put_string(buffer_, trade_update.external_order_id);
+  put_string(buffer_, trade_update.client_order_id);
+  put_string(buffer_, trade_update.user);
+  put(buffer_, trade_update.strategy_id);
+  put(buffer_, static_cast<uint16_t>(std::size(trade_update.fills)));
+  for (auto &fill : trade_update.fills) {
+    put(buffer_, fill.exchange_time_utc);
+    put_string(buffer_, fill.external_trade_id);
+    put(buffer_, fill.quantity);
+    put(buffer_, fill.price);
+    put_enum(buffer_, fill.liquidity);
+  }
+  end();
+}
+
+// payload: account, exchange, symbol, external account, long quantity (f64), short quantity (f64),
+//          exchange time utc (i64)
+void Recorder::operator()(Event<PositionUpdate> const &event) {
+  auto &position_update = event.value;
+  begin(Type::POSITION_UPDATE, event.message_info);
+  put_string(buffer_, position_update.account);
+  put_string(buffer_, position_update.exchange);
+  put_string(buffer_, position_update.symbol);
+  put_string(buffer_, position_update.external_account);
+  put(buffer_, position_update.long_quantity);
+  put(buffer_, position_update.short_quantity);
+  put(buffer_, position_update.exchange_time_utc);
+  end();
+}
+
+// payload: account, currency, balance (f64), hold (f64), external account, exchange time utc (i64)
+void Recorder::operator()(Event<FundsUpdate> const &event) {
+  auto &funds_update = event.value;
+  begin(Type::FUNDS_UPDATE, event.message_info);
+  put_string(buffer_, funds_update.account);
+  put_string(buffer_, funds_update.currency);
+  put(buffer_, funds_update.balance);
+  put(buffer_, funds_update.hold);
+  put_string(buffer_, funds_update.external_account);
+  put(buffer_, funds_update.exchange_time_utc);
+  end();
+}
+
+void Recorder::flush() {
+  if (std::empty(buffer_))
+    return;
+  file_.write(std::data(buffer_), std::size(buffer_));
+  file_.flush();
+  buffer_.clear();
+  if (!file_) [[unlikely]]
+    throw RuntimeError{R"(Unexpected: unable to write file="{}")"sv, path_};
+}
+
+void Recorder::begin(Type type, MessageInfo const &message_info) {
+  static_assert(sizeof(message_info.source_session_id) == 16);
+  offset_ = std::size(buffer_);
+  put<uint32_t>(buffer_, 0);  // note! updated by end()
+  put_enum(buffer_, type);
+  put(buffer_, message_info.source);
+  put<uint8_t>(buffer_, message_info.is_last);
+  buffer_.append(reinterpret_cast<char const *>(&message_info.source_session_id), 16);
+  put(buffer_, message_info.source_seqno);
+  put(buffer_, message_info.receive_time_utc);
+  put(buffer_, message_info.receive_time);
+  put(buffer_, message_info.source_send_time);
+  put(buffer_, message_info.source_receive_time);
+  put(buffer_, message_info.origin_create_time);
+  put(buffer_, message_info.origin_create_time_utc);
+}
+
+void Recorder::end() {
+  auto size = static_cast<uint32_t>(std::size(buffer_) - offset_ - sizeof(uint32_t));
+  std::memcpy(std::data(buffer_) + offset_, &size, sizeof(size));
+  if (std::size(buffer_) >= FLUSH_SIZE)
+    flush();
+}
+
+}  // namespace events
+}  // namespace risk_manager
+}  // namespace roq
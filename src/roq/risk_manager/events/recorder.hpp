@@ -0,0 +1,54 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include <fstream>
+#include <string>
+#include <string_view>
+
+#include "roq/api.hpp"
+
+#include "roq/risk_manager/events/format.hpp"
+
+namespace roq {
+namespace risk_manager {
+namespace events {
+
+// note! events are buffered and written when the buffer is full or when a timer event is recorded
+
+struct Recorder final {
+  Recorder(std::string_view const &path, size_t source_count);
+
+  Recorder(Recorder &&) = delete;
+  Recorder(Recorder const &) = delete;
+
+  ~Recorder();
+
+  void operator()(Event<Timer> const &);
+  void operator()(Event<Connected> const &);
+  void operator()(Event<Disconnected> const &);
+  void operator()(Event<DownloadBegin> const &);
+  void operator()(Event<DownloadEnd> const &);
+  void operator()(Event<Ready> const &);
+  void operator()(Event<ReferenceData> const &);
+  void operator()(Event<TopOfBook> const &);
+  void operator()(Event<TradeUpdate> const &);
+  void operator()(Event<PositionUpdate> const &);
+  void operator()(Event<FundsUpdate> const &);
+
+  void flush();
+
+ protected:
+  void begin(Type, MessageInfo const &);
+  void end();
+
+ private:
+  std::string const path_;
+  std::ofstream file_;
+  std::string buffer_;
+  size_t offset_ = {};  // note! current record
+};
+
+}  // namespace events
+}  // namespace risk_manager
+}  // namespace roq
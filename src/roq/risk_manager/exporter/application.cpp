@@ -0,0 +1,97 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include "roq/risk_manager/exporter/application.hpp"
+
+#include <charconv>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include "roq/exceptions.hpp"
+#include "roq/logging.hpp"
+
+#include "roq/risk_manager/database/factory.hpp"
+
+#include "roq/risk_manager/columnar/encoder.hpp"
+
+#include "roq/risk_manager/exporter/flags/flags.hpp"
+
+using namespace std::literals;
+
+namespace roq {
+namespace risk_manager {
+namespace exporter {
+
+// === HELPERS ===
+
+namespace {
+std::chrono::nanoseconds get_start_time(std::string_view const &value) {
+  if (std::empty(value))
+    return {};
+  int64_t result = {};
+  auto [ptr, error_code] = std::from_chars(std::data(value), std::data(value) + std::size(value), result);
+  if (error_code != std::errc{} || ptr != std::data(value) + std::size(value))
+    log::fatal(R"(Unexpected: start_time="{}")"sv, value);
+  return std::chrono::nanoseconds{result};
+}
+}  // namespace
+
+// === IMPLEMENTATION ===
+
+int Application::main(args::Parser const &args) {
+  auto params = args.params();
+  if (std::size(params) != 1)
+    log::fatal("Expected: output file"sv);
+  auto flags = flags::Flags::create();
+  auto positions = flags.export_type == "positions"sv;
+  if (!positions && flags.export_type != "trades"sv)
+    log::fatal(R"(Unexpected: type="{}")"sv, flags.export_type);
+  auto start_time = get_start_time(flags.export_start_time);
+  auto session = database::Factory::create({
+      // note! no read-only connections and no scheduled backups
+      .type = flags.db_type,
+      .params = flags.db_params,
+      .partition_interval = flags.db_partition_interval,
+  });
+  std::string path{params[0]};
+  std::ofstream file{path, std::ios::binary | std::ios::trunc};
+  if (!file)
+    throw RuntimeError{R"(Unexpected: unable to open file="{}")"sv, path};
+  auto output = [&](auto &data) { file.write(std::data(data), std::size(data)); };
+  auto started = std::chrono::steady_clock::now();
+  size_t row_count = 0;
+  if (positions) {
+    columnar::Writer writer{output, columnar::Encoder::get_positions_schema(), flags.export_row_group_size};
+    auto callback = [&](database::Position const &position) {
+      columnar::Encoder::encode(writer, position);
+      ++row_count;
+    };
+    (*session)(callback, {});
+    writer.finish();
+  } else {
+    columnar::Writer writer{output, columnar::Encoder::get_trades_schema(), flags.export_row_group_size};
+    auto callback = [&](database::Trade const &trade) {
+      columnar::Encoder::encode(writer, trade);
+      ++row_count;
+    };
+    (*session)(callback, flags.export_account, start_time, {});
+    writer.finish();
+  }
+  file.close();
+  if (!file)
+    throw RuntimeError{R"(Unexpected: unable to write file="{}")"sv, path};
+  auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - started);
+  log::info(
+      R"(Exported {} (row_count={}, file="{}", size={}, duration={}))"sv,
+      flags.export_type,
+      row_count,
+      path,
+      std::filesystem::file_size(path),
+      duration);
+  return EXIT_SUCCESS;
+}
+
+}  // namespace exporter
+}  // namespace risk_manager
+}  // namespace roq
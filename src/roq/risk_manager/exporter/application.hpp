@@ -0,0 +1,20 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include "roq/service.hpp"
+
+namespace roq {
+namespace risk_manager {
+namespace exporter {
+
+struct Application final : public Service {
+  using Service::Service;  // inherit constructors
+
+ protected:
+  int main(args::Parser const &) override;
+};
+
+}  // namespace exporter
+}  // namespace risk_manager
+}  // namespace roq
@@ -0,0 +1,33 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include "roq/risk_manager/importer/application.hpp"
+
+#include "roq/logging.hpp"
+
+#include "roq/risk_manager/importer/flags/flags.hpp"
+
+#include "roq/risk_manager/importer/importer.hpp"
+
+using namespace std::literals;
+
+namespace roq {
+namespace risk_manager {
+namespace importer {
+
+// === IMPLEMENTATION ===
+
+int Application::main(args::Parser const &args) {
+  auto params = args.params();
+  if (std::empty(params))
+    log::fatal("Expected: one or more files (csv or ndjson)"sv);
+  auto flags = flags::Flags::create();
+  Importer importer{flags};
+  for (auto &path : params)
+    importer(path);
+  importer.finish();
+  return EXIT_SUCCESS;
+}
+
+}  // namespace importer
+}  // namespace risk_manager
+}  // namespace roq
@@ -0,0 +1,198 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include "roq/risk_manager/importer/importer.hpp"
+
+#include <algorithm>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <optional>
+#include <span>
+#include <utility>
+
+#include "roq/exceptions.hpp"
+#include "roq/logging.hpp"
+
+#include "roq/utils/compare.hpp"
+
+#include "roq/risk_manager/database/factory.hpp"
+
+using namespace std::literals;
+
+namespace roq {
+namespace risk_manager {
+namespace importer {
+
+// === HELPERS ===
+
+namespace {
+auto create_session(auto &flags) {
+  auto result = database::Factory::create({
+      // note! no read-only connections and no scheduled backups
+      .type = flags.db_type,
+      .params = flags.db_params,
+      .partition_interval = flags.db_partition_interval,
+  });
+  (*result)(database::Bulk{.enabled = true});
+  return result;
+}
+
+auto get_rate(size_t count, std::chrono::nanoseconds duration) {
+  auto seconds = std::chrono::duration<double>{duration}.count();
+  return seconds > 0.0 ? static_cast<double>(count) / seconds : 0.0;
+}
+
+auto get_duration(auto start_time) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_time);
+}
+}  // namespace
+
+// === IMPLEMENTATION ===
+
+Importer::Importer(flags::Flags const &flags)
+    : format_{flags.import_format}, threads_{std::max<size_t>(flags.import_threads, 1)},
+      chunk_size_{flags.import_chunk_size}, session_{create_session(flags)},
+      start_time_{std::chrono::steady_clock::now()} {
+  if (chunk_size_ == 0)
+    log::fatal("Unexpected: chunk size must be positive"sv);
+}
+
+Importer::~Importer() {
+  if (finished_)
+    return;
+  log::warn("Import did not finish, building indexes..."sv);
+  try {
+    (*session_)(database::Bulk{.enabled = false});
+  } catch (std::exception &e) {
+    log::error(R"(Unable to build indexes (what="{}"))"sv, e.what());
+  }
+}
+
+void Importer::operator()(std::string_view const &path) {
+  auto start_time = std::chrono::steady_clock::now();
+  auto trade_count = trade_count_, correction_count = correction_count_;
+  auto format = get_format(path);
+  log::info(R"(Importing file="{}" (format={})...)"sv, path, magic_enum::enum_name(format));
+  std::ifstream file{std::string{path}, std::ios::binary};
+  if (!file)
+    throw RuntimeError{R"(Unexpected: unable to open file="{}")"sv, path};
+  std::string header;
+  if (format == Format::CSV) {
+    if (!std::getline(file, header))
+      throw RuntimeError{R"(Unexpected: file="{}" has no header)"sv, path};
+    if (!std::empty(header) && header.back() == '\r')
+      header.pop_back();
+  }
+  Parser parser{format, header};
+  // note! must be destroyed before the parser (futures returned by std::async will block)
+  std::deque<std::future<std::unique_ptr<Batch>>> pending;
+  auto next = [&]() {
+    auto batch = pending.front().get();
+    pending.pop_front();
+    insert(*batch);
+  };
+  std::string remainder;
+  while (file) {
+    auto buffer = std::exchange(remainder, {});
+    auto offset = std::size(buffer);
+    buffer.resize(offset + chunk_size_);
+    file.read(std::data(buffer) + offset, chunk_size_);
+    buffer.resize(offset + file.gcount());
+    // note! the last line may be incomplete (unless we're at the end of the file)
+    if (file) {
+      auto end = buffer.rfind('\n');
+      if (end == buffer.npos) {
+        remainder = std::move(buffer);
+        continue;
+      }
+      remainder.assign(std::data(buffer) + end + 1, std::size(buffer) - end - 1);
+      buffer.resize(end + 1);
+    }
+    if (std::empty(buffer))
+      continue;
+    pending.emplace_back(std::async(std::launch::async, [&parser, buffer = std::move(buffer)]() mutable {
+      return parser(std::move(buffer));
+    }));
+    if (std::size(pending) >= threads_)
+      next();
+  }
+  if (file.bad())
+    throw RuntimeError{R"(Unexpected: unable to read file="{}")"sv, path};
+  while (!std::empty(pending))
+    next();
+  auto duration = get_duration(start_time);
+  auto count = (trade_count_ - trade_count) + (correction_count_ - correction_count);
+  log::info(
+      R"(Imported file="{}" (trade_count={}, correction_count={}, duration={}, rows/second={:.0f}))"sv,
+      path,
+      trade_count_ - trade_count,
+      correction_count_ - correction_count,
+      duration,
+      get_rate(count, duration));
+}
+
+void Importer::finish() {
+  auto load_duration = get_duration(start_time_);
+  log::info("Building indexes..."sv);
+  auto start_time = std::chrono::steady_clock::now();
+  (*session_)(database::Bulk{.enabled = false});
+  finished_ = true;
+  auto index_duration = get_duration(start_time);
+  size_t position_count = 0;
+  (*session_)([&](database::Position const &) { ++position_count; }, {});
+  uint64_t duplicate_count = 0;
+  (*session_)([&](database::Account const &account) { duplicate_count += account.duplicate_count; }, {});
+  auto duration = get_duration(start_time_);
+  auto count = trade_count_ + correction_count_;
+  log::info(
+      "Imported trade_count={}, correction_count={}, duplicate_count={}, position_count={} "
+      "(load_duration={}, index_duration={}, duration={}, rows/second={:.0f})"sv,
+      trade_count_,
+      correction_count_,
+      duplicate_count,
+      position_count,
+      load_duration,
+      index_duration,
+      duration,
+      get_rate(count, duration));
+}
+
+// note! missing format means "by file extension"
+Format Importer::get_format(std::string_view const &path) const {
+  auto helper = [](auto &value) -> std::optional<Format> {
+    if (utils::case_insensitive_compare(value, "csv"sv) == 0)
+      return Format::CSV;
+    if (utils::case_insensitive_compare(value, "ndjson"sv) == 0 ||
+        utils::case_insensitive_compare(value, "jsonl"sv) == 0)
+      return Format::NDJSON;
+    return {};
+  };
+  if (!std::empty(format_)) {
+    auto format = helper(format_);
+    if (!format.has_value())
+      throw RuntimeError{R"(Unexpected: format="{}")"sv, format_};
+    return format.value();
+  }
+  auto extension = std::filesystem::path{path}.extension().string();
+  if (!std::empty(extension))
+    extension.erase(0, 1);
+  auto format = helper(extension);
+  if (!format.has_value())
+    throw RuntimeError{R"(Unexpected: unable to derive format from file="{}" (use --import_format))"sv, path};
+  return format.value();
+}
+
+void Importer::insert(Batch const &batch) {
+  if (!std::empty(batch.trades))
+    (*session_)(std::span<database::Trade const>{batch.trades});
+  if (!std::empty(batch.corrections))
+    (*session_)(std::span<database::Correction const>{batch.corrections});
+  trade_count_ += std::size(batch.trades);
+  correction_count_ += std::size(batch.corrections);
+  log::info<1>("trade_count={}, correction_count={}"sv, trade_count_, correction_count_);
+}
+
+}  // namespace importer
+}  // namespace risk_manager
+}  // namespace roq
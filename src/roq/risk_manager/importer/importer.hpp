@@ -0,0 +1,56 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "roq/risk_manager/database/session.hpp"
+
+#include "roq/risk_manager/importer/flags/flags.hpp"
+
+#include "roq/risk_manager/importer/parser.hpp"
+
+namespace roq {
+namespace risk_manager {
+namespace importer {
+
+// note!
+//   files are read in chunks (only complete lines) which are parsed concurrently
+//   batches are inserted (in order) by the calling thread, one transaction per batch
+//   the database is in bulk mode until finish() (e.g. secondary indexes are only built at the end)
+//   bulk mode is also ended when destroyed without finish() (e.g. an exception), i.e. indexes are always re-built
+
+struct Importer final {
+  explicit Importer(flags::Flags const &);
+
+  Importer(Importer &&) = delete;
+  Importer(Importer const &) = delete;
+
+  ~Importer();
+
+  void operator()(std::string_view const &path);
+
+  void finish();
+
+ protected:
+  Format get_format(std::string_view const &path) const;
+
+  void insert(Batch const &);
+
+ private:
+  std::string const format_;
+  size_t const threads_;
+  size_t const chunk_size_;
+  std::unique_ptr<database::Session> session_;
+  std::chrono::steady_clock::time_point const start_time_;
+  size_t trade_count_ = {};
+  size_t correction_count_ = {};
+  bool finished_ = false;
+};
+
+}  // namespace importer
+}  // namespace risk_manager
+}  // namespace roq
@@ -0,0 +1,320 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include "roq/risk_manager/importer/parser.hpp"
+
+#include <nlohmann/json.hpp>
+
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <utility>
+
+#include "roq/exceptions.hpp"
+
+using namespace std::literals;
+
+namespace roq {
+namespace risk_manager {
+namespace importer {
+
+// === CONSTANTS ===
+
+namespace {
+auto const CSV_SEPARATOR = ',';
+auto const CSV_QUOTE = '"';
+
+std::array<std::pair<std::string_view, Field>, 13> const FIELDS{{
+    {"user"sv, Field::USER},
+    {"strategy_id"sv, Field::STRATEGY_ID},
+    {"account"sv, Field::ACCOUNT},
+    {"exchange"sv, Field::EXCHANGE},
+    {"symbol"sv, Field::SYMBOL},
+    {"side"sv, Field::SIDE},
+    {"quantity"sv, Field::QUANTITY},
+    {"price"sv, Field::PRICE},
+    {"exchange_time_utc"sv, Field::EXCHANGE_TIME_UTC},
+    {"external_account"sv, Field::EXTERNAL_ACCOUNT},
+    {"external_order_id"sv, Field::EXTERNAL_ORDER_ID},
+    {"external_trade_id"sv, Field::EXTERNAL_TRADE_ID},
+    {"reason"sv, Field::REASON},
+}};
+}  // namespace
+
+// === HELPERS ===
+
+namespace {
+Field get_field(std::string_view const &name) {
+  for (auto &[key, field] : FIELDS)
+    if (key == name)
+      return field;
+  throw RuntimeError{R"(Unexpected: field="{}" not supported)"sv, name};
+}
+
+// note! empty means "default"
+template <typename R>
+R convert(std::string_view const &value, R default_value = {}) {
+  if (std::empty(value))
+    return default_value;
+  R result = {};
+  auto [ptr, error_code] = std::from_chars(std::data(value), std::data(value) + std::size(value), result);
+  if (error_code == std::errc{} && ptr == std::data(value) + std::size(value))
+    return result;
+  throw InvalidArgument{R"(parse: "{}")"sv, value};
+}
+
+Side convert_side(std::string_view const &value) {
+  auto side = magic_enum::enum_cast<Side>(value);
+  if (!side.has_value())
+    throw InvalidArgument{R"(parse: side="{}")"sv, value};
+  return side.value();
+}
+
+// note! typed record, strings refer to the buffer (or storage)
+struct Item final {
+  std::string_view user;
+  uint32_t strategy_id = {};
+  std::string_view account;
+  std::string_view exchange;
+  std::string_view symbol;
+  Side side = {};
+  double quantity = NaN;
+  double price = NaN;
+  std::chrono::nanoseconds exchange_time_utc = {};
+  std::string_view external_account;
+  std::string_view external_order_id;
+  std::string_view external_trade_id;
+  std::string_view reason;
+};
+
+void set(Item &item, Field field, std::string_view const &value) {
+  switch (field) {
+    case Field::UNKNOWN:
+      break;
+    case Field::USER:
+      item.user = value;
+      break;
+    case Field::STRATEGY_ID:
+      item.strategy_id = convert<uint32_t>(value);
+      break;
+    case Field::ACCOUNT:
+      item.account = value;
+      break;
+    case Field::EXCHANGE:
+      item.exchange = value;
+      break;
+    case Field::SYMBOL:
+      item.symbol = value;
+      break;
+    case Field::SIDE:
+      item.side = convert_side(value);
+      break;
+    case Field::QUANTITY:
+      item.quantity = convert<double>(value, NaN);
+      break;
+    case Field::PRICE:
+      item.price = convert<double>(value, NaN);
+      break;
+    case Field::EXCHANGE_TIME_UTC:
+      item.exchange_time_utc = std::chrono::nanoseconds{convert<int64_t>(value)};
+      break;
+    case Field::EXTERNAL_ACCOUNT:
+      item.external_account = value;
+      break;
+    case Field::EXTERNAL_ORDER_ID:
+      item.external_order_id = value;
+      break;
+    case Field::EXTERNAL_TRADE_ID:
+      item.external_trade_id = value;
+      break;
+    case Field::REASON:
+      item.reason = value;
+      break;
+  }
+}
+
+void add(Batch &batch, Item const &item) {
+  if (std::empty(item.account) || std::empty(item.exchange) || std::empty(item.symbol))
+    throw RuntimeError{"Unexpected: account, exchange and symbol are required"sv};
+  if (item.side != Side::BUY && item.side != Side::SELL)
+    throw RuntimeError{"Unexpected: side={}"sv, magic_enum::enum_name(item.side)};
+  if (std::isnan(item.quantity) || std::isnan(item.price))
+    throw RuntimeError{"Unexpected: quantity and price are required"sv};
+  if (std::empty(item.reason)) {
+    // note! corrections would default to "now" which is never right for historical trades
+    if (item.exchange_time_utc.count() == 0)
+      throw RuntimeError{"Unexpected: exchange_time_utc is required"sv};
+    auto trade = database::Trade{
+        .user = item.user,
+        .strategy_id = item.strategy_id,
+        .account = item.account,
+        .exchange = item.exchange,
+        .symbol = item.symbol,
+        .side = item.side,
+        .quantity = item.quantity,
+        .price = item.price,
+        .exchange_time_utc = item.exchange_time_utc,
+        .external_account = item.external_account,
+        .external_order_id = item.external_order_id,
+        .external_trade_id = item.external_trade_id,
+    };
+    batch.trades.emplace_back(trade);
+  } else {
+    auto correction = database::Correction{
+        .user = item.user,
+        .strategy_id = item.strategy_id,
+        .account = item.account,
+        .exchange = item.exchange,
+        .symbol = item.symbol,
+        .side = item.side,
+        .quantity = item.quantity,
+        .price = item.price,
+        .exchange_time_utc = item.exchange_time_utc,
+        .reason = item.reason,
+    };
+    batch.corrections.emplace_back(correction);
+  }
+}
+
+// note! RFC 4180 (except for line breaks within quoted fields)
+template <typename Callback>
+void split_csv(std::string_view const &line, std::deque<std::string> &storage, Callback callback) {
+  size_t index = 0, offset = 0;
+  for (;;) {
+    if (offset < std::size(line) && line[offset] == CSV_QUOTE) {
+      auto begin = ++offset;
+      auto escaped = false;
+      for (;; ++offset) {
+        if (offset >= std::size(line))
+          throw RuntimeError{"Unexpected: missing closing quote"sv};
+        if (line[offset] != CSV_QUOTE)
+          continue;
+        if ((offset + 1) < std::size(line) && line[offset + 1] == CSV_QUOTE) {
+          escaped = true;
+          ++offset;
+          continue;
+        }
+        break;
+      }
+      auto value = line.substr(begin, offset - begin);
+      ++offset;
+      if (escaped) {
+        auto &tmp = storage.emplace_back();
+        for (size_t i = 0; i < std::size(value); ++i) {
+          tmp.push_back(value[i]);
+          if (value[i] == CSV_QUOTE)
+            ++i;
+        }
+        callback(index++, std::string_view{tmp});
+      } else {
+        callback(index++, value);
+      }
+      if (offset < std::size(line) && line[offset] != CSV_SEPARATOR)
+        throw RuntimeError{"Unexpected: separator expected after closing quote"sv};
+    } else {
+      auto end = std::min(line.find(CSV_SEPARATOR, offset), std::size(line));
+      callback(index++, line.substr(offset, end - offset));
+      offset = end;
+    }
+    if (offset >= std::size(line))
+      break;
+    ++offset;  // note! separator
+  }
+}
+
+auto create_columns(Format format, std::string_view const &header) {
+  std::vector<Field> result;
+  if (format != Format::CSV)
+    return result;
+  std::deque<std::string> storage;
+  split_csv(header, storage, [&](auto, auto const &name) { result.emplace_back(get_field(name)); });
+  return result;
+}
+}  // namespace
+
+// === IMPLEMENTATION ===
+
+Parser::Parser(Format format, std::string_view const &header)
+    : format_{format}, columns_{create_columns(format, header)} {
+}
+
+std::unique_ptr<Batch> Parser::operator()(std::string &&buffer) const {
+  auto result = std::make_unique<Batch>();
+  auto &batch = *result;
+  batch.buffer = std::move(buffer);
+  std::string_view text{batch.buffer};
+  while (!std::empty(text)) {
+    auto end = text.find('\n');
+    auto line = text.substr(0, end);
+    text = end == text.npos ? std::string_view{} : text.substr(end + 1);
+    if (!std::empty(line) && line.back() == '\r')
+      line.remove_suffix(1);
+    if (std::empty(line))
+      continue;
+    try {
+      switch (format_) {
+        case Format::CSV:
+          parse_csv(batch, line);
+          break;
+        case Format::NDJSON:
+          parse_ndjson(batch, line);
+          break;
+      }
+    } catch (std::exception &e) {
+      throw RuntimeError{R"({} (line="{}"))"sv, e.what(), line};
+    }
+  }
+  return result;
+}
+
+void Parser::parse_csv(Batch &batch, std::string_view const &line) const {
+  Item item;
+  size_t count = 0;
+  split_csv(line, batch.storage, [&](auto index, auto const &value) {
+    if (index >= std::size(columns_))
+      throw RuntimeError{"Unexpected: too many fields (expected {})"sv, std::size(columns_)};
+    set(item, columns_[index], value);
+    ++count;
+  });
+  if (count != std::size(columns_))
+    throw RuntimeError{"Unexpected: too few fields (expected {})"sv, std::size(columns_)};
+  add(batch, item);
+}
+
+// note! strings are copied (the json object is released after each line)
+void Parser::parse_ndjson(Batch &batch, std::string_view const &line) const {
+  Item item;
+  auto json = nlohmann::json::parse(line);
+  if (!json.is_object())
+    throw RuntimeError{"Unexpected: expected a json object"sv};
+  for (auto &[key, value] : json.items()) {
+    auto field = get_field(key);
+    if (value.is_string()) {
+      auto &tmp = batch.storage.emplace_back(value.template get<std::string>());
+      set(item, field, tmp);
+    } else if (value.is_number()) {
+      switch (field) {
+        case Field::STRATEGY_ID:
+          item.strategy_id = value.template get<uint32_t>();
+          break;
+        case Field::QUANTITY:
+          item.quantity = value.template get<double>();
+          break;
+        case Field::PRICE:
+          item.price = value.template get<double>();
+          break;
+        case Field::EXCHANGE_TIME_UTC:
+          item.exchange_time_utc = std::chrono::nanoseconds{value.template get<int64_t>()};
+          break;
+        default:
+          throw RuntimeError{R"(Unexpected: field="{}" must be a string)"sv, key};
+      }
+    } else if (!value.is_null()) {
+      throw RuntimeError{R"(Unexpected: field="{}" has unsupported type)"sv, key};
+    }
+  }
+  add(batch, item);
+}
+
+}  // namespace importer
+}  // namespace risk_manager
+}  // namespace roq
@@ -0,0 +1,78 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include <deque>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "roq/risk_manager/database/correction.hpp"
+#include "roq/risk_manager/database/trade.hpp"
+
+namespace roq {
+namespace risk_manager {
+namespace importer {
+
+enum class Format {
+  CSV,
+  NDJSON,
+};
+
+// note! a record has the same field names as used by the control interface
+enum class Field {
+  UNKNOWN,
+  USER,
+  STRATEGY_ID,
+  ACCOUNT,
+  EXCHANGE,
+  SYMBOL,
+  SIDE,
+  QUANTITY,
+  PRICE,
+  EXCHANGE_TIME_UTC,
+  EXTERNAL_ACCOUNT,
+  EXTERNAL_ORDER_ID,
+  EXTERNAL_TRADE_ID,
+  REASON,
+};
+
+// note!
+//   trades and corrections refer to the buffer (or to storage, e.g. unescaped strings)
+//   heap allocated (moving the buffer could otherwise invalidate the references)
+struct Batch final {
+  std::string buffer;
+  std::deque<std::string> storage;
+  std::vector<database::Trade> trades;
+  std::vector<database::Correction> corrections;
+};
+
+// note!
+//   one record per line (JSON object or CSV row)
+//   a record is a correction if it has a (non-empty) reason
+//   exchange_time_utc is an integer (nanoseconds since epoch)
+//   CSV: the first line is the header, quoted fields can't contain line breaks
+//   thread-safe (a batch can be parsed from any thread)
+
+struct Parser final {
+  Parser(Format, std::string_view const &header);
+
+  Parser(Parser &&) = delete;
+  Parser(Parser const &) = delete;
+
+  // note! the buffer must only contain complete lines
+  std::unique_ptr<Batch> operator()(std::string &&buffer) const;
+
+ protected:
+  void parse_csv(Batch &, std::string_view const &line) const;
+  void parse_ndjson(Batch &, std::string_view const &line) const;
+
+ private:
+  Format const format_;
+  std::vector<Field> const columns_;  // note! CSV
+};
+
+}  // namespace importer
+}  // namespace risk_manager
+}  // namespace roq
@@ -0,0 +1,50 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace roq {
+namespace risk_manager {
+namespace metrics {
+
+// note!
+//   single writer => relaxed load and store (no locked instruction)
+//   readers (e.g. the exposition) may observe a slightly stale value
+
+struct Counter final {
+  Counter() = default;
+
+  Counter(Counter &&) = delete;
+  Counter(Counter const &) = delete;
+
+  void operator+=(uint64_t value) {
+    value_.store(value_.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+  }
+
+  void operator++() { (*this) += 1; }
+
+  uint64_t get() const { return value_.load(std::memory_order_relaxed); }
+
+ private:
+  std::atomic<uint64_t> value_ = {};
+};
+
+struct Gauge final {
+  Gauge() = default;
+
+  Gauge(Gauge &&) = delete;
+  Gauge(Gauge const &) = delete;
+
+  void set(uint64_t value) { value_.store(value, std::memory_order_relaxed); }
+
+  uint64_t get() const { return value_.load(std::memory_order_relaxed); }
+
+ private:
+  std::atomic<uint64_t> value_ = {};
+};
+
+}  // namespace metrics
+}  // namespace risk_manager
+}  // namespace roq
@@ -0,0 +1,77 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace roq {
+namespace risk_manager {
+namespace metrics {
+
+// note!
+//   log-linear buckets, two per power of two (0, 1, 2, 3, 4-5, 6-7, 8-11, 12-15, 16-23, ...)
+//   => the relative error is bounded (< 50%) for all 64-bit values without any range configuration
+//   buckets are fixed (recording never allocates) and there is a single writer (relaxed load and store)
+//   durations are recorded in nanoseconds
+
+struct Histogram final {
+  static constexpr size_t SIZE = 128;
+
+  Histogram() = default;
+
+  Histogram(Histogram &&) = delete;
+  Histogram(Histogram const &) = delete;
+
+  void operator()(uint64_t value) {
+    add(buckets_[get_index(value)], 1);
+    add(sum_, value);
+  }
+
+  void operator()(std::chrono::nanoseconds duration) {
+    (*this)(static_cast<uint64_t>(std::max<int64_t>(duration.count(), 0)));
+  }
+
+  uint64_t get_sum() const { return sum_.load(std::memory_order_relaxed); }
+
+  // note! callback(upper_bound, count) for each bucket, upper bound is inclusive
+  template <typename Callback>
+  void get_buckets(Callback callback) const {
+    for (size_t index = 0; index < SIZE; ++index)
+      callback(get_upper_bound(index), buckets_[index].load(std::memory_order_relaxed));
+  }
+
+  static constexpr size_t get_index(uint64_t value) {
+    if (value < 4)
+      return value;
+    auto width = static_cast<size_t>(std::bit_width(value));
+    return 2 * (width - 1) + ((value >> (width - 2)) & 1);
+  }
+
+  static constexpr uint64_t get_upper_bound(size_t index) {
+    if (index < 4)
+      return index;
+    auto width = index / 2 + 1;
+    if (index & 1)
+      return width < 64 ? (uint64_t{1} << width) - 1 : UINT64_MAX;
+    return (uint64_t{3} << (width - 2)) - 1;
+  }
+
+ protected:
+  static void add(std::atomic<uint64_t> &counter, uint64_t value) {
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+  }
+
+ private:
+  std::array<std::atomic<uint64_t>, SIZE> buckets_ = {};
+  std::atomic<uint64_t> sum_ = {};
+};
+
+}  // namespace metrics
+}  // namespace risk_manager
+}  // namespace roq
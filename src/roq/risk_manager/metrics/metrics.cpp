@@ -0,0 +1,185 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include "roq/risk_manager/metrics/metrics.hpp"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <string_view>
+
+using namespace std::literals;
+
+namespace roq {
+namespace risk_manager {
+namespace metrics {
+
+// === CONSTANTS ===
+
+namespace {
+auto const PREFIX = "roq_risk_manager_"sv;
+
+double const SECONDS = 1.0e9;  // note! durations are recorded in nanoseconds
+double const UNITS = 1.0;
+
+struct Label final {
+  std::string_view method;
+  std::string_view path;
+};
+
+// note! must match the order of Route
+std::array<Label, magic_enum::enum_count<Route>()> const ROUTES{{
+    {"GET"sv, "/accounts"sv},
+    {"GET"sv, "/positions"sv},
+    {"GET"sv, "/trades"sv},
+    {"GET"sv, "/funds"sv},
+    {"GET"sv, "/backup"sv},
+    {"GET"sv, "/export"sv},
+    {"GET"sv, "/metrics"sv},
+    {"GET"sv, "/limits"sv},
+    {"GET"sv, "/pnl"sv},
+    {"PUT"sv, "/trade"sv},
+    {"PUT"sv, "/compress"sv},
+    {"PUT"sv, "/backup"sv},
+    {"PUT"sv, "/trace"sv},
+    {"PUT"sv, "/reload"sv},
+    {"PUT"sv, "/limits"sv},
+}};
+}  // namespace
+
+// === HELPERS ===
+
+namespace {
+void encode_header(
+    std::string &result, std::string_view const &name, std::string_view const &type, std::string_view const &help) {
+  fmt::format_to(std::back_inserter(result), "# HELP {}{} {}\n"sv, PREFIX, name, help);
+  fmt::format_to(std::back_inserter(result), "# TYPE {}{} {}\n"sv, PREFIX, name, type);
+}
+
+// note! labels are pre-formatted, e.g. source="0"
+void encode_sample(std::string &result, std::string_view const &name, std::string_view const &labels, auto value) {
+  if (std::empty(labels))
+    fmt::format_to(std::back_inserter(result), "{}{} {}\n"sv, PREFIX, name, value);
+  else
+    fmt::format_to(std::back_inserter(result), "{}{}{{{}}} {}\n"sv, PREFIX, name, labels, value);
+}
+
+// note!
+//   buckets are cumulative and only emitted from the first to the last non-empty bucket
+//   the range can only grow (counts never decrease), i.e. series are never removed
+void encode_histogram(
+    std::string &result,
+    std::string_view const &name,
+    std::string_view const &labels,
+    Histogram const &histogram,
+    double scale) {
+  std::array<uint64_t, Histogram::SIZE> counts;
+  size_t index = 0, first = Histogram::SIZE, last = 0;
+  auto callback = [&](uint64_t, uint64_t count) {
+    counts[index] = count;
+    if (count) {
+      first = std::min(first, index);
+      last = index;
+    }
+    ++index;
+  };
+  histogram.get_buckets(callback);
+  auto separator = std::empty(labels) ? ""sv : ","sv;
+  uint64_t total = 0;
+  for (size_t i = 0; i < Histogram::SIZE; ++i) {
+    total += counts[i];
+    if (i < first || i > last)
+      continue;
+    auto upper_bound = static_cast<double>(Histogram::get_upper_bound(i)) / scale;
+    fmt::format_to(
+        std::back_inserter(result),
+        R"({}{}_bucket{{{}{}le="{}"}} {})"
+        "\n"sv,
+        PREFIX,
+        name,
+        labels,
+        separator,
+        upper_bound,
+        total);
+  }
+  fmt::format_to(
+      std::back_inserter(result),
+      R"({}{}_bucket{{{}{}le="+Inf"}} {})"
+      "\n"sv,
+      PREFIX,
+      name,
+      labels,
+      separator,
+      total);
+  auto sum = static_cast<double>(histogram.get_sum()) / scale;
+  encode_sample(result, fmt::format("{}_sum"sv, name), labels, sum);
+  encode_sample(result, fmt::format("{}_count"sv, name), labels, total);
+}
+}  // namespace
+
+// === IMPLEMENTATION ===
+
+Metrics::Metrics(size_t source_count) : sources(source_count) {
+}
+
+// note! prometheus text exposition format
+void Metrics::encode(std::string &result, uint64_t duplicate_count) const {
+  // engine
+  encode_header(result, "fills_total"sv, "counter"sv, "Fills processed."sv);
+  encode_sample(result, "fills_total"sv, {}, fills.get());
+  encode_header(result, "trades_dropped_total"sv, "counter"sv, "Trade updates dropped (exchange time)."sv);
+  encode_sample(result, "trades_dropped_total"sv, {}, trades_dropped.get());
+  encode_header(result, "trades_duplicate_total"sv, "counter"sv, "Trades ignored by the database (duplicate)."sv);
+  encode_sample(result, "trades_duplicate_total"sv, {}, duplicate_count);
+  encode_header(result, "trade_update_seconds"sv, "histogram"sv, "Engine processing time per trade update."sv);
+  encode_histogram(result, "trade_update_seconds"sv, {}, trade_update_latency, SECONDS);
+  encode_header(result, "database_insert_seconds"sv, "histogram"sv, "Database insert time per batch."sv);
+  encode_histogram(result, "database_insert_seconds"sv, {}, database_insert_latency, SECONDS);
+  encode_header(result, "database_insert_batch_size"sv, "histogram"sv, "Trades per database insert."sv);
+  encode_histogram(result, "database_insert_batch_size"sv, {}, database_insert_batch_size, UNITS);
+  encode_header(result, "timer_publish_seconds"sv, "histogram"sv, "Snapshot and risk limits publishing time."sv);
+  encode_histogram(result, "timer_publish_seconds"sv, {}, timer_publish_latency, SECONDS);
+  encode_header(result, "market_data_updates_total"sv, "counter"sv, "Top of book updates received."sv);
+  encode_sample(result, "market_data_updates_total"sv, {}, market_data_updates.get());
+  encode_header(result, "market_data_conflated_total"sv, "counter"sv, "Top of book updates conflated."sv);
+  encode_sample(result, "market_data_conflated_total"sv, {}, market_data_conflated.get());
+  encode_header(result, "reprice_seconds"sv, "histogram"sv, "Exposure re-computation time per timer."sv);
+  encode_histogram(result, "reprice_seconds"sv, {}, reprice_latency, SECONDS);
+  encode_header(result, "risk_limits_urgent_total"sv, "counter"sv, "Risk limits published due to a breach."sv);
+  encode_sample(result, "risk_limits_urgent_total"sv, {}, risk_limits_urgent.get());
+  // sources
+  auto encode_sources = [&](std::string_view const &name, std::string_view const &help, auto get_value) {
+    encode_header(result, name, "counter"sv, help);
+    for (size_t i = 0; i < std::size(sources); ++i)
+      encode_sample(result, name, fmt::format(R"(source="{}")"sv, i), get_value(sources[i]));
+  };
+  encode_sources("risk_limits_messages_total"sv, "Risk limits messages sent."sv, [](auto &source) {
+    return source.risk_limits_messages.get();
+  });
+  encode_sources("risk_limits_total"sv, "Risk limits (instruments) sent."sv, [](auto &source) {
+    return source.risk_limits_limits.get();
+  });
+  encode_sources("risk_limits_bytes_total"sv, "Risk limits payload sent (estimated)."sv, [](auto &source) {
+    return source.risk_limits_bytes.get();
+  });
+  // control
+  encode_header(result, "control_requests_total"sv, "counter"sv, "Control requests."sv);
+  for (size_t i = 0; i < std::size(requests); ++i) {
+    auto labels = fmt::format(R"(method="{}",path="{}")"sv, ROUTES[i].method, ROUTES[i].path);
+    encode_sample(result, "control_requests_total"sv, labels, requests[i].count.get());
+  }
+  encode_header(result, "control_request_seconds"sv, "histogram"sv, "Control request to response time."sv);
+  for (size_t i = 0; i < std::size(requests); ++i) {
+    auto labels = fmt::format(R"(method="{}",path="{}")"sv, ROUTES[i].method, ROUTES[i].path);
+    encode_histogram(result, "control_request_seconds"sv, labels, requests[i].latency, SECONDS);
+  }
+  encode_header(result, "websocket_queue_depth"sv, "histogram"sv, "Trades drained from the engine queue."sv);
+  encode_histogram(result, "websocket_queue_depth"sv, {}, websocket_queue_depth, UNITS);
+  encode_header(result, "websocket_queue_overflow_total"sv, "counter"sv, "Engine queue overflows."sv);
+  encode_sample(result, "websocket_queue_overflow_total"sv, {}, websocket_queue_overflow.get());
+  encode_header(result, "websocket_subscribers"sv, "gauge"sv, "WebSocket subscribers."sv);
+  encode_sample(result, "websocket_subscribers"sv, {}, websocket_subscribers.get());
+}
+
+}  // namespace metrics
+}  // namespace risk_manager
+}  // namespace roq
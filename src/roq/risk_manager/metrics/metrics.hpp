@@ -0,0 +1,89 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include <magic_enum.hpp>
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "roq/risk_manager/metrics/counter.hpp"
+#include "roq/risk_manager/metrics/histogram.hpp"
+
+namespace roq {
+namespace risk_manager {
+namespace metrics {
+
+// note!
+//   every metric has exactly one writer (the engine thread or the control thread)
+//   the exposition (GET /metrics) may be rendered from any thread
+
+enum class Route : uint8_t {
+  GET_ACCOUNTS,
+  GET_POSITIONS,
+  GET_TRADES,
+  GET_FUNDS,
+  GET_BACKUP,
+  GET_EXPORT,
+  GET_METRICS,
+  GET_LIMITS,
+  GET_PNL,
+  PUT_TRADE,
+  PUT_COMPRESS,
+  PUT_BACKUP,
+  PUT_TRACE,
+  PUT_RELOAD,
+  PUT_LIMITS,
+};
+
+struct Metrics final {
+  explicit Metrics(size_t source_count);
+
+  Metrics(Metrics &&) = delete;
+  Metrics(Metrics const &) = delete;
+
+  // engine thread
+
+  Counter fills;
+  Counter trades_dropped;         // note! exchange time prior to the last seen
+  Histogram trade_update_latency;  // note! positions, subscribers and database
+  Histogram database_insert_latency;
+  Histogram database_insert_batch_size;
+  Histogram timer_publish_latency;
+  Counter market_data_updates;
+  Counter market_data_conflated;  // note! price replaced before the next timer
+  Histogram reprice_latency;      // note! positions and groups (once per timer)
+  Counter risk_limits_urgent;     // note! published from a trade update (not waiting for the timer)
+
+  struct Source final {
+    Counter risk_limits_messages;
+    Counter risk_limits_limits;
+    Counter risk_limits_bytes;  // note! estimated (strings and limits), not the encoded size
+  };
+
+  std::vector<Source> sources;
+
+  // control thread
+
+  struct Request final {
+    Counter count;
+    Histogram latency;  // note! from request to response (including the time spent waiting for a worker)
+  };
+
+  std::array<Request, magic_enum::enum_count<Route>()> requests;
+
+  Request &operator[](Route route) { return requests[static_cast<size_t>(route)]; }
+
+  Histogram websocket_queue_depth;  // note! trades drained per event loop iteration
+  Counter websocket_queue_overflow;
+  Gauge websocket_subscribers;
+
+  // note! duplicates are detected by the database (passed in from the in-memory statistics)
+  void encode(std::string &result, uint64_t duplicate_count) const;
+};
+
+}  // namespace metrics
+}  // namespace risk_manager
+}  // namespace roq
@@ -0,0 +1,85 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include "roq/risk_manager/replay/application.hpp"
+
+#include <chrono>
+#include <thread>
+
+#include "roq/logging.hpp"
+
+#include "roq/io/engine/context_factory.hpp"
+
+#include "roq/risk_manager/config.hpp"
+#include "roq/risk_manager/controller.hpp"
+#include "roq/risk_manager/settings.hpp"
+
+#include "roq/risk_manager/events/dispatcher.hpp"
+#include "roq/risk_manager/events/reader.hpp"
+
+#include "roq/risk_manager/replay/flags/flags.hpp"
+
+using namespace std::literals;
+
+namespace roq {
+namespace risk_manager {
+namespace replay {
+
+// === HELPERS ===
+
+namespace {
+auto get_rate(size_t count, std::chrono::nanoseconds duration) {
+  auto seconds = std::chrono::duration<double>{duration}.count();
+  return seconds > 0.0 ? static_cast<double>(count) / seconds : 0.0;
+}
+}  // namespace
+
+// === IMPLEMENTATION ===
+
+// note! the controller is exactly the same as the service, i.e. use a scratch database
+int Application::main(args::Parser const &args) {
+  auto params = args.params();
+  if (std::size(params) != 1)
+    log::fatal("Expected: event file"sv);
+  auto flags = flags::Flags::create();
+  Settings settings{args};
+  auto config = Config::parse_file(settings.config_file);
+  auto context = roq::io::engine::ContextFactory::create_libevent();
+  events::Reader reader{params[0]};
+  auto source_count = reader.get_source_count();
+  events::Dispatcher dispatcher{source_count};
+  Controller controller{dispatcher, settings, config, *context, source_count};
+  auto &handler = static_cast<client::Handler &>(controller);
+  size_t event_count = 0, trade_count = 0;
+  std::chrono::nanoseconds offset = {};
+  auto start_time = std::chrono::steady_clock::now();
+  while (reader.next()) {
+    auto &message_info = reader.get_message_info();
+    if (flags.replay_pacing) {
+      // note! relative to the first event
+      if (event_count == 0)
+        offset = message_info.receive_time;
+      std::this_thread::sleep_until(start_time + (message_info.receive_time - offset));
+    }
+    reader.dispatch(handler);
+    ++event_count;
+    if (reader.get_type() == events::Type::TRADE_UPDATE)
+      ++trade_count;
+  }
+  auto duration =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_time);
+  auto total = dispatcher.get_total();
+  log::info(
+      "Replayed event_count={}, trade_count={}, risk_limits_count={}, risk_limit_count={} "
+      "(duration={}, events/second={:.0f})"sv,
+      event_count,
+      trade_count,
+      total.risk_limits_count,
+      total.risk_limit_count,
+      duration,
+      get_rate(event_count, duration));
+  return EXIT_SUCCESS;
+}
+
+}  // namespace replay
+}  // namespace risk_manager
+}  // namespace roq
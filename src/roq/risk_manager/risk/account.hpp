@@ -4,13 +4,18 @@
 
 #include <absl/container/flat_hash_map.h>
 
+#include <chrono>
+
 #include "roq/reference_data.hpp"
 #include "roq/trade_update.hpp"
 
 #include "roq/risk_manager/database/position.hpp"
 
+#include "roq/risk_manager/risk/change.hpp"
 #include "roq/risk_manager/risk/instrument.hpp"
 #include "roq/risk_manager/risk/position.hpp"
+#include "roq/risk_manager/risk/rate_limit.hpp"
+#include "roq/risk_manager/risk/velocity.hpp"
 
 namespace roq {
 namespace risk_manager {
@@ -19,6 +24,8 @@ namespace risk {
 struct Account final {
   struct Handler {
     virtual void publish_account(std::string_view const &name, uint32_t instrument_id) = 0;
+    virtual void aggregate_account(std::string_view const &name, uint32_t instrument_id, Change const &) = 0;
+    virtual void throttle_account(std::string_view const &name) = 0;
     virtual Instrument &get_instrument(std::string_view const &exchange, std::string_view const &symbol) = 0;
     virtual Limit get_limit_by_account(
         std::string_view const &name, std::string_view const &exchange, std::string_view const &symbol) const = 0;
@@ -34,7 +41,20 @@ struct Account final {
   void operator()(database::Position const &);
 
   void operator()(ReferenceData const &);
-  void operator()(TradeUpdate const &);
+  // note! now is used by the rate limits (same clock as the timer)
+  void operator()(TradeUpdate const &, std::chrono::nanoseconds now);
+
+  // note! only existing positions are updated (new positions will look up the current limit)
+  void operator()(uint32_t instrument_id, Limit const &);
+
+  // note! returns true if the rate limit breach has changed (all positions are then re-published)
+  bool operator()(RateLimit const &);
+  bool operator()(std::chrono::nanoseconds now);
+
+  RateLimit const &get_rate_limit() const { return velocity_.get_rate_limit(); }
+
+  // note! rate limit has been breached => reduce-only
+  bool get_breach() const { return velocity_.get_breach(); }
 
   template <typename Callback>
   void get_position(uint32_t instrument_id, Callback callback) {
@@ -43,13 +63,22 @@ struct Account final {
       callback((*iter).second);
   }
 
+  template <typename Callback>
+  void get_all_positions(Callback callback) const {
+    for (auto &[instrument_id, position] : positions_)
+      callback(instrument_id, position);
+  }
+
  protected:
   template <typename Callback>
   void dispatch(auto &value, Callback);
 
+  void publish_all();
+
  private:
   Handler &handler_;
   absl::flat_hash_map<uint32_t, Position> positions_;
+  Velocity velocity_;
 };
 
 }  // namespace risk
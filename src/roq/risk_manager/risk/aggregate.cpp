@@ -0,0 +1,82 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include "roq/risk_manager/risk/aggregate.hpp"
+
+#include <cmath>
+
+#include "roq/exceptions.hpp"
+
+using namespace std::literals;
+
+namespace roq {
+namespace risk_manager {
+namespace risk {
+
+// === HELPERS ===
+
+namespace {
+auto create_regex(auto &value) -> std::optional<std::regex> {
+  if (std::empty(value))
+    return {};
+  return std::regex{std::begin(value), std::end(value), std::regex::ECMAScript | std::regex::optimize};
+}
+
+bool match(auto &regex, std::string_view const &value) {
+  return !regex || std::regex_match(std::begin(value), std::end(value), *regex);
+}
+
+// note! nan means "no limit"
+bool is_breach(double quantity, double limit) {
+  return !std::isnan(limit) && quantity >= limit;
+}
+}  // namespace
+
+// === IMPLEMENTATION ===
+
+Aggregate::Aggregate(std::string_view const &name, Group const &group)
+    : name{name}, long_position_limit{group.long_position_limit}, short_position_limit{group.short_position_limit},
+      long_notional_limit{group.long_notional_limit}, short_notional_limit{group.short_notional_limit},
+      exchange_{create_regex(group.exchange)}, symbol_{create_regex(group.symbol)},
+      underlying_{create_regex(group.underlying)}, base_currency_{create_regex(group.base_currency)} {
+}
+
+void Aggregate::validate(Group const &group) {
+  auto helper = [](auto &value) {
+    try {
+      create_regex(value);
+    } catch (std::regex_error &) {
+      throw RuntimeError{R"(Unexpected: invalid regex="{}")"sv, value};
+    }
+  };
+  helper(group.exchange);
+  helper(group.symbol);
+  helper(group.underlying);
+  helper(group.base_currency);
+}
+
+bool Aggregate::operator()(ReferenceData const &reference_data) const {
+  return match(exchange_, reference_data.exchange) && match(symbol_, reference_data.symbol) &&
+         match(underlying_, reference_data.underlying) && match(base_currency_, reference_data.base_currency);
+}
+
+bool Aggregate::operator()(State &state, double quantity) const {
+  state.quantity += quantity;
+  return (*this)(state);
+}
+
+bool Aggregate::operator()(State &state) const {
+  auto breach = Breach{
+      .long_position =
+          is_breach(state.quantity, long_position_limit) || is_breach(state.notional, long_notional_limit),
+      .short_position =
+          is_breach(-state.quantity, short_position_limit) || is_breach(-state.notional, short_notional_limit),
+  };
+  if (breach.long_position == state.breach.long_position && breach.short_position == state.breach.short_position)
+    return false;
+  state.breach = breach;
+  return true;
+}
+
+}  // namespace risk
+}  // namespace risk_manager
+}  // namespace roq
@@ -0,0 +1,72 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include <absl/container/flat_hash_map.h>
+
+#include <optional>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "roq/reference_data.hpp"
+
+#include "roq/risk_manager/risk/breach.hpp"
+#include "roq/risk_manager/risk/group.hpp"
+
+namespace roq {
+namespace risk_manager {
+namespace risk {
+
+// note!
+//   the aggregate is maintained incrementally (fills only apply the change of the net position)
+//   members are only known once reference data has been received
+
+struct Aggregate final {
+  struct State final {
+    double quantity = {};  // note! net, in units of the underlying
+    double notional = {};  // note! net, repriced (once per timer)
+    uint32_t bucket = {};  // note! exposure
+    Breach breach;
+  };
+
+  Aggregate(std::string_view const &name, Group const &);
+
+  Aggregate(Aggregate &&) = default;
+  Aggregate(Aggregate const &) = delete;
+
+  // note! throws if a regex is not valid
+  static void validate(Group const &);
+
+  std::string const name;
+
+  bool operator()(ReferenceData const &) const;
+
+  // note! returns true if the breach has changed
+  bool operator()(State &, double quantity) const;
+
+  // note! limits can be changed (e.g. reload), returns true if the breach has changed
+  bool operator()(State &) const;
+
+  double long_position_limit;
+  double short_position_limit;
+  double long_notional_limit;
+  double short_notional_limit;
+
+  std::vector<uint32_t> members;  // note! instrument ids
+
+  absl::flat_hash_map<std::string, State> accounts;
+  absl::flat_hash_map<std::string, State> users;
+  absl::flat_hash_map<uint32_t, State> strategies;
+
+ private:
+  std::optional<std::regex> exchange_;
+  std::optional<std::regex> symbol_;
+  std::optional<std::regex> underlying_;
+  std::optional<std::regex> base_currency_;
+};
+
+}  // namespace risk
+}  // namespace risk_manager
+}  // namespace roq
@@ -0,0 +1,18 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+namespace roq {
+namespace risk_manager {
+namespace risk {
+
+// note! reduce-only, i.e. the published limit can't exceed the current position
+
+struct Breach final {
+  bool long_position = {};
+  bool short_position = {};
+};
+
+}  // namespace risk
+}  // namespace risk_manager
+}  // namespace roq
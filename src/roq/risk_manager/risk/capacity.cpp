@@ -0,0 +1,71 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include "roq/risk_manager/risk/capacity.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "roq/exceptions.hpp"
+
+using namespace std::literals;
+
+namespace roq {
+namespace risk_manager {
+namespace risk {
+
+// === HELPERS ===
+
+namespace {
+// note! nan means "no limit"
+bool is_equal(double lhs, double rhs) {
+  return (std::isnan(lhs) && std::isnan(rhs)) || lhs == rhs;
+}
+}  // namespace
+
+// === IMPLEMENTATION ===
+
+Capacity::Capacity(FundsLimit const &funds_limit) : funds_limit_{funds_limit} {
+}
+
+void Capacity::validate(FundsLimit const &funds_limit) {
+  if (std::empty(funds_limit.currency))
+    throw RuntimeError{"Unexpected: currency is required (funds_limit={})"sv, funds_limit};
+  if (!(funds_limit.leverage > 0.0))
+    throw RuntimeError{"Unexpected: leverage must be positive (funds_limit={})"sv, funds_limit};
+}
+
+bool Capacity::operator()(FundsLimit const &funds_limit) {
+  if (funds_limit.currency != funds_limit_.currency)
+    available_ = std::numeric_limits<double>::quiet_NaN();  // note! wait for funds of the new currency
+  funds_limit_ = funds_limit;
+  return update();
+}
+
+bool Capacity::operator()(std::string_view const &currency, double balance, double hold) {
+  if (currency != funds_limit_.currency)
+    return false;
+  // note! hold is optional
+  available_ = std::isnan(hold) ? balance : (balance - hold);
+  return update();
+}
+
+double Capacity::get_position_limit(double price, double multiplier) const {
+  auto notional = std::abs(price) * multiplier;
+  if (std::isnan(capacity_) || std::isnan(notional) || notional == 0.0)
+    return std::numeric_limits<double>::quiet_NaN();
+  return capacity_ / notional;
+}
+
+bool Capacity::update() {
+  // note! no funds => no capacity (not a negative limit)
+  auto capacity = std::isnan(available_) ? std::numeric_limits<double>::quiet_NaN()
+                                         : std::max(available_, 0.0) * funds_limit_.leverage;
+  if (is_equal(capacity, capacity_))
+    return false;
+  capacity_ = capacity;
+  return true;
+}
+
+}  // namespace risk
+}  // namespace risk_manager
+}  // namespace roq
@@ -0,0 +1,53 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include <limits>
+#include <string>
+#include <string_view>
+
+#include "roq/risk_manager/risk/funds_limit.hpp"
+
+namespace roq {
+namespace risk_manager {
+namespace risk {
+
+// note!
+//   funds driven position limit of an account, O(1) per funds update
+//   nan means "no limit" (funds or price not yet known), i.e. the static limits still apply
+
+struct Capacity final {
+  explicit Capacity(FundsLimit const &);
+
+  Capacity(Capacity &&) = default;
+  Capacity(Capacity const &) = delete;
+
+  // note! throws if the limit is not valid
+  static void validate(FundsLimit const &);
+
+  FundsLimit const &get_funds_limit() const { return funds_limit_; }
+
+  // note! limits can be changed (e.g. reload), returns true if the capacity has changed
+  bool operator()(FundsLimit const &);
+
+  // note! returns true if the capacity has changed (funds of other currencies are ignored)
+  bool operator()(std::string_view const &currency, double balance, double hold);
+
+  // note! amount (funds times leverage)
+  double get_capacity() const { return capacity_; }
+
+  // note! quantity
+  double get_position_limit(double price, double multiplier) const;
+
+ protected:
+  bool update();
+
+ private:
+  FundsLimit funds_limit_;
+  double available_ = std::numeric_limits<double>::quiet_NaN();
+  double capacity_ = std::numeric_limits<double>::quiet_NaN();
+};
+
+}  // namespace risk
+}  // namespace risk_manager
+}  // namespace roq
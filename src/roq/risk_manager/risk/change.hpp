@@ -0,0 +1,23 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include "roq/api.hpp"
+
+namespace roq {
+namespace risk_manager {
+namespace risk {
+
+// note! change of a position (fill or database), aggregates are updated incrementally
+
+struct Change final {
+  double quantity = {};        // note! net
+  double realized_pnl = {};    // note! net of fees
+  double average_price = NaN;  // note! after the change
+  uint64_t fill_count = {};    // note! new fills (duplicates are ignored)
+  double notional = {};        // note! of the new fills
+};
+
+}  // namespace risk
+}  // namespace risk_manager
+}  // namespace roq
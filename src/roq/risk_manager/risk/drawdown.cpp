@@ -0,0 +1,78 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include "roq/risk_manager/risk/drawdown.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "roq/exceptions.hpp"
+
+using namespace std::literals;
+
+namespace roq {
+namespace risk_manager {
+namespace risk {
+
+// === HELPERS ===
+
+namespace {
+// note! the next reset strictly after now
+std::chrono::nanoseconds get_next_reset(std::chrono::nanoseconds now, std::chrono::seconds reset_time) {
+  auto result = std::chrono::floor<std::chrono::days>(now) + reset_time;
+  if (result <= now)
+    result += std::chrono::days{1};
+  return result;
+}
+
+// note! nan means "no limit"
+bool is_breach(double loss, double limit) {
+  return !std::isnan(limit) && loss >= limit;
+}
+}  // namespace
+
+// === IMPLEMENTATION ===
+
+Drawdown::Drawdown(LossLimit const &loss_limit)
+    : max_drawdown{loss_limit.max_drawdown}, max_daily_loss{loss_limit.max_daily_loss},
+      reset_time{loss_limit.reset_time} {
+}
+
+void Drawdown::validate(LossLimit const &loss_limit) {
+  if (loss_limit.max_drawdown <= 0.0)
+    throw RuntimeError{"Unexpected: max_drawdown must be positive (loss_limit={})"sv, loss_limit};
+  if (loss_limit.max_daily_loss <= 0.0)
+    throw RuntimeError{"Unexpected: max_daily_loss must be positive (loss_limit={})"sv, loss_limit};
+  if (loss_limit.reset_time < 0s || loss_limit.reset_time >= std::chrono::days{1})
+    throw RuntimeError{"Unexpected: reset_time must be a time of day (loss_limit={})"sv, loss_limit};
+}
+
+void Drawdown::operator()(LossLimit const &loss_limit) {
+  max_drawdown = loss_limit.max_drawdown;
+  max_daily_loss = loss_limit.max_daily_loss;
+  reset_time = loss_limit.reset_time;
+}
+
+bool Drawdown::operator()(double pnl) {
+  this->pnl = pnl;
+  peak = std::max(peak, pnl);
+  if (breach)
+    return false;
+  breach = is_breach(drawdown(), max_drawdown) || is_breach(daily_loss(), max_daily_loss);
+  return breach;
+}
+
+bool Drawdown::operator()(std::chrono::nanoseconds now) {
+  if (now < next_reset)
+    return false;
+  auto initial = next_reset.count() == 0;
+  next_reset = get_next_reset(now, reset_time);
+  start = peak = pnl;
+  if (initial || !breach)
+    return false;
+  breach = false;
+  return true;
+}
+
+}  // namespace risk
+}  // namespace risk_manager
+}  // namespace roq
@@ -0,0 +1,56 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+#include "roq/risk_manager/risk/loss_limit.hpp"
+
+namespace roq {
+namespace risk_manager {
+namespace risk {
+
+// note!
+//   loss limits of an account or user, O(1) per update (the peak is the only history)
+//   pnl is the realized pnl (net of fees, maintained incrementally) plus the unrealized pnl (exposure)
+//   the breach is kept until the next reset (then reduce-only for all positions)
+
+struct Drawdown final {
+  explicit Drawdown(LossLimit const &);
+
+  Drawdown(Drawdown &&) = default;
+  Drawdown(Drawdown const &) = delete;
+
+  // note! throws if the limit is not valid
+  static void validate(LossLimit const &);
+
+  // note! limits can be changed (e.g. reload), the reset time is used from the next reset
+  void operator()(LossLimit const &);
+
+  // note! returns true if the breach has changed
+  bool operator()(double pnl);
+
+  // note! returns true if the breach has changed (reset)
+  bool operator()(std::chrono::nanoseconds now);
+
+  double drawdown() const { return peak - pnl; }
+  double daily_loss() const { return start - pnl; }
+
+  double max_drawdown;
+  double max_daily_loss;
+  std::chrono::seconds reset_time;
+
+  double realized = {};  // note! net of fees
+  uint32_t owner = {};   // note! exposure (unrealized)
+
+  double pnl = {};
+  double peak = {};
+  double start = {};
+  std::chrono::nanoseconds next_reset = {};
+  bool breach = {};
+};
+
+}  // namespace risk
+}  // namespace risk_manager
+}  // namespace roq
@@ -0,0 +1,148 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include "roq/risk_manager/risk/exposure.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace std::literals;
+
+namespace roq {
+namespace risk_manager {
+namespace risk {
+
+// === HELPERS ===
+
+namespace {
+double zero_if_nan(double value) {
+  return std::isnan(value) ? 0.0 : value;
+}
+}  // namespace
+
+// === IMPLEMENTATION ===
+
+Exposure::Exposure() : buckets_(1), owners_(1) {
+}
+
+uint32_t Exposure::create_slot(uint32_t instrument_id) {
+  auto &instrument = instruments_[instrument_id];
+  auto result = static_cast<uint32_t>(std::size(quantity_));
+  quantity_.emplace_back();
+  multiplier_.emplace_back(instrument.multiplier);
+  price_.emplace_back(instrument.price);
+  notional_.emplace_back(std::numeric_limits<double>::quiet_NaN());  // note! until repriced
+  average_price_.emplace_back(std::numeric_limits<double>::quiet_NaN());
+  unrealized_.emplace_back(std::numeric_limits<double>::quiet_NaN());
+  buckets_by_slot_.emplace_back();
+  owner_by_slot_.emplace_back();
+  instrument.slots.emplace_back(result);
+  return result;
+}
+
+uint32_t Exposure::create_bucket() {
+  auto result = static_cast<uint32_t>(std::size(buckets_));
+  buckets_.emplace_back();
+  return result;
+}
+
+uint32_t Exposure::create_owner() {
+  auto result = static_cast<uint32_t>(std::size(owners_));
+  owners_.emplace_back();
+  return result;
+}
+
+void Exposure::set_owner(uint32_t slot, uint32_t owner) {
+  owners_[owner_by_slot_[slot]] -= zero_if_nan(unrealized_[slot]);
+  owner_by_slot_[slot] = owner;
+  owners_[owner] += zero_if_nan(unrealized_[slot]);
+  owners_[0] = 0.0;  // note! "no owner"
+}
+
+void Exposure::set_buckets(uint32_t slot, std::span<uint32_t const> const &buckets) {
+  auto &tmp = buckets_by_slot_[slot];
+  tmp.assign(std::begin(buckets), std::end(buckets));
+}
+
+void Exposure::operator()(uint32_t slot, double quantity) {
+  quantity_[slot] += quantity;
+  update_unrealized(slot);
+}
+
+void Exposure::set_average_price(uint32_t slot, double average_price) {
+  average_price_[slot] = average_price;
+  update_unrealized(slot);
+}
+
+bool Exposure::set_price(uint32_t instrument_id, double price) {
+  auto &instrument = instruments_[instrument_id];
+  instrument.price = price;
+  if (instrument.dirty)
+    return true;
+  instrument.dirty = true;
+  dirty_.emplace_back(instrument_id);
+  return false;
+}
+
+void Exposure::set_multiplier(uint32_t instrument_id, double multiplier) {
+  auto &instrument = instruments_[instrument_id];
+  if (instrument.multiplier == multiplier)
+    return;
+  instrument.multiplier = multiplier;
+  for (auto slot : instrument.slots)
+    multiplier_[slot] = multiplier;
+}
+
+double Exposure::get_price(uint32_t instrument_id) const {
+  auto iter = instruments_.find(instrument_id);
+  if (iter == std::end(instruments_))
+    return std::numeric_limits<double>::quiet_NaN();
+  return (*iter).second.price;
+}
+
+// note!
+//   prices are first scattered to the slots of the instruments having a new price
+//   all slots are then repriced (the loop has no dependencies and is vectorized by the compiler)
+//   the sums are re-computed (not adjusted), i.e. incremental updates can't accumulate rounding errors
+size_t Exposure::reprice() {
+  repriced_.swap(dirty_);
+  dirty_.clear();
+  for (auto instrument_id : repriced_) {
+    auto &instrument = instruments_[instrument_id];
+    for (auto slot : instrument.slots)
+      price_[slot] = instrument.price;
+    instrument.dirty = false;
+  }
+  auto result = std::size(repriced_);
+  auto size = std::size(quantity_);
+  auto quantity = std::data(quantity_), multiplier = std::data(multiplier_), price = std::data(price_);
+  auto notional = std::data(notional_), average_price = std::data(average_price_), unrealized = std::data(unrealized_);
+  for (size_t i = 0; i < size; ++i) {
+    notional[i] = quantity[i] * multiplier[i] * price[i];
+    unrealized[i] = notional[i] - quantity[i] * multiplier[i] * average_price[i];
+  }
+  std::fill(std::begin(buckets_), std::end(buckets_), 0.0);
+  std::fill(std::begin(owners_), std::end(owners_), 0.0);
+  for (size_t i = 0; i < size; ++i) {
+    owners_[owner_by_slot_[i]] += zero_if_nan(unrealized[i]);
+    if (std::isnan(notional[i]))
+      continue;
+    for (auto bucket : buckets_by_slot_[i])
+      buckets_[bucket] += notional[i];
+  }
+  buckets_[0] = 0.0;  // note! "no bucket"
+  owners_[0] = 0.0;   // note! "no owner"
+  return result;
+}
+
+// note! O(1), uses the price of the last reprice
+void Exposure::update_unrealized(uint32_t slot) {
+  auto unrealized = quantity_[slot] * multiplier_[slot] * (price_[slot] - average_price_[slot]);
+  owners_[owner_by_slot_[slot]] += zero_if_nan(unrealized) - zero_if_nan(unrealized_[slot]);
+  owners_[0] = 0.0;  // note! "no owner"
+  unrealized_[slot] = unrealized;
+}
+
+}  // namespace risk
+}  // namespace risk_manager
+}  // namespace roq
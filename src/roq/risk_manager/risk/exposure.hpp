@@ -0,0 +1,99 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include <absl/container/flat_hash_map.h>
+
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+namespace roq {
+namespace risk_manager {
+namespace risk {
+
+// note!
+//   notional exposure, structure of arrays (one slot per position)
+//   prices are conflated (only the latest price per instrument is used when repricing)
+//   repricing is a single pass over contiguous arrays (vectorized), slots are then summed into buckets (e.g. groups)
+//   nan means "no price", unpriced slots are not included in a bucket
+//   unrealized pnl is summed by owner (e.g. account), a slot is also updated when the position changes
+
+struct Exposure final {
+  Exposure();
+
+  Exposure(Exposure &&) = default;
+  Exposure(Exposure const &) = delete;
+
+  uint32_t create_slot(uint32_t instrument_id);
+
+  // note! zero means "no bucket"
+  uint32_t create_bucket();
+
+  // note! replaces the buckets of a slot
+  void set_buckets(uint32_t slot, std::span<uint32_t const> const &buckets);
+
+  // note! zero means "no owner"
+  uint32_t create_owner();
+
+  void set_owner(uint32_t slot, uint32_t owner);
+
+  // note! change of the net position
+  void operator()(uint32_t slot, double quantity);
+
+  // note! nan if flat (or unknown)
+  void set_average_price(uint32_t slot, double average_price);
+
+  // note! returns true if a previous price has been replaced (conflated)
+  bool set_price(uint32_t instrument_id, double price);
+
+  void set_multiplier(uint32_t instrument_id, double multiplier);
+
+  // note! the latest price (nan if unknown)
+  double get_price(uint32_t instrument_id) const;
+
+  // note! returns the number of instruments having a new price
+  size_t reprice();
+
+  // note! instruments having a new price (last reprice)
+  std::span<uint32_t const> get_repriced() const { return repriced_; }
+
+  size_t size() const { return std::size(quantity_); }
+
+  double get_notional(uint32_t slot) const { return notional_[slot]; }
+  double get_bucket(uint32_t bucket) const { return buckets_[bucket]; }
+
+  double get_unrealized(uint32_t owner) const { return owners_[owner]; }
+
+ protected:
+  void update_unrealized(uint32_t slot);
+
+ private:
+  struct Instrument final {
+    double price = std::numeric_limits<double>::quiet_NaN();
+    double multiplier = 1.0;
+    bool dirty = {};
+    std::vector<uint32_t> slots;
+  };
+  absl::flat_hash_map<uint32_t, Instrument> instruments_;
+  std::vector<uint32_t> dirty_;     // note! instrument ids
+  std::vector<uint32_t> repriced_;  // note! instrument ids
+  // slots
+  std::vector<double> quantity_;
+  std::vector<double> multiplier_;
+  std::vector<double> price_;
+  std::vector<double> notional_;
+  std::vector<double> average_price_;
+  std::vector<double> unrealized_;
+  std::vector<std::vector<uint32_t>> buckets_by_slot_;
+  std::vector<uint32_t> owner_by_slot_;
+  // buckets
+  std::vector<double> buckets_;
+  // owners
+  std::vector<double> owners_;
+};
+
+}  // namespace risk
+}  // namespace risk_manager
+}  // namespace roq
@@ -0,0 +1,46 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include <fmt/compile.h>
+#include <fmt/format.h>
+
+#include <limits>
+#include <string>
+
+namespace roq {
+namespace risk_manager {
+namespace risk {
+
+// note!
+//   max position = (balance - hold) * leverage / (price * multiplier)
+//   funds are matched by currency, price is the latest mark (top of book)
+
+struct FundsLimit final {
+  std::string currency;
+  double leverage = std::numeric_limits<double>::quiet_NaN();
+};
+
+}  // namespace risk
+}  // namespace risk_manager
+}  // namespace roq
+
+template <>
+struct fmt::formatter<roq::risk_manager::risk::FundsLimit> {
+  template <typename Context>
+  constexpr auto parse(Context &context) {
+    return std::begin(context);
+  }
+  template <typename Context>
+  auto format(roq::risk_manager::risk::FundsLimit const &value, Context &context) const {
+    using namespace fmt::literals;
+    return fmt::format_to(
+        context.out(),
+        R"({{)"
+        R"(currency="{}", )"
+        R"(leverage={})"
+        R"(}})"_cf,
+        value.currency,
+        value.leverage);
+  }
+};
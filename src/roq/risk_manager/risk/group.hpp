@@ -0,0 +1,65 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include <fmt/compile.h>
+#include <fmt/format.h>
+
+#include <limits>
+#include <string>
+
+namespace roq {
+namespace risk_manager {
+namespace risk {
+
+// note!
+//   regular expressions matched against reference data (empty means "any"), all must match
+//   limits are in units of the underlying (quantity times multiplier) and apply to each account, user or strategy
+//   notional limits are in units of the quote currency (quantity times multiplier times price)
+
+struct Group final {
+  std::string exchange;
+  std::string symbol;
+  std::string underlying;
+  std::string base_currency;
+  double long_position_limit = std::numeric_limits<double>::quiet_NaN();
+  double short_position_limit = std::numeric_limits<double>::quiet_NaN();
+  double long_notional_limit = std::numeric_limits<double>::quiet_NaN();
+  double short_notional_limit = std::numeric_limits<double>::quiet_NaN();
+};
+
+}  // namespace risk
+}  // namespace risk_manager
+}  // namespace roq
+
+template <>
+struct fmt::formatter<roq::risk_manager::risk::Group> {
+  template <typename Context>
+  constexpr auto parse(Context &context) {
+    return std::begin(context);
+  }
+  template <typename Context>
+  auto format(roq::risk_manager::risk::Group const &value, Context &context) const {
+    using namespace fmt::literals;
+    return fmt::format_to(
+        context.out(),
+        R"({{)"
+        R"(exchange="{}", )"
+        R"(symbol="{}", )"
+        R"(underlying="{}", )"
+        R"(base_currency="{}", )"
+        R"(long_position_limit={}, )"
+        R"(short_position_limit={}, )"
+        R"(long_notional_limit={}, )"
+        R"(short_notional_limit={})"
+        R"(}})"_cf,
+        value.exchange,
+        value.symbol,
+        value.underlying,
+        value.base_currency,
+        value.long_position_limit,
+        value.short_position_limit,
+        value.long_notional_limit,
+        value.short_notional_limit);
+  }
+};
@@ -2,6 +2,8 @@
 
 #include "roq/risk_manager/risk/instrument.hpp"
 
+#include <cmath>
+
 #include "roq/client.hpp"
 
 using namespace std::literals;
@@ -15,6 +17,8 @@ Instrument::Instrument(uint32_t id, std::string_view const &exchange, std::strin
 }
 
 bool Instrument::operator()(ReferenceData const &reference_data) {
+  if (!std::isnan(reference_data.multiplier) && reference_data.multiplier > 0.0)
+    multiplier_ = reference_data.multiplier;
   if (std::isnan(reference_data.min_trade_vol))
     return false;
   min_trade_vol_ = reference_data.min_trade_vol;
@@ -27,6 +27,8 @@ struct Instrument final {
 
   int64_t quantity_to_internal(double quantity) const;
 
+  double multiplier() const { return multiplier_; }
+
   template <typename Context>
   auto format_to(Context &context) const {
     using namespace std::literals;
@@ -35,15 +37,18 @@ struct Instrument final {
         context.out(),
         R"({{)"
         R"(min_trade_vol={}, )"
-        R"(quantity_decimals={})"
+        R"(quantity_decimals={}, )"
+        R"(multiplier={})"
         R"(}})"_cf,
         min_trade_vol_,
-        quantity_decimals_);
+        quantity_decimals_,
+        multiplier_);
   }
 
  private:
   double min_trade_vol_ = std::numeric_limits<double>::quiet_NaN();
   Decimals quantity_decimals_;
+  double multiplier_ = 1.0;
 };
 
 }  // namespace risk
@@ -0,0 +1,51 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include <fmt/chrono.h>
+#include <fmt/compile.h>
+#include <fmt/format.h>
+
+#include <chrono>
+#include <limits>
+
+namespace roq {
+namespace risk_manager {
+namespace risk {
+
+// note!
+//   losses are positive amounts (same units as the pnl), nan means "no limit"
+//   drawdown is measured from the peak pnl, daily loss from the pnl at the last reset
+//   reset time is the time of day (UTC)
+
+struct LossLimit final {
+  double max_drawdown = std::numeric_limits<double>::quiet_NaN();
+  double max_daily_loss = std::numeric_limits<double>::quiet_NaN();
+  std::chrono::seconds reset_time = {};
+};
+
+}  // namespace risk
+}  // namespace risk_manager
+}  // namespace roq
+
+template <>
+struct fmt::formatter<roq::risk_manager::risk::LossLimit> {
+  template <typename Context>
+  constexpr auto parse(Context &context) {
+    return std::begin(context);
+  }
+  template <typename Context>
+  auto format(roq::risk_manager::risk::LossLimit const &value, Context &context) const {
+    using namespace fmt::literals;
+    return fmt::format_to(
+        context.out(),
+        R"({{)"
+        R"(max_drawdown={}, )"
+        R"(max_daily_loss={}, )"
+        R"(reset_time={})"
+        R"(}})"_cf,
+        value.max_drawdown,
+        value.max_daily_loss,
+        value.reset_time);
+  }
+};
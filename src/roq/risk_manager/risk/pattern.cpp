@@ -0,0 +1,69 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include "roq/risk_manager/risk/pattern.hpp"
+
+#include <tuple>
+
+#include "roq/exceptions.hpp"
+
+using namespace std::literals;
+
+namespace roq {
+namespace risk_manager {
+namespace risk {
+
+// === HELPERS ===
+
+namespace {
+bool is_regex(auto &symbol) {
+  return !std::empty(symbol) && symbol[0] == '^';
+}
+
+auto create_regex(auto &symbol) -> std::optional<std::regex> {
+  if (!is_regex(symbol))
+    return {};
+  return std::regex{std::begin(symbol), std::end(symbol), std::regex::ECMAScript | std::regex::optimize};
+}
+
+auto get_rank(auto &pattern) {
+  return std::make_tuple(pattern.exchange != Pattern::ANY, pattern.symbol != Pattern::ANY, std::size(pattern.symbol));
+}
+}  // namespace
+
+// === IMPLEMENTATION ===
+
+Pattern::Pattern(std::string_view const &exchange, std::string_view const &symbol, Limit const &limit)
+    : exchange{exchange}, symbol{symbol}, limit{limit}, regex_{create_regex(symbol)} {
+}
+
+bool Pattern::is_pattern(std::string_view const &exchange, std::string_view const &symbol) {
+  return exchange == ANY || symbol == ANY || is_regex(symbol);
+}
+
+void Pattern::validate(std::string_view const &symbol) {
+  try {
+    create_regex(symbol);
+  } catch (std::regex_error &) {
+    throw RuntimeError{R"(Unexpected: invalid regex="{}")"sv, symbol};
+  }
+}
+
+bool Pattern::operator()(std::string_view const &exchange, std::string_view const &symbol) const {
+  if (this->exchange != ANY && this->exchange != exchange)
+    return false;
+  if (regex_)
+    return std::regex_match(std::begin(symbol), std::end(symbol), *regex_);
+  return this->symbol == ANY || this->symbol == symbol;
+}
+
+// note! ties are broken by name (deterministic)
+bool Pattern::operator<(Pattern const &rhs) const {
+  auto lhs_rank = get_rank(*this), rhs_rank = get_rank(rhs);
+  if (lhs_rank != rhs_rank)
+    return lhs_rank > rhs_rank;
+  return std::tie(symbol, exchange) < std::tie(rhs.symbol, rhs.exchange);
+}
+
+}  // namespace risk
+}  // namespace risk_manager
+}  // namespace roq
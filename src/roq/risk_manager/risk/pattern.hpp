@@ -0,0 +1,52 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include <optional>
+#include <regex>
+#include <string>
+#include <string_view>
+
+#include "roq/risk_manager/risk/limit.hpp"
+
+namespace roq {
+namespace risk_manager {
+namespace risk {
+
+// note!
+//   exchange is either exact or "*" (any)
+//   symbol is either exact, a regex (starting with "^") or "*" (any)
+//   most specific wins: exact exchange before any exchange, then regex symbol (longest first) before any symbol
+//   exact exchange and exact symbol is not a pattern (found by lookup)
+
+struct Pattern final {
+  static constexpr std::string_view ANY = "*";
+
+  Pattern(std::string_view const &exchange, std::string_view const &symbol, Limit const &);
+
+  Pattern(Pattern &&) = default;
+  Pattern(Pattern const &) = delete;
+
+  Pattern &operator=(Pattern &&) = default;
+
+  static bool is_pattern(std::string_view const &exchange, std::string_view const &symbol);
+
+  // note! throws if the symbol is not a valid regex
+  static void validate(std::string_view const &symbol);
+
+  bool operator()(std::string_view const &exchange, std::string_view const &symbol) const;
+
+  // note! sort order, most specific first
+  bool operator<(Pattern const &) const;
+
+  std::string exchange;
+  std::string symbol;
+  Limit limit;
+
+ private:
+  std::optional<std::regex> regex_;
+};
+
+}  // namespace risk
+}  // namespace risk_manager
+}  // namespace roq
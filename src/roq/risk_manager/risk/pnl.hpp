@@ -0,0 +1,52 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include <fmt/compile.h>
+#include <fmt/format.h>
+
+#include "roq/api.hpp"
+
+namespace roq {
+namespace risk_manager {
+namespace risk {
+
+// note!
+//   average cost of the net position, realized when the position is reduced
+//   amounts are price times quantity times multiplier (fees are summed in their own currencies)
+//   nan means "unknown", e.g. no price
+
+struct PnL final {
+  double average_price = NaN;
+  double realized = {};
+  double unrealized = NaN;
+  double fees = {};
+};
+
+}  // namespace risk
+}  // namespace risk_manager
+}  // namespace roq
+
+template <>
+struct fmt::formatter<roq::risk_manager::risk::PnL> {
+  template <typename Context>
+  constexpr auto parse(Context &context) {
+    return std::begin(context);
+  }
+  template <typename Context>
+  auto format(roq::risk_manager::risk::PnL const &value, Context &context) const {
+    using namespace fmt::literals;
+    return fmt::format_to(
+        context.out(),
+        R"({{)"
+        R"(average_price={}, )"
+        R"(realized={}, )"
+        R"(unrealized={}, )"
+        R"(fees={})"
+        R"(}})"_cf,
+        value.average_price,
+        value.realized,
+        value.unrealized,
+        value.fees);
+  }
+};
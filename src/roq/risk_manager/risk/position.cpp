@@ -2,6 +2,9 @@
 
 #include "roq/risk_manager/risk/position.hpp"
 
+#include <algorithm>
+#include <cmath>
+
 #include "roq/logging.hpp"
 
 #include "roq/utils/common.hpp"
@@ -13,7 +16,7 @@ namespace risk_manager {
 namespace risk {
 
 Position::Position(Limit const &limit)
-    : allow_netting{limit.allow_netting}, long_position_limit_{limit.long_position_limit},
+    : allow_netting_{limit.allow_netting}, long_position_limit_{limit.long_position_limit},
       short_position_limit_{limit.short_position_limit}, long_risk_exposure_limit_{limit.long_risk_exposure_limit},
       short_risk_exposure_limit_{limit.short_risk_exposure_limit} {
 }
@@ -21,6 +24,14 @@ Position::Position(Limit const &limit)
 void Position::operator()(database::Position const &position, Instrument const &) {
   long_position_ = position.long_quantity;
   short_position_ = position.short_quantity;
+  quantity_ = long_position_ - short_position_;  // note! fills are applied to the net position
+  exchange_time_utc_ = position.exchange_time_utc;
+  // note! nan means the pnl has never been persisted (the average price is then marked by the first price)
+  if (!std::isnan(position.realized_pnl)) {
+    average_price_ = position.average_price;
+    realized_pnl_ = position.realized_pnl;
+    fees_ = std::isnan(position.fees) ? 0.0 : position.fees;
+  }
 }
 
 void Position::operator()(ReferenceData const &, Instrument const &) {
@@ -35,6 +46,11 @@ void Position::operator()(TradeUpdate const &trade_update, Instrument const &ins
     auto res = fills_.emplace(item.external_trade_id);
     if (!res.second)
       continue;
+    ++fill_count_;
+    notional_ += item.quantity * item.price * instrument.multiplier();
+    update_pnl(sign * item.quantity, item.price, instrument.multiplier());
+    if (!std::isnan(item.commission_amount))
+      fees_ += item.commission_amount;
     // note! this could be more complex, e.g. omnibus accounting
     quantity_ += sign * item.quantity;
     long_position_ = std::max(quantity_, 0.0);
@@ -45,9 +61,28 @@ void Position::operator()(TradeUpdate const &trade_update, Instrument const &ins
       log::warn("Probably something wrong... perhaps missing reference data?"sv);
     }
     current_ += sign * quantity;
+    exchange_time_utc_ = std::max(exchange_time_utc_, trade_update.create_time_utc);
   }
 }
 
+void Position::operator()(Limit const &limit) {
+  allow_netting_ = limit.allow_netting;
+  long_position_limit_ = limit.long_position_limit;
+  short_position_limit_ = limit.short_position_limit;
+  long_risk_exposure_limit_ = limit.long_risk_exposure_limit;
+  short_risk_exposure_limit_ = limit.short_risk_exposure_limit;
+}
+
+Limit Position::get_limit() const {
+  return {
+      .long_position_limit = long_position_limit_,
+      .short_position_limit = short_position_limit_,
+      .long_risk_exposure_limit = long_risk_exposure_limit_,
+      .short_risk_exposure_limit = short_risk_exposure_limit_,
+      .allow_netting = allow_netting_,
+  };
+}
+
 double Position::long_position_limit() const {
   // return std::max(0.0, long_position_limit_ - long_position_);
   return long_position_limit_;
@@ -68,6 +103,73 @@ double Position::short_risk_exposure_limit() const {
   return short_risk_exposure_limit_;
 }
 
+RiskLimit Position::get_risk_limit(Instrument const &instrument, Breach const &breach, double max_position) const {
+  // note! nan means "no limit"
+  auto reduce_only = [](auto limit, auto position) { return std::isnan(limit) ? position : std::min(limit, position); };
+  auto cap = [&](auto limit) {
+    if (std::isnan(max_position))
+      return limit;
+    return std::isnan(limit) ? max_position : std::min(limit, max_position);
+  };
+  auto result = RiskLimit{
+      .exchange = instrument.exchange,
+      .symbol = instrument.symbol,
+      .long_position = long_position(),
+      .short_position = short_position(),
+      .long_position_limit = cap(long_position_limit()),
+      .short_position_limit = cap(short_position_limit()),
+      .long_risk_exposure_limit = long_risk_exposure_limit(),
+      .short_risk_exposure_limit = short_risk_exposure_limit(),
+      .allow_netting = allow_netting(),
+  };
+  if (breach.long_position) {
+    result.long_position_limit = reduce_only(result.long_position_limit, result.long_position);
+    result.long_risk_exposure_limit = reduce_only(result.long_risk_exposure_limit, result.long_position);
+  }
+  if (breach.short_position) {
+    result.short_position_limit = reduce_only(result.short_position_limit, result.short_position);
+    result.short_risk_exposure_limit = reduce_only(result.short_risk_exposure_limit, result.short_position);
+  }
+  return result;
+}
+
+void Position::mark(double price) {
+  if (std::isnan(average_price_) && quantity_ != 0.0)
+    average_price_ = price;
+}
+
+PnL Position::get_pnl(Instrument const &instrument, double price) const {
+  auto unrealized = quantity_ == 0.0 ? 0.0 : quantity_ * (price - average_price_) * instrument.multiplier();
+  return {
+      .average_price = average_price_,
+      .realized = realized_pnl_,
+      .unrealized = unrealized,
+      .fees = fees_,
+  };
+}
+
+// note!
+//   average cost, O(1) per fill (the trade history is never re-scanned)
+//   a fill crossing zero first closes the current position and then opens at the fill price
+void Position::update_pnl(double quantity, double price, double multiplier) {
+  if (std::isnan(price) || quantity == 0.0) [[unlikely]]
+    return;
+  if (std::isnan(average_price_))
+    mark(price);  // note! loaded from the database and not yet marked
+  auto current = std::fabs(quantity_), size = std::fabs(quantity);
+  if (quantity_ == 0.0 || std::signbit(quantity_) == std::signbit(quantity)) {
+    average_price_ = quantity_ == 0.0 ? price : (average_price_ * current + price * size) / (current + size);
+    return;
+  }
+  auto closed = std::min(current, size);
+  auto direction = quantity_ > 0.0 ? 1.0 : -1.0;
+  realized_pnl_ += closed * (price - average_price_) * direction * multiplier;
+  if (size > current)
+    average_price_ = price;
+  else if (size == current)
+    average_price_ = NaN;
+}
+
 }  // namespace risk
 }  // namespace risk_manager
 }  // namespace roq
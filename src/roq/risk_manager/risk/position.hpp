@@ -7,15 +7,19 @@
 #include <fmt/compile.h>
 #include <fmt/format.h>
 
+#include <chrono>
 #include <limits>
 
 #include "roq/reference_data.hpp"
+#include "roq/risk_limit.hpp"
 #include "roq/trade_update.hpp"
 
 #include "roq/risk_manager/database/position.hpp"
 
+#include "roq/risk_manager/risk/breach.hpp"
 #include "roq/risk_manager/risk/instrument.hpp"
 #include "roq/risk_manager/risk/limit.hpp"
+#include "roq/risk_manager/risk/pnl.hpp"
 
 namespace roq {
 namespace risk_manager {
@@ -32,15 +36,48 @@ struct Position final {
   void operator()(ReferenceData const &, Instrument const &);
   void operator()(TradeUpdate const &, Instrument const &);
 
+  // note! limits can be changed (e.g. reload)
+  void operator()(Limit const &);
+
+  Limit get_limit() const;
+
   double long_position() const { return long_position_; }
   double short_position() const { return short_position_; }
 
+  // note! net
+  double quantity() const { return quantity_; }
+
+  std::chrono::nanoseconds exchange_time_utc() const { return exchange_time_utc_; }
+
+  // note! accumulated from new fills (duplicates are ignored)
+  uint64_t fill_count() const { return fill_count_; }
+  double notional() const { return notional_; }
+
+  double average_price() const { return average_price_; }
+  double realized_pnl() const { return realized_pnl_; }
+  double fees() const { return fees_; }
+
+  bool allow_netting() const { return allow_netting_; }
+
   double long_position_limit() const;
   double short_position_limit() const;
 
   double long_risk_exposure_limit() const;
   double short_risk_exposure_limit() const;
 
+  // note! refers to the instrument (exchange and symbol)
+  // note! max position caps the position limits (nan means "no limit")
+  RiskLimit get_risk_limit(
+      Instrument const &,
+      Breach const & = {},
+      double max_position = std::numeric_limits<double>::quiet_NaN()) const;
+
+  // note! positions loaded from the database without pnl have an unknown average price (the first mark is then used)
+  void mark(double price);
+
+  // note! unrealized is computed from the mark (nan if there is no mark)
+  PnL get_pnl(Instrument const &, double price) const;
+
   template <typename Context>
   auto format_to(Context &context) const {
     using namespace std::literals;
@@ -55,30 +92,45 @@ struct Position final {
         R"(short_risk_exposure_limit={}, )"
         R"(long_position={}, )"
         R"(short_position={}, )"
+        R"(average_price={}, )"
+        R"(realized_pnl={}, )"
+        R"(fees={}, )"
         R"(fills=[{}])"
         R"(}})"_cf,
-        allow_netting,
+        allow_netting_,
         long_position_limit_,
         short_position_limit_,
         long_risk_exposure_limit_,
         short_risk_exposure_limit_,
         long_position_,
         short_position_,
+        average_price_,
+        realized_pnl_,
+        fees_,
         fmt::join(fills_, ", "sv));
   }
 
-  bool const allow_netting;
+ protected:
+  void update_pnl(double quantity, double price, double multiplier);
 
  private:
-  double const long_position_limit_;
-  double const short_position_limit_;
-  double const long_risk_exposure_limit_;
-  double const short_risk_exposure_limit_;
+  bool allow_netting_;
+  double long_position_limit_;
+  double short_position_limit_;
+  double long_risk_exposure_limit_;
+  double short_risk_exposure_limit_;
   absl::flat_hash_set<std::string> fills_;  // history
   // DEBUG
   double quantity_ = {};
   double long_position_ = {};
   double short_position_ = {};
+  std::chrono::nanoseconds exchange_time_utc_ = {};
+  uint64_t fill_count_ = {};
+  double notional_ = {};
+  // pnl
+  double average_price_ = NaN;
+  double realized_pnl_ = {};
+  double fees_ = {};
   // TEST
   int64_t current_ = {};  // XXX TODO issues min_trade_vol changing over time
 };
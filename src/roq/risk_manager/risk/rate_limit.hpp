@@ -0,0 +1,49 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include <fmt/compile.h>
+#include <fmt/format.h>
+
+#include <limits>
+
+namespace roq {
+namespace risk_manager {
+namespace risk {
+
+// note!
+//   sliding windows, nan means "no limit"
+//   notional is quantity times multiplier times fill price (not converted)
+//   orders are counted when the order id differs from the previous fill (churn)
+
+struct RateLimit final {
+  double max_fills_per_second = std::numeric_limits<double>::quiet_NaN();
+  double max_notional_per_minute = std::numeric_limits<double>::quiet_NaN();
+  double max_orders_per_minute = std::numeric_limits<double>::quiet_NaN();
+};
+
+}  // namespace risk
+}  // namespace risk_manager
+}  // namespace roq
+
+template <>
+struct fmt::formatter<roq::risk_manager::risk::RateLimit> {
+  template <typename Context>
+  constexpr auto parse(Context &context) {
+    return std::begin(context);
+  }
+  template <typename Context>
+  auto format(roq::risk_manager::risk::RateLimit const &value, Context &context) const {
+    using namespace fmt::literals;
+    return fmt::format_to(
+        context.out(),
+        R"({{)"
+        R"(max_fills_per_second={}, )"
+        R"(max_notional_per_minute={}, )"
+        R"(max_orders_per_minute={})"
+        R"(}})"_cf,
+        value.max_fills_per_second,
+        value.max_notional_per_minute,
+        value.max_orders_per_minute);
+  }
+};
@@ -28,6 +28,14 @@ void Strategy::operator()(TradeUpdate const &trade_update) {
   dispatch(trade_update, callback);
 }
 
+void Strategy::operator()(uint32_t instrument_id, Limit const &limit) {
+  auto iter = positions_.find(instrument_id);
+  if (iter == std::end(positions_))
+    return;
+  (*iter).second(limit);
+  handler_.publish_strategy(strategy_id, instrument_id);
+}
+
 template <typename Callback>
 void Strategy::dispatch(auto &value, Callback callback) {
   auto &instrument = handler_.get_instrument(value.exchange, value.symbol);
@@ -37,7 +45,16 @@ void Strategy::dispatch(auto &value, Callback callback) {
     iter = positions_.try_emplace(instrument.id, limit).first;
   }
   auto &position = (*iter).second;
+  auto quantity = position.quantity();
+  auto realized_pnl = position.realized_pnl() - position.fees();
   position(value, instrument);
+  auto change = Change{
+      .quantity = position.quantity() - quantity,
+      .realized_pnl = position.realized_pnl() - position.fees() - realized_pnl,
+      .average_price = position.average_price(),
+  };
+  if (change.quantity != 0.0 || change.realized_pnl != 0.0)
+    handler_.aggregate_strategy(strategy_id, instrument.id, change);
   callback(instrument.id);
   log::debug(
       R"(strategy_id={}, exchange="{}", symbol="{}", instrument={}, position={})"sv,
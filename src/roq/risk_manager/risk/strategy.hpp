@@ -9,6 +9,7 @@
 
 #include "roq/risk_manager/database/position.hpp"
 
+#include "roq/risk_manager/risk/change.hpp"
 #include "roq/risk_manager/risk/instrument.hpp"
 #include "roq/risk_manager/risk/position.hpp"
 
@@ -19,6 +20,7 @@ namespace risk {
 struct Strategy final {
   struct Handler {
     virtual void publish_strategy(uint32_t strategy_id, uint32_t instrument_id) = 0;
+    virtual void aggregate_strategy(uint32_t strategy_id, uint32_t instrument_id, Change const &) = 0;
     virtual Instrument &get_instrument(std::string_view const &exchange, std::string_view const &symbol) = 0;
     virtual Limit get_limit_by_strategy(
         uint32_t strategy_id, std::string_view const &exchange, std::string_view const &symbol) const = 0;
@@ -36,6 +38,9 @@ struct Strategy final {
   void operator()(ReferenceData const &);
   void operator()(TradeUpdate const &);
 
+  // note! only existing positions are updated (new positions will look up the current limit)
+  void operator()(uint32_t instrument_id, Limit const &);
+
   template <typename Callback>
   void get_position(uint32_t instrument_id, Callback callback) {
     auto iter = positions_.find(instrument_id);
@@ -43,6 +48,12 @@ struct Strategy final {
       callback((*iter).second);
   }
 
+  template <typename Callback>
+  void get_all_positions(Callback callback) const {
+    for (auto &[instrument_id, position] : positions_)
+      callback(instrument_id, position);
+  }
+
  protected:
   template <typename Callback>
   void dispatch(auto &value, Callback);
@@ -14,20 +14,56 @@ User::User(std::string_view const &name, Handler &handler) : name{name}, handler
 }
 
 void User::operator()(database::Position const &position) {
-  auto callback = []([[maybe_unused]] auto instrument_id) {};
+  auto callback = []([[maybe_unused]] auto &instrument, [[maybe_unused]] auto &change) {};
   dispatch(position, callback);
 }
 
 void User::operator()(ReferenceData const &reference_data) {
-  auto callback = []([[maybe_unused]] auto instrument_id) {};
+  auto callback = []([[maybe_unused]] auto &instrument, [[maybe_unused]] auto &change) {};
   dispatch(reference_data, callback);
 }
 
-void User::operator()(TradeUpdate const &trade_update) {
-  auto callback = [this](auto instrument_id) { handler_.publish_user(name, instrument_id); };
+void User::operator()(TradeUpdate const &trade_update, std::chrono::nanoseconds now) {
+  auto callback = [&](auto &instrument, auto &change) {
+    handler_.publish_user(name, instrument.id);
+    // note! the cut is immediate (all positions, including this one)
+    if (velocity_(trade_update, change, now)) [[unlikely]] {
+      log::warn(R"(*** RATE LIMIT *** (user="{}", rate_limit={}))"sv, name, velocity_.get_rate_limit());
+      publish_all();
+      handler_.throttle_user(name);
+    }
+  };
   dispatch(trade_update, callback);
 }
 
+void User::operator()(uint32_t instrument_id, Limit const &limit) {
+  auto iter = positions_.find(instrument_id);
+  if (iter == std::end(positions_))
+    return;
+  (*iter).second(limit);
+  handler_.publish_user(name, instrument_id);
+}
+
+bool User::operator()(RateLimit const &rate_limit) {
+  if (!velocity_(rate_limit))
+    return false;
+  publish_all();
+  return true;
+}
+
+bool User::operator()(std::chrono::nanoseconds now) {
+  if (!velocity_(now))
+    return false;
+  log::info(R"(Rate limit is no longer breached (user="{}"))"sv, name);
+  publish_all();
+  return true;
+}
+
+void User::publish_all() {
+  for (auto &[instrument_id, _] : positions_)
+    handler_.publish_user(name, instrument_id);
+}
+
 template <typename Callback>
 void User::dispatch(auto &value, Callback callback) {
   auto &instrument = handler_.get_instrument(value.exchange, value.symbol);
@@ -37,8 +73,21 @@ void User::dispatch(auto &value, Callback callback) {
     iter = positions_.try_emplace(instrument.id, limit).first;
   }
   auto &position = (*iter).second;
+  auto quantity = position.quantity();
+  auto realized_pnl = position.realized_pnl() - position.fees();
+  auto fill_count = position.fill_count();
+  auto notional = position.notional();
   position(value, instrument);
-  callback(instrument.id);
+  auto change = Change{
+      .quantity = position.quantity() - quantity,
+      .realized_pnl = position.realized_pnl() - position.fees() - realized_pnl,
+      .average_price = position.average_price(),
+      .fill_count = position.fill_count() - fill_count,
+      .notional = position.notional() - notional,
+  };
+  if (change.quantity != 0.0 || change.realized_pnl != 0.0)
+    handler_.aggregate_user(name, instrument.id, change);
+  callback(instrument, change);
   log::debug(
       R"(user="{}", exchange="{}", symbol="{}", instrument={}, position={})"sv,
       name,
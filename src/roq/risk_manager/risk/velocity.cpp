@@ -0,0 +1,85 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include "roq/risk_manager/risk/velocity.hpp"
+
+#include <cmath>
+#include <utility>
+
+#include "roq/exceptions.hpp"
+
+using namespace std::literals;
+
+namespace roq {
+namespace risk_manager {
+namespace risk {
+
+// === HELPERS ===
+
+namespace {
+// note! nan means "no limit"
+bool is_exceeded(double value, double limit) {
+  return !std::isnan(limit) && value > limit;
+}
+
+bool is_enabled(RateLimit const &rate_limit) {
+  return !std::isnan(rate_limit.max_fills_per_second) || !std::isnan(rate_limit.max_notional_per_minute) ||
+         !std::isnan(rate_limit.max_orders_per_minute);
+}
+}  // namespace
+
+// === IMPLEMENTATION ===
+
+Velocity::Velocity() : fills_{1s}, notional_{1min}, orders_{1min} {
+}
+
+void Velocity::validate(RateLimit const &rate_limit) {
+  if (rate_limit.max_fills_per_second <= 0.0)
+    throw RuntimeError{"Unexpected: max_fills_per_second must be positive (rate_limit={})"sv, rate_limit};
+  if (rate_limit.max_notional_per_minute <= 0.0)
+    throw RuntimeError{"Unexpected: max_notional_per_minute must be positive (rate_limit={})"sv, rate_limit};
+  if (rate_limit.max_orders_per_minute <= 0.0)
+    throw RuntimeError{"Unexpected: max_orders_per_minute must be positive (rate_limit={})"sv, rate_limit};
+}
+
+// note! windows are not advanced (expiry is handled by the timer)
+bool Velocity::operator()(RateLimit const &rate_limit) {
+  rate_limit_ = rate_limit;
+  enabled_ = is_enabled(rate_limit);
+  auto breach = enabled_ && is_breach(fills_.get(), notional_.get(), orders_.get());
+  return std::exchange(breach_, breach) != breach;
+}
+
+bool Velocity::operator()(TradeUpdate const &trade_update, Change const &change, std::chrono::nanoseconds now) {
+  if (!enabled_ || change.fill_count == 0)
+    return false;
+  auto orders = 0.0;
+  if (trade_update.external_order_id != external_order_id_) {
+    external_order_id_ = trade_update.external_order_id;
+    orders = 1.0;
+  }
+  auto fills = fills_(now, static_cast<double>(change.fill_count));
+  auto breach = is_breach(fills, notional_(now, change.notional), orders_(now, orders));
+  if (breach_ || !breach)
+    return false;
+  breach_ = true;
+  return true;
+}
+
+bool Velocity::operator()(std::chrono::nanoseconds now) {
+  if (!breach_)
+    return false;
+  if (is_breach(fills_.get(now), notional_.get(now), orders_.get(now)))
+    return false;
+  breach_ = false;
+  return true;
+}
+
+bool Velocity::is_breach(double fills, double notional, double orders) const {
+  return is_exceeded(fills, rate_limit_.max_fills_per_second) ||
+         is_exceeded(notional, rate_limit_.max_notional_per_minute) ||
+         is_exceeded(orders, rate_limit_.max_orders_per_minute);
+}
+
+}  // namespace risk
+}  // namespace risk_manager
+}  // namespace roq
@@ -0,0 +1,63 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include <chrono>
+#include <string>
+
+#include "roq/trade_update.hpp"
+
+#include "roq/risk_manager/risk/change.hpp"
+#include "roq/risk_manager/risk/rate_limit.hpp"
+#include "roq/risk_manager/risk/window.hpp"
+
+namespace roq {
+namespace risk_manager {
+namespace risk {
+
+// note!
+//   trading rate of an account or user, O(1) per trade update
+//   windows are driven by trade updates (when received) and by the timer (expiry), both using the same clock
+//   the breach is kept until all windows are back within their limits (then reduce-only for all positions)
+
+struct Velocity final {
+  Velocity();
+
+  Velocity(Velocity &&) = default;
+  Velocity(Velocity const &) = delete;
+
+  // note! throws if the limit is not valid
+  static void validate(RateLimit const &);
+
+  RateLimit const &get_rate_limit() const { return rate_limit_; }
+
+  bool get_breach() const { return breach_; }
+
+  // note! limits can be changed (e.g. reload), returns true if the breach has changed
+  bool operator()(RateLimit const &);
+
+  // note!
+  //   only the new fills are counted (the change of the position), i.e. a replayed trade update is ignored
+  //   now is the time the trade update was received (not the exchange time), the same clock as used for expiry
+  //   returns true if the breach has changed
+  bool operator()(TradeUpdate const &, Change const &, std::chrono::nanoseconds now);
+
+  // note! returns true if the breach has changed (expiry)
+  bool operator()(std::chrono::nanoseconds now);
+
+ protected:
+  bool is_breach(double fills, double notional, double orders) const;
+
+ private:
+  RateLimit rate_limit_;
+  bool enabled_ = {};
+  Window fills_;
+  Window notional_;
+  Window orders_;
+  std::string external_order_id_;
+  bool breach_ = {};
+};
+
+}  // namespace risk
+}  // namespace risk_manager
+}  // namespace roq
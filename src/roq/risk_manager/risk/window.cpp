@@ -0,0 +1,48 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include "roq/risk_manager/risk/window.hpp"
+
+#include <algorithm>
+
+namespace roq {
+namespace risk_manager {
+namespace risk {
+
+// === IMPLEMENTATION ===
+
+Window::Window(std::chrono::nanoseconds span) : width_{span / SIZE} {
+}
+
+double Window::operator()(std::chrono::nanoseconds now, double value) {
+  advance(now);
+  buckets_[head_ % SIZE] += value;
+  sum_ += value;
+  return sum_;
+}
+
+double Window::get(std::chrono::nanoseconds now) {
+  advance(now);
+  return sum_;
+}
+
+void Window::advance(std::chrono::nanoseconds now) {
+  auto index = now / width_;
+  if (index <= head_)
+    return;
+  auto count = std::min<int64_t>(index - head_, SIZE);
+  if (count == SIZE) {
+    buckets_.fill(0.0);
+    sum_ = 0.0;  // note! also drops accumulated rounding errors
+  } else {
+    for (int64_t i = 1; i <= count; ++i) {
+      auto &bucket = buckets_[(head_ + i) % SIZE];
+      sum_ -= bucket;
+      bucket = 0.0;
+    }
+  }
+  head_ = index;
+}
+
+}  // namespace risk
+}  // namespace risk_manager
+}  // namespace roq
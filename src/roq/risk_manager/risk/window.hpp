@@ -0,0 +1,46 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+namespace roq {
+namespace risk_manager {
+namespace risk {
+
+// note!
+//   sliding window (ring of buckets), O(1) per update (at most SIZE buckets are cleared when time advances)
+//   resolution is the width of a bucket, i.e. values expire (at the latest) one bucket late
+//   time going backwards is added to the current bucket
+
+struct Window final {
+  static constexpr size_t const SIZE = 10;
+
+  explicit Window(std::chrono::nanoseconds span);
+
+  Window(Window &&) = default;
+  Window(Window const &) = delete;
+
+  // note! returns the sum
+  double operator()(std::chrono::nanoseconds now, double value);
+
+  double get(std::chrono::nanoseconds now);
+
+  // note! not advanced
+  double get() const { return sum_; }
+
+ protected:
+  void advance(std::chrono::nanoseconds now);
+
+ private:
+  std::chrono::nanoseconds const width_;
+  std::array<double, SIZE> buckets_ = {};
+  int64_t head_ = {};  // note! index (time divided by width) of the latest bucket
+  double sum_ = {};
+};
+
+}  // namespace risk
+}  // namespace risk_manager
+}  // namespace roq
@@ -2,6 +2,12 @@
 
 #include "roq/risk_manager/shared.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+#include <vector>
+
 #include "roq/logging.hpp"
 
 using namespace std::literals;
@@ -35,15 +41,688 @@ auto create_limits(auto &limits) {
   return result;
 }
 
+// note! the config may later be reloaded
+void merge(auto &limits, auto const &overrides) {
+  for (auto &[key, value_1] : overrides)
+    for (auto &[exchange, value_2] : value_1)
+      for (auto &[symbol, limit] : value_2)
+        limits[key][exchange].insert_or_assign(symbol, limit);
+}
+
+risk::Limit create_limit(database::Limit const &limit) {
+  return {
+      .long_position_limit = limit.long_position_limit,
+      .short_position_limit = limit.short_position_limit,
+      .long_risk_exposure_limit = limit.long_risk_exposure_limit,
+      .short_risk_exposure_limit = limit.short_risk_exposure_limit,
+      .allow_netting = limit.allow_netting,
+  };
+}
+
+// note! nan means "no limit"
+bool is_equal(double lhs, double rhs) {
+  return (std::isnan(lhs) && std::isnan(rhs)) || lhs == rhs;
+}
+
+bool is_equal(risk::Limit const &lhs, risk::Limit const &rhs) {
+  return is_equal(lhs.long_position_limit, rhs.long_position_limit) &&
+         is_equal(lhs.short_position_limit, rhs.short_position_limit) &&
+         is_equal(lhs.long_risk_exposure_limit, rhs.long_risk_exposure_limit) &&
+         is_equal(lhs.short_risk_exposure_limit, rhs.short_risk_exposure_limit) &&
+         lhs.allow_netting == rhs.allow_netting;
+}
+
+bool is_equal(risk::RateLimit const &lhs, risk::RateLimit const &rhs) {
+  return is_equal(lhs.max_fills_per_second, rhs.max_fills_per_second) &&
+         is_equal(lhs.max_notional_per_minute, rhs.max_notional_per_minute) &&
+         is_equal(lhs.max_orders_per_minute, rhs.max_orders_per_minute);
+}
+
+risk::Limit const *find_limit(auto &limits, auto const &key, auto const &exchange, auto const &symbol) {
+  auto iter_1 = limits.find(key);
+  if (iter_1 == std::end(limits))
+    return nullptr;
+  auto &tmp_1 = (*iter_1).second;
+  auto iter_2 = tmp_1.find(exchange);
+  if (iter_2 == std::end(tmp_1))
+    return nullptr;
+  auto &tmp_2 = (*iter_2).second;
+  auto iter_3 = tmp_2.find(symbol);
+  if (iter_3 == std::end(tmp_2))
+    return nullptr;
+  return &(*iter_3).second;
+}
+
+// note! removed limits are reported as the default limit
+template <typename Callback>
+void get_changes(auto const &current, auto const &next, Callback callback) {
+  for (auto &[key, value_1] : next)
+    for (auto &[exchange, value_2] : value_1)
+      for (auto &[symbol, limit] : value_2) {
+        auto previous = find_limit(current, key, exchange, symbol);
+        if (previous == nullptr || !is_equal(*previous, limit))
+          callback(key, exchange, symbol, limit);
+      }
+  for (auto &[key, value_1] : current)
+    for (auto &[exchange, value_2] : value_1)
+      for (auto &[symbol, _] : value_2)
+        if (find_limit(next, key, exchange, symbol) == nullptr)
+          callback(key, exchange, symbol, risk::Limit{});
+}
+
+// note! patterns are compiled once (and only evaluated when a position is created or limits have changed)
+void update_patterns(auto &patterns, auto const &limits, auto const &key) {
+  auto &tmp = patterns[key];
+  tmp.clear();
+  auto iter = limits.find(key);
+  if (iter != std::end(limits))
+    for (auto &[exchange, value] : (*iter).second)
+      for (auto &[symbol, limit] : value)
+        if (risk::Pattern::is_pattern(exchange, symbol))
+          tmp.emplace_back(exchange, symbol, limit);
+  if (std::empty(tmp)) {
+    patterns.erase(key);
+    return;
+  }
+  std::sort(std::begin(tmp), std::end(tmp));
+}
+
+template <typename R>
+auto create_patterns(auto const &limits) {
+  using result_type = std::remove_cvref<R>::type;
+  result_type result;
+  for (auto &[key, _] : limits)
+    update_patterns(result, limits, key);
+  return result;
+}
+
+// note! most specific wins: exact, then patterns (already sorted), then the default (no limit)
+risk::Limit resolve(
+    auto const &limits,
+    auto const &patterns,
+    auto const &key,
+    std::string_view const &exchange,
+    std::string_view const &symbol) {
+  auto limit = find_limit(limits, key, exchange, symbol);
+  if (limit != nullptr)
+    return *limit;
+  auto iter = patterns.find(key);
+  if (iter != std::end(patterns))
+    for (auto &pattern : (*iter).second)
+      if (pattern(exchange, symbol))
+        return pattern.limit;
+  return {};
+}
+
+// note! all positions of the entity are resolved again, only positions having a different limit are updated
+void apply_changes(auto &items, auto const &limits, auto &patterns, auto const &keys, auto const &instruments) {
+  std::vector<std::pair<uint32_t, risk::Limit>> changes;
+  for (auto &key : keys) {
+    update_patterns(patterns, limits, key);
+    auto iter_1 = items.find(key);
+    if (iter_1 == std::end(items))
+      continue;  // note! no positions
+    auto &item = (*iter_1).second;
+    changes.clear();
+    auto callback = [&](auto instrument_id, auto const &position) {
+      auto iter_2 = instruments.find(instrument_id);
+      if (iter_2 == std::end(instruments))
+        return;  // XXX should never happen
+      auto &instrument = (*iter_2).second;
+      auto limit = resolve(limits, patterns, key, instrument.exchange, instrument.symbol);
+      if (!is_equal(position.get_limit(), limit))
+        changes.emplace_back(instrument_id, limit);
+    };
+    item.get_all_positions(callback);
+    for (auto &[instrument_id, limit] : changes)
+      item(instrument_id, limit);
+  }
+}
+
+// note! the exposure sums the unrealized pnl of all positions of the entity (owner)
+template <typename R>
+auto create_drawdowns(auto const &loss_limits, auto &exposure) {
+  using result_type = std::remove_cvref<R>::type;
+  result_type result;
+  for (auto &[key, loss_limit] : loss_limits) {
+    auto &drawdown = (*result.try_emplace(key, loss_limit).first).second;
+    drawdown.owner = exposure.create_owner();
+  }
+  return result;
+}
+
+uint32_t get_owner(auto const &drawdowns, auto const &key) {
+  auto iter = drawdowns.find(key);
+  if (iter == std::end(drawdowns))
+    return {};
+  return (*iter).second.owner;
+}
+
+void publish_all(auto const &instruments, auto &publish) {
+  for (auto &[instrument_id, _] : instruments)
+    publish.emplace(instrument_id);
+}
+
+// note! O(1), all positions of the entity are published when the breach has changed
+bool update_drawdown(
+    auto &drawdowns,
+    auto const &key,
+    double realized_pnl,
+    auto const &exposure,
+    auto const &instruments,
+    auto &publish) {
+  auto iter = drawdowns.find(key);
+  if (iter == std::end(drawdowns))
+    return false;
+  auto &drawdown = (*iter).second;
+  drawdown.realized += realized_pnl;
+  if (!drawdown(drawdown.realized + exposure.get_unrealized(drawdown.owner)))
+    return false;
+  log::warn(
+      R"(*** LOSS LIMIT *** (key={}, pnl={}, drawdown={}, daily_loss={}))"sv,
+      key,
+      drawdown.pnl,
+      drawdown.drawdown(),
+      drawdown.daily_loss());
+  publish_all(instruments, publish[key]);
+  return true;
+}
+
+template <typename R>
+auto create_capacities(auto const &funds_limits) {
+  using result_type = std::remove_cvref<R>::type;
+  result_type result;
+  for (auto &[key, funds_limit] : funds_limits)
+    result.try_emplace(key, funds_limit);
+  return result;
+}
+
+auto create_aggregates(auto const &groups) {
+  std::vector<risk::Aggregate> result;
+  for (auto &[name, group] : groups)
+    result.emplace_back(name, group);
+  return result;
+}
+
+// note! contracts are converted to units of the underlying
+double get_multiplier(ReferenceData const &reference_data) {
+  auto multiplier = reference_data.multiplier;
+  if (std::isnan(multiplier) || multiplier <= 0.0)
+    return 1.0;
+  return multiplier;
+}
+
+// note! O(1) per group, members are only published when the breach has changed
+void update_aggregates(
+    auto &aggregates, auto const &member, auto select, auto const &key, double quantity, auto &publish) {
+  for (auto index : member.groups) {
+    auto &aggregate = aggregates[index];
+    auto &state = (aggregate.*select)[key];
+    if (!aggregate(state, quantity * member.multiplier))
+      continue;
+    log::warn(
+        R"(Breach has changed (group="{}", key={}, quantity={}, long={}, short={}))"sv,
+        aggregate.name,
+        key,
+        state.quantity,
+        state.breach.long_position,
+        state.breach.short_position);
+    auto &tmp = publish[key];
+    for (auto instrument_id : aggregate.members)
+      tmp.emplace(instrument_id);
+  }
+}
+
+// note! limits or notional exposure have changed
+void update_aggregates(auto &aggregate, auto select, auto const &exposure, auto &publish) {
+  for (auto &[key, state] : aggregate.*select) {
+    state.notional = exposure.get_bucket(state.bucket);
+    if (!aggregate(state))
+      continue;
+    log::warn(
+        R"(Breach has changed (group="{}", key={}, notional={}, long={}, short={}))"sv,
+        aggregate.name,
+        key,
+        state.notional,
+        state.breach.long_position,
+        state.breach.short_position);
+    auto &tmp = publish[key];
+    for (auto instrument_id : aggregate.members)
+      tmp.emplace(instrument_id);
+  }
+}
+
+// note! buckets are created when first used
+std::vector<uint32_t> get_buckets(auto &aggregates, auto const &member, auto select, auto const &key, auto &exposure) {
+  std::vector<uint32_t> result;
+  for (auto index : member.groups) {
+    auto &state = (aggregates[index].*select)[key];
+    if (!state.bucket)
+      state.bucket = exposure.create_bucket();
+    result.emplace_back(state.bucket);
+  }
+  return result;
+}
+
+uint32_t get_slot(
+    auto &slots,
+    auto &exposure,
+    auto &aggregates,
+    auto const &members,
+    auto select,
+    auto const &key,
+    uint32_t instrument_id,
+    uint32_t owner) {
+  auto &tmp = slots[key];
+  auto iter_1 = tmp.find(instrument_id);
+  if (iter_1 != std::end(tmp))
+    return (*iter_1).second;
+  auto slot = exposure.create_slot(instrument_id);
+  tmp.emplace(instrument_id, slot);
+  if (owner)
+    exposure.set_owner(slot, owner);
+  auto iter_2 = members.find(instrument_id);
+  if (iter_2 != std::end(members))
+    exposure.set_buckets(slot, get_buckets(aggregates, (*iter_2).second, select, key, exposure));
+  return slot;
+}
+
+// note! nan if either side is missing
+double get_price(TopOfBook const &top_of_book) {
+  auto &layer = top_of_book.layer;
+  if (std::isnan(layer.bid_price) || std::isnan(layer.ask_price))
+    return std::numeric_limits<double>::quiet_NaN();
+  return 0.5 * (layer.bid_price + layer.ask_price);
+}
+
 // === IMPLEMENTATION ===
 
-Shared::Shared(Settings const &, Config const &config)
+Shared::Shared(Config const &config)
     : accounts_{create_config<decltype(accounts_)>(config.accounts, *this)},
       users_{create_config<decltype(users_)>(config.users, *this)},
       strategies_{create_config<decltype(strategies_)>(config.strategies, *this)},
       limits_by_account_{create_limits<decltype(limits_by_account_)>(config.accounts)},
       limits_by_user_{create_limits<decltype(limits_by_user_)>(config.users)},
-      limits_by_strategy_{create_limits<decltype(limits_by_strategy_)>(config.strategies)} {
+      limits_by_strategy_{create_limits<decltype(limits_by_strategy_)>(config.strategies)},
+      patterns_by_account_{create_patterns<decltype(patterns_by_account_)>(limits_by_account_)},
+      patterns_by_user_{create_patterns<decltype(patterns_by_user_)>(limits_by_user_)},
+      patterns_by_strategy_{create_patterns<decltype(patterns_by_strategy_)>(limits_by_strategy_)},
+      aggregates_{create_aggregates(config.groups)},
+      drawdowns_by_account_{
+          create_drawdowns<decltype(drawdowns_by_account_)>(config.loss_limits_by_account, exposure_)},
+      drawdowns_by_user_{create_drawdowns<decltype(drawdowns_by_user_)>(config.loss_limits_by_user, exposure_)},
+      capacity_by_account_{create_capacities<decltype(capacity_by_account_)>(config.funds_limits_by_account)} {
+  for (auto &[name, rate_limit] : config.rate_limits_by_account)
+    get_account(name, [&](auto &account) { account(rate_limit); });
+  for (auto &[name, rate_limit] : config.rate_limits_by_user)
+    get_user(name, [&](auto &user) { user(rate_limit); });
+}
+
+// note!
+//   the new limits are created before anything is changed, i.e. the current state is never partially updated
+//   the accounts, users and strategies are fixed at start-up (only their limits can change)
+size_t Shared::operator()(Config const &config) {
+  auto limits_by_account = create_limits<decltype(limits_by_account_)>(config.accounts);
+  auto limits_by_user = create_limits<decltype(limits_by_user_)>(config.users);
+  auto limits_by_strategy = create_limits<decltype(limits_by_strategy_)>(config.strategies);
+  merge(limits_by_account, overrides_by_account_);
+  merge(limits_by_user, overrides_by_user_);
+  merge(limits_by_strategy, overrides_by_strategy_);
+  size_t result = {};
+  absl::flat_hash_set<std::string> accounts, users;
+  absl::flat_hash_set<uint32_t> strategies;
+  auto helper = [&](auto const &current, auto const &next, auto &keys) {
+    auto callback = [&](auto const &key, auto const &exchange, auto const &symbol, auto const &limit) {
+      log::info(R"(Limit has changed (key={}, exchange="{}", symbol="{}", limit={}))"sv, key, exchange, symbol, limit);
+      ++result;
+      keys.emplace(key);
+    };
+    get_changes(current, next, callback);
+  };
+  helper(limits_by_account_, limits_by_account, accounts);
+  helper(limits_by_user_, limits_by_user, users);
+  helper(limits_by_strategy_, limits_by_strategy, strategies);
+  limits_by_account_ = std::move(limits_by_account);
+  limits_by_user_ = std::move(limits_by_user);
+  limits_by_strategy_ = std::move(limits_by_strategy);
+  apply_changes(accounts_, limits_by_account_, patterns_by_account_, accounts, instruments_);
+  apply_changes(users_, limits_by_user_, patterns_by_user_, users, instruments_);
+  apply_changes(strategies_, limits_by_strategy_, patterns_by_strategy_, strategies, instruments_);
+  // note! groups can't be added or removed, only their limits can change
+  for (auto &aggregate : aggregates_) {
+    auto iter = config.groups.find(aggregate.name);
+    if (iter == std::end(config.groups))
+      continue;  // XXX should never happen
+    auto &group = (*iter).second;
+    if (is_equal(aggregate.long_position_limit, group.long_position_limit) &&
+        is_equal(aggregate.short_position_limit, group.short_position_limit) &&
+        is_equal(aggregate.long_notional_limit, group.long_notional_limit) &&
+        is_equal(aggregate.short_notional_limit, group.short_notional_limit))
+      continue;
+    log::info(R"(Group has changed (name="{}", group={}))"sv, aggregate.name, group);
+    ++result;
+    aggregate.long_position_limit = group.long_position_limit;
+    aggregate.short_position_limit = group.short_position_limit;
+    aggregate.long_notional_limit = group.long_notional_limit;
+    aggregate.short_notional_limit = group.short_notional_limit;
+    update_aggregates(aggregate, &risk::Aggregate::accounts, exposure_, publish_by_account_);
+    update_aggregates(aggregate, &risk::Aggregate::users, exposure_, publish_by_user_);
+    update_aggregates(aggregate, &risk::Aggregate::strategies, exposure_, publish_by_strategy_);
+  }
+  // note! loss limits can't be added or removed, only changed
+  auto helper_2 = [&](auto &drawdowns, auto const &loss_limits, auto &publish) {
+    for (auto &[key, drawdown] : drawdowns) {
+      auto iter = loss_limits.find(key);
+      if (iter == std::end(loss_limits))
+        continue;  // XXX should never happen
+      auto &loss_limit = (*iter).second;
+      if (is_equal(drawdown.max_drawdown, loss_limit.max_drawdown) &&
+          is_equal(drawdown.max_daily_loss, loss_limit.max_daily_loss) && drawdown.reset_time == loss_limit.reset_time)
+        continue;
+      log::info(R"(Loss limit has changed (key={}, loss_limit={}))"sv, key, loss_limit);
+      ++result;
+      drawdown(loss_limit);
+      if (drawdown(drawdown.pnl))
+        publish_all(instruments_, publish[key]);
+    }
+  };
+  helper_2(drawdowns_by_account_, config.loss_limits_by_account, publish_by_account_);
+  helper_2(drawdowns_by_user_, config.loss_limits_by_user, publish_by_user_);
+  // note! rate limits can be added or removed
+  auto helper_3 = [&](auto &items, auto const &rate_limits) {
+    for (auto &[key, item] : items) {
+      auto iter = rate_limits.find(key);
+      auto rate_limit = iter == std::end(rate_limits) ? risk::RateLimit{} : (*iter).second;
+      if (is_equal(item.get_rate_limit(), rate_limit))
+        continue;
+      log::info(R"(Rate limit has changed (key={}, rate_limit={}))"sv, key, rate_limit);
+      ++result;
+      item(rate_limit);
+    }
+  };
+  helper_3(accounts_, config.rate_limits_by_account);
+  helper_3(users_, config.rate_limits_by_user);
+  // note! funds limits can be added or removed
+  for (auto iter = std::begin(capacity_by_account_); iter != std::end(capacity_by_account_);) {
+    auto &[key, _] = *iter;
+    if (config.funds_limits_by_account.contains(key)) {
+      ++iter;
+      continue;
+    }
+    log::info(R"(Funds limit has been removed (key={}))"sv, key);
+    ++result;
+    publish_account(key);
+    capacity_by_account_.erase(iter++);
+  }
+  for (auto &[key, funds_limit] : config.funds_limits_by_account) {
+    auto iter = capacity_by_account_.find(key);
+    if (iter == std::end(capacity_by_account_)) {
+      iter = capacity_by_account_.try_emplace(key, funds_limit).first;
+    } else {
+      auto &previous = (*iter).second.get_funds_limit();
+      if (previous.currency == funds_limit.currency && is_equal(previous.leverage, funds_limit.leverage))
+        continue;
+      (*iter).second(funds_limit);
+    }
+    log::info(R"(Funds limit has changed (key={}, funds_limit={}))"sv, key, funds_limit);
+    ++result;
+    seed_capacity(key, (*iter).second);
+    publish_account(key);
+  }
+  return result;
+}
+
+// note! the pnl is not restored, the realized pnl is then added by the positions (and the breach is re-evaluated)
+bool Shared::operator()(database::Drawdown const &drawdown) {
+  auto helper = [&](auto &drawdowns, auto const &key) {
+    auto iter = drawdowns.find(key);
+    if (iter == std::end(drawdowns))
+      return false;
+    auto &item = (*iter).second;
+    item.peak = drawdown.peak;
+    item.start = drawdown.start;
+    item.next_reset = drawdown.next_reset;
+    item.breach = drawdown.breach;
+    return true;
+  };
+  if (!std::empty(drawdown.user))
+    return helper(drawdowns_by_user_, drawdown.user);
+  return helper(drawdowns_by_account_, drawdown.account);
+}
+
+size_t Shared::operator()(std::span<database::Limit const> const &limits) {
+  size_t result = {};
+  absl::flat_hash_set<std::string> accounts, users;
+  absl::flat_hash_set<uint32_t> strategies;
+  auto helper = [&](auto &current, auto &overrides, auto const &key, auto const &item, auto &keys) {
+    auto limit = create_limit(item);
+    overrides[key][item.exchange].insert_or_assign(item.symbol, limit);
+    auto previous = find_limit(current, key, item.exchange, item.symbol);
+    if (previous != nullptr && is_equal(*previous, limit))
+      return;
+    log::info(
+        R"(Limit has changed (key={}, exchange="{}", symbol="{}", limit={}))"sv,
+        key,
+        item.exchange,
+        item.symbol,
+        limit);
+    current[key][item.exchange].insert_or_assign(item.symbol, limit);
+    ++result;
+    keys.emplace(key);
+  };
+  for (auto &item : limits) {
+    if (!std::empty(item.user))
+      helper(limits_by_user_, overrides_by_user_, item.user, item, users);
+    else if (item.strategy_id)
+      helper(limits_by_strategy_, overrides_by_strategy_, item.strategy_id, item, strategies);
+    else if (!std::empty(item.account))
+      helper(limits_by_account_, overrides_by_account_, item.account, item, accounts);
+    else
+      log::warn("Unexpected: limit={}"sv, item);
+  }
+  apply_changes(accounts_, limits_by_account_, patterns_by_account_, accounts, instruments_);
+  apply_changes(users_, limits_by_user_, patterns_by_user_, users, instruments_);
+  apply_changes(strategies_, limits_by_strategy_, patterns_by_strategy_, strategies, instruments_);
+  return result;
+}
+
+// note! the contribution of existing positions is moved (once) when the members or the multiplier have changed
+void Shared::operator()(ReferenceData const &reference_data) {
+  auto instrument_id = get_instrument_id(reference_data.exchange, reference_data.symbol);
+  exposure_.set_multiplier(instrument_id, get_multiplier(reference_data));
+  if (std::empty(aggregates_))
+    return;
+  Member member{
+      .groups = {},
+      .multiplier = get_multiplier(reference_data),
+  };
+  for (size_t index = 0; index < std::size(aggregates_); ++index)
+    if (aggregates_[index](reference_data))
+      member.groups.emplace_back(static_cast<uint32_t>(index));
+  auto &current = members_[instrument_id];
+  if (member.groups == current.groups && member.multiplier == current.multiplier)
+    return;
+  log::info(
+      R"(Groups have changed (exchange="{}", symbol="{}", groups=[{}], multiplier={}))"sv,
+      reference_data.exchange,
+      reference_data.symbol,
+      fmt::join(member.groups, ", "sv),
+      member.multiplier);
+  auto helper = [&](auto &items, auto &slots, auto select, auto &publish) {
+    for (auto &[key, item] : items) {
+      auto callback = [&](auto &position) {
+        auto quantity = position.quantity();
+        if (quantity != 0.0) {
+          update_aggregates(aggregates_, current, select, key, -quantity, publish);
+          update_aggregates(aggregates_, member, select, key, quantity, publish);
+        }
+        publish[key].emplace(instrument_id);
+      };
+      item.get_position(instrument_id, callback);
+      auto iter_1 = slots.find(key);
+      if (iter_1 == std::end(slots))
+        continue;
+      auto &tmp = (*iter_1).second;
+      auto iter_2 = tmp.find(instrument_id);
+      if (iter_2 != std::end(tmp))
+        exposure_.set_buckets((*iter_2).second, get_buckets(aggregates_, member, select, key, exposure_));
+    }
+  };
+  helper(accounts_, slots_by_account_, &risk::Aggregate::accounts, publish_by_account_);
+  helper(users_, slots_by_user_, &risk::Aggregate::users, publish_by_user_);
+  helper(strategies_, slots_by_strategy_, &risk::Aggregate::strategies, publish_by_strategy_);
+  for (auto index : current.groups)
+    std::erase(aggregates_[index].members, instrument_id);
+  for (auto index : member.groups)
+    aggregates_[index].members.emplace_back(instrument_id);
+  current = std::move(member);
+}
+
+void Shared::operator()(FundsUpdate const &funds_update) {
+  auto iter = capacity_by_account_.find(funds_update.account);
+  if (iter == std::end(capacity_by_account_))
+    return;
+  auto &capacity = (*iter).second;
+  if (!capacity(funds_update.currency, funds_update.balance, funds_update.hold))
+    return;
+  log::info<1>(R"(Capacity has changed (account="{}", capacity={}))"sv, funds_update.account, capacity.get_capacity());
+  publish_account(funds_update.account);
+}
+
+bool Shared::operator()(TopOfBook const &top_of_book) {
+  auto price = get_price(top_of_book);
+  if (std::isnan(price))
+    return false;
+  auto instrument_id = find_instrument_id(top_of_book.exchange, top_of_book.symbol);
+  if (!instrument_id)
+    return false;  // note! no reference data
+  if (std::isnan(exposure_.get_price(instrument_id))) [[unlikely]] {
+    // note! first price => positions loaded from the database will use this as the average price
+    auto helper = [&](auto &items, auto const &slots) {
+      for (auto &[key, item] : items) {
+        auto callback = [&](auto &position) {
+          position.mark(price);
+          auto iter_1 = slots.find(key);
+          if (iter_1 == std::end(slots))
+            return;
+          auto &tmp = (*iter_1).second;
+          auto iter_2 = tmp.find(instrument_id);
+          if (iter_2 != std::end(tmp))
+            exposure_.set_average_price((*iter_2).second, position.average_price());
+        };
+        item.get_position(instrument_id, callback);
+      }
+    };
+    helper(accounts_, slots_by_account_);
+    helper(users_, slots_by_user_);
+    helper(strategies_, slots_by_strategy_);
+    marked_ = true;
+  }
+  return exposure_.set_price(instrument_id, price);
+}
+
+// note! the breach of a group can change without any fill
+size_t Shared::reprice() {
+  auto result = exposure_.reprice();
+  for (auto &aggregate : aggregates_) {
+    update_aggregates(aggregate, &risk::Aggregate::accounts, exposure_, publish_by_account_);
+    update_aggregates(aggregate, &risk::Aggregate::users, exposure_, publish_by_user_);
+    update_aggregates(aggregate, &risk::Aggregate::strategies, exposure_, publish_by_strategy_);
+  }
+  // note! only positions having a new price (not all positions of the account)
+  auto repriced = exposure_.get_repriced();
+  if (std::empty(repriced))
+    return result;
+  for (auto &[key, capacity] : capacity_by_account_) {
+    if (std::isnan(capacity.get_capacity()))
+      continue;
+    auto iter = accounts_.find(key);
+    if (iter == std::end(accounts_))
+      continue;
+    auto &account = (*iter).second;
+    auto &publish = publish_by_account_[key];
+    for (auto instrument_id : repriced)
+      account.get_position(instrument_id, [&]([[maybe_unused]] auto &position) { publish.emplace(instrument_id); });
+  }
+  return result;
+}
+
+void Shared::update_loss_limits(std::chrono::nanoseconds now) {
+  auto helper = [&](auto &drawdowns, auto &publish) {
+    for (auto &[key, drawdown] : drawdowns) {
+      auto next_reset = drawdown.next_reset;
+      if (drawdown(now)) {
+        log::info(R"(Loss limit has been reset (key={}, pnl={}))"sv, key, drawdown.pnl);
+        publish_all(instruments_, publish[key]);
+      }
+      if (drawdown.next_reset != next_reset)
+        drawdowns_changed_ = true;
+      if (update_drawdown(drawdowns, key, 0.0, exposure_, instruments_, publish))
+        drawdowns_changed_ = true;
+    }
+  };
+  helper(drawdowns_by_account_, publish_by_account_);
+  helper(drawdowns_by_user_, publish_by_user_);
+}
+
+void Shared::update_rate_limits(std::chrono::nanoseconds now) {
+  for (auto &[_, account] : accounts_)
+    account(now);
+  for (auto &[_, user] : users_)
+    user(now);
+}
+
+double Shared::get_max_position(std::string_view const &account, risk::Instrument const &instrument) const {
+  auto iter = capacity_by_account_.find(account);
+  if (iter == std::end(capacity_by_account_))
+    return std::numeric_limits<double>::quiet_NaN();
+  auto &capacity = (*iter).second;
+  return capacity.get_position_limit(exposure_.get_price(instrument.id), instrument.multiplier());
+}
+
+void Shared::seed_capacity(std::string_view const &account, risk::Capacity &capacity) {
+  for (auto &[_, accounts] : accounts_by_source) {
+    auto iter_1 = accounts.find(account);
+    if (iter_1 == std::end(accounts))
+      continue;
+    auto &funds = (*iter_1).second.funds;
+    auto iter_2 = funds.find(capacity.get_funds_limit().currency);
+    if (iter_2 != std::end(funds))
+      capacity((*iter_2).first, (*iter_2).second.balance, (*iter_2).second.hold);
+  }
+}
+
+database::Position Shared::create_position(
+    std::string_view const &user,
+    uint32_t strategy_id,
+    std::string_view const &account,
+    risk::Instrument const &instrument,
+    risk::Position const &position) {
+  return {
+      .user = user,
+      .strategy_id = strategy_id,
+      .account = account,
+      .exchange = instrument.exchange,
+      .symbol = instrument.symbol,
+      .long_quantity = position.long_position(),
+      .short_quantity = position.short_position(),
+      .exchange_time_utc = position.exchange_time_utc(),
+      .average_price = position.average_price(),
+      .realized_pnl = position.realized_pnl(),
+      .fees = position.fees(),
+  };
+}
+
+database::Drawdown Shared::create_drawdown(
+    std::string_view const &user, std::string_view const &account, risk::Drawdown const &drawdown) {
+  return {
+      .user = user,
+      .account = account,
+      .peak = drawdown.peak,
+      .start = drawdown.start,
+      .next_reset = drawdown.next_reset,
+      .breach = drawdown.breach,
+  };
 }
 
 uint32_t Shared::get_instrument_id(std::string_view const &exchange, std::string_view const &symbol) {
@@ -54,6 +733,17 @@ uint32_t Shared::get_instrument_id(std::string_view const &exchange, std::string
   return result;
 }
 
+uint32_t Shared::find_instrument_id(std::string_view const &exchange, std::string_view const &symbol) const {
+  auto iter_1 = instrument_lookup_.find(exchange);
+  if (iter_1 == std::end(instrument_lookup_))
+    return {};
+  auto &tmp = (*iter_1).second;
+  auto iter_2 = tmp.find(symbol);
+  if (iter_2 == std::end(tmp))
+    return {};
+  return (*iter_2).second;
+}
+
 risk::Instrument &Shared::get_instrument(std::string_view const &exchange, std::string_view const &symbol) {
   auto instrument_id = get_instrument_id(exchange, symbol);
   auto iter = instruments_.find(instrument_id);
@@ -64,21 +754,28 @@ risk::Instrument &Shared::get_instrument(std::string_view const &exchange, std::
 
 // accounts
 
-// note! lookup is rare -- no need to optimize
+// note! only used when a position is created (the limit is then kept by the position)
 risk::Limit Shared::get_limit_by_account(
     std::string_view const &account, std::string_view const &exchange, std::string_view const &symbol) const {
-  auto iter_1 = limits_by_account_.find(account);
-  if (iter_1 == std::end(limits_by_account_))
-    return {};
-  auto &tmp_1 = (*iter_1).second;
-  auto iter_2 = tmp_1.find(exchange);
-  if (iter_2 == std::end(tmp_1))
-    return {};
-  auto &tmp_2 = (*iter_2).second;
-  auto iter_3 = tmp_2.find(symbol);
-  if (iter_3 == std::end(tmp_2))
-    return {};
-  return (*iter_3).second;
+  return resolve(limits_by_account_, patterns_by_account_, account, exchange, symbol);
+}
+
+void Shared::aggregate_account(std::string_view const &account, uint32_t instrument_id, risk::Change const &change) {
+  auto owner = get_owner(drawdowns_by_account_, account);
+  auto slot = get_slot(
+      slots_by_account_, exposure_, aggregates_, members_, &risk::Aggregate::accounts, account, instrument_id, owner);
+  exposure_(slot, change.quantity);
+  exposure_.set_average_price(slot, change.average_price);
+  auto &publish = publish_by_account_;
+  if (update_drawdown(drawdowns_by_account_, account, change.realized_pnl, exposure_, instruments_, publish))
+    urgent_ = true;
+  if (change.quantity == 0.0)
+    return;
+  auto iter = members_.find(instrument_id);
+  if (iter == std::end(members_))
+    return;  // note! not a member of any group (or reference data not yet received)
+  auto &member = (*iter).second;
+  update_aggregates(aggregates_, member, &risk::Aggregate::accounts, account, change.quantity, publish);
 }
 
 void Shared::publish_account(std::string_view const &account) {
@@ -89,21 +786,27 @@ void Shared::publish_account(std::string_view const &account) {
 
 // users
 
-// note! lookup is rare -- no need to optimize
+// note! only used when a position is created (the limit is then kept by the position)
 risk::Limit Shared::get_limit_by_user(
     std::string_view const &user, std::string_view const &exchange, std::string_view const &symbol) const {
-  auto iter_1 = limits_by_user_.find(user);
-  if (iter_1 == std::end(limits_by_user_))
-    return {};
-  auto &tmp_1 = (*iter_1).second;
-  auto iter_2 = tmp_1.find(exchange);
-  if (iter_2 == std::end(tmp_1))
-    return {};
-  auto &tmp_2 = (*iter_2).second;
-  auto iter_3 = tmp_2.find(symbol);
-  if (iter_3 == std::end(tmp_2))
-    return {};
-  return (*iter_3).second;
+  return resolve(limits_by_user_, patterns_by_user_, user, exchange, symbol);
+}
+
+void Shared::aggregate_user(std::string_view const &user, uint32_t instrument_id, risk::Change const &change) {
+  auto owner = get_owner(drawdowns_by_user_, user);
+  auto slot = get_slot(
+      slots_by_user_, exposure_, aggregates_, members_, &risk::Aggregate::users, user, instrument_id, owner);
+  exposure_(slot, change.quantity);
+  exposure_.set_average_price(slot, change.average_price);
+  if (update_drawdown(drawdowns_by_user_, user, change.realized_pnl, exposure_, instruments_, publish_by_user_))
+    urgent_ = true;
+  if (change.quantity == 0.0)
+    return;
+  auto iter = members_.find(instrument_id);
+  if (iter == std::end(members_))
+    return;  // note! not a member of any group (or reference data not yet received)
+  auto &member = (*iter).second;
+  update_aggregates(aggregates_, member, &risk::Aggregate::users, user, change.quantity, publish_by_user_);
 }
 
 void Shared::publish_user(std::string_view const &user) {
@@ -114,21 +817,32 @@ void Shared::publish_user(std::string_view const &user) {
 
 // strategies
 
-// note! lookup is rare -- no need to optimize
+// note! only used when a position is created (the limit is then kept by the position)
 risk::Limit Shared::get_limit_by_strategy(
     uint32_t strategy_id, std::string_view const &exchange, std::string_view const &symbol) const {
-  auto iter_1 = limits_by_strategy_.find(strategy_id);
-  if (iter_1 == std::end(limits_by_strategy_))
-    return {};
-  auto &tmp_1 = (*iter_1).second;
-  auto iter_2 = tmp_1.find(exchange);
-  if (iter_2 == std::end(tmp_1))
-    return {};
-  auto &tmp_2 = (*iter_2).second;
-  auto iter_3 = tmp_2.find(symbol);
-  if (iter_3 == std::end(tmp_2))
-    return {};
-  return (*iter_3).second;
+  return resolve(limits_by_strategy_, patterns_by_strategy_, strategy_id, exchange, symbol);
+}
+
+void Shared::aggregate_strategy(uint32_t strategy_id, uint32_t instrument_id, risk::Change const &change) {
+  auto slot = get_slot(
+      slots_by_strategy_,
+      exposure_,
+      aggregates_,
+      members_,
+      &risk::Aggregate::strategies,
+      strategy_id,
+      instrument_id,
+      0);
+  exposure_(slot, change.quantity);
+  exposure_.set_average_price(slot, change.average_price);
+  if (change.quantity == 0.0)
+    return;
+  auto iter = members_.find(instrument_id);
+  if (iter == std::end(members_))
+    return;  // note! not a member of any group (or reference data not yet received)
+  auto &member = (*iter).second;
+  update_aggregates(
+      aggregates_, member, &risk::Aggregate::strategies, strategy_id, change.quantity, publish_by_strategy_);
 }
 
 void Shared::publish_strategy(uint32_t strategy_id) {
@@ -4,17 +4,31 @@
 
 #include <absl/container/flat_hash_map.h>
 
+#include <chrono>
+#include <span>
+#include <utility>
+#include <vector>
+
 #include "roq/client.hpp"
 
 #include "roq/cache/funds.hpp"
 #include "roq/cache/position.hpp"
 
 #include "roq/risk_manager/config.hpp"
-#include "roq/risk_manager/settings.hpp"
+
+#include "roq/risk_manager/database/drawdown.hpp"
+#include "roq/risk_manager/database/limit.hpp"
+#include "roq/risk_manager/database/position.hpp"
 
 #include "roq/risk_manager/risk/account.hpp"
+#include "roq/risk_manager/risk/aggregate.hpp"
+#include "roq/risk_manager/risk/breach.hpp"
+#include "roq/risk_manager/risk/capacity.hpp"
+#include "roq/risk_manager/risk/drawdown.hpp"
+#include "roq/risk_manager/risk/exposure.hpp"
 #include "roq/risk_manager/risk/instrument.hpp"
 #include "roq/risk_manager/risk/limit.hpp"
+#include "roq/risk_manager/risk/pattern.hpp"
 #include "roq/risk_manager/risk/strategy.hpp"
 #include "roq/risk_manager/risk/user.hpp"
 
@@ -22,13 +36,54 @@ namespace roq {
 namespace risk_manager {
 
 struct Shared final : public risk::Account::Handler, public risk::User::Handler, public risk::Strategy::Handler {
-  Shared(Settings const &, Config const &);
+  explicit Shared(Config const &);
 
   Shared(Shared const &) = delete;
   Shared(Shared &&) = default;
 
   risk::Instrument &get_instrument(std::string_view const &exchange, std::string_view const &symbol) override;
 
+  // note!
+  //   limits only (returns the number of limits having changed)
+  //   positions are then resolved again (if the entity has changed), only positions having a different limit are
+  //   re-published
+  size_t operator()(Config const &);
+
+  // note! limits from the database take precedence over the config (also after a reload)
+  size_t operator()(std::span<database::Limit const> const &);
+
+  // note! loss limit state (must be restored before positions are loaded), returns false if there is no loss limit
+  bool operator()(database::Drawdown const &);
+
+  // note! group membership (and multiplier) can only change when reference data is received
+  void operator()(ReferenceData const &);
+
+  // note! funds limits (positions of the account are re-published if the capacity has changed)
+  void operator()(FundsUpdate const &);
+
+  // note! conflated (returns true if the previous price has not yet been repriced)
+  bool operator()(TopOfBook const &);
+
+  // note!
+  //   notional exposure (positions and groups), returns the number of instruments having a new price
+  //   positions of accounts having a funds limit are re-published if the instrument has a new price
+  size_t reprice();
+
+  // note! loss limits are marked to the last reprice and reset when the reset time has passed
+  void update_loss_limits(std::chrono::nanoseconds now);
+
+  // note! rate limits are expired (sliding windows)
+  void update_rate_limits(std::chrono::nanoseconds now);
+
+  // note! a loss limit or a rate limit has been breached by a fill, i.e. risk limits should be published immediately
+  bool take_urgent() { return std::exchange(urgent_, false); }
+
+  // note! positions loaded from the database have been marked by a first price, i.e. their average price has changed
+  bool take_marked() { return std::exchange(marked_, false); }
+
+  // note! a loss limit has been reset or breached by the timer, i.e. the loss limit state should be persisted
+  bool take_drawdowns_changed() { return std::exchange(drawdowns_changed_, false); }
+
   // accounts
 
   template <typename Callback>
@@ -49,6 +104,7 @@ struct Shared final : public risk::Account::Handler, public risk::User::Handler,
 
   void publish_account(std::string_view const &account);
 
+  // note! the callback receives the risk limit (reduce-only if a group has been breached)
   template <typename Callback>
   bool get_publish_by_account(std::string_view const &account, Callback callback) {
     auto iter_1 = publish_by_account_.find(account);
@@ -62,9 +118,14 @@ struct Shared final : public risk::Account::Handler, public risk::User::Handler,
       auto iter_3 = accounts_.find(account);
       if (iter_3 == std::end(accounts_))
         continue;  // XXX should never happen
-      auto callback_2 = [&](auto &position) { callback(position, instrument); };
-      auto &account = (*iter_3).second;
-      account.get_position(instrument_id, callback_2);
+      auto &account_2 = (*iter_3).second;
+      auto breach = get_breach(&risk::Aggregate::accounts, account, instrument_id);
+      breach = get_breach(drawdowns_by_account_, account, breach);
+      if (account_2.get_breach())
+        breach = {true, true};  // note! rate limit
+      auto max_position = get_max_position(account, instrument);
+      auto callback_2 = [&](auto &position) { callback(position.get_risk_limit(instrument, breach, max_position)); };
+      account_2.get_position(instrument_id, callback_2);
     }
     (*iter_1).second.clear();
     return true;
@@ -103,9 +164,13 @@ struct Shared final : public risk::Account::Handler, public risk::User::Handler,
       auto iter_3 = users_.find(user);
       if (iter_3 == std::end(users_))
         continue;  // XXX should never happen
-      auto callback_2 = [&](auto &position) { callback(position, instrument); };
-      auto &user = (*iter_3).second;
-      user.get_position(instrument_id, callback_2);
+      auto &user_2 = (*iter_3).second;
+      auto breach = get_breach(&risk::Aggregate::users, user, instrument_id);
+      breach = get_breach(drawdowns_by_user_, user, breach);
+      if (user_2.get_breach())
+        breach = {true, true};  // note! rate limit
+      auto callback_2 = [&](auto &position) { callback(position.get_risk_limit(instrument, breach)); };
+      user_2.get_position(instrument_id, callback_2);
     }
     (*iter_1).second.clear();
     return true;
@@ -144,7 +209,8 @@ struct Shared final : public risk::Account::Handler, public risk::User::Handler,
       auto iter_3 = strategies_.find(strategy_id);
       if (iter_3 == std::end(strategies_))
         continue;  // XXX should never happen
-      auto callback_2 = [&](auto &position) { callback(position, instrument); };
+      auto breach = get_breach(&risk::Aggregate::strategies, strategy_id, instrument_id);
+      auto callback_2 = [&](auto &position) { callback(position.get_risk_limit(instrument, breach)); };
       auto &strategy = (*iter_3).second;
       strategy.get_position(instrument_id, callback_2);
     }
@@ -152,9 +218,134 @@ struct Shared final : public risk::Account::Handler, public risk::User::Handler,
     return true;
   }
 
+  // positions
+
+  // note! converted to the database representation, e.g. for snapshots (pnl is marked to the latest price)
+  template <typename Callback>
+  void get_all_positions(Callback callback) const {
+    auto dispatch = [&](auto const &user, auto strategy_id, auto const &account, auto const &item) {
+      auto callback_2 = [&](auto instrument_id, auto const &position) {
+        auto iter = instruments_.find(instrument_id);
+        if (iter == std::end(instruments_))
+          return;  // XXX should never happen
+        auto &instrument = (*iter).second;
+        auto position_2 = create_position(user, strategy_id, account, instrument, position);
+        auto pnl = position.get_pnl(instrument, exposure_.get_price(instrument_id));
+        callback(instrument_id, position_2, pnl);
+      };
+      item.get_all_positions(callback_2);
+    };
+    for (auto &[name, user] : users_)
+      dispatch(name, uint32_t{}, std::string_view{}, user);
+    for (auto &[strategy_id, strategy] : strategies_)
+      dispatch(std::string_view{}, strategy_id, std::string_view{}, strategy);
+    for (auto &[name, account] : accounts_)
+      dispatch(std::string_view{}, uint32_t{}, name, account);
+  }
+
+  // note! the account and user positions of the instrument, e.g. to persist the pnl after a fill
+  template <typename Callback>
+  void get_positions(TradeUpdate const &trade_update, Callback callback) {
+    auto iter = instruments_.find(find_instrument_id(trade_update.exchange, trade_update.symbol));
+    if (iter == std::end(instruments_))
+      return;
+    auto instrument_id = (*iter).first;
+    auto &instrument = (*iter).second;
+    auto dispatch = [&](auto const &user, auto const &account, auto &item) {
+      auto callback_2 = [&](auto const &position) {
+        callback(create_position(user, uint32_t{}, account, instrument, position));
+      };
+      item.get_position(instrument_id, callback_2);
+    };
+    get_account(trade_update.account, [&](auto &item) { dispatch(std::string_view{}, item.name, item); });
+    get_user(trade_update.user, [&](auto &item) { dispatch(item.name, std::string_view{}, item); });
+  }
+
+  // loss limits
+
+  // note! the account and user of the trade update, e.g. to persist the loss limit state after a fill
+  template <typename Callback>
+  void get_drawdowns(TradeUpdate const &trade_update, Callback callback) const {
+    auto iter_1 = drawdowns_by_account_.find(trade_update.account);
+    if (iter_1 != std::end(drawdowns_by_account_))
+      callback(create_drawdown({}, (*iter_1).first, (*iter_1).second));
+    auto iter_2 = drawdowns_by_user_.find(trade_update.user);
+    if (iter_2 != std::end(drawdowns_by_user_))
+      callback(create_drawdown((*iter_2).first, {}, (*iter_2).second));
+  }
+
+  template <typename Callback>
+  void get_all_drawdowns(Callback callback) const {
+    for (auto &[name, drawdown] : drawdowns_by_account_)
+      callback(create_drawdown({}, name, drawdown));
+    for (auto &[name, drawdown] : drawdowns_by_user_)
+      callback(create_drawdown(name, {}, drawdown));
+  }
+
+  // prices
+
+  // note! nan if the instrument has no price
+  template <typename Callback>
+  void get_all_prices(Callback callback) const {
+    for (auto &[instrument_id, instrument] : instruments_)
+      callback(instrument_id, exposure_.get_price(instrument_id), instrument.multiplier());
+  }
+
  protected:
+  static database::Position create_position(
+      std::string_view const &user,
+      uint32_t strategy_id,
+      std::string_view const &account,
+      risk::Instrument const &,
+      risk::Position const &);
+
+  static database::Drawdown create_drawdown(
+      std::string_view const &user, std::string_view const &account, risk::Drawdown const &);
+
   uint32_t get_instrument_id(std::string_view const &exchange, std::string_view const &symbol);
 
+  // note! funds limit (nan means "no limit")
+  double get_max_position(std::string_view const &account, risk::Instrument const &) const;
+
+  // note! funds received before the funds limit was added (or the currency changed)
+  void seed_capacity(std::string_view const &account, risk::Capacity &);
+
+  // note! returns zero if the instrument doesn't exist
+  uint32_t find_instrument_id(std::string_view const &exchange, std::string_view const &symbol) const;
+
+  // note! reduce-only if any group of the instrument has been breached (by this account, user or strategy)
+  template <typename Key>
+  risk::Breach get_breach(auto select, Key const &key, uint32_t instrument_id) const {
+    risk::Breach result;
+    if (std::empty(aggregates_))
+      return result;
+    auto iter_1 = members_.find(instrument_id);
+    if (iter_1 == std::end(members_))
+      return result;
+    for (auto index : (*iter_1).second.groups) {
+      auto &states = aggregates_[index].*select;
+      auto iter_2 = states.find(key);
+      if (iter_2 == std::end(states))
+        continue;
+      auto &breach = (*iter_2).second.breach;
+      result.long_position = result.long_position || breach.long_position;
+      result.short_position = result.short_position || breach.short_position;
+    }
+    return result;
+  }
+
+  // note! reduce-only (both sides) if a loss limit has been breached
+  template <typename Key>
+  static risk::Breach get_breach(auto const &drawdowns, Key const &key, risk::Breach const &breach) {
+    auto iter = drawdowns.find(key);
+    if (iter == std::end(drawdowns) || !(*iter).second.breach)
+      return breach;
+    return {
+        .long_position = true,
+        .short_position = true,
+    };
+  }
+
   // accounts
 
   risk::Limit get_limit_by_account(
@@ -164,6 +355,10 @@ struct Shared final : public risk::Account::Handler, public risk::User::Handler,
     publish_by_account_[account].emplace(instrument_id);
   }
 
+  void aggregate_account(std::string_view const &account, uint32_t instrument_id, risk::Change const &) override;
+
+  void throttle_account(std::string_view const &) override { urgent_ = true; }
+
   // users
 
   risk::Limit get_limit_by_user(
@@ -173,6 +368,10 @@ struct Shared final : public risk::Account::Handler, public risk::User::Handler,
     publish_by_user_[user].emplace(instrument_id);
   }
 
+  void aggregate_user(std::string_view const &user, uint32_t instrument_id, risk::Change const &) override;
+
+  void throttle_user(std::string_view const &) override { urgent_ = true; }
+
   // strategies
 
   risk::Limit get_limit_by_strategy(
@@ -182,6 +381,8 @@ struct Shared final : public risk::Account::Handler, public risk::User::Handler,
     publish_by_strategy_[strategy_id].emplace(instrument_id);
   }
 
+  void aggregate_strategy(uint32_t strategy_id, uint32_t instrument_id, risk::Change const &) override;
+
  private:
   uint32_t next_instrument_id_ = {};
   absl::flat_hash_map<std::string, absl::flat_hash_map<std::string, int32_t>> instrument_lookup_;
@@ -191,12 +392,44 @@ struct Shared final : public risk::Account::Handler, public risk::User::Handler,
   absl::flat_hash_map<uint32_t, risk::Strategy> strategies_;  // note! can't make const
   absl::flat_hash_map<
       std::string,
-      absl::flat_hash_map<std::string, absl::flat_hash_map<std::string, risk::Limit>>> const limits_by_account_;
+      absl::flat_hash_map<std::string, absl::flat_hash_map<std::string, risk::Limit>>> limits_by_account_;
   absl::flat_hash_map<
       std::string,
-      absl::flat_hash_map<std::string, absl::flat_hash_map<std::string, risk::Limit>>> const limits_by_user_;
-  absl::flat_hash_map<uint32_t, absl::flat_hash_map<std::string, absl::flat_hash_map<std::string, risk::Limit>>> const
+      absl::flat_hash_map<std::string, absl::flat_hash_map<std::string, risk::Limit>>> limits_by_user_;
+  absl::flat_hash_map<uint32_t, absl::flat_hash_map<std::string, absl::flat_hash_map<std::string, risk::Limit>>>
       limits_by_strategy_;
+  // database
+  absl::flat_hash_map<
+      std::string,
+      absl::flat_hash_map<std::string, absl::flat_hash_map<std::string, risk::Limit>>> overrides_by_account_;
+  absl::flat_hash_map<
+      std::string,
+      absl::flat_hash_map<std::string, absl::flat_hash_map<std::string, risk::Limit>>> overrides_by_user_;
+  absl::flat_hash_map<uint32_t, absl::flat_hash_map<std::string, absl::flat_hash_map<std::string, risk::Limit>>>
+      overrides_by_strategy_;
+  // note! exchange and/or symbol patterns, most specific first (only used when a position is created)
+  absl::flat_hash_map<std::string, std::vector<risk::Pattern>> patterns_by_account_;
+  absl::flat_hash_map<std::string, std::vector<risk::Pattern>> patterns_by_user_;
+  absl::flat_hash_map<uint32_t, std::vector<risk::Pattern>> patterns_by_strategy_;
+  // note! groups, indexed by position (fixed at start-up)
+  std::vector<risk::Aggregate> aggregates_;
+  struct Member final {
+    std::vector<uint32_t> groups;  // note! index into aggregates_
+    double multiplier = 1.0;
+  };
+  absl::flat_hash_map<uint32_t, Member> members_;
+  // note! notional exposure, one slot per position (created when the position first changes)
+  risk::Exposure exposure_;
+  absl::flat_hash_map<std::string, absl::flat_hash_map<uint32_t, uint32_t>> slots_by_account_;
+  absl::flat_hash_map<std::string, absl::flat_hash_map<uint32_t, uint32_t>> slots_by_user_;
+  absl::flat_hash_map<uint32_t, absl::flat_hash_map<uint32_t, uint32_t>> slots_by_strategy_;
+  // note! loss limits (fixed at start-up), the unrealized pnl is summed by the exposure (owner)
+  absl::flat_hash_map<std::string, risk::Drawdown> drawdowns_by_account_;
+  absl::flat_hash_map<std::string, risk::Drawdown> drawdowns_by_user_;
+  absl::flat_hash_map<std::string, risk::Capacity> capacity_by_account_;
+  bool urgent_ = {};
+  bool marked_ = {};
+  bool drawdowns_changed_ = {};
   absl::flat_hash_map<std::string, absl::flat_hash_set<uint32_t>> publish_by_account_;
   absl::flat_hash_map<std::string, absl::flat_hash_set<uint32_t>> publish_by_user_;
   absl::flat_hash_map<uint32_t, absl::flat_hash_set<uint32_t>> publish_by_strategy_;
@@ -0,0 +1,40 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include "roq/risk_manager/simulator/application.hpp"
+
+#include "roq/logging.hpp"
+
+#include "roq/io/engine/context_factory.hpp"
+
+#include "roq/risk_manager/config.hpp"
+#include "roq/risk_manager/settings.hpp"
+
+#include "roq/risk_manager/simulator/flags/flags.hpp"
+
+#include "roq/risk_manager/simulator/simulator.hpp"
+
+using namespace std::literals;
+
+namespace roq {
+namespace risk_manager {
+namespace simulator {
+
+// === IMPLEMENTATION ===
+
+// note! the controller is exactly the same as the service, i.e. use a scratch database
+int Application::main(args::Parser const &args) {
+  auto params = args.params();
+  if (!std::empty(params))
+    log::fatal("Unexpected: parameters not supported"sv);
+  auto flags = flags::Flags::create();
+  Settings settings{args};
+  auto config = Config::parse_file(settings.config_file);
+  auto context = roq::io::engine::ContextFactory::create_libevent();
+  Simulator simulator{flags, settings, config, *context};
+  simulator.run();
+  return EXIT_SUCCESS;
+}
+
+}  // namespace simulator
+}  // namespace risk_manager
+}  // namespace roq
@@ -0,0 +1,263 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include "roq/risk_manager/simulator/simulator.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <set>
+#include <thread>
+
+#include "roq/logging.hpp"
+
+#include "roq/risk_manager/risk/pattern.hpp"
+
+using namespace std::literals;
+
+namespace roq {
+namespace risk_manager {
+namespace simulator {
+
+// === HELPERS ===
+
+namespace {
+auto get_now() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch());
+}
+
+auto get_realtime() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch());
+}
+
+auto get_names(auto &limits) {
+  std::set<std::string> result;
+  for (auto &[name, _] : limits)
+    result.emplace(name);
+  return std::vector<std::string>{std::begin(result), std::end(result)};
+}
+
+auto get_instruments(auto &config) {
+  std::set<std::pair<std::string, std::string>> result;
+  auto helper = [&](auto &limits) {
+    for (auto &[_, value_1] : limits)
+      for (auto &[exchange, value_2] : value_1)
+        for (auto &[symbol, _] : value_2)
+          if (!risk::Pattern::is_pattern(exchange, symbol))  // note! only exact instruments
+            result.emplace(exchange, symbol);
+  };
+  helper(config.accounts);
+  helper(config.users);
+  return std::vector<std::pair<std::string, std::string>>{std::begin(result), std::end(result)};
+}
+
+auto get_source_count(auto &flags) {
+  auto result = std::max<uint32_t>(flags.simulator_source_count, 1);
+  if (result > std::numeric_limits<uint8_t>::max())
+    log::fatal("Unexpected: source_count={}"sv, result);
+  return result;
+}
+
+auto get_percentile(auto &values, double percentile) -> std::chrono::nanoseconds {
+  if (std::empty(values))
+    return {};
+  auto index = static_cast<size_t>(percentile * static_cast<double>(std::size(values) - 1));
+  return values[index];
+}
+}  // namespace
+
+// === IMPLEMENTATION ===
+
+Simulator::Simulator(flags::Flags const &flags, Settings const &settings, Config const &config, io::Context &context)
+    : flags_{flags}, accounts_{get_names(config.accounts)}, users_{get_names(config.users)},
+      instruments_{get_instruments(config)}, dispatcher_{*this, get_source_count(flags)},
+      controller_{dispatcher_, settings, config, context, get_source_count(flags)},
+      seqno_(get_source_count(flags)) {
+  if (std::empty(accounts_) || std::empty(instruments_))
+    log::fatal("Unexpected: config must have account limits"sv);
+  for (size_t i = 0; i < std::size(accounts_); ++i)
+    account_index_.try_emplace(accounts_[i], i);
+  for (size_t i = 0; i < std::size(instruments_); ++i) {
+    auto &[exchange, symbol] = instruments_[i];
+    instrument_index_[exchange].try_emplace(symbol, i);
+  }
+  pending_.resize(std::size(accounts_) * std::size(instruments_));
+  fills_buffer_.resize(std::max<uint32_t>(flags_.simulator_fills_per_trade, 1));
+  external_trade_ids_.resize(std::size(fills_buffer_));
+  log::info(
+      "Simulating source_count={}, account_count={}, user_count={}, instrument_count={}"sv,
+      std::size(seqno_),
+      std::size(accounts_),
+      std::size(users_),
+      std::size(instruments_));
+}
+
+// note!
+//   the timer is only checked between trades, i.e. it will be late when the controller can't keep up
+//   the fill rate is "sustained" if the lag never exceeded the timer interval
+void Simulator::run() {
+  auto start_time = get_now();
+  start(start_time);
+  auto end_time = start_time + flags_.simulator_duration;
+  auto next_timer = start_time + flags_.simulator_timer_interval;
+  auto fill_rate = flags_.simulator_fill_rate;
+  std::chrono::nanoseconds max_lag = {};
+  for (;;) {
+    auto now = get_now();
+    if (now >= end_time)
+      break;
+    if (now >= next_timer) {
+      timer(now);
+      next_timer = now + flags_.simulator_timer_interval;
+      continue;
+    }
+    if (fill_rate) {
+      auto scheduled = start_time + std::chrono::nanoseconds{(fill_count_ * 1000000000) / fill_rate};
+      if (scheduled > now) {
+        std::this_thread::sleep_for(std::min(scheduled, next_timer) - now);
+        continue;
+      }
+      max_lag = std::max(max_lag, now - scheduled);
+    }
+    trade(now);
+  }
+  auto duration = get_now() - start_time;
+  timer(get_now());  // note! publish everything
+  report(duration, max_lag);
+}
+
+// events::Dispatcher::Handler
+
+void Simulator::operator()(RiskLimits const &risk_limits, uint8_t) {
+  if (std::empty(risk_limits.account))
+    return;
+  auto iter_1 = account_index_.find(std::string_view{risk_limits.account});
+  if (iter_1 == std::end(account_index_))
+    return;
+  auto offset = (*iter_1).second * std::size(instruments_);
+  auto now = get_now();
+  for (auto &risk_limit : risk_limits.limits) {
+    auto iter_2 = instrument_index_.find(std::string_view{risk_limit.exchange});
+    if (iter_2 == std::end(instrument_index_))
+      continue;
+    auto iter_3 = (*iter_2).second.find(std::string_view{risk_limit.symbol});
+    if (iter_3 == std::end((*iter_2).second))
+      continue;
+    auto &pending = pending_[offset + (*iter_3).second];
+    for (auto fill_time : pending)
+      latencies_.emplace_back(now - fill_time);
+    pending.clear();
+  }
+}
+
+// utilities
+
+template <typename T>
+void Simulator::dispatch(uint8_t source, T const &value, std::chrono::nanoseconds now) {
+  auto message_info = MessageInfo{};
+  message_info.source = source;
+  message_info.source_seqno = ++seqno_[source];
+  message_info.receive_time_utc = get_realtime();
+  message_info.receive_time = now;
+  message_info.is_last = true;
+  Event<T> event{message_info, value};
+  static_cast<client::Handler &>(controller_)(event);
+}
+
+// note! same sequence as a gateway (download, then ready)
+void Simulator::start(std::chrono::nanoseconds now) {
+  for (size_t i = 0; i < std::size(seqno_); ++i) {
+    auto source = static_cast<uint8_t>(i);
+    dispatch(source, Connected{}, now);
+    for (auto &[exchange, symbol] : instruments_) {
+      ReferenceData reference_data;
+      reference_data.exchange = exchange;
+      reference_data.symbol = symbol;
+      reference_data.tick_size = 0.01;
+      reference_data.min_trade_vol = 1.0;
+      dispatch(source, reference_data, now);
+    }
+    for (auto &account : accounts_) {
+      DownloadBegin download_begin;
+      download_begin.account = account;
+      dispatch(source, download_begin, now);
+      DownloadEnd download_end;
+      download_end.account = account;
+      dispatch(source, download_end, now);
+    }
+    dispatch(source, Ready{}, now);
+  }
+}
+
+void Simulator::timer(std::chrono::nanoseconds now) {
+  Timer timer;
+  timer.now = now;
+  dispatch(0, timer, now);
+}
+
+void Simulator::trade(std::chrono::nanoseconds now) {
+  auto index = trade_count_++;
+  auto source = static_cast<uint8_t>(index % std::size(seqno_));
+  auto account_index = index % std::size(accounts_);
+  auto instrument_index = index % std::size(instruments_);
+  auto &[exchange, symbol] = instruments_[instrument_index];
+  // note! the controller drops trades that are not strictly increasing
+  exchange_time_utc_ = std::max(exchange_time_utc_ + 1ns, get_realtime());
+  for (size_t i = 0; i < std::size(fills_buffer_); ++i) {
+    auto &external_trade_id = external_trade_ids_[i];
+    external_trade_id.clear();
+    fmt::format_to(std::back_inserter(external_trade_id), "{}"sv, ++fill_count_);
+    auto &fill = fills_buffer_[i];
+    fill.exchange_time_utc = exchange_time_utc_;
+    fill.external_trade_id = external_trade_id;
+    fill.quantity = 1.0;
+    fill.price = 100.0;
+  }
+  TradeUpdate trade_update;
+  trade_update.account = accounts_[account_index];
+  trade_update.exchange = exchange;
+  trade_update.symbol = symbol;
+  trade_update.side = (index % 2) ? Side::SELL : Side::BUY;
+  trade_update.create_time_utc = exchange_time_utc_;
+  trade_update.update_time_utc = exchange_time_utc_;
+  trade_update.external_order_id = external_trade_ids_[0];
+  trade_update.fills = fills_buffer_;
+  if (!std::empty(users_))
+    trade_update.user = users_[index % std::size(users_)];
+  auto &pending = pending_[account_index * std::size(instruments_) + instrument_index];
+  pending.insert(std::end(pending), std::size(fills_buffer_), now);
+  dispatch(source, trade_update, now);
+}
+
+void Simulator::report(std::chrono::nanoseconds duration, std::chrono::nanoseconds max_lag) {
+  std::sort(std::begin(latencies_), std::end(latencies_));
+  size_t unacknowledged = 0;
+  for (auto &pending : pending_)
+    unacknowledged += std::size(pending);
+  auto seconds = std::chrono::duration<double>{duration}.count();
+  auto total = dispatcher_.get_total();
+  log::info(
+      "Simulated fill_count={}, trade_count={}, duration={}, fills/second={:.0f} "
+      "(target={}, max_lag={}, sustained={})"sv,
+      fill_count_,
+      trade_count_,
+      duration,
+      seconds > 0.0 ? static_cast<double>(fill_count_) / seconds : 0.0,
+      flags_.simulator_fill_rate,
+      max_lag,
+      max_lag <= flags_.simulator_timer_interval);
+  log::info(
+      "Latency fill->risk_limits (count={}, unacknowledged={}): "
+      "p50={}, p90={}, p99={}, p99.9={}, max={}"sv,
+      std::size(latencies_),
+      unacknowledged,
+      get_percentile(latencies_, 0.5),
+      get_percentile(latencies_, 0.9),
+      get_percentile(latencies_, 0.99),
+      get_percentile(latencies_, 0.999),
+      get_percentile(latencies_, 1.0));
+  log::info(
+      "Published risk_limits_count={}, risk_limit_count={}"sv, total.risk_limits_count, total.risk_limit_count);
+}
+
+}  // namespace simulator
+}  // namespace risk_manager
+}  // namespace roq
@@ -0,0 +1,77 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include <absl/container/flat_hash_map.h>
+
+#include <chrono>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "roq/client.hpp"
+
+#include "roq/io/context.hpp"
+
+#include "roq/risk_manager/config.hpp"
+#include "roq/risk_manager/controller.hpp"
+#include "roq/risk_manager/settings.hpp"
+
+#include "roq/risk_manager/events/dispatcher.hpp"
+
+#include "roq/risk_manager/simulator/flags/flags.hpp"
+
+namespace roq {
+namespace risk_manager {
+namespace simulator {
+
+// note!
+//   accounts, users and instruments are derived from the config (the limits)
+//   fills are distributed round-robin (source, account, user, instrument)
+//   latency is measured from a fill until the first risk limits (for the account) including the instrument
+
+struct Simulator final : public events::Dispatcher::Handler {
+  Simulator(flags::Flags const &, Settings const &, Config const &, io::Context &);
+
+  Simulator(Simulator &&) = delete;
+  Simulator(Simulator const &) = delete;
+
+  void run();
+
+ protected:
+  // events::Dispatcher::Handler
+  void operator()(RiskLimits const &, uint8_t source) override;
+
+  template <typename T>
+  void dispatch(uint8_t source, T const &, std::chrono::nanoseconds now);
+
+  void start(std::chrono::nanoseconds now);
+  void timer(std::chrono::nanoseconds now);
+  void trade(std::chrono::nanoseconds now);
+
+  void report(std::chrono::nanoseconds duration, std::chrono::nanoseconds max_lag);
+
+ private:
+  flags::Flags const flags_;
+  std::vector<std::string> accounts_;
+  std::vector<std::string> users_;
+  std::vector<std::pair<std::string, std::string>> instruments_;  // note! (exchange, symbol)
+  events::Dispatcher dispatcher_;
+  Controller controller_;
+  std::vector<uint64_t> seqno_;  // note! by source
+  // fills
+  uint64_t trade_count_ = {};
+  uint64_t fill_count_ = {};
+  std::chrono::nanoseconds exchange_time_utc_ = {};
+  std::vector<Fill> fills_buffer_;
+  std::vector<std::string> external_trade_ids_;
+  // latency
+  absl::flat_hash_map<std::string, size_t> account_index_;
+  absl::flat_hash_map<std::string, absl::flat_hash_map<std::string, size_t>> instrument_index_;
+  std::vector<std::vector<std::chrono::nanoseconds>> pending_;  // note! (account, instrument)
+  std::vector<std::chrono::nanoseconds> latencies_;
+};
+
+}  // namespace simulator
+}  // namespace risk_manager
+}  // namespace roq
@@ -0,0 +1,55 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstring>
+#include <string>
+
+#include "roq/risk_manager/columnar/encoder.hpp"
+
+#include "roq/risk_manager/test/helpers.hpp"
+
+using namespace std::literals;
+
+using namespace roq::risk_manager;
+
+namespace {
+template <typename T>
+T get(std::string const &buffer, size_t offset) {
+  T result;
+  std::memcpy(&result, std::data(buffer) + offset, sizeof(T));
+  return result;
+}
+}  // namespace
+
+TEST_CASE("columnar_writer_row_groups", "[columnar_writer]") {
+  std::string buffer;
+  size_t flush_count = 0;
+  auto output = [&](auto const &data) {
+    buffer.append(data);
+    ++flush_count;
+  };
+  columnar::Writer writer{output, columnar::Encoder::get_trades_schema(), 2};
+  auto header_size = std::size(buffer);
+  CHECK(buffer.starts_with(columnar::Writer::MAGIC));
+  CHECK(header_size % 8 == 0);
+  columnar::Encoder::encode(writer, test::create_trade({.symbol = "BTC-PERPETUAL"sv, .exchange_time_utc = 3ns}));
+  columnar::Encoder::encode(writer, test::create_trade({.symbol = "BTC-PERPETUAL"sv, .exchange_time_utc = 2ns}));
+  CHECK(get<uint32_t>(buffer, header_size) == 2);  // note! first row group has been written
+  columnar::Encoder::encode(writer, test::create_trade({.symbol = "ETH-PERPETUAL"sv, .exchange_time_utc = 1ns}));
+  writer.finish();
+  CHECK(buffer.ends_with(columnar::Writer::MAGIC));
+  auto footer = std::size(buffer) - std::size(columnar::Writer::MAGIC);
+  CHECK(get<uint64_t>(buffer, footer - 8) == 3);  // note! row count
+  CHECK(get<uint64_t>(buffer, footer - 16) == 2);  // note! row group count
+  auto offset = get<uint64_t>(buffer, footer - 16 - 8);  // note! second row group
+  CHECK(get<uint32_t>(buffer, offset) == 1);
+  CHECK(get<uint32_t>(buffer, offset + 4) == std::size(columnar::Encoder::get_trades_schema()));
+  // note! statistics (exchange_time_utc is the 9th column)
+  auto chunk = offset + 8;
+  for (size_t i = 0; i < 8; ++i)
+    chunk += 8 + get<uint64_t>(buffer, chunk);
+  CHECK(get<int64_t>(buffer, chunk + 8) == 1);
+  CHECK(get<int64_t>(buffer, chunk + 16) == 1);
+  CHECK(flush_count > 2);
+}
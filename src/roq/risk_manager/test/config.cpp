@@ -0,0 +1,96 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <initializer_list>
+#include <string>
+
+#include "roq/risk_manager/config.hpp"
+
+using namespace std::literals;
+
+using namespace roq;
+using namespace roq::risk_manager;
+
+namespace {
+auto const SYMBOLS = R"(symbols = ["^BTC-PERPETUAL$"])"sv;
+
+auto const SYMBOLS_ADDED = R"(symbols = ["^BTC-PERPETUAL$", "^ETH-PERPETUAL$"])"sv;
+
+auto const ACCOUNTS = R"(
+[accounts.A1.deribit.BTC-PERPETUAL]
+long_position_limit = 10
+)"sv;
+
+auto const ACCOUNTS_CHANGED = R"(
+[accounts.A1.deribit.BTC-PERPETUAL]
+long_position_limit = 20
+short_position_limit = 5
+)"sv;
+
+auto const ACCOUNTS_ADDED = R"(
+[accounts.A1.deribit.BTC-PERPETUAL]
+long_position_limit = 10
+
+[accounts.A2.deribit.BTC-PERPETUAL]
+long_position_limit = 10
+)"sv;
+
+auto const USERS = R"(
+[users.trader.deribit.BTC-PERPETUAL]
+long_position_limit = 5
+)"sv;
+
+auto const GROUPS = R"(
+[groups.BTC]
+symbol = "^BTC-.*"
+long_position_limit = 20
+)"sv;
+
+auto const GROUPS_CHANGED = R"(
+[groups.BTC]
+symbol = "^BTC-.*"
+long_position_limit = 30
+)"sv;
+
+auto const GROUPS_MEMBERS_CHANGED = R"(
+[groups.BTC]
+symbol = "^BTC-PERPETUAL$"
+long_position_limit = 20
+)"sv;
+
+auto const LOSS_LIMITS = R"(
+[loss_limits.accounts.A1]
+max_drawdown = 1000
+)"sv;
+
+auto const LOSS_LIMITS_CHANGED = R"(
+[loss_limits.accounts.A1]
+max_drawdown = 2000
+)"sv;
+
+auto create_config(std::initializer_list<std::string_view> sections) {
+  std::string text;
+  for (auto &section : sections) {
+    text += section;
+    text += '\n';
+  }
+  return Config::parse_text(text);
+}
+}  // namespace
+
+TEST_CASE("config_check_reload", "[config]") {
+  auto config = create_config({SYMBOLS, ACCOUNTS, USERS, GROUPS, LOSS_LIMITS});
+  CHECK_NOTHROW(config.check_reload(config));
+  // note! only limits can be changed
+  CHECK_NOTHROW(config.check_reload(create_config({SYMBOLS, ACCOUNTS_CHANGED, USERS, GROUPS, LOSS_LIMITS})));
+  CHECK_NOTHROW(config.check_reload(create_config({SYMBOLS, ACCOUNTS, USERS, GROUPS_CHANGED, LOSS_LIMITS})));
+  CHECK_NOTHROW(config.check_reload(create_config({SYMBOLS, ACCOUNTS, USERS, GROUPS, LOSS_LIMITS_CHANGED})));
+  // note! everything else requires a restart
+  CHECK_THROWS(config.check_reload(create_config({SYMBOLS_ADDED, ACCOUNTS, USERS, GROUPS, LOSS_LIMITS})));
+  CHECK_THROWS(config.check_reload(create_config({SYMBOLS, ACCOUNTS_ADDED, USERS, GROUPS, LOSS_LIMITS})));
+  CHECK_THROWS(config.check_reload(create_config({SYMBOLS, ACCOUNTS, GROUPS, LOSS_LIMITS})));
+  CHECK_THROWS(config.check_reload(create_config({SYMBOLS, ACCOUNTS, USERS, GROUPS_MEMBERS_CHANGED, LOSS_LIMITS})));
+  CHECK_THROWS(config.check_reload(create_config({SYMBOLS, ACCOUNTS, USERS, LOSS_LIMITS})));
+  CHECK_THROWS(config.check_reload(create_config({SYMBOLS, ACCOUNTS, USERS, GROUPS})));
+}
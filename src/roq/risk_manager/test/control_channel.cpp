@@ -0,0 +1,60 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <atomic>
+#include <thread>
+
+#include "roq/risk_manager/control/channel.hpp"
+
+#include "roq/risk_manager/test/helpers.hpp"
+
+using namespace std::literals;
+
+using namespace roq::risk_manager;
+
+TEST_CASE("control_channel_simple", "[control_channel]") {
+  control::Channel channel{4};
+  CHECK(channel(test::create_trade()));
+  CHECK(channel(test::create_trade()));
+  channel(control::Snapshot{});
+  CHECK(channel(test::create_trade()));
+  auto snapshot = channel.get_snapshot();
+  CHECK((*snapshot).trade_count == 2);
+  CHECK((*snapshot).version == 1);
+  CHECK(channel.drain([](auto &) {}) == 3);
+  CHECK(channel.get_lag(*snapshot) == 1);
+  // note! prices are published separately (sharing the version)
+  channel(control::Prices{});
+  CHECK((*channel.get_prices()).version == 2);
+  CHECK((*channel.get_snapshot()).version == 1);
+}
+
+// note! the engine publishes snapshots while the control thread is resuming (snapshot is loaded before draining)
+TEST_CASE("control_channel_resume_interleaved", "[control_channel]") {
+  control::Channel channel{1024};
+  std::atomic<bool> done = {};
+  std::thread engine{[&]() {
+    for (size_t i = 0; i < 100000; ++i) {
+      while (!channel(test::create_trade()))
+        std::this_thread::yield();
+      if ((i % 7) == 0)
+        channel(control::Snapshot{});
+    }
+    done.store(true, std::memory_order_release);
+  }};
+  size_t failures = 0;
+  auto callback = [](auto &) {};
+  while (!done.load(std::memory_order_acquire)) {
+    auto snapshot = channel.get_snapshot();
+    channel.drain(callback);
+    if (channel.pop_count() < (*snapshot).trade_count)
+      ++failures;
+  }
+  engine.join();
+  CHECK(failures == 0);
+  auto snapshot = channel.get_snapshot();
+  channel.drain(callback);
+  CHECK(channel.pop_count() == 100000);
+  CHECK(channel.get_lag(*snapshot) == 100000 - (*snapshot).trade_count);
+}
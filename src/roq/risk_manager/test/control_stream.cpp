@@ -0,0 +1,86 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <string>
+#include <vector>
+
+#include "roq/risk_manager/control/stream.hpp"
+
+#include "roq/risk_manager/test/helpers.hpp"
+
+using namespace std::literals;
+
+using namespace roq::risk_manager;
+
+TEST_CASE("control_stream_resume", "[control_stream]") {
+  control::Stream stream{4};
+  auto initial_seqno = stream.seqno();
+  for (auto &item : {"1"sv, "2"sv, "3"sv})
+    stream(test::create_trade({.external_trade_id = item}));
+  CHECK(stream.seqno() == initial_seqno + 3);
+  std::vector<std::string> messages;
+  auto callback = [&](auto const &message) { messages.emplace_back(message); };
+  // gap
+  CHECK(stream.get_messages_after(initial_seqno + 1, callback) == true);
+  REQUIRE(std::size(messages) == 2);
+  CHECK(messages[0].find(fmt::format(R"("seqno":{})"sv, initial_seqno + 2)) != std::string::npos);
+  CHECK(messages[1].find(fmt::format(R"("seqno":{})"sv, initial_seqno + 3)) != std::string::npos);
+  // up to date
+  messages.clear();
+  CHECK(stream.get_messages_after(stream.seqno(), callback) == true);
+  CHECK(std::empty(messages));
+  // from the future (e.g. previous process)
+  CHECK(stream.get_messages_after(stream.seqno() + 1, callback) == false);
+}
+
+TEST_CASE("control_stream_outside_ring", "[control_stream]") {
+  control::Stream stream{2};
+  auto initial_seqno = stream.seqno();
+  for (auto &item : {"1"sv, "2"sv, "3"sv, "4"sv})
+    stream(test::create_trade({.external_trade_id = item}));
+  auto callback = [](auto const &) {};
+  CHECK(stream.get_messages_after(initial_seqno + 1, callback) == false);
+  CHECK(stream.get_messages_after(initial_seqno + 2, callback) == true);
+  stream.reset();
+  CHECK(stream.get_messages_after(initial_seqno + 4, callback) == false);
+  CHECK(stream.get_messages_after(stream.seqno(), callback) == true);
+}
+
+TEST_CASE("control_stream_snapshot", "[control_stream]") {
+  control::Stream stream{4};
+  auto position = control::Snapshot::Position{
+      .instrument_id = 1,
+      .user = {},
+      .strategy_id = {},
+      .account = "A1",
+      .exchange = "deribit",
+      .symbol = "BTC-PERPETUAL",
+      .long_quantity = 1.0,
+      .short_quantity = 0.0,
+      .exchange_time_utc = {},
+      .average_price = 27193.0,
+      .realized_pnl = 0.0,
+  };
+  control::Prices prices;
+  auto count = 0;
+  auto generator = [&](auto &callback) {
+    ++count;
+    callback(position, prices);
+  };
+  auto snapshot = std::string{stream.get_snapshot(stream.seqno(), 1, generator)};
+  CHECK(snapshot.starts_with(R"({"type":"snapshot",)"sv));
+  CHECK(snapshot.find(R"("unrealized_pnl":null)"sv) != std::string::npos);
+  // note! cached until the next event
+  stream.get_snapshot(stream.seqno(), 1, generator);
+  CHECK(count == 1);
+  stream(test::create_trade());
+  stream.get_snapshot(stream.seqno(), 1, generator);
+  CHECK(count == 2);
+  // note! ... or a new version of the snapshot or the prices
+  prices.prices = {{}, {.price = 27200.0, .multiplier = 2.0}};
+  snapshot = std::string{stream.get_snapshot(stream.seqno(), 2, generator)};
+  CHECK(count == 3);
+  CHECK(snapshot.find(R"("unrealized_pnl":null)"sv) == std::string::npos);
+  CHECK(position.get_unrealized_pnl(prices) == 14.0);
+}
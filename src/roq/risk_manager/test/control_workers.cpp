@@ -0,0 +1,110 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <fmt/format.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "roq/risk_manager/control/workers.hpp"
+
+#include "roq/risk_manager/database/sqlite/session.hpp"
+
+#include "roq/risk_manager/test/helpers.hpp"
+
+using namespace std::literals;
+using namespace std::chrono_literals;
+
+using namespace roq;
+using namespace roq::risk_manager;
+
+namespace {
+size_t const TRADE_COUNT = 1000;  // note! enough for the progress handler to be called many times
+
+// note! the database is shared with the worker thread
+struct Database final {
+  Database() {
+    std::vector<std::string> ids;
+    for (size_t i = 0; i < TRADE_COUNT; ++i)
+      ids.emplace_back(fmt::format("{}"sv, i));
+    std::vector<database::Trade> trades;
+    for (size_t i = 0; i < TRADE_COUNT; ++i)
+      trades.emplace_back(test::create_trade({.exchange_time_utc = 1000h + i * 1s, .external_trade_id = ids[i]}));
+    (**this)(std::span<database::Trade const>{trades});
+  }
+
+  // note! the interface is only public from the base class
+  database::Session &operator*() { return session_; }
+
+ private:
+  database::sqlite::Session session_{":memory:"sv, 0, 24h, {}, {}, 100};
+};
+
+// note! the callback is called (from the worker thread) for each trade
+auto create_query(database::Session &database, std::shared_ptr<std::atomic<bool>> const &cancelled, auto callback) {
+  return control::Query{
+      .session_id = 1,
+      .connection = {},
+      .cancelled = cancelled,
+      .execute =
+          [&database, callback](control::Response &response, control::Budget &budget) {
+            size_t count = 0;
+            database([&](database::Trade const &) { callback(++count); }, "A1"sv, {}, budget.interrupt());
+            response(web::http::Status::OK, web::http::ContentType::APPLICATION_JSON, "{}"sv, count);
+          },
+  };
+}
+
+auto wait_for_result(control::Workers &workers) {
+  control::Result result;
+  for (size_t i = 0; i < 10000; ++i) {
+    if (workers.pop_all([&](auto &item) { result = item; }))
+      break;
+    std::this_thread::sleep_for(1ms);
+  }
+  return result;
+}
+}  // namespace
+
+TEST_CASE("control_workers_budget", "[control_workers]") {
+  Database database;
+  auto cancelled = std::make_shared<std::atomic<bool>>(false);
+  // note! no limit
+  control::Workers workers_1{1, 0ns, 0};
+  workers_1(create_query(*database, cancelled, [](auto) {}));
+  auto result_1 = wait_for_result(workers_1);
+  CHECK(result_1.status == web::http::Status::OK);
+  CHECK(result_1.body == fmt::format("{}"sv, TRADE_COUNT));
+  // note! over budget => interrupted by the progress handler
+  control::Workers workers_2{1, 1ns, 0};
+  workers_2(create_query(*database, cancelled, [](auto) {}));
+  auto result_2 = wait_for_result(workers_2);
+  CHECK(result_2.status == web::http::Status::SERVICE_UNAVAILABLE);
+  CHECK(result_2.body.find("timeout"sv) != std::string::npos);
+}
+
+TEST_CASE("control_workers_cancelled", "[control_workers]") {
+  Database database;
+  auto cancelled = std::make_shared<std::atomic<bool>>(false);
+  std::atomic<bool> started = false;
+  control::Workers workers{1, 0ns, 0};
+  // note! the query blocks on the first row until the session has been disconnected
+  workers(create_query(*database, cancelled, [&](auto count) {
+    if (count != 1)
+      return;
+    started.store(true, std::memory_order_release);
+    while (!(*cancelled).load(std::memory_order_acquire))
+      std::this_thread::yield();
+  }));
+  while (!started.load(std::memory_order_acquire))
+    std::this_thread::yield();
+  (*cancelled).store(true, std::memory_order_release);  // note! what the session does when disconnected
+  auto result = wait_for_result(workers);
+  CHECK(result.status == web::http::Status::SERVICE_UNAVAILABLE);
+  CHECK(result.body.find("cancelled"sv) != std::string::npos);
+}
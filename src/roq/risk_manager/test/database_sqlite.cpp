@@ -0,0 +1,634 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <fmt/format.h>
+
+#include <atomic>
+#include <cmath>
+#include <deque>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "roq/third_party/sqlite/connection.hpp"
+#include "roq/third_party/sqlite/statement.hpp"
+
+#include "roq/risk_manager/database/backup.hpp"
+
+#include "roq/risk_manager/database/sqlite/dimension.hpp"
+#include "roq/risk_manager/database/sqlite/partitions.hpp"
+#include "roq/risk_manager/database/sqlite/schema.hpp"
+#include "roq/risk_manager/database/sqlite/session.hpp"
+#include "roq/risk_manager/database/sqlite/trades.hpp"
+
+#include "roq/risk_manager/test/helpers.hpp"
+
+using namespace std::literals;
+using namespace std::chrono_literals;
+
+using namespace roq;
+using namespace roq::risk_manager;
+
+namespace {
+auto const START_TIME = std::chrono::nanoseconds{1000h};
+
+struct Session final {
+  explicit Session(
+      std::string_view const &params = ":memory:"sv, size_t read_connections = 0, size_t backup_step_pages = 100)
+      : session_{params, read_connections, 1h, {}, {}, backup_step_pages} {}
+
+  // note! the interface is only public from the base class
+  database::Session &operator*() { return session_; }
+
+  auto get_accounts() {
+    std::vector<database::Account> result;
+    names_.clear();
+    (**this)(
+        [&](database::Account const &account) {
+          result.emplace_back(account);
+          result.back().name = names_.emplace_back(account.name);
+        },
+        {});
+    return result;
+  }
+
+  auto get_trade_count(std::string_view const &account, std::chrono::nanoseconds start_time = {}) {
+    size_t result = 0;
+    (**this)([&](database::Trade const &) { ++result; }, account, start_time, {});
+    return result;
+  }
+
+  auto get_long_quantity(std::string_view const &account) {
+    auto result = 0.0;
+    (**this)(
+        [&](database::Position const &position) {
+          if (position.account == account)
+            result += position.long_quantity;
+        },
+        {});
+    return result;
+  }
+
+ private:
+  database::sqlite::Session session_;
+  std::deque<std::string> names_;  // note! stable references
+};
+
+// note! removed when constructed and when destroyed
+struct File final {
+  explicit File(std::string_view const &name = "test"sv)
+      : name_{(std::filesystem::temp_directory_path() / fmt::format("roq-risk-manager-{}.sqlite3"sv, name)).string()} {
+    remove();
+  }
+  ~File() { remove(); }
+
+  operator std::string_view() const { return name_; }
+
+ private:
+  void remove() {
+    for (auto extension : {""sv, "-wal"sv, "-shm"sv, ".tmp"sv})
+      std::filesystem::remove(fmt::format("{}{}"sv, name_, extension));
+  }
+
+  std::string const name_;
+};
+
+// note! the notional is checked by the statistics tests
+auto create_trade(std::chrono::nanoseconds exchange_time_utc, std::string_view const &external_trade_id) {
+  return test::create_trade({
+      .price = 100.0,
+      .exchange_time_utc = exchange_time_utc,
+      .external_trade_id = external_trade_id,
+  });
+}
+
+auto get_row_count(third_party::sqlite::Connection &connection, std::string_view const &table_name) {
+  auto &statement = connection.prepare(fmt::format("SELECT COUNT(*) FROM {}"sv, table_name));
+  REQUIRE(statement.step());
+  auto result = statement.get<int64_t>(0);
+  connection.reset();
+  return result;
+}
+}  // namespace
+
+TEST_CASE("database_sqlite_compress_statistics", "[database_sqlite]") {
+  Session session;
+  std::vector<database::Trade> trades{
+      create_trade(START_TIME + 1min, "1"sv),
+      create_trade(START_TIME + 2min, "2"sv),
+      create_trade(START_TIME + 3min, "3"sv),
+      create_trade(START_TIME + 1h + 1min, "4"sv),
+      test::create_trade({.account = "A2"sv, .exchange_time_utc = START_TIME + 1h + 2min, .external_trade_id = "5"sv}),
+  };
+  (*session)(std::span<database::Trade const>{trades});
+  auto accounts = session.get_accounts();
+  REQUIRE(std::size(accounts) == 2);
+  CHECK(accounts[0].trade_count == 4);
+  CHECK(accounts[0].exchange_time_utc_min == START_TIME + 1min);
+  (*session)(database::Compress{.exchange_time_utc = START_TIME + 1h});
+  // note! one position row replaces the first partition (only the compressed accounts are adjusted)
+  accounts = session.get_accounts();
+  REQUIRE(std::size(accounts) == 2);
+  CHECK(accounts[0].trade_count == 2);
+  CHECK(accounts[0].exchange_time_utc_min == START_TIME + 3min);
+  CHECK(accounts[0].exchange_time_utc_max == START_TIME + 1h + 1min);
+  CHECK(accounts[0].volume == 4.0);
+  CHECK(accounts[0].notional == 400.0);
+  CHECK(session.get_long_quantity("A1"sv) == 4.0);
+  CHECK(accounts[1].trade_count == 1);
+  CHECK(accounts[1].exchange_time_utc_min == START_TIME + 1h + 2min);
+}
+
+TEST_CASE("database_sqlite_duplicates", "[database_sqlite]") {
+  Session session;
+  std::vector<database::Trade> trades{
+      create_trade(START_TIME + 1min, "1"sv),
+      create_trade(START_TIME + 1h + 1min, "2"sv),
+  };
+  (*session)(std::span<database::Trade const>{trades});
+  // note! same trade id, different partition
+  std::vector<database::Trade> replay_1{create_trade(START_TIME + 1h + 2min, "1"sv)};
+  (*session)(std::span<database::Trade const>{replay_1});
+  CHECK(session.get_trade_count("A1"sv) == 2);
+  (*session)(database::Compress{.exchange_time_utc = START_TIME + 1h});
+  // note! the partition has been dropped
+  std::vector<database::Trade> replay_2{create_trade(START_TIME + 1min, "1"sv)};
+  (*session)(std::span<database::Trade const>{replay_2});
+  auto accounts = session.get_accounts();
+  REQUIRE(std::size(accounts) == 1);
+  CHECK(accounts[0].trade_count == 2);
+  CHECK(accounts[0].duplicate_count == 2);
+  CHECK(session.get_long_quantity("A1"sv) == 2.0);
+  // note! corrections have no trade id and are never ignored
+  std::vector<database::Correction> corrections{
+      {
+          .user = "trader"sv,
+          .strategy_id = 1,
+          .account = "A1"sv,
+          .exchange = "deribit"sv,
+          .symbol = "BTC-PERPETUAL"sv,
+          .side = Side::BUY,
+          .quantity = 1.0,
+          .price = 100.0,
+          .exchange_time_utc = START_TIME + 2min,
+          .reason = "test"sv,
+      },
+  };
+  (*session)(std::span<database::Correction const>{corrections});
+  (*session)(std::span<database::Correction const>{corrections});
+  CHECK(session.get_long_quantity("A1"sv) == 4.0);
+}
+
+// note! nothing of a failed batch is visible (also not the in-memory statistics)
+TEST_CASE("database_sqlite_rollback", "[database_sqlite]") {
+  Session session;
+  std::vector<database::Trade> trades{create_trade(START_TIME + 1min, "1"sv)};
+  (*session)(std::span<database::Trade const>{trades});
+  std::vector<database::Trade> batch{
+      create_trade(START_TIME + 2min, "2"sv),
+      create_trade(START_TIME + 1h + 1min, "3"sv),
+      test::create_trade({.price = NaN, .exchange_time_utc = START_TIME + 1h + 2min, .external_trade_id = "4"sv}),
+  };
+  CHECK_THROWS((*session)(std::span<database::Trade const>{batch}));
+  auto accounts = session.get_accounts();
+  REQUIRE(std::size(accounts) == 1);
+  CHECK(accounts[0].trade_count == 1);
+  CHECK(accounts[0].exchange_time_utc_max == START_TIME + 1min);
+  CHECK(session.get_trade_count("A1"sv) == 1);
+  // note! the trade ids have also been rolled back
+  batch.pop_back();
+  (*session)(std::span<database::Trade const>{batch});
+  accounts = session.get_accounts();
+  REQUIRE(std::size(accounts) == 1);
+  CHECK(accounts[0].trade_count == 3);
+  CHECK(accounts[0].duplicate_count == 0);
+  CHECK(accounts[0].exchange_time_utc_max == START_TIME + 1h + 1min);
+  CHECK(session.get_trade_count("A1"sv) == 3);
+}
+
+TEST_CASE("database_sqlite_migrate_from_v4", "[database_sqlite]") {
+  File file;
+  std::vector<database::Trade> trades{create_trade(START_TIME + 1min, "1"sv)};
+  {
+    Session session{file};
+    (*session)(std::span<database::Trade const>{trades});
+  }
+  // note! version 4 didn't have the trade ids
+  {
+    third_party::sqlite::Connection connection{file};
+    connection.drop_table("trade_ids"sv);
+    connection.set_user_version(4);
+  }
+  // note! different partition
+  Session session{file};
+  std::vector<database::Trade> replay{create_trade(START_TIME + 1h + 1min, "1"sv)};
+  (*session)(std::span<database::Trade const>{replay});
+  auto accounts = session.get_accounts();
+  REQUIRE(std::size(accounts) == 1);
+  CHECK(accounts[0].trade_count == 1);
+  CHECK(accounts[0].duplicate_count == 1);
+}
+
+// note! version 5 also had a unique index on each partition
+TEST_CASE("database_sqlite_migrate_from_v5", "[database_sqlite]") {
+  File file;
+  std::vector<database::Trade> trades{
+      create_trade(START_TIME + 1min, "1"sv),
+      create_trade(START_TIME + 1h + 1min, "2"sv),
+  };
+  {
+    Session session{file};
+    (*session)(std::span<database::Trade const>{trades});
+  }
+  auto get_index_count = [&](auto &connection) {
+    return get_row_count(connection, "sqlite_master WHERE type='index' AND name LIKE '%external_trade_id'"sv);
+  };
+  {
+    third_party::sqlite::Connection connection{file};
+    auto names = database::sqlite::Partitions::get_names(connection);
+    for (auto &name : names)
+      connection.exec(fmt::format(
+          "CREATE UNIQUE INDEX idx_{}_external_trade_id ON {}(exchange_id, external_trade_id) "
+          "WHERE external_trade_id<>''"sv,
+          name,
+          name));
+    CHECK(get_index_count(connection) == static_cast<int64_t>(std::size(names)));
+    connection.set_user_version(5);
+  }
+  {
+    Session session{file};
+    (*session)(std::span<database::Trade const>{trades});
+    auto accounts = session.get_accounts();
+    REQUIRE(std::size(accounts) == 1);
+    CHECK(accounts[0].trade_count == 2);
+    CHECK(accounts[0].duplicate_count == 2);
+  }
+  third_party::sqlite::Connection connection{file};
+  CHECK(get_index_count(connection) == 0);
+  CHECK(connection.get_user_version() == database::sqlite::Schema::VERSION);
+}
+
+TEST_CASE("database_sqlite_partitions", "[database_sqlite]") {
+  Session session;
+  std::vector<database::Trade> trades{
+      create_trade(START_TIME + 1min, "1"sv),
+      create_trade(START_TIME + 1h + 1min, "2"sv),
+      create_trade(START_TIME + 1h + 2min, "3"sv),
+      create_trade(START_TIME + 2h + 1min, "4"sv),
+  };
+  (*session)(std::span<database::Trade const>{trades});
+  CHECK(session.get_trade_count("A1"sv) == 4);
+  CHECK(session.get_trade_count("A1"sv, START_TIME) == 4);
+  CHECK(session.get_trade_count("A1"sv, START_TIME + 1h) == 3);
+  CHECK(session.get_trade_count({}, START_TIME + 1h + 2min) == 2);
+  CHECK(session.get_trade_count({}, START_TIME + 3h) == 0);
+  CHECK(session.get_trade_count("A2"sv, START_TIME) == 0);
+  // note! the first two partitions are merged into a single position row
+  (*session)(database::Compress{.exchange_time_utc = START_TIME + 2h});
+  CHECK(session.get_trade_count("A1"sv) == 2);
+  CHECK(session.get_trade_count("A1"sv, START_TIME) == 2);
+  CHECK(session.get_trade_count("A1"sv, START_TIME + 2h) == 1);
+  CHECK(session.get_long_quantity("A1"sv) == 4.0);
+  // note! the merged partition still covers its range
+  std::vector<database::Trade> more{create_trade(START_TIME + 30min, "5"sv)};
+  (*session)(std::span<database::Trade const>{more});
+  CHECK(session.get_trade_count("A1"sv, START_TIME) == 3);
+  // note! the merged partition can be compressed again
+  (*session)(database::Compress{.exchange_time_utc = START_TIME + 2h});
+  CHECK(session.get_trade_count("A1"sv, START_TIME) == 2);
+  CHECK(session.get_long_quantity("A1"sv) == 5.0);
+  // note! nothing to compress
+  (*session)(database::Compress{.exchange_time_utc = START_TIME + 1h});
+  CHECK(session.get_trade_count("A1"sv, START_TIME) == 2);
+}
+
+// note! version 0 used text columns (no dimensions) and had no unique trade id
+TEST_CASE("database_sqlite_migrate_from_v0", "[database_sqlite]") {
+  File file;
+  {
+    third_party::sqlite::Connection connection{file};
+    connection.exec(
+        "CREATE TABLE trades ("
+        "  user TEXT, "
+        "  strategy_id INTEGER, "
+        "  account TEXT NOT NULL, "
+        "  exchange TEXT NOT NULL, "
+        "  symbol TEXT NOT NULL, "
+        "  side TEXT NOT NULL, "
+        "  quantity REAL NOT NULL, "
+        "  price REAL NOT NULL, "
+        "  exchange_time_utc INTEGER NOT NULL, "
+        "  external_account TEXT, "
+        "  external_order_id TEXT, "
+        "  external_trade_id TEXT NOT NULL, "
+        "  reason TEXT NOT NULL, "
+        "  type TEXT NOT NULL, "
+        "  PRIMARY KEY (user, strategy_id, account, exchange, symbol, exchange_time_utc, external_trade_id, type)"
+        ")"sv);
+    // note! values are (user, strategy_id, account, exchange, symbol, side, quantity, external_trade_id, type)
+    auto insert = [&](std::string_view const &values, std::chrono::nanoseconds exchange_time_utc) {
+      connection.exec(fmt::format(
+          "INSERT INTO trades ("
+          "  user, strategy_id, account, exchange, symbol, side, quantity, external_trade_id, type, "
+          "  price, reason, exchange_time_utc"
+          ") VALUES ({}, 100.0, '', {})"sv,
+          values,
+          exchange_time_utc.count()));
+    };
+    insert("'trader', 1, 'A1', 'deribit', 'BTC-PERPETUAL', 'BUY', 1.0, '1', 'EXCHANGE'"sv, START_TIME + 1min);
+    insert("NULL, NULL, 'A1', 'deribit', 'ETH-PERPETUAL', 'SELL', 2.0, '2', 'MANUAL'"sv, START_TIME + 2min);
+    insert("'trader', 1, 'A2', 'deribit', 'BTC-PERPETUAL', 'BUY', 1.0, '3', 'EXCHANGE'"sv, START_TIME + 3min);
+    // note! duplicated trade id => ignored (the first trade wins)
+    insert("'trader', 1, 'A1', 'deribit', 'BTC-PERPETUAL', 'BUY', 5.0, '1', 'EXCHANGE'"sv, START_TIME + 4min);
+    // note! missing trade id => never a duplicate
+    insert("'trader', 1, 'A1', 'deribit', 'BTC-PERPETUAL', 'BUY', 1.0, '', 'EXCHANGE'"sv, START_TIME + 5min);
+  }
+  {
+    Session session{file};
+    CHECK(session.get_trade_count("A1"sv) == 3);
+    CHECK(session.get_trade_count("A2"sv) == 1);
+    CHECK(session.get_long_quantity("A1"sv) == 2.0);
+    size_t count = 0;
+    (*session)(
+        [&](database::Trade const &trade) {
+          if (trade.external_trade_id != "2"sv)
+            return;
+          ++count;
+          CHECK(std::empty(trade.user));
+          CHECK(trade.strategy_id == 0);
+          CHECK(trade.symbol == "ETH-PERPETUAL"sv);
+          CHECK(trade.side == Side::SELL);
+          CHECK(trade.quantity == 2.0);
+          CHECK(trade.exchange_time_utc == START_TIME + 2min);
+        },
+        "A1"sv,
+        {},
+        {});
+    CHECK(count == 1);
+    // note! trade ids have been migrated
+    std::vector<database::Trade> replay{create_trade(START_TIME + 1h, "1"sv)};
+    (*session)(std::span<database::Trade const>{replay});
+    auto accounts = session.get_accounts();
+    REQUIRE(std::size(accounts) == 2);
+    CHECK(accounts[0].trade_count + accounts[1].trade_count == 4);
+    CHECK(accounts[0].duplicate_count + accounts[1].duplicate_count == 1);
+  }
+  // note! each name has been interned once (a missing user is interned as an empty name)
+  third_party::sqlite::Connection connection{file};
+  CHECK(!connection.table_exists("trades_v0"sv));
+  CHECK(get_row_count(connection, database::sqlite::Dimensions::USERS) == 2);
+  CHECK(get_row_count(connection, database::sqlite::Dimensions::ACCOUNTS) == 2);
+  CHECK(get_row_count(connection, database::sqlite::Dimensions::EXCHANGES) == 1);
+  CHECK(get_row_count(connection, database::sqlite::Dimensions::SYMBOLS) == 2);
+  CHECK(connection.get_user_version() == database::sqlite::Schema::VERSION);
+}
+
+TEST_CASE("database_sqlite_migrate_from_v2", "[database_sqlite]") {
+  File file;
+  {
+    third_party::sqlite::Connection connection{file};
+    database::sqlite::Dimensions::create(connection);
+    database::sqlite::Trades::create(connection, "trades"sv);
+    database::sqlite::Dimensions dimensions;
+    auto user_id = dimensions.users(connection, "trader"sv);
+    auto account_id = dimensions.accounts(connection, "A1"sv);
+    auto exchange_id = dimensions.exchanges(connection, "deribit"sv);
+    auto symbol_id = dimensions.symbols(connection, "BTC-PERPETUAL"sv);
+    for (auto i = 1; i <= 3; ++i) {
+      auto exchange_time_utc = START_TIME + i * 1min;
+      connection.exec(fmt::format(
+          "INSERT INTO trades VALUES ({}, 1, {}, {}, {}, 1, 1.0, 100.0, {}, '', '1', '{}', '', 1)"sv,
+          user_id,
+          account_id,
+          exchange_id,
+          symbol_id,
+          exchange_time_utc.count(),
+          i));
+    }
+    connection.set_user_version(2);
+  }
+  Session session{file};
+  CHECK(session.get_trade_count("A1"sv) == 3);
+  CHECK(session.get_trade_count("A1"sv, START_TIME + 2min) == 2);
+  CHECK(session.get_long_quantity("A1"sv) == 3.0);
+  auto accounts = session.get_accounts();
+  REQUIRE(std::size(accounts) == 1);
+  CHECK(accounts[0].trade_count == 3);
+  // note! trade ids have been migrated
+  std::vector<database::Trade> trades{
+      create_trade(START_TIME + 1h, "1"sv),
+      create_trade(START_TIME + 1h, "4"sv),
+  };
+  (*session)(std::span<database::Trade const>{trades});
+  CHECK(session.get_trade_count("A1"sv) == 4);
+  CHECK(session.get_trade_count("A1"sv, START_TIME + 1h) == 1);
+}
+
+// note! partitions are dropped by the writer while readers are scanning them
+TEST_CASE("database_sqlite_compress_concurrent", "[database_sqlite]") {
+  File file;
+  Session session{file, 2};
+  auto const hours = 48;
+  std::vector<database::Trade> trades;
+  std::vector<std::string> ids;
+  for (auto i = 0; i < hours; ++i)
+    ids.emplace_back(fmt::format("{}"sv, i));
+  for (auto i = 0; i < hours; ++i)
+    trades.emplace_back(create_trade(START_TIME + i * 1h + 1min, ids[i]));
+  (*session)(std::span<database::Trade const>{trades});
+  std::atomic<bool> done = false;
+  size_t errors = 0;
+  std::thread reader{[&]() {
+    while (!done.load(std::memory_order_acquire)) {
+      try {
+        session.get_trade_count("A1"sv, START_TIME);
+      } catch (...) {
+        ++errors;
+      }
+    }
+  }};
+  for (auto i = 1; i < hours; ++i)
+    (*session)(database::Compress{.exchange_time_utc = START_TIME + i * 1h});
+  done.store(true, std::memory_order_release);
+  reader.join();
+  CHECK(errors == 0);
+  CHECK(session.get_trade_count("A1"sv, START_TIME) == 2);
+}
+
+TEST_CASE("database_sqlite_limits", "[database_sqlite]") {
+  Session session;
+  auto create_limit = [](std::string_view const &symbol, double long_position_limit, uint64_t version) {
+    return database::Limit{
+        .user = {},
+        .strategy_id = {},
+        .account = "A1"sv,
+        .exchange = "deribit"sv,
+        .symbol = symbol,
+        .long_position_limit = long_position_limit,
+        .version = version,
+    };
+  };
+  auto get_limits = [&](bool history) {
+    std::vector<std::pair<double, uint64_t>> result;
+    (*session)(
+        [&](database::Limit const &limit) { result.emplace_back(limit.long_position_limit, limit.version); },
+        history,
+        {});
+    return result;
+  };
+  std::vector<database::Limit> limits_1{
+      create_limit("BTC-PERPETUAL"sv, 1.0, 0),
+      create_limit("ETH-PERPETUAL"sv, 2.0, 0),
+  };
+  CHECK((*session)(std::span<database::Limit const>{limits_1}));
+  // note! expects the current version
+  std::vector<database::Limit> limits_2{create_limit("BTC-PERPETUAL"sv, 3.0, 1)};
+  CHECK((*session)(std::span<database::Limit const>{limits_2}));
+  CHECK(!(*session)(std::span<database::Limit const>{limits_2}));
+  // note! all or nothing
+  std::vector<database::Limit> limits_3{
+      create_limit("ETH-PERPETUAL"sv, 4.0, 1),
+      create_limit("BTC-PERPETUAL"sv, 5.0, 1),
+  };
+  CHECK(!(*session)(std::span<database::Limit const>{limits_3}));
+  auto current = get_limits(false);
+  REQUIRE(std::size(current) == 2);
+  CHECK(current[0] == std::pair{3.0, uint64_t{2}});  // note! BTC-PERPETUAL
+  CHECK(current[1] == std::pair{2.0, uint64_t{1}});  // note! ETH-PERPETUAL
+  auto history = get_limits(true);
+  REQUIRE(std::size(history) == 3);
+  CHECK(history[0] == std::pair{1.0, uint64_t{1}});
+  CHECK(history[1] == std::pair{3.0, uint64_t{2}});
+  CHECK(history[2] == std::pair{2.0, uint64_t{1}});
+}
+
+// note! the pnl is joined to the positions aggregated from the trades (by key)
+TEST_CASE("database_sqlite_pnl", "[database_sqlite]") {
+  Session session;
+  auto create_position = [](std::string_view const &user, std::string_view const &account, double realized_pnl) {
+    return database::Position{
+        .user = user,
+        .strategy_id = {},
+        .account = account,
+        .exchange = "deribit"sv,
+        .symbol = "BTC-PERPETUAL"sv,
+        .average_price = 100.0,
+        .realized_pnl = realized_pnl,
+        .fees = 0.5,
+    };
+  };
+  auto get_realized_pnl = [&](auto select) {
+    std::vector<double> result;
+    (*session)(
+        [&](database::Position const &position) {
+          if (select(position))
+            result.emplace_back(position.realized_pnl);
+        },
+        {});
+    return result;
+  };
+  std::vector<database::Trade> trades_1{create_trade(START_TIME + 1min, "1"sv)};
+  std::vector<database::Position> positions_1{create_position({}, "A1"sv, 1.0)};
+  (*session)(std::span<database::Trade const>{trades_1}, std::span<database::Position const>{positions_1}, {});
+  // note! the latest row replaces the previous
+  std::vector<database::Trade> trades_2{create_trade(START_TIME + 2min, "2"sv)};
+  std::vector<database::Position> positions_2{create_position({}, "A1"sv, 2.0), create_position("trader"sv, {}, 3.0)};
+  (*session)(std::span<database::Trade const>{trades_2}, std::span<database::Position const>{positions_2}, {});
+  auto by_account = get_realized_pnl([](auto &position) { return position.account == "A1"sv; });
+  REQUIRE(std::size(by_account) == 1);
+  CHECK(by_account[0] == 2.0);
+  auto by_user = get_realized_pnl([](auto &position) { return position.user == "trader"sv; });
+  REQUIRE(std::size(by_user) == 1);
+  CHECK(by_user[0] == 3.0);
+  // note! never persisted
+  auto by_strategy = get_realized_pnl([](auto &position) { return position.strategy_id != 0; });
+  REQUIRE(std::size(by_strategy) == 1);
+  CHECK(std::isnan(by_strategy[0]));
+  CHECK(session.get_long_quantity("A1"sv) == 2.0);
+}
+
+TEST_CASE("database_sqlite_drawdowns", "[database_sqlite]") {
+  Session session;
+  auto get_drawdowns = [&]() {
+    std::vector<std::pair<double, bool>> result;
+    (*session)([&](database::Drawdown const &drawdown) { result.emplace_back(drawdown.peak, drawdown.breach); }, {});
+    return result;
+  };
+  std::vector<database::Trade> trades{create_trade(START_TIME + 1min, "1"sv)};
+  std::vector<database::Drawdown> drawdowns_1{
+      {.user = {}, .account = "A1"sv, .peak = 1.0, .start = 0.0, .next_reset = START_TIME + 1h, .breach = false},
+  };
+  (*session)(std::span<database::Trade const>{trades}, {}, std::span<database::Drawdown const>{drawdowns_1});
+  // note! the latest row replaces the previous
+  std::vector<database::Drawdown> drawdowns_2{
+      {.user = {}, .account = "A1"sv, .peak = 2.0, .start = 0.0, .next_reset = START_TIME + 1h, .breach = true},
+      {.user = "trader"sv, .account = {}, .peak = 3.0, .start = 0.0, .next_reset = START_TIME + 1h, .breach = false},
+  };
+  (*session)(std::span<database::Drawdown const>{drawdowns_2});
+  auto drawdowns = get_drawdowns();
+  REQUIRE(std::size(drawdowns) == 2);
+  CHECK(drawdowns[0] == std::pair{2.0, true});  // note! ordered by user
+  CHECK(drawdowns[1] == std::pair{3.0, false});
+}
+
+// note! one page per step => the backup is slow enough to be observed while running
+TEST_CASE("database_sqlite_backup", "[database_sqlite]") {
+  File file, target{"backup"sv};
+  Session session{file, 0, 1};
+  auto const count = 10000;
+  std::vector<database::Trade> trades;
+  std::vector<std::string> ids;
+  for (auto i = 0; i < count + 1; ++i)
+    ids.emplace_back(fmt::format("{}"sv, i));
+  for (auto i = 0; i < count; ++i)
+    trades.emplace_back(create_trade(START_TIME + i * 1s, ids[i]));
+  (*session)(std::span<database::Trade const>{trades});
+  database::BackupStatus status;
+  std::string filename, error;  // note! copied (the status only references the backup)
+  auto refresh = [&]() {
+    (*session)(
+        [&](database::BackupStatus const &value) {
+          status = value;
+          filename = value.filename;
+          error = value.error;
+        },
+        {});
+  };
+  CHECK((*session)(database::Backup{.filename = target}));
+  // note! only one backup at a time (409)
+  CHECK(!(*session)(database::Backup{.filename = target}));
+  do {
+    std::this_thread::yield();
+    refresh();
+  } while (!status.running || status.page_count == 0);
+  CHECK(filename == std::string_view{target});
+  CHECK(status.remaining > 0);
+  CHECK(status.backup_count == 0);
+  // note! written to a temporary file
+  CHECK(std::filesystem::exists(fmt::format("{}.tmp"sv, std::string_view{target})));
+  CHECK(!std::filesystem::exists(std::string_view{target}));
+  // note! inserted by the writer while the backup is running => also copied
+  std::vector<database::Trade> more{create_trade(START_TIME + count * 1s, ids[count])};
+  (*session)(std::span<database::Trade const>{more});
+  refresh();
+  REQUIRE(status.running);
+  CHECK(!(*session)(database::Backup{.filename = target}));
+  while (status.running) {
+    std::this_thread::sleep_for(1ms);
+    refresh();
+  }
+  CHECK(status.backup_count == 1);
+  CHECK(status.remaining == 0);
+  CHECK(status.page_count > 0);
+  CHECK(status.duration.count() > 0);
+  CHECK(std::empty(error));
+  // note! renamed when completed
+  CHECK(!std::filesystem::exists(fmt::format("{}.tmp"sv, std::string_view{target})));
+  Session backup{target};
+  CHECK(backup.get_trade_count("A1"sv) == count + 1);
+  // note! the next backup may start
+  CHECK((*session)(database::Backup{.filename = target}));
+}
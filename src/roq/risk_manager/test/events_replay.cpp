@@ -0,0 +1,88 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "roq/risk_manager/events/reader.hpp"
+#include "roq/risk_manager/events/recorder.hpp"
+
+using namespace std::literals;
+
+using namespace roq;
+using namespace roq::risk_manager;
+
+namespace {
+struct Handler final : public client::Handler {
+  void operator()(Event<Timer> const &event) override { now = event.value.now; }
+  void operator()(Event<Ready> const &event) override { source = event.message_info.source; }
+  void operator()(Event<TradeUpdate> const &event) override {
+    auto &[message_info, trade_update] = event;
+    seqno = message_info.source_seqno;
+    receive_time = message_info.receive_time;
+    account = trade_update.account;
+    side = trade_update.side;
+    create_time_utc = trade_update.create_time_utc;
+    for (auto &fill : trade_update.fills)
+      external_trade_ids.emplace_back(fill.external_trade_id);
+    quantity = trade_update.fills[1].quantity;
+  }
+
+  std::chrono::nanoseconds now = {};
+  uint8_t source = {};
+  uint64_t seqno = {};
+  std::chrono::nanoseconds receive_time = {};
+  std::string account;
+  Side side = {};
+  std::chrono::nanoseconds create_time_utc = {};
+  std::vector<std::string> external_trade_ids;
+  double quantity = NaN;
+};
+}  // namespace
+
+TEST_CASE("events_replay_round_trip", "[events_replay]") {
+  auto path = (std::filesystem::temp_directory_path() / "roq-risk-manager-events.bin").string();
+  {
+    events::Recorder recorder{path, 2};
+    auto message_info = MessageInfo{};
+    message_info.source = 1;
+    recorder(Event<Ready>{message_info, {}});
+    message_info.source_seqno = 123;
+    message_info.receive_time = 456ns;
+    Fill fills[2];
+    fills[0].external_trade_id = "T1"sv;
+    fills[0].quantity = 1.0;
+    fills[1].external_trade_id = "T2"sv;
+    fills[1].quantity = 2.0;
+    TradeUpdate trade_update;
+    trade_update.account = "A1"sv;
+    trade_update.side = Side::SELL;
+    trade_update.create_time_utc = 1685248384123000000ns;
+    trade_update.fills = fills;
+    recorder(Event<TradeUpdate>{message_info, trade_update});
+    Timer timer;
+    timer.now = 789ns;
+    recorder(Event<Timer>{message_info, timer});
+  }
+  events::Reader reader{path};
+  CHECK(reader.get_source_count() == 2);
+  Handler handler;
+  size_t count = 0;
+  while (reader.next()) {
+    reader.dispatch(handler);
+    ++count;
+  }
+  CHECK(count == 3);
+  CHECK(handler.source == 1);
+  CHECK(handler.seqno == 123);
+  CHECK(handler.receive_time == 456ns);
+  CHECK(handler.account == "A1"sv);
+  CHECK(handler.side == Side::SELL);
+  CHECK(handler.create_time_utc == 1685248384123000000ns);
+  CHECK(handler.external_trade_ids == std::vector<std::string>{"T1", "T2"});
+  CHECK(handler.quantity == 2.0);
+  CHECK(handler.now == 789ns);
+  std::filesystem::remove(path);
+}
@@ -0,0 +1,43 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include <chrono>
+#include <string_view>
+
+#include "roq/risk_manager/database/trade.hpp"
+
+namespace roq {
+namespace risk_manager {
+namespace test {
+
+// note! only what matters to a test is specified, everything else is a fill of "trader" (strategy 1) on deribit
+
+struct TradeOptions final {
+  std::string_view account = "A1";
+  std::string_view symbol = "BTC-PERPETUAL";
+  double price = 27193.0;
+  std::chrono::nanoseconds exchange_time_utc = std::chrono::nanoseconds{1685248384123000000};
+  std::string_view external_trade_id = "1";
+};
+
+inline database::Trade create_trade(TradeOptions const &options = {}) {
+  return database::Trade{
+      .user = "trader",
+      .strategy_id = 1,
+      .account = options.account,
+      .exchange = "deribit",
+      .symbol = options.symbol,
+      .side = Side::BUY,
+      .quantity = 1.0,
+      .price = options.price,
+      .exchange_time_utc = options.exchange_time_utc,
+      .external_account = {},
+      .external_order_id = {},
+      .external_trade_id = options.external_trade_id,
+  };
+}
+
+}  // namespace test
+}  // namespace risk_manager
+}  // namespace roq
@@ -0,0 +1,100 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <string>
+
+#include "roq/risk_manager/importer/parser.hpp"
+
+using namespace std::literals;
+
+using namespace roq;
+using namespace roq::risk_manager;
+
+namespace {
+auto const CSV_HEADER = "account,exchange,symbol,side,quantity,price,exchange_time_utc,external_trade_id,reason"sv;
+}  // namespace
+
+TEST_CASE("importer_parser_csv", "[importer_parser]") {
+  importer::Parser parser{importer::Format::CSV, CSV_HEADER};
+  auto batch = parser(
+      "A1,deribit,BTC-PERPETUAL,BUY,1,100.5,1000,T1,\r\n"
+      "\n"
+      "A1,deribit,\"BTC-\"\"X\"\"\",SELL,2,99,2000,\"T,2\",\n"
+      "A1,deribit,BTC-PERPETUAL,BUY,3,98,,,fix\n"s);
+  REQUIRE(std::size((*batch).trades) == 2);
+  auto &trade_1 = (*batch).trades[0];
+  CHECK(trade_1.account == "A1"sv);
+  CHECK(trade_1.exchange == "deribit"sv);
+  CHECK(trade_1.symbol == "BTC-PERPETUAL"sv);
+  CHECK(trade_1.side == Side::BUY);
+  CHECK(trade_1.quantity == 1.0);
+  CHECK(trade_1.price == 100.5);
+  CHECK(trade_1.exchange_time_utc == 1000ns);
+  CHECK(trade_1.external_trade_id == "T1"sv);
+  // note! quoted (escaped quotes and separator)
+  auto &trade_2 = (*batch).trades[1];
+  CHECK(trade_2.symbol == R"(BTC-"X")"sv);
+  CHECK(trade_2.side == Side::SELL);
+  CHECK(trade_2.external_trade_id == "T,2"sv);
+  // note! a record with a reason is a correction (exchange_time_utc defaults to "now")
+  REQUIRE(std::size((*batch).corrections) == 1);
+  auto &correction = (*batch).corrections[0];
+  CHECK(correction.quantity == 3.0);
+  CHECK(correction.exchange_time_utc == 0ns);
+  CHECK(correction.reason == "fix"sv);
+}
+
+TEST_CASE("importer_parser_ndjson", "[importer_parser]") {
+  importer::Parser parser{importer::Format::NDJSON, {}};
+  auto batch = parser(
+      R"({"user":"trader","strategy_id":1,"account":"A1","exchange":"deribit","symbol":"BTC-PERPETUAL",)"
+      R"("side":"BUY","quantity":1.0,"price":100.0,"exchange_time_utc":1000,"external_trade_id":"T1"})"
+      "\n"
+      R"({"account":"A1","exchange":"deribit","symbol":"BTC-PERPETUAL","side":"SELL","quantity":"2",)"
+      R"("price":"99","reason":"fix","external_order_id":null})"
+      "\n"s);
+  REQUIRE(std::size((*batch).trades) == 1);
+  auto &trade = (*batch).trades[0];
+  CHECK(trade.user == "trader"sv);
+  CHECK(trade.strategy_id == 1);
+  CHECK(trade.quantity == 1.0);
+  CHECK(trade.exchange_time_utc == 1000ns);
+  CHECK(trade.external_trade_id == "T1"sv);
+  REQUIRE(std::size((*batch).corrections) == 1);
+  auto &correction = (*batch).corrections[0];
+  CHECK(correction.side == Side::SELL);
+  CHECK(correction.quantity == 2.0);
+  CHECK(correction.price == 99.0);
+  CHECK(correction.reason == "fix"sv);
+}
+
+TEST_CASE("importer_parser_malformed", "[importer_parser]") {
+  CHECK_THROWS(importer::Parser{importer::Format::CSV, "account,unknown"sv});
+  importer::Parser csv{importer::Format::CSV, CSV_HEADER};
+  // note! too few fields
+  CHECK_THROWS(csv("A1,deribit,BTC-PERPETUAL,BUY,1,100,1000,T1\n"s));
+  // note! too many fields
+  CHECK_THROWS(csv("A1,deribit,BTC-PERPETUAL,BUY,1,100,1000,T1,,\n"s));
+  // note! missing closing quote
+  CHECK_THROWS(csv("A1,deribit,\"BTC-PERPETUAL,BUY,1,100,1000,T1,\n"s));
+  // note! not a number
+  CHECK_THROWS(csv("A1,deribit,BTC-PERPETUAL,BUY,1x,100,1000,T1,\n"s));
+  // note! unknown side
+  CHECK_THROWS(csv("A1,deribit,BTC-PERPETUAL,HOLD,1,100,1000,T1,\n"s));
+  // note! missing price
+  CHECK_THROWS(csv("A1,deribit,BTC-PERPETUAL,BUY,1,,1000,T1,\n"s));
+  // note! trades require exchange_time_utc
+  CHECK_THROWS(csv("A1,deribit,BTC-PERPETUAL,BUY,1,100,,T1,\n"s));
+  // note! account is required
+  CHECK_THROWS(csv(",deribit,BTC-PERPETUAL,BUY,1,100,1000,T1,\n"s));
+  importer::Parser ndjson{importer::Format::NDJSON, {}};
+  CHECK_THROWS(ndjson("{\n"s));
+  CHECK_THROWS(ndjson("[]\n"s));
+  CHECK_THROWS(ndjson(R"({"unknown":1})"
+                      "\n"s));
+  CHECK_THROWS(ndjson(R"({"account":1,"exchange":"deribit","symbol":"X","side":"BUY","quantity":1,"price":1})"
+                      "\n"s));
+  CHECK_THROWS(ndjson(R"({"account":"A1","exchange":"deribit","symbol":"X","side":"BUY","quantity":[1],"price":1})"
+                      "\n"s));
+}
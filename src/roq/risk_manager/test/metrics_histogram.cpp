@@ -0,0 +1,57 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <string>
+
+#include "roq/risk_manager/metrics/metrics.hpp"
+
+using namespace std::literals;
+
+using namespace roq::risk_manager;
+
+TEST_CASE("metrics_histogram_buckets", "[metrics_histogram]") {
+  using metrics::Histogram;
+  // note! buckets must be contiguous and each value must be covered by its own bucket
+  for (uint64_t value = 0; value < 100000; ++value) {
+    auto index = Histogram::get_index(value);
+    CHECK(value <= Histogram::get_upper_bound(index));
+    if (index > 0)
+      CHECK(value > Histogram::get_upper_bound(index - 1));
+  }
+  CHECK(Histogram::get_index(UINT64_MAX) == Histogram::SIZE - 1);
+  CHECK(Histogram::get_upper_bound(Histogram::SIZE - 1) == UINT64_MAX);
+  CHECK(Histogram::get_upper_bound(Histogram::get_index(1000)) == 1023);
+}
+
+TEST_CASE("metrics_histogram_record", "[metrics_histogram]") {
+  metrics::Histogram histogram;
+  histogram(5);
+  histogram(5);
+  histogram(1000ns);
+  histogram(-1ns);  // note! clamped
+  CHECK(histogram.get_sum() == 1010);
+  uint64_t total = 0;
+  auto callback = [&](uint64_t upper_bound, uint64_t count) {
+    if (upper_bound == 5)
+      CHECK(count == 2);
+    total += count;
+  };
+  histogram.get_buckets(callback);
+  CHECK(total == 4);
+}
+
+TEST_CASE("metrics_encode", "[metrics_histogram]") {
+  metrics::Metrics metrics{2};
+  metrics.fills += 3;
+  metrics.trade_update_latency(1500ns);
+  ++metrics[metrics::Route::GET_ACCOUNTS].count;
+  std::string result;
+  metrics.encode(result, 7);
+  CHECK(result.find("roq_risk_manager_fills_total 3\n"sv) != result.npos);
+  CHECK(result.find("roq_risk_manager_trades_duplicate_total 7\n"sv) != result.npos);
+  CHECK(result.find(R"(roq_risk_manager_trade_update_seconds_bucket{le="1.535e-06"} 1)"sv) != result.npos);
+  CHECK(result.find(R"(roq_risk_manager_trade_update_seconds_bucket{le="+Inf"} 1)"sv) != result.npos);
+  CHECK(result.find(R"(roq_risk_manager_risk_limits_messages_total{source="1"} 0)"sv) != result.npos);
+  CHECK(result.find(R"(roq_risk_manager_control_requests_total{method="GET",path="/accounts"} 1)"sv) != result.npos);
+}
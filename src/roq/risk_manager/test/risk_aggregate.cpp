@@ -0,0 +1,57 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "roq/exceptions.hpp"
+
+#include "roq/risk_manager/risk/aggregate.hpp"
+
+using namespace std::literals;
+
+using namespace roq;
+using namespace roq::risk_manager;
+
+TEST_CASE("risk_aggregate_match", "[risk_aggregate]") {
+  auto group = risk::Group{
+      .exchange = {},
+      .symbol = "BTC-.*",
+      .underlying = {},
+      .base_currency = "BTC",
+  };
+  risk::Aggregate aggregate{"BTC"sv, group};
+  ReferenceData reference_data;
+  reference_data.exchange = "deribit"sv;
+  reference_data.symbol = "BTC-PERPETUAL"sv;
+  reference_data.base_currency = "BTC"sv;
+  CHECK(aggregate(reference_data));
+  reference_data.base_currency = "USD"sv;
+  CHECK(!aggregate(reference_data));
+  reference_data.symbol = "ETH-PERPETUAL"sv;
+  reference_data.base_currency = "BTC"sv;
+  CHECK(!aggregate(reference_data));
+  group.underlying = "BTC-(";
+  CHECK_THROWS_AS(risk::Aggregate::validate(group), RuntimeError);
+}
+
+TEST_CASE("risk_aggregate_breach", "[risk_aggregate]") {
+  auto group = risk::Group{
+      .exchange = {},
+      .symbol = "BTC-.*",
+      .underlying = {},
+      .base_currency = {},
+      .long_position_limit = 10.0,
+  };
+  risk::Aggregate aggregate{"BTC"sv, group};
+  risk::Aggregate::State state;
+  CHECK(!aggregate(state, 6.0));
+  CHECK(aggregate(state, 4.0));  // note! the limit has been reached
+  CHECK(state.breach.long_position);
+  CHECK(!state.breach.short_position);  // note! no limit
+  CHECK(!aggregate(state, 1.0));
+  CHECK(aggregate(state, -2.0));
+  CHECK(!state.breach.long_position);
+  CHECK(!aggregate(state, -100.0));
+  aggregate.short_position_limit = 50.0;
+  CHECK(aggregate(state));
+  CHECK(state.breach.short_position);
+}
@@ -0,0 +1,42 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <cmath>
+
+#include "roq/risk_manager/risk/capacity.hpp"
+
+using namespace std::literals;
+
+using namespace roq;
+using namespace roq::risk_manager;
+
+TEST_CASE("risk_capacity_simple", "[risk_capacity]") {
+  risk::Capacity capacity{risk::FundsLimit{.currency = "USD", .leverage = 2.0}};
+  CHECK(std::isnan(capacity.get_position_limit(100.0, 1.0)));  // note! no funds
+  CHECK(!capacity("BTC"sv, 1.0, 0.0));
+  CHECK(capacity("USD"sv, 1000.0, 200.0));
+  CHECK(capacity.get_capacity() == 1600.0);
+  CHECK(!capacity("USD"sv, 1100.0, 300.0));  // note! same capacity
+  CHECK(capacity.get_position_limit(100.0, 2.0) == 8.0);
+  CHECK(std::isnan(capacity.get_position_limit(std::nan(""), 1.0)));  // note! no price
+  CHECK(capacity("USD"sv, 100.0, 200.0));
+  CHECK(capacity.get_position_limit(100.0, 1.0) == 0.0);
+}
+
+TEST_CASE("risk_capacity_change", "[risk_capacity]") {
+  risk::Capacity capacity{risk::FundsLimit{.currency = "USD", .leverage = 2.0}};
+  CHECK(capacity("USD"sv, 1000.0, std::nan("")));
+  CHECK(capacity.get_capacity() == 2000.0);
+  CHECK(capacity(risk::FundsLimit{.currency = "USD", .leverage = 3.0}));
+  CHECK(capacity.get_capacity() == 3000.0);
+  CHECK(capacity(risk::FundsLimit{.currency = "USDT", .leverage = 3.0}));
+  CHECK(std::isnan(capacity.get_capacity()));
+}
+
+TEST_CASE("risk_capacity_validate", "[risk_capacity]") {
+  CHECK_NOTHROW(risk::Capacity::validate(risk::FundsLimit{.currency = "USD", .leverage = 1.0}));
+  CHECK_THROWS(risk::Capacity::validate(risk::FundsLimit{.leverage = 1.0}));
+  CHECK_THROWS(risk::Capacity::validate(risk::FundsLimit{.currency = "USD"}));
+  CHECK_THROWS(risk::Capacity::validate(risk::FundsLimit{.currency = "USD", .leverage = 0.0}));
+}
@@ -0,0 +1,49 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "roq/risk_manager/risk/drawdown.hpp"
+
+using namespace std::literals;
+
+using namespace roq;
+using namespace roq::risk_manager;
+
+TEST_CASE("risk_drawdown_peak", "[risk_drawdown]") {
+  risk::Drawdown drawdown{risk::LossLimit{.max_drawdown = 100.0}};
+  CHECK(!drawdown(50.0));
+  CHECK(!drawdown(200.0));
+  CHECK(drawdown.peak == 200.0);
+  CHECK(!drawdown(101.0));
+  CHECK(drawdown(100.0));
+  CHECK(drawdown.breach);
+  // note! latched
+  CHECK(!drawdown(300.0));
+  CHECK(drawdown.breach);
+}
+
+TEST_CASE("risk_drawdown_daily_loss", "[risk_drawdown]") {
+  auto day = std::chrono::nanoseconds{std::chrono::days{1}};
+  risk::Drawdown drawdown{risk::LossLimit{.max_daily_loss = 10.0, .reset_time = 8h}};
+  CHECK(!drawdown(5.0));
+  CHECK(!drawdown(day + 1h));  // note! initial
+  CHECK(drawdown.next_reset == day + 8h);
+  CHECK(drawdown.start == 5.0);
+  CHECK(!drawdown(-4.0));
+  CHECK(drawdown(-5.0));
+  CHECK(!drawdown(day + 7h));
+  CHECK(drawdown.breach);
+  CHECK(drawdown(day + 8h));
+  CHECK(!drawdown.breach);
+  CHECK(drawdown.next_reset == 2 * day + 8h);
+  CHECK(drawdown.start == -5.0);
+  CHECK(!drawdown(-14.0));
+  CHECK(drawdown(-15.0));
+}
+
+TEST_CASE("risk_drawdown_validate", "[risk_drawdown]") {
+  CHECK_NOTHROW(risk::Drawdown::validate(risk::LossLimit{.max_drawdown = 1.0}));
+  CHECK_THROWS(risk::Drawdown::validate(risk::LossLimit{.max_drawdown = 0.0}));
+  CHECK_THROWS(risk::Drawdown::validate(risk::LossLimit{.max_daily_loss = -1.0}));
+  CHECK_THROWS(risk::Drawdown::validate(risk::LossLimit{.reset_time = 24h}));
+}
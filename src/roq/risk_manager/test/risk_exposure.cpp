@@ -0,0 +1,48 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <cmath>
+
+#include "roq/risk_manager/risk/exposure.hpp"
+
+using namespace std::literals;
+
+using namespace roq;
+using namespace roq::risk_manager;
+
+TEST_CASE("risk_exposure_reprice", "[risk_exposure]") {
+  risk::Exposure exposure;
+  auto bucket = exposure.create_bucket();
+  auto slot_1 = exposure.create_slot(1);
+  auto slot_2 = exposure.create_slot(2);
+  exposure.set_buckets(slot_1, {&bucket, 1});
+  exposure.set_buckets(slot_2, {&bucket, 1});
+  exposure.set_multiplier(2, 10.0);
+  exposure(slot_1, 2.0);
+  exposure(slot_2, -1.0);
+  CHECK(!exposure.set_price(1, 100.0));
+  CHECK(exposure.set_price(1, 101.0));  // note! conflated
+  CHECK(exposure.reprice() == 1);
+  CHECK(exposure.get_notional(slot_1) == 202.0);
+  CHECK(std::isnan(exposure.get_notional(slot_2)));  // note! no price
+  CHECK(exposure.get_bucket(bucket) == 202.0);
+  CHECK(!exposure.set_price(2, 5.0));
+  CHECK(exposure.reprice() == 1);
+  CHECK(exposure.get_notional(slot_2) == -50.0);
+  CHECK(exposure.get_bucket(bucket) == 152.0);
+  exposure(slot_1, -2.0);
+  CHECK(exposure.reprice() == 0);
+  CHECK(exposure.get_bucket(bucket) == -50.0);
+}
+
+TEST_CASE("risk_exposure_new_slot", "[risk_exposure]") {
+  risk::Exposure exposure;
+  exposure.set_price(1, 100.0);
+  exposure.reprice();
+  auto slot = exposure.create_slot(1);  // note! uses the last price
+  exposure(slot, 3.0);
+  CHECK(std::isnan(exposure.get_notional(slot)));  // note! until repriced
+  exposure.reprice();
+  CHECK(exposure.get_notional(slot) == 300.0);
+}
@@ -0,0 +1,50 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <vector>
+
+#include "roq/exceptions.hpp"
+
+#include "roq/risk_manager/risk/pattern.hpp"
+
+using namespace std::literals;
+
+using namespace roq::risk_manager;
+
+TEST_CASE("risk_pattern_match", "[risk_pattern]") {
+  CHECK(risk::Pattern::is_pattern("*"sv, "BTC-PERPETUAL"sv));
+  CHECK(risk::Pattern::is_pattern("deribit"sv, "*"sv));
+  CHECK(risk::Pattern::is_pattern("deribit"sv, "^BTC-.*"sv));
+  CHECK(!risk::Pattern::is_pattern("deribit"sv, "BTC-PERPETUAL"sv));
+  risk::Pattern pattern{"deribit"sv, "^BTC-.*"sv, {}};
+  CHECK(pattern("deribit"sv, "BTC-27DEC24"sv));
+  CHECK(!pattern("deribit"sv, "ETH-27DEC24"sv));
+  CHECK(!pattern("bitmex"sv, "BTC-27DEC24"sv));
+  CHECK(!pattern("deribit"sv, "XBTC-27DEC24"sv));  // note! full match
+  risk::Pattern any{"*"sv, "*"sv, {}};
+  CHECK(any("bitmex"sv, "XBTUSD"sv));
+  CHECK_THROWS_AS(risk::Pattern::validate("^BTC-("sv), roq::RuntimeError);
+}
+
+TEST_CASE("risk_pattern_order", "[risk_pattern]") {
+  std::vector<risk::Pattern> patterns;
+  patterns.emplace_back("*"sv, "*"sv, risk::Limit{.long_position_limit = 1.0});
+  patterns.emplace_back("deribit"sv, "*"sv, risk::Limit{.long_position_limit = 2.0});
+  patterns.emplace_back("deribit"sv, "^BTC-.*"sv, risk::Limit{.long_position_limit = 3.0});
+  patterns.emplace_back("deribit"sv, "^BTC-27DEC24.*"sv, risk::Limit{.long_position_limit = 4.0});
+  patterns.emplace_back("*"sv, "^BTC-.*"sv, risk::Limit{.long_position_limit = 5.0});
+  std::sort(std::begin(patterns), std::end(patterns));
+  auto resolve = [&](auto const &exchange, auto const &symbol) {
+    for (auto &pattern : patterns)
+      if (pattern(exchange, symbol))
+        return pattern.limit.long_position_limit;
+    return 0.0;
+  };
+  CHECK(resolve("deribit"sv, "BTC-27DEC24-50000-C"sv) == 4.0);
+  CHECK(resolve("deribit"sv, "BTC-PERPETUAL"sv) == 3.0);
+  CHECK(resolve("deribit"sv, "ETH-PERPETUAL"sv) == 2.0);
+  CHECK(resolve("bitmex"sv, "BTC-PERPETUAL"sv) == 5.0);
+  CHECK(resolve("bitmex"sv, "XBTUSD"sv) == 1.0);
+}
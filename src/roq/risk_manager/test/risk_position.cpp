@@ -0,0 +1,111 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <cmath>
+
+#include "roq/risk_manager/risk/instrument.hpp"
+#include "roq/risk_manager/risk/position.hpp"
+
+using namespace std::literals;
+
+using namespace roq;
+using namespace roq::risk_manager;
+
+namespace {
+void fill(auto &position, auto &instrument, Side side, double quantity, double price, std::string_view const &id) {
+  Fill fill;
+  fill.external_trade_id = id;
+  fill.quantity = quantity;
+  fill.price = price;
+  fill.commission_amount = 0.5;
+  TradeUpdate trade_update;
+  trade_update.exchange = instrument.exchange;
+  trade_update.symbol = instrument.symbol;
+  trade_update.side = side;
+  trade_update.fills = {&fill, 1};
+  position(trade_update, instrument);
+}
+}  // namespace
+
+TEST_CASE("risk_position_pnl", "[risk_position]") {
+  risk::Instrument instrument{1, "deribit"sv, "BTC-PERPETUAL"sv};
+  risk::Position position{risk::Limit{}};
+  fill(position, instrument, Side::BUY, 1.0, 100.0, "1"sv);
+  fill(position, instrument, Side::BUY, 3.0, 200.0, "2"sv);
+  auto pnl = position.get_pnl(instrument, 200.0);
+  CHECK(pnl.average_price == 175.0);
+  CHECK(pnl.realized == 0.0);
+  CHECK(pnl.unrealized == 100.0);
+  CHECK(pnl.fees == 1.0);
+  fill(position, instrument, Side::BUY, 3.0, 200.0, "2"sv);  // note! duplicate
+  fill(position, instrument, Side::SELL, 2.0, 225.0, "3"sv);
+  pnl = position.get_pnl(instrument, 225.0);
+  CHECK(pnl.average_price == 175.0);
+  CHECK(pnl.realized == 100.0);
+  CHECK(pnl.unrealized == 100.0);
+  // note! crossing zero
+  fill(position, instrument, Side::SELL, 3.0, 150.0, "4"sv);
+  pnl = position.get_pnl(instrument, 140.0);
+  CHECK(position.quantity() == -1.0);
+  CHECK(pnl.average_price == 150.0);
+  CHECK(pnl.realized == 50.0);
+  CHECK(pnl.unrealized == 10.0);
+  CHECK(pnl.fees == 2.0);
+  fill(position, instrument, Side::BUY, 1.0, 160.0, "5"sv);
+  pnl = position.get_pnl(instrument, NaN);
+  CHECK(std::isnan(pnl.average_price));
+  CHECK(pnl.realized == 40.0);
+  CHECK(pnl.unrealized == 0.0);  // note! flat
+}
+
+TEST_CASE("risk_position_pnl_loaded", "[risk_position]") {
+  risk::Instrument instrument{1, "deribit"sv, "BTC-PERPETUAL"sv};
+  risk::Position position{risk::Limit{}};
+  auto loaded = database::Position{
+      .user = {},
+      .strategy_id = {},
+      .account = "A1"sv,
+      .exchange = instrument.exchange,
+      .symbol = instrument.symbol,
+      .long_quantity = 2.0,
+      .short_quantity = 0.0,
+      .exchange_time_utc = {},
+  };
+  position(loaded, instrument);
+  CHECK(std::isnan(position.get_pnl(instrument, 100.0).unrealized));
+  position.mark(100.0);
+  position.mark(110.0);  // note! only the first mark
+  auto pnl = position.get_pnl(instrument, 110.0);
+  CHECK(pnl.average_price == 100.0);
+  CHECK(pnl.unrealized == 20.0);
+}
+
+TEST_CASE("risk_position_pnl_persisted", "[risk_position]") {
+  risk::Instrument instrument{1, "deribit"sv, "BTC-PERPETUAL"sv};
+  risk::Position position{risk::Limit{}};
+  auto loaded = database::Position{
+      .user = {},
+      .strategy_id = {},
+      .account = "A1"sv,
+      .exchange = instrument.exchange,
+      .symbol = instrument.symbol,
+      .long_quantity = 2.0,
+      .short_quantity = 0.0,
+      .exchange_time_utc = {},
+      .average_price = 90.0,
+      .realized_pnl = 30.0,
+      .fees = 1.5,
+  };
+  position(loaded, instrument);
+  position.mark(100.0);  // note! the persisted average price is kept
+  auto pnl = position.get_pnl(instrument, 110.0);
+  CHECK(pnl.average_price == 90.0);
+  CHECK(pnl.realized == 30.0);
+  CHECK(pnl.unrealized == 40.0);
+  CHECK(pnl.fees == 1.5);
+  fill(position, instrument, Side::SELL, 2.0, 100.0, "1"sv);
+  pnl = position.get_pnl(instrument, 110.0);
+  CHECK(pnl.realized == 50.0);
+  CHECK(pnl.fees == 2.0);
+}
@@ -0,0 +1,134 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <array>
+
+#include "roq/risk_manager/risk/account.hpp"
+#include "roq/risk_manager/risk/velocity.hpp"
+#include "roq/risk_manager/risk/window.hpp"
+
+using namespace std::literals;
+
+using namespace roq;
+using namespace roq::risk_manager;
+
+namespace {
+auto trade(auto &velocity, auto &instrument, std::chrono::nanoseconds now, std::string_view const &order_id) {
+  Fill fill;
+  fill.quantity = 1.0;
+  fill.price = 100.0;
+  TradeUpdate trade_update;
+  trade_update.exchange = instrument.exchange;
+  trade_update.symbol = instrument.symbol;
+  trade_update.external_order_id = order_id;
+  trade_update.fills = {&fill, 1};
+  auto change = risk::Change{
+      .fill_count = 1,
+      .notional = fill.quantity * fill.price * instrument.multiplier(),
+  };
+  return velocity(trade_update, change, now);
+}
+
+struct Handler final : public risk::Account::Handler {
+  void publish_account(std::string_view const &, uint32_t) override {}
+  void aggregate_account(std::string_view const &, uint32_t, risk::Change const &) override {}
+  void throttle_account(std::string_view const &) override { ++throttle_count; }
+  risk::Instrument &get_instrument(std::string_view const &, std::string_view const &) override { return instrument; }
+  risk::Limit get_limit_by_account(std::string_view const &, std::string_view const &, std::string_view const &)
+      const override {
+    return {};
+  }
+
+  risk::Instrument instrument{1, "deribit"sv, "BTC-PERPETUAL"sv};
+  size_t throttle_count = {};
+};
+}  // namespace
+
+TEST_CASE("risk_window_simple", "[risk_window]") {
+  risk::Window window{1s};
+  CHECK(window(1000ms, 1.0) == 1.0);
+  CHECK(window(1050ms, 1.0) == 2.0);
+  CHECK(window(1500ms, 1.0) == 3.0);
+  CHECK(window.get(2000ms) == 1.0);  // note! first bucket has expired
+  CHECK(window.get(2500ms) == 0.0);
+  CHECK(window(2400ms, 1.0) == 1.0);  // note! time going backwards
+  CHECK(window.get(10s) == 0.0);
+}
+
+TEST_CASE("risk_velocity_fills", "[risk_velocity]") {
+  risk::Instrument instrument{1, "deribit"sv, "BTC-PERPETUAL"sv};
+  risk::Velocity velocity;
+  CHECK(!trade(velocity, instrument, 1s, "1"sv));  // note! disabled
+  CHECK(!velocity(risk::RateLimit{.max_fills_per_second = 2.0}));
+  CHECK(!trade(velocity, instrument, 1100ms, "1"sv));
+  CHECK(!trade(velocity, instrument, 1200ms, "1"sv));
+  CHECK(trade(velocity, instrument, 1300ms, "1"sv));
+  CHECK(velocity.get_breach());
+  CHECK(!trade(velocity, instrument, 1400ms, "1"sv));
+  CHECK(!velocity(1900ms));
+  CHECK(velocity(2300ms));
+  CHECK(!velocity.get_breach());
+}
+
+TEST_CASE("risk_velocity_orders", "[risk_velocity]") {
+  risk::Instrument instrument{1, "deribit"sv, "BTC-PERPETUAL"sv};
+  risk::Velocity velocity;
+  CHECK(!velocity(risk::RateLimit{.max_notional_per_minute = 1000.0, .max_orders_per_minute = 2.0}));
+  CHECK(!trade(velocity, instrument, 1s, "1"sv));
+  CHECK(!trade(velocity, instrument, 2s, "1"sv));
+  CHECK(!trade(velocity, instrument, 3s, "2"sv));
+  CHECK(trade(velocity, instrument, 4s, "3"sv));
+  CHECK(!velocity(30s));
+  CHECK(velocity(70s));
+  // note! removing the limit clears the breach
+  CHECK(!trade(velocity, instrument, 71s, "4"sv));
+  CHECK(!trade(velocity, instrument, 72s, "5"sv));
+  CHECK(trade(velocity, instrument, 73s, "6"sv));
+  CHECK(velocity(risk::RateLimit{}));
+  CHECK(!velocity.get_breach());
+}
+
+// note! e.g. the gateway re-downloads trades after a reconnect
+TEST_CASE("risk_velocity_replay", "[risk_velocity]") {
+  Handler handler;
+  risk::Account account{"A1"sv, handler};
+  CHECK(!account(risk::RateLimit{.max_fills_per_second = 2.0, .max_orders_per_minute = 1.0}));
+  std::array<Fill, 3> fills;
+  for (size_t i = 0; i < std::size(fills); ++i) {
+    fills[i].external_trade_id = std::array{"1"sv, "2"sv, "3"sv}[i];
+    fills[i].quantity = 1.0;
+    fills[i].price = 100.0;
+  }
+  TradeUpdate trade_update;
+  trade_update.exchange = handler.instrument.exchange;
+  trade_update.symbol = handler.instrument.symbol;
+  trade_update.side = Side::BUY;
+  trade_update.external_order_id = "1"sv;
+  trade_update.fills = {std::data(fills), 2};
+  account(trade_update, 1s);
+  CHECK(!account.get_breach());
+  // note! replayed => neither fills nor orders are counted
+  account(trade_update, 1100ms);
+  trade_update.external_order_id = "2"sv;
+  account(trade_update, 1100ms);
+  CHECK(!account.get_breach());
+  CHECK(handler.throttle_count == 0);
+  // note! only the last fill is new
+  trade_update.fills = {std::data(fills), 3};
+  account(trade_update, 1200ms);
+  CHECK(account.get_breach());
+  CHECK(handler.throttle_count == 1);
+  account.get_position(handler.instrument.id, [](auto &position) { CHECK(position.quantity() == 3.0); });
+}
+
+// note! a delayed fill (exchange time) is counted when received, i.e. the same clock as used for expiry
+TEST_CASE("risk_velocity_clock", "[risk_velocity]") {
+  risk::Instrument instrument{1, "deribit"sv, "BTC-PERPETUAL"sv};
+  risk::Velocity velocity;
+  CHECK(!velocity(risk::RateLimit{.max_fills_per_second = 1.0}));
+  CHECK(!trade(velocity, instrument, 1000s, "1"sv));
+  CHECK(trade(velocity, instrument, 1000s + 100ms, "1"sv));
+  CHECK(!velocity(1000s + 500ms));
+  CHECK(velocity(1002s));
+}
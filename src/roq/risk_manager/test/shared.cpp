@@ -0,0 +1,240 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "roq/risk_manager/config.hpp"
+#include "roq/risk_manager/shared.hpp"
+
+using namespace std::literals;
+
+using namespace roq;
+using namespace roq::risk_manager;
+
+namespace {
+auto const CONFIG_1 = R"(
+symbols = ["^BTC-PERPETUAL$", "^ETH-PERPETUAL$"]
+
+[accounts.A1.deribit.BTC-PERPETUAL]
+long_position_limit = 10
+
+[accounts.A1.deribit.ETH-PERPETUAL]
+long_position_limit = 2
+)"sv;
+
+auto const CONFIG_2 = R"(
+symbols = ["^BTC-PERPETUAL$", "^ETH-PERPETUAL$"]
+
+[accounts.A1.deribit.BTC-PERPETUAL]
+long_position_limit = 20
+
+[accounts.A1.deribit.ETH-PERPETUAL]
+long_position_limit = 3
+)"sv;
+
+// note! BTC-PERPETUAL has been removed
+auto const CONFIG_3 = R"(
+symbols = ["^BTC-PERPETUAL$", "^ETH-PERPETUAL$"]
+
+[accounts.A1.deribit.ETH-PERPETUAL]
+long_position_limit = 3
+)"sv;
+
+// note! BTC-PERPETUAL is matched by a pattern
+auto const CONFIG_4 = R"(
+symbols = ["^BTC-PERPETUAL$", "^ETH-PERPETUAL$"]
+
+[accounts.A1.deribit."^BTC-.*"]
+long_position_limit = 7
+
+[accounts.A1.deribit.ETH-PERPETUAL]
+long_position_limit = 3
+)"sv;
+
+// note! loss limit
+auto const CONFIG_5 = R"(
+symbols = ["^BTC-PERPETUAL$"]
+
+[accounts.A1.deribit.BTC-PERPETUAL]
+long_position_limit = 10
+
+[loss_limits.accounts.A1]
+max_drawdown = 1000
+)"sv;
+
+void create_position(Shared &shared, std::string_view const &account, std::string_view const &symbol) {
+  auto position = database::Position{
+      .user = {},
+      .strategy_id = {},
+      .account = account,
+      .exchange = "deribit"sv,
+      .symbol = symbol,
+      .long_quantity = 1.0,
+      .short_quantity = 0.0,
+      .exchange_time_utc = {},
+  };
+  shared.get_account(account, [&](auto &item) { item(position); });
+}
+
+// note! symbol => long position limit (positions waiting to be published)
+auto get_published(Shared &shared, std::string_view const &account) {
+  std::map<std::string, double, std::less<>> result;
+  shared.get_publish_by_account(account, [&](auto const &risk_limit) {
+    result.insert_or_assign(std::string{risk_limit.symbol}, risk_limit.long_position_limit);
+  });
+  return result;
+}
+
+// note! all positions of the account
+auto get_long_position_limits(Shared &shared, std::string_view const &account) {
+  shared.publish_account(account);
+  return get_published(shared, account);
+}
+
+auto create_limit(std::string_view const &account, std::string_view const &symbol, double long_position_limit) {
+  return database::Limit{
+      .user = {},
+      .strategy_id = {},
+      .account = account,
+      .exchange = "deribit"sv,
+      .symbol = symbol,
+      .long_position_limit = long_position_limit,
+  };
+}
+}  // namespace
+
+TEST_CASE("shared_limits_database", "[shared]") {
+  auto config_1 = Config::parse_text(CONFIG_1);
+  Shared shared{config_1};
+  create_position(shared, "A1"sv, "BTC-PERPETUAL"sv);
+  create_position(shared, "A1"sv, "ETH-PERPETUAL"sv);
+  auto limits = get_long_position_limits(shared, "A1"sv);
+  CHECK(limits["BTC-PERPETUAL"] == 10.0);
+  CHECK(limits["ETH-PERPETUAL"] == 2.0);
+  std::vector<database::Limit> overrides{create_limit("A1"sv, "BTC-PERPETUAL"sv, 50.0)};
+  CHECK(shared(std::span<database::Limit const>{overrides}) == 1);
+  CHECK(shared(std::span<database::Limit const>{overrides}) == 0);
+  limits = get_long_position_limits(shared, "A1"sv);
+  CHECK(limits["BTC-PERPETUAL"] == 50.0);
+  CHECK(limits["ETH-PERPETUAL"] == 2.0);
+  // note! the database takes precedence over a reload
+  auto config_2 = Config::parse_text(CONFIG_2);
+  CHECK(shared(config_2) == 1);
+  limits = get_long_position_limits(shared, "A1"sv);
+  CHECK(limits["BTC-PERPETUAL"] == 50.0);
+  CHECK(limits["ETH-PERPETUAL"] == 3.0);
+  // note! also when the limit has been removed from the config
+  auto config_3 = Config::parse_text(CONFIG_3);
+  CHECK(shared(config_3) == 0);
+  limits = get_long_position_limits(shared, "A1"sv);
+  CHECK(limits["BTC-PERPETUAL"] == 50.0);
+  CHECK(limits["ETH-PERPETUAL"] == 3.0);
+}
+
+TEST_CASE("shared_reload", "[shared]") {
+  auto config_1 = Config::parse_text(CONFIG_1);
+  Shared shared{config_1};
+  create_position(shared, "A1"sv, "BTC-PERPETUAL"sv);
+  create_position(shared, "A1"sv, "ETH-PERPETUAL"sv);
+  CHECK(shared(config_1) == 0);
+  auto limits = get_long_position_limits(shared, "A1"sv);
+  CHECK(limits["BTC-PERPETUAL"] == 10.0);
+  CHECK(limits["ETH-PERPETUAL"] == 2.0);
+  // note! only changed limits are re-published
+  auto config_2 = Config::parse_text(CONFIG_2);
+  CHECK(shared(config_2) == 2);
+  limits = get_published(shared, "A1"sv);
+  CHECK(std::size(limits) == 2);
+  CHECK(limits["BTC-PERPETUAL"] == 20.0);
+  CHECK(limits["ETH-PERPETUAL"] == 3.0);
+  CHECK(shared(config_2) == 0);
+  CHECK(std::empty(get_published(shared, "A1"sv)));
+  // note! a removed limit means "no limit"
+  auto config_3 = Config::parse_text(CONFIG_3);
+  CHECK(shared(config_3) == 1);
+  limits = get_published(shared, "A1"sv);
+  CHECK(std::size(limits) == 1);
+  CHECK(std::isnan(limits["BTC-PERPETUAL"]));
+  // note! positions are resolved again (patterns)
+  auto config_4 = Config::parse_text(CONFIG_4);
+  CHECK(shared(config_4) == 1);
+  limits = get_published(shared, "A1"sv);
+  CHECK(std::size(limits) == 1);
+  CHECK(limits["BTC-PERPETUAL"] == 7.0);
+  // note! the pattern has been removed
+  CHECK(shared(config_1) == 3);
+  limits = get_long_position_limits(shared, "A1"sv);
+  CHECK(limits["BTC-PERPETUAL"] == 10.0);
+  CHECK(limits["ETH-PERPETUAL"] == 2.0);
+}
+
+TEST_CASE("shared_prices", "[shared]") {
+  auto config = Config::parse_text(CONFIG_1);
+  Shared shared{config};
+  create_position(shared, "A1"sv, "BTC-PERPETUAL"sv);
+  TopOfBook top_of_book;
+  top_of_book.exchange = "deribit"sv;
+  top_of_book.symbol = "BTC-PERPETUAL"sv;
+  top_of_book.layer = {
+      .bid_price = 99.0,
+      .bid_quantity = 1.0,
+      .ask_price = 101.0,
+      .ask_quantity = 1.0,
+  };
+  shared(top_of_book);
+  // note! the position loaded from the database has been marked by the first price
+  CHECK(shared.take_marked());
+  shared(top_of_book);
+  CHECK(!shared.take_marked());
+  CHECK(shared.reprice() == 1);
+  size_t count = 0;
+  shared.get_all_prices([&](auto, auto price, auto) {
+    ++count;
+    CHECK(price == 100.0);
+  });
+  CHECK(count == 1);
+  shared.get_all_positions([&](auto, auto const &, auto const &pnl) {
+    CHECK(pnl.average_price == 100.0);
+    CHECK(pnl.unrealized == 0.0);
+  });
+}
+
+TEST_CASE("shared_drawdowns", "[shared]") {
+  auto config = Config::parse_text(CONFIG_5);
+  Shared shared{config};
+  auto next_reset = std::chrono::nanoseconds{std::chrono::days{20000}};
+  auto drawdown = database::Drawdown{
+      .user = {},
+      .account = "A1"sv,
+      .peak = 100.0,
+      .start = 50.0,
+      .next_reset = next_reset,
+      .breach = true,
+  };
+  // note! restored before the positions are loaded
+  CHECK(shared(drawdown));
+  drawdown.account = "A2"sv;
+  CHECK(!shared(drawdown));
+  create_position(shared, "A1"sv, "BTC-PERPETUAL"sv);
+  auto limits = get_long_position_limits(shared, "A1"sv);
+  CHECK(limits["BTC-PERPETUAL"] == 1.0);  // note! reduce-only
+  std::vector<database::Drawdown> drawdowns;
+  shared.get_all_drawdowns([&](auto const &item) { drawdowns.emplace_back(item); });
+  REQUIRE(std::size(drawdowns) == 1);
+  CHECK(drawdowns[0].account == "A1"sv);
+  CHECK(drawdowns[0].peak == 100.0);
+  CHECK(drawdowns[0].start == 50.0);
+  CHECK(drawdowns[0].breach);
+  // note! not yet reset
+  shared.update_loss_limits(next_reset - std::chrono::nanoseconds{1});
+  CHECK(!shared.take_drawdowns_changed());
+  shared.update_loss_limits(next_reset);
+  CHECK(shared.take_drawdowns_changed());
+  limits = get_long_position_limits(shared, "A1"sv);
+  CHECK(limits["BTC-PERPETUAL"] == 10.0);
+}
@@ -0,0 +1,63 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#include "roq/risk_manager/trace/tracer.hpp"
+
+using namespace std::literals;
+
+using namespace roq;
+using namespace roq::risk_manager;
+
+namespace {
+auto create_message_info(uint8_t source, uint64_t seqno) {
+  MessageInfo message_info;
+  message_info.source = source;
+  message_info.source_seqno = seqno;
+  message_info.receive_time = std::chrono::nanoseconds{seqno * 1000};
+  return message_info;
+}
+
+auto get_value(std::string const &buffer, size_t offset) {
+  int64_t result = {};
+  std::memcpy(&result, std::data(buffer) + offset, sizeof(result));
+  return result;
+}
+}  // namespace
+
+TEST_CASE("trace_tracer_dump", "[trace_tracer]") {
+  auto path = (std::filesystem::temp_directory_path() / "roq-risk-manager-test-trace.bin").string();
+  {
+    trace::Tracer tracer{path, 2, {}, 2};
+    REQUIRE(tracer.enabled());
+    for (uint64_t seqno = 1; seqno <= 3; ++seqno) {
+      auto &record = tracer(trace::Type::TRADE_UPDATE, create_message_info(seqno == 3 ? 1 : 0, seqno));
+      record.engine_done = record.receive_time + 1ns;
+      record.database_enqueued = record.receive_time + 2ns;
+      record.database_committed = record.receive_time + 3ns;
+    }
+    tracer(uint8_t{0}, 10000ns);  // note! only source 0
+    tracer.request_dump();
+    tracer.refresh(20000ns);
+  }  // note! the file is written by the writer thread (joined by the destructor)
+  std::ifstream file{path, std::ios::binary};
+  std::string buffer{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+  REQUIRE(std::size(buffer) == 24 + 2 * trace::RECORD_SIZE);
+  CHECK(buffer.substr(0, 8) == trace::MAGIC);
+  CHECK(get_value(buffer, 16) == 2);  // note! capacity
+  // note! oldest first: seqno 2 (source 0, stamped), seqno 3 (source 1, pending)
+  size_t first = 24, second = first + trace::RECORD_SIZE;
+  CHECK(get_value(buffer, first + 16) == 2);
+  CHECK(get_value(buffer, first + 24) == 2000);
+  CHECK(get_value(buffer, first + 56) == 10000);
+  CHECK(get_value(buffer, second + 16) == 3);
+  CHECK(get_value(buffer, second + 56) == 0);
+  CHECK(static_cast<uint8_t>(buffer[second + 64]) == 1);
+  std::filesystem::remove(path);
+}
@@ -0,0 +1,222 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include "roq/risk_manager/trace/tracer.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#include "roq/exceptions.hpp"
+#include "roq/logging.hpp"
+
+using namespace std::literals;
+using namespace std::chrono_literals;
+
+namespace roq {
+namespace risk_manager {
+namespace trace {
+
+// === CONSTANTS ===
+
+namespace {
+auto const DUMP_FREQUENCY = 10s;  // note! only used to rate-limit dumps triggered by the slo
+
+auto const TEMPORARY_EXTENSION = ".tmp"sv;
+}  // namespace
+
+// === HELPERS ===
+
+namespace {
+static_assert(std::endian::native == std::endian::little, "values are written in native byte order");
+
+template <typename T>
+void put(std::string &buffer, T value) {
+  char tmp[sizeof(T)];
+  std::memcpy(tmp, &value, sizeof(T));
+  buffer.append(tmp, sizeof(T));
+}
+
+void put(std::string &buffer, std::chrono::nanoseconds value) {
+  put<int64_t>(buffer, value.count());
+}
+
+auto get_size(auto &path, auto capacity) -> size_t {
+  if (std::empty(path))
+    return 1;
+  return std::bit_ceil(std::max<size_t>(capacity, 1));
+}
+
+auto get_stage(auto end, auto begin) {
+  if (end.count() == 0 || begin.count() == 0)
+    return std::chrono::nanoseconds{};
+  return end - begin;
+}
+}  // namespace
+
+// === IMPLEMENTATION ===
+
+Tracer::Tracer(
+    std::string_view const &path, size_t capacity, std::chrono::nanoseconds latency_slo, size_t source_count)
+    : path_{path}, latency_slo_{latency_slo}, records_(get_size(path, capacity)), mask_{std::size(records_) - 1},
+      pending_(source_count), thread_{enabled() ? std::thread{[this]() { run(); }} : std::thread{}} {
+  {
+    std::lock_guard lock{mutex_};
+    dump_.reserve(std::size(records_));  // note! the engine thread never allocates when copying
+  }
+  if (enabled())
+    log::info(
+        R"(Latency trace has been enabled (capacity={}, latency_slo={}, file="{}"))"sv,
+        std::size(records_),
+        latency_slo_,
+        path_);
+}
+
+Tracer::~Tracer() {
+  {
+    std::lock_guard lock{mutex_};
+    stop_ = true;
+  }
+  condition_.notify_all();
+  if (thread_.joinable())
+    thread_.join();
+}
+
+Record &Tracer::operator()(Type type, MessageInfo const &message_info) {
+  auto &record = records_[count_ & mask_];
+  if (enabled())
+    ++count_;
+  static_assert(sizeof(message_info.source_session_id) == sizeof(record.session_id));
+  std::memcpy(std::data(record.session_id), &message_info.source_session_id, sizeof(record.session_id));
+  record.seqno = message_info.source_seqno;
+  // note! receive time is missing when events are injected (e.g. the simulator)
+  record.receive_time = message_info.receive_time.count() ? message_info.receive_time : clock::get_system();
+  record.engine_done = {};
+  record.database_enqueued = {};
+  record.database_committed = {};
+  record.risk_limits_sent = {};
+  record.source = message_info.source;
+  record.type = type;
+  return record;
+}
+
+void Tracer::operator()(uint8_t source, std::chrono::nanoseconds now) {
+  if (!enabled())
+    return;
+  auto &pending = pending_[source];
+  auto first = std::max(pending, count_ > std::size(records_) ? count_ - std::size(records_) : 0);
+  for (auto index = first; index < count_; ++index) {
+    auto &record = records_[index & mask_];
+    if (record.source != source || record.type != Type::TRADE_UPDATE)
+      continue;
+    if (record.database_enqueued.count() == 0 || record.risk_limits_sent.count() != 0)
+      continue;  // note! dropped (or already stamped)
+    record.risk_limits_sent = now;
+    if (latency_slo_.count() && !breached_ && (now - record.receive_time) > latency_slo_) {
+      breached_ = true;
+      breach_ = record;
+    }
+  }
+  pending = count_;
+}
+
+void Tracer::refresh(std::chrono::nanoseconds now) {
+  if (!enabled())
+    return;
+  if (dump_requested_.exchange(false, std::memory_order_acq_rel)) {
+    dump("requested"sv);
+    return;
+  }
+  if (!breached_ || now < next_dump_)
+    return;
+  log::warn(
+      "Latency SLO has been breached (source={}, seqno={}, engine={}, database={}, publish={}, total={})"sv,
+      breach_.source,
+      breach_.seqno,
+      get_stage(breach_.engine_done, breach_.receive_time),
+      get_stage(breach_.database_committed, breach_.database_enqueued),
+      get_stage(breach_.risk_limits_sent, std::max(breach_.database_committed, breach_.engine_done)),
+      breach_.risk_limits_sent - breach_.receive_time);
+  dump("latency_slo"sv);
+  next_dump_ = now + DUMP_FREQUENCY;
+  breached_ = false;
+}
+
+// note! the copy is bounded by the capacity (no allocation), skipped if the previous copy has not yet been picked up
+void Tracer::dump(std::string_view const &reason) {
+  auto first = count_ > std::size(records_) ? count_ - std::size(records_) : 0;
+  {
+    std::lock_guard lock{mutex_};
+    if (dump_ready_) {
+      log::warn("Latency trace has not been dumped (reason={}, the previous dump is still pending)"sv, reason);
+      return;
+    }
+    dump_.clear();
+    for (auto index = first; index < count_; ++index)
+      dump_.emplace_back(records_[index & mask_]);
+    dump_reason_ = reason;
+    dump_ready_ = true;
+  }
+  condition_.notify_one();
+}
+
+void Tracer::run() {
+  std::vector<Record> records;
+  records.reserve(std::size(records_));
+  for (;;) {
+    std::string_view reason;
+    {
+      std::unique_lock lock{mutex_};
+      condition_.wait(lock, [&]() { return stop_ || dump_ready_; });
+      if (!dump_ready_)
+        return;
+      std::swap(records, dump_);
+      reason = dump_reason_;
+      dump_ready_ = false;
+    }
+    write(records, reason);
+  }
+}
+
+void Tracer::write(std::vector<Record> const &records, std::string_view const &reason) {
+  std::string buffer;
+  buffer.reserve(24 + std::size(records) * RECORD_SIZE);
+  buffer.append(MAGIC);
+  put(buffer, VERSION);
+  put(buffer, RECORD_SIZE);
+  put<uint64_t>(buffer, std::size(records));
+  for (auto &record : records) {
+    buffer.append(reinterpret_cast<char const *>(std::data(record.session_id)), std::size(record.session_id));
+    put(buffer, record.seqno);
+    put(buffer, record.receive_time);
+    put(buffer, record.engine_done);
+    put(buffer, record.database_enqueued);
+    put(buffer, record.database_committed);
+    put(buffer, record.risk_limits_sent);
+    put(buffer, record.source);
+    put(buffer, record.type);
+    buffer.append(6, '\0');
+  }
+  auto temporary = path_ + std::string{TEMPORARY_EXTENSION};
+  try {
+    {
+      std::ofstream file{temporary, std::ios::binary | std::ios::trunc};
+      if (!file)
+        throw RuntimeError{R"(Unexpected: unable to open file="{}")"sv, temporary};
+      file.write(std::data(buffer), std::size(buffer));
+      if (!file)
+        throw RuntimeError{R"(Unexpected: unable to write file="{}")"sv, temporary};
+    }
+    std::filesystem::rename(temporary, path_);
+    log::info(R"(Latency trace has been dumped (reason={}, count={}, file="{}"))"sv, reason, std::size(records), path_);
+  } catch (RuntimeError &e) {
+    log::error("Error: {}"sv, e);
+  } catch (std::exception &e) {
+    log::error("Error: {}"sv, e.what());
+  }
+}
+
+}  // namespace trace
+}  // namespace risk_manager
+}  // namespace roq
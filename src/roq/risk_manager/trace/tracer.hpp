@@ -0,0 +1,116 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "roq/api.hpp"
+
+namespace roq {
+namespace risk_manager {
+namespace trace {
+
+// note!
+//   little-endian, fixed-size records (oldest first), i.e. the file can be used in-place (e.g. numpy.fromfile)
+//
+//   file:   magic (8), version (u32), record size (u32), record count (u64), record*
+//   record: session id (16), seqno (u64), receive time (i64), engine done (i64), database enqueued (i64),
+//           database committed (i64), risk limits sent (i64), source (u8), type (u8), padding (6)
+//
+//   all times are from the monotonic clock (ns), zero means the stage was not reached
+
+static constexpr std::string_view MAGIC = "ROQTRACE";
+static constexpr uint32_t VERSION = 1;
+static constexpr uint32_t RECORD_SIZE = 72;
+
+enum class Type : uint8_t {
+  TRADE_UPDATE = 1,
+  POSITION_UPDATE,
+  FUNDS_UPDATE,
+};
+
+struct Record final {
+  std::array<uint8_t, 16> session_id = {};
+  uint64_t seqno = {};
+  std::chrono::nanoseconds receive_time = {};
+  std::chrono::nanoseconds engine_done = {};
+  std::chrono::nanoseconds database_enqueued = {};
+  std::chrono::nanoseconds database_committed = {};
+  std::chrono::nanoseconds risk_limits_sent = {};
+  uint8_t source = {};
+  Type type = {};
+};
+
+// note!
+//   per inbound event latency trace (ring), owned by the engine thread
+//   the ring is dumped on demand (any thread) or when the latency slo (receive to risk limits sent) is breached
+//   dumping is rate-limited and triggered from the timer, the ring is only copied by the engine thread
+//   the file is written by a dedicated thread (first to (path).tmp and then renamed)
+//   a disabled tracer (empty path) only ever re-uses a single record
+
+struct Tracer final {
+  Tracer(std::string_view const &path, size_t capacity, std::chrono::nanoseconds latency_slo, size_t source_count);
+
+  Tracer(Tracer &&) = delete;
+  Tracer(Tracer const &) = delete;
+
+  // note! a pending dump is still written
+  ~Tracer();
+
+  bool enabled() const { return !std::empty(path_); }
+
+  // note! engine thread
+
+  // note! the record is only valid until the next event
+  Record &operator()(Type, MessageInfo const &);
+
+  // note! stamps all (processed) trade updates received from source since the last call
+  void operator()(uint8_t source, std::chrono::nanoseconds now);
+
+  // note! dumps the ring if requested (or the slo has been breached), the file is written asynchronously
+  void refresh(std::chrono::nanoseconds now);
+
+  // note! any thread
+
+  void request_dump() { dump_requested_.store(true, std::memory_order_release); }
+
+ protected:
+  void dump(std::string_view const &reason);
+
+  // note! writer thread
+  void run();
+  void write(std::vector<Record> const &, std::string_view const &reason);
+
+ private:
+  std::string const path_;
+  std::chrono::nanoseconds const latency_slo_;
+  std::vector<Record> records_;
+  size_t const mask_;
+  uint64_t count_ = {};
+  std::vector<uint64_t> pending_;  // note! by source, first record not yet stamped
+  bool breached_ = {};
+  Record breach_ = {};  // note! first record breaching the slo (since the last dump)
+  std::chrono::nanoseconds next_dump_ = {};
+  std::atomic<bool> dump_requested_ = {};
+  // writer
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  bool stop_ = {};
+  bool dump_ready_ = {};
+  std::vector<Record> dump_;      // note! engine => writer (protected by the mutex)
+  std::string_view dump_reason_;  // note! (protected by the mutex)
+  std::thread thread_;            // note! must be last
+};
+
+}  // namespace trace
+}  // namespace risk_manager
+}  // namespace roq
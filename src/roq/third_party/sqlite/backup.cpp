@@ -0,0 +1,64 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#include "roq/third_party/sqlite/backup.hpp"
+
+#include "roq/exceptions.hpp"
+
+using namespace std::literals;
+
+namespace roq {
+namespace third_party {
+namespace sqlite {
+
+// === HELPERS ===
+
+namespace {
+using value_type = Backup::value_type;
+
+void deleter(value_type *ptr) {
+  if (ptr)
+    sqlite3_backup_finish(ptr);
+}
+
+template <typename R>
+R create(auto &destination, auto &source) {
+  auto handle = sqlite3_backup_init(destination, "main", source, "main");
+  if (handle == nullptr) {
+    auto result = sqlite3_errcode(destination);
+    throw RuntimeError{R"(sqlite3_backup_init: result={} ("{}"))"sv, result, sqlite3_errmsg(destination)};
+  }
+  return R{handle, deleter};
+}
+}  // namespace
+
+// === IMPLEMENTATION ===
+
+Backup::Backup(Connection &destination, Connection &source)
+    : handle_(create<decltype(handle_)>(destination, source)) {
+}
+
+bool Backup::step(int pages) {
+  auto result = sqlite3_backup_step(*this, pages);
+  switch (result) {
+    case SQLITE_DONE:
+      return false;
+    case SQLITE_OK:
+    case SQLITE_BUSY:
+    case SQLITE_LOCKED:
+      return true;  // note! try again
+    default:
+      throw RuntimeError{R"(sqlite3_backup_step: result={} ("{}"))"sv, result, sqlite3_errstr(result)};
+  }
+}
+
+int Backup::remaining() {
+  return sqlite3_backup_remaining(*this);
+}
+
+int Backup::page_count() {
+  return sqlite3_backup_pagecount(*this);
+}
+
+}  // namespace sqlite
+}  // namespace third_party
+}  // namespace roq
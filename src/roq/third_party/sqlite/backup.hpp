@@ -0,0 +1,40 @@
+/* Copyright (c) 2017-2024, Hans Erik Thrane */
+
+#pragma once
+
+#include <sqlite3.h>
+
+#include <memory>
+
+#include "roq/third_party/sqlite/connection.hpp"
+
+namespace roq {
+namespace third_party {
+namespace sqlite {
+
+// note!
+//   online backup (main => main)
+//   changes made through the source connection are applied to the destination as the backup progresses
+//   changes made through any other connection will restart the backup
+
+struct Backup final {
+  using value_type = struct sqlite3_backup;
+
+  Backup(Connection &destination, Connection &source);
+
+  operator value_type *() { return handle_.get(); }
+  operator value_type const *() const { return handle_.get(); }
+
+  // returns false when done
+  bool step(int pages);
+
+  int remaining();
+  int page_count();
+
+ private:
+  std::unique_ptr<value_type, void (*)(value_type *)> handle_;
+};
+
+}  // namespace sqlite
+}  // namespace third_party
+}  // namespace roq
@@ -28,19 +28,31 @@ void deleter(value_type *ptr) {
     sqlite3_close(ptr);
 }
 
+// note! serialized mode => the connection can safely be shared between threads
+auto const DEFAULT_FLAGS = SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_FULLMUTEX;
+
 template <typename R>
-R create(std::string const &filename) {
+R create(std::string const &filename, int flags) {
   value_type *handle = nullptr;
-  auto result = sqlite3_open(filename.c_str(), &handle);
+  auto result = sqlite3_open_v2(filename.c_str(), &handle, flags, nullptr);
   if (result != SQLITE_OK)
-    throw RuntimeError{R"(sqlite3_open: result={} ("{}"))"sv, result, sqlite3_errstr(result)};
+    throw RuntimeError{R"(sqlite3_open_v2: result={} ("{}"))"sv, result, sqlite3_errstr(result)};
   return R{handle, deleter};
 }
 }  // namespace
 
 // === IMPLEMENTATION ===
-//
-Connection::Connection(std::string_view const &filename) : handle_(create<decltype(handle_)>(std::string{filename})) {
+
+Connection::Connection(std::string_view const &filename) : Connection{filename, DEFAULT_FLAGS} {
+}
+
+Connection::Connection(std::string_view const &filename, int flags)
+    : handle_(create<decltype(handle_)>(std::string{filename}, flags)) {
+}
+
+// note! statements must be finalized before the connection is closed
+Connection::~Connection() {
+  statements_.clear();
 }
 
 void Connection::exec(std::string_view const &query) {
@@ -49,6 +61,69 @@ void Connection::exec(std::string_view const &query) {
     throw RuntimeError{"Statement is not complete"sv};
 }
 
+void Connection::busy_timeout(std::chrono::milliseconds timeout) {
+  auto result = sqlite3_busy_timeout(*this, static_cast<int>(timeout.count()));
+  if (result != SQLITE_OK)
+    throw RuntimeError{R"(sqlite3_busy_timeout: result={} ("{}"))"sv, result, sqlite3_errstr(result)};
+}
+
+void Connection::progress_handler(std::function<bool()> const &callback, int instructions) {
+  progress_handler_ = callback;
+  if (progress_handler_) {
+    auto handler = [](void *ptr) -> int {
+      auto &self = *static_cast<Connection *>(ptr);
+      return self.progress_handler_() ? 1 : 0;
+    };
+    sqlite3_progress_handler(*this, instructions, handler, this);
+  } else {
+    sqlite3_progress_handler(*this, 0, nullptr, nullptr);
+  }
+}
+
+// statement cache
+
+Statement &Connection::prepare(std::string_view const &query) {
+  auto iter = statements_.find(query);
+  if (iter == std::end(statements_)) {
+    log::debug(R"(Preparing query="{}")"sv, query);
+    iter = statements_.emplace(query, std::make_unique<Statement>(*this, query)).first;
+  } else {
+    // note! the result repeats the error of the most recent step (if any) and is therefore ignored
+    sqlite3_reset(*(*iter).second);
+  }
+  return *(*iter).second;
+}
+
+void Connection::reset() {
+  for (auto &[_, statement] : statements_)
+    sqlite3_reset(*statement);
+}
+
+void Connection::clear() {
+  statements_.clear();
+}
+
+int64_t Connection::last_insert_rowid() {
+  return sqlite3_last_insert_rowid(*this);
+}
+
+int64_t Connection::changes() {
+  return sqlite3_changes(*this);
+}
+
+uint32_t Connection::get_user_version() {
+  Statement statement{*this, "PRAGMA user_version"sv};
+  if (!statement.step())
+    throw RuntimeError{"Unexpected: no result"sv};
+  return statement.template get<uint32_t>(0);
+}
+
+void Connection::set_user_version(uint32_t version) {
+  auto query = fmt::format("PRAGMA user_version={}"_cf, version);
+  log::debug(R"(query="{}")"sv, query);
+  exec(query);
+}
+
 bool Connection::table_exists(std::string_view const &name) {
   auto query = fmt::format("SELECT name FROM sqlite_master WHERE type='table' AND name='{}'"_cf, name);
   log::debug(R"(query="{}")"sv, query);
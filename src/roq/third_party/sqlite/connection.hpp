@@ -4,31 +4,74 @@
 
 #include <sqlite3.h>
 
+#include <absl/container/flat_hash_map.h>
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
 #include <memory>
+#include <string>
 #include <string_view>
 
 namespace roq {
 namespace third_party {
 namespace sqlite {
 
+struct Statement;
+
 struct Connection final {
   using value_type = struct sqlite3;
 
   explicit Connection(std::string_view const &filename);
+  Connection(std::string_view const &filename, int flags);
+
+  Connection(Connection &&) = delete;
+  Connection(Connection const &) = delete;
+
+  ~Connection();
 
   operator value_type *() { return handle_.get(); }
   operator value_type const *() const { return handle_.get(); }
 
   void exec(std::string_view const &query);
 
+  void busy_timeout(std::chrono::milliseconds);
+
+  // note!
+  //   callback is invoked (approximately) every N virtual machine instructions
+  //   returning true will interrupt the current statement (step will then throw)
+  //   an empty callback removes the handler
+  void progress_handler(std::function<bool()> const &callback, int instructions);
+
+  // statement cache
+  //   note! the statement is reset before being returned
+  //   note! reset() must be called when done, otherwise read transactions may be kept open
+
+  Statement &prepare(std::string_view const &query);
+
+  void reset();
+
+  // note! finalizes all statements, e.g. after dropping the tables they refer to
+  void clear();
+
   // utilities
 
+  int64_t last_insert_rowid();
+
+  // note! number of rows modified by the most recent INSERT, UPDATE or DELETE
+  int64_t changes();
+
+  uint32_t get_user_version();
+  void set_user_version(uint32_t);
+
   bool table_exists(std::string_view const &name);
   void rename_table(std::string_view const &old_name, std::string_view const &new_name);
   void drop_table(std::string_view const &name);
 
  private:
   std::unique_ptr<value_type, void (*)(value_type *)> handle_;
+  absl::flat_hash_map<std::string, std::unique_ptr<Statement>> statements_;
+  std::function<bool()> progress_handler_;
 };
 
 }  // namespace sqlite
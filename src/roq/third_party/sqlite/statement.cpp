@@ -29,9 +29,10 @@ void deleter(value_type *ptr) {
 template <typename R>
 R create(auto &connection, auto &query) {
   value_type *handle = nullptr;
-  auto result = sqlite3_prepare(connection, std::data(query), std::size(query), &handle, nullptr);
+  // note! v2 => statements are transparently re-prepared when the schema changes
+  auto result = sqlite3_prepare_v2(connection, std::data(query), std::size(query), &handle, nullptr);
   if (result != SQLITE_OK)
-    throw RuntimeError{R"(sqlite3_prepare: result={} ("{}"))"sv, result, sqlite3_errstr(result)};
+    throw RuntimeError{R"(sqlite3_prepare_v2: result={} ("{}"))"sv, result, sqlite3_errstr(result)};
   return R{handle, deleter};
 }
 }  // namespace
@@ -60,7 +61,7 @@ bool Statement::step() {
     case SQLITE_ROW:
       return true;
     default:
-      throw RuntimeError{R"(sqlite3_bind_null: result={} ("{}"))"sv, result, sqlite3_errstr(result)};
+      throw RuntimeError{R"(sqlite3_step: result={} ("{}"))"sv, result, sqlite3_errstr(result)};
   }
 }
 
@@ -96,7 +97,9 @@ void Statement::bind(size_t column, double value) {
 
 void Statement::bind(size_t column, std::string_view const &value) {
   auto real_column = static_cast<int>(column) + 1;
-  auto result = sqlite3_bind_text(*this, real_column, std::data(value), std::size(value), nullptr);
+  // note! an empty string_view may have a nullptr data pointer which sqlite would then bind as null
+  auto data = std::empty(value) ? "" : std::data(value);
+  auto result = sqlite3_bind_text(*this, real_column, data, std::size(value), nullptr);
   if (result != SQLITE_OK)
     throw RuntimeError{R"(sqlite3_bind_text: result={} ("{}"))"sv, result, sqlite3_errstr(result)};
 }